@@ -172,6 +172,81 @@ esp_err_t mbc_master_send_request(void *ctx, mb_param_request_t *request, void *
     return ESP_OK;
 }
 
+/**
+ * Abort the request in progress
+ */
+esp_err_t mbc_master_abort_request(void *ctx)
+{
+    MB_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly initialized.");
+    mbm_controller_iface_t *mbm_controller = MB_MASTER_GET_IFACE(ctx);
+    MB_RETURN_ON_FALSE(mbm_controller->is_active, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly configured.");
+    if (!mbm_controller->abort_request) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return mbm_controller->abort_request(ctx);
+}
+
+/**
+ * Set the slave respond timeout at runtime
+ */
+esp_err_t mbc_master_set_response_time(void *ctx, uint32_t resp_time_ms)
+{
+    MB_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly initialized.");
+    mbm_controller_iface_t *mbm_controller = MB_MASTER_GET_IFACE(ctx);
+    if (!mbm_controller->set_response_time) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return mbm_controller->set_response_time(ctx, resp_time_ms);
+}
+
+/**
+ * Queue a request and return, the result is passed to the callback
+ */
+esp_err_t mbc_master_send_request_async(void *ctx, const mb_param_request_t *request, void *data_ptr,
+                                        mb_request_prio_t prio, mb_request_done_cb_t done_cb, void *cb_arg)
+{
+    MB_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly initialized.");
+    mbm_controller_iface_t *mbm_controller = MB_MASTER_GET_IFACE(ctx);
+    if (!mbm_controller->send_request_async) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    MB_RETURN_ON_FALSE(mbm_controller->is_active, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly configured.");
+    return mbm_controller->send_request_async(ctx, request, data_ptr, prio, done_cb, cb_arg);
+}
+
+/**
+ * Cancel the queued asynchronous requests of a class and the classes below it
+ */
+esp_err_t mbc_master_cancel_requests(void *ctx, mb_request_prio_t prio)
+{
+    MB_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly initialized.");
+    mbm_controller_iface_t *mbm_controller = MB_MASTER_GET_IFACE(ctx);
+    if (!mbm_controller->cancel_requests) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return mbm_controller->cancel_requests(ctx, prio);
+}
+
+/**
+ * Get the counters of the memory pools of the controller
+ */
+esp_err_t mbc_master_get_pool_stats(void *ctx, mb_pool_stats_t *stats)
+{
+    MB_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG,
+                       "Master interface is not correctly initialized.");
+    mbm_controller_iface_t *mbm_controller = MB_MASTER_GET_IFACE(ctx);
+    if (!mbm_controller->get_pool_stats) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return mbm_controller->get_pool_stats(ctx, stats);
+}
+
 /**
  * Set Modbus parameter description table
  */
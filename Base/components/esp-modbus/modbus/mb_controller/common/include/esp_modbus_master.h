@@ -185,6 +185,39 @@ typedef struct {
     uint16_t reg_size;              /*!< Modbus number of registers */
 } mb_param_request_t;
 
+/**
+ * @brief Completion callback of an asynchronous request (see mbc_master_send_request_async())
+ *
+ * @param[in] cb_arg user argument given at submission
+ * @param[in] error result of the request, the same codes as mbc_master_send_request()
+ */
+typedef void (*mb_request_done_cb_t)(void *cb_arg, esp_err_t error);
+
+/**
+ * @brief Priority class of an asynchronous request
+ *
+ * The async task sends the oldest request of the highest non-empty class. A NORMAL or LOW request passed over
+ * CONFIG_FMB_MASTER_ASYNC_AGING times goes before the NORMAL ones (aging), so monitoring is never starved.
+ * HIGH requests are not subject to aging: they wait at most for the request in progress.
+ */
+typedef enum {
+    MB_REQUEST_PRIO_HIGH = 0,       /*!< Safety writes, ahead of everything queued */
+    MB_REQUEST_PRIO_NORMAL,         /*!< Control writes */
+    MB_REQUEST_PRIO_LOW,            /*!< Monitoring reads and polls */
+    MB_REQUEST_PRIO_COUNT
+} mb_request_prio_t;
+
+/**
+ * @brief Counters of the fixed-size memory pools of the master controller (see mbc_master_get_pool_stats())
+ */
+typedef struct {
+    uint16_t buffers;                            /*!< Parameter buffers in the pool (0 - CONFIG_FMB_STATIC_POOL disabled, heap allocation) */
+    uint16_t buffers_max_used;                   /*!< Most parameter buffers in use at the same time */
+    uint32_t buffer_waits;                       /*!< Requests that found the pool exhausted and waited for a buffer */
+    uint32_t buffer_failures;                    /*!< Requests failed without a buffer (wait timeout or parameter too large) */
+    uint32_t async_full[MB_REQUEST_PRIO_COUNT];  /*!< Asynchronous requests rejected because the queue of their class was full */
+} mb_pool_stats_t;
+
 /**
  * @brief Initialize Modbus controller and stack for TCP port
  *
@@ -214,11 +247,15 @@ esp_err_t mbc_master_create_serial(mb_communication_info_t *config, void **ctx);
 /**
  * @brief Deletes Modbus controller and stack engine
  *
+ *        The asynchronous task (serial master) finishes the request in progress, completes the queued ones with
+ *        ESP_ERR_INVALID_STATE and exits before anything is released.
+ *
  * @param[in] ctx context pointer of the initialized modbus interface 
  *
  * @return
  *     - ESP_OK   Success
- *     - ESP_ERR_INVALID_STATE Parameter error
+ *     - ESP_ERR_INVALID_STATE Parameter error, or the asynchronous task did not exit (nothing is released, the
+ *       delete can be retried)
  */
 esp_err_t mbc_master_delete(void *ctx);
 
@@ -302,6 +339,94 @@ esp_err_t mbc_master_set_descriptor(void *ctx, const mb_parameter_descriptor_t *
  */
 esp_err_t mbc_master_send_request(void *ctx, mb_param_request_t *request, void *data_ptr);
 
+/**
+ * @brief Abort the request in progress. The pending mbc_master_send_request() returns ESP_ERR_TIMEOUT
+ *        as soon as the request frame is sent, without waiting for the respond timeout.
+ *        Can be called from any task while another task is blocked in the request.
+ *        If no request is in progress, the abort is discarded by the next request.
+ *
+ * @param[in] ctx context pointer of the initialized modbus interface
+ *
+ * @return
+ *     - esp_err_t ESP_OK - the respond timer of the request in progress is expired
+ *     - esp_err_t ESP_ERR_INVALID_STATE - no request waiting for response, the abort is pending
+ *     - esp_err_t ESP_ERR_NOT_SUPPORTED - the port type does not support the abort
+ */
+esp_err_t mbc_master_abort_request(void *ctx);
+
+/**
+ * @brief Set the slave respond timeout at runtime (overrides response_tout_ms of the communication options).
+ *        The new value applies to the next request frame; a request waiting for response keeps its timeout.
+ *
+ * @param[in] ctx context pointer of the initialized modbus interface
+ * @param[in] resp_time_ms respond timeout in milliseconds
+ *
+ * @return
+ *     - esp_err_t ESP_OK - the timeout is set
+ *     - esp_err_t ESP_ERR_INVALID_ARG - the timeout is below the minimum supported by the stack
+ *     - esp_err_t ESP_ERR_INVALID_STATE - the stack is not created
+ *     - esp_err_t ESP_ERR_NOT_SUPPORTED - the port type does not support the runtime setting
+ */
+esp_err_t mbc_master_set_response_time(void *ctx, uint32_t resp_time_ms);
+
+/**
+ * @brief Queue a request without waiting for it. The controller sends the queued requests back-to-back,
+ *        by priority class and in submission order within a class (see mb_request_prio_t), each one as
+ *        mbc_master_send_request() would, and calls done_cb with the result.
+ *        The callback is called exactly once per accepted request, from the controller async task:
+ *        it must not block, but may submit new requests. The request structure is copied; the data buffer
+ *        is used in place and must stay valid until the callback.
+ *
+ * @param[in] ctx context pointer of the initialized modbus interface
+ * @param[in] request pointer to request structure of type mb_param_request_t
+ * @param[in] data_ptr pointer to data buffer to send or received data (dependent of command field in request)
+ * @param[in] prio priority class of the request
+ * @param[in] done_cb completion callback (can be NULL)
+ * @param[in] cb_arg user argument of the callback
+ *
+ * @return
+ *     - esp_err_t ESP_OK - the request is queued
+ *     - esp_err_t ESP_ERR_INVALID_ARG - invalid argument of function
+ *     - esp_err_t ESP_ERR_NO_MEM - the queue of the class is full (CONFIG_FMB_MASTER_ASYNC_QUEUE_SIZE requests
+ *       of the class in flight); a full LOW class does not prevent queuing HIGH requests
+ *     - esp_err_t ESP_ERR_INVALID_STATE - the stack is not started
+ *     - esp_err_t ESP_ERR_NOT_SUPPORTED - the port type does not support asynchronous requests
+ */
+esp_err_t mbc_master_send_request_async(void *ctx, const mb_param_request_t *request, void *data_ptr,
+                                        mb_request_prio_t prio, mb_request_done_cb_t done_cb, void *cb_arg);
+
+/**
+ * @brief Cancel the queued asynchronous requests of class prio and of the classes below it that are not sent yet.
+ *        Their callbacks are called with ESP_ERR_INVALID_STATE and their frames are never sent, even if the async
+ *        task has already taken one of them and waits for the bus. The request in progress is not affected
+ *        (see mbc_master_abort_request()). A safety write can cancel the pending polls with
+ *        prio = MB_REQUEST_PRIO_LOW before it is queued.
+ *
+ * @param[in] ctx context pointer of the initialized modbus interface
+ * @param[in] prio highest class to cancel (MB_REQUEST_PRIO_HIGH cancels all)
+ *
+ * @return
+ *     - esp_err_t ESP_OK - the queued requests are cancelled
+ *     - esp_err_t ESP_ERR_INVALID_STATE - the stack is not created
+ *     - esp_err_t ESP_ERR_NOT_SUPPORTED - the port type does not support asynchronous requests
+ */
+esp_err_t mbc_master_cancel_requests(void *ctx, mb_request_prio_t prio);
+
+/**
+ * @brief Get the counters of the fixed-size memory pools: parameter buffers of mbc_master_get_parameter() and
+ *        mbc_master_set_parameter() (CONFIG_FMB_STATIC_POOL) and slots of the asynchronous request queues.
+ *        The counters are cumulative since the controller is created.
+ *
+ * @param[in] ctx context pointer of the initialized modbus interface
+ * @param[out] stats pointer to the counters
+ *
+ * @return
+ *     - esp_err_t ESP_OK - the counters are copied
+ *     - esp_err_t ESP_ERR_INVALID_ARG - invalid argument of function
+ *     - esp_err_t ESP_ERR_NOT_SUPPORTED - the port type does not use the pools
+ */
+esp_err_t mbc_master_get_pool_stats(void *ctx, mb_pool_stats_t *stats);
+
 /**
  * @brief Get information about supported characteristic defined as cid. Uses parameter description table to get
  *        this information. The function will check if characteristic defined as a cid parameter is supported
@@ -45,6 +45,15 @@ typedef struct {
     SemaphoreHandle_t mbm_sema;                         /*!< Modbus controller semaphore */
     const mb_parameter_descriptor_t *param_descriptor_table; /*!< Modbus controller parameter description table */
     size_t mbm_param_descriptor_size;                   /*!< Modbus controller parameter description table size */
+    QueueHandle_t async_queue[MB_REQUEST_PRIO_COUNT];   /*!< Modbus controller queues of asynchronous requests, by class */
+    TaskHandle_t async_task_handle;                     /*!< Modbus controller task sending asynchronous requests */
+    uint32_t async_generation[MB_REQUEST_PRIO_COUNT];   /*!< Incremented to cancel the queued requests of a class */
+    SemaphoreHandle_t async_exit_sema;                  /*!< Set by delete: the async task completes its queued requests, gives it and exits */
+#if CONFIG_FMB_STATIC_POOL
+    uint8_t *pool_arena;                                /*!< Parameter buffers, allocated once at creation */
+    QueueHandle_t pool_free;                            /*!< Indexes of the free parameter buffers */
+#endif
+    mb_pool_stats_t pool_stats;                         /*!< Modbus controller pool counters */
 } mb_master_options_t;
 
 typedef esp_err_t (*iface_get_cid_info_fp)(void *, uint16_t, const mb_parameter_descriptor_t **);           /*!< Interface get_cid_info method */
@@ -54,6 +63,12 @@ typedef esp_err_t (*iface_send_request_fp)(void *, mb_param_request_t*, void *);
 typedef esp_err_t (*iface_mbm_set_descriptor_fp)(void *, const mb_parameter_descriptor_t*, const uint16_t); /*!< Interface set_descriptor method */
 typedef esp_err_t (*iface_set_parameter_fp)(void *, uint16_t, uint8_t *, uint8_t *);                        /*!< Interface set_parameter method */
 typedef esp_err_t (*iface_set_parameter_with_fp)(void *, uint16_t, uint8_t, uint8_t *, uint8_t *);          /*!< Interface set_parameter_with method */
+typedef esp_err_t (*iface_abort_request_fp)(void *);                                                         /*!< Interface abort_request method */
+typedef esp_err_t (*iface_set_response_time_fp)(void *, uint32_t);                                           /*!< Interface set_response_time method */
+typedef esp_err_t (*iface_send_request_async_fp)(void *, const mb_param_request_t *, void *, mb_request_prio_t,
+                                                 mb_request_done_cb_t, void *);                              /*!< Interface send_request_async method */
+typedef esp_err_t (*iface_cancel_requests_fp)(void *, mb_request_prio_t);                                    /*!< Interface cancel_requests method */
+typedef esp_err_t (*iface_get_pool_stats_fp)(void *, mb_pool_stats_t *);                                     /*!< Interface get_pool_stats method */
 
 /**
  * @brief Modbus controller interface structure
@@ -76,6 +91,11 @@ typedef struct {
     iface_mbm_set_descriptor_fp set_descriptor;     /*!< Interface set_descriptor method */
     iface_set_parameter_fp set_parameter;           /*!< Interface set_parameter method */
     iface_set_parameter_with_fp set_parameter_with; /*!< Interface set_parameter_with method */
+    iface_abort_request_fp abort_request;           /*!< Interface abort_request method */
+    iface_set_response_time_fp set_response_time;   /*!< Interface set_response_time method */
+    iface_send_request_async_fp send_request_async; /*!< Interface send_request_async method */
+    iface_cancel_requests_fp cancel_requests;       /*!< Interface cancel_requests method */
+    iface_get_pool_stats_fp get_pool_stats;         /*!< Interface get_pool_stats method */
 } mbm_controller_iface_t;
 
 #ifdef __cplusplus
@@ -13,6 +13,7 @@
 #include "freertos/FreeRTOS.h"      // for task creation
 #include "freertos/task.h"          // for task api access
 #include "freertos/event_groups.h"  // for event groups
+#include "esp_heap_caps.h"          // for the parameter buffer pool
 
 #include "sdkconfig.h"              // for KConfig values
 #include "esp_modbus_common.h"      // for common types
@@ -53,6 +54,108 @@ static void mbc_ser_master_task(void *param)
     }
 }
 
+// Asynchronous request queued by mbc_serial_master_send_request_async()
+typedef struct {
+    mb_param_request_t request;
+    void *data_ptr;
+    mb_request_done_cb_t done_cb;
+    void *cb_arg;
+    uint32_t generation;                // async_generation of its class at submission, cancelled if it changed
+} mbc_async_request_t;
+
+// Time for the async task to exit on delete: the request in progress may wait for the bus,
+// for the stack and for its response, each bounded by MB_MAX_RESP_DELAY_MS
+#define MB_ASYNC_EXIT_TIMEOUT_MS (3 * MB_MAX_RESP_DELAY_MS)
+
+static mb_err_enum_t mbc_serial_master_request(void *ctx, const mb_param_request_t *request, void *data_ptr);
+
+static bool mbc_async_is_cancelled(mb_master_options_t *mbm_opts, mb_request_prio_t prio,
+                                   const mbc_async_request_t *item)
+{
+    return item->generation != __atomic_load_n(&mbm_opts->async_generation[prio], __ATOMIC_ACQUIRE);
+}
+
+// Class of the next request to send, MB_REQUEST_PRIO_COUNT if none is queued:
+// HIGH first, then a class passed over CONFIG_FMB_MASTER_ASYNC_AGING times, then the highest non-empty class
+static mb_request_prio_t mbc_async_pick(mb_master_options_t *mbm_opts, const uint8_t *age)
+{
+    if (uxQueueMessagesWaiting(mbm_opts->async_queue[MB_REQUEST_PRIO_HIGH])) {
+        return MB_REQUEST_PRIO_HIGH;
+    }
+    for (int prio = MB_REQUEST_PRIO_NORMAL; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        if ((age[prio] >= CONFIG_FMB_MASTER_ASYNC_AGING) && uxQueueMessagesWaiting(mbm_opts->async_queue[prio])) {
+            return (mb_request_prio_t)prio;
+        }
+    }
+    for (int prio = MB_REQUEST_PRIO_NORMAL; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        if (uxQueueMessagesWaiting(mbm_opts->async_queue[prio])) {
+            return (mb_request_prio_t)prio;
+        }
+    }
+    return MB_REQUEST_PRIO_COUNT;
+}
+
+// Complete every queued request with an error, without sending it
+static void mbc_async_drain(mb_master_options_t *mbm_opts)
+{
+    mbc_async_request_t item;
+    for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        while (xQueueReceive(mbm_opts->async_queue[prio], &item, 0) == pdTRUE) {
+            if (item.done_cb) {
+                item.done_cb(item.cb_arg, ESP_ERR_INVALID_STATE);
+            }
+        }
+    }
+}
+
+// Sends the asynchronous requests back-to-back by class and calls their callbacks
+static void mbc_ser_master_async_task(void *param)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(param);
+    mbc_async_request_t item;
+    uint8_t age[MB_REQUEST_PRIO_COUNT] = {0};   // Times the class was passed over with requests queued
+
+    for (;;)
+    {
+        // One notification per queued request (sent after the request is in its queue)
+        (void)ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        // Exit requested by delete: checked between requests, so mbm_sema is never held here
+        SemaphoreHandle_t exit_sema = __atomic_load_n(&mbm_opts->async_exit_sema, __ATOMIC_ACQUIRE);
+        if (exit_sema) {
+            mbc_async_drain(mbm_opts);
+            (void)xSemaphoreGive(exit_sema);
+            vTaskDelete(NULL);
+        }
+        mb_request_prio_t prio = mbc_async_pick(mbm_opts, age);
+        if ((prio == MB_REQUEST_PRIO_COUNT) || (xQueueReceive(mbm_opts->async_queue[prio], &item, 0) != pdTRUE)) {
+            continue;
+        }
+        for (int lower = prio + 1; lower < MB_REQUEST_PRIO_COUNT; lower++) {
+            if (uxQueueMessagesWaiting(mbm_opts->async_queue[lower]) && (age[lower] < UINT8_MAX)) {
+                age[lower]++;
+            }
+        }
+        age[prio] = 0;
+
+        esp_err_t error = ESP_ERR_INVALID_STATE;
+        if (!mbc_async_is_cancelled(mbm_opts, prio, &item)) {
+            if (xSemaphoreTake(mbm_opts->mbm_sema, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS)) == pdTRUE) {
+                // Checked again with the bus taken: a cancel while waiting for it must not send the frame
+                if (!mbc_async_is_cancelled(mbm_opts, prio, &item)) {
+                    error = MB_ERR_TO_ESP_ERR(mbc_serial_master_request(param, &item.request, item.data_ptr));
+                }
+                (void)xSemaphoreGive(mbm_opts->mbm_sema);
+            } else {
+                ESP_LOGD(TAG, "%s:MBC semaphore take fail.", __func__);
+                error = MB_ERR_TO_ESP_ERR(MB_EBUSY);
+            }
+        }
+        if (item.done_cb) {
+            item.done_cb(item.cb_arg, error);
+        }
+    }
+}
+
 // Modbus controller stack start function
 static esp_err_t mbc_serial_master_start(void *ctx)
 {
@@ -94,6 +197,44 @@ static esp_err_t mbc_serial_master_stop(void *ctx)
     return ESP_OK;
 }
 
+// Release the parameter buffer pool
+static void mbc_serial_master_pool_delete(mb_master_options_t *mbm_opts)
+{
+#if CONFIG_FMB_STATIC_POOL
+    if (mbm_opts->pool_free) {
+        vQueueDelete(mbm_opts->pool_free);
+        mbm_opts->pool_free = NULL;
+    }
+    free(mbm_opts->pool_arena);
+    mbm_opts->pool_arena = NULL;
+#endif
+}
+
+// Stop the async task: it finishes the request in progress, completes the queued ones with an error and exits
+static esp_err_t mbc_serial_master_async_stop(mb_master_options_t *mbm_opts)
+{
+    if (!mbm_opts->async_task_handle) {
+        return ESP_OK;
+    }
+    // Kept from a previous delete that timed out: the exit is still requested
+    SemaphoreHandle_t exit_sema = mbm_opts->async_exit_sema;
+    if (!exit_sema) {
+        exit_sema = xSemaphoreCreateBinary();
+        MB_RETURN_ON_FALSE((exit_sema), ESP_ERR_NO_MEM, TAG, "mb async exit semaphore create error.");
+        __atomic_store_n(&mbm_opts->async_exit_sema, exit_sema, __ATOMIC_RELEASE);
+    }
+    (void)xTaskNotifyGive(mbm_opts->async_task_handle);
+    if (xSemaphoreTake(exit_sema, pdMS_TO_TICKS(MB_ASYNC_EXIT_TIMEOUT_MS)) != pdTRUE) {
+        // The task still uses the controller: nothing can be released, the delete can be retried
+        ESP_LOGE(TAG, "%s: mb async task did not exit.", __func__);
+        return ESP_ERR_TIMEOUT;
+    }
+    mbm_opts->async_task_handle = NULL;
+    __atomic_store_n(&mbm_opts->async_exit_sema, NULL, __ATOMIC_RELEASE);
+    vSemaphoreDelete(exit_sema);
+    return ESP_OK;
+}
+
 // Modbus controller destroy function
 static esp_err_t mbc_serial_master_delete(void *ctx)
 {
@@ -101,6 +242,10 @@ static esp_err_t mbc_serial_master_delete(void *ctx)
     mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
     mb_err_enum_t mb_error = MB_ENOERR;
 
+    // Before stopping the stack, so that the request in progress completes normally
+    MB_RETURN_ON_FALSE((mbc_serial_master_async_stop(mbm_opts) == ESP_OK),
+                       ESP_ERR_INVALID_STATE, TAG, "mb async task stop failure.");
+
     // Check the stack started bit
     BaseType_t status = xEventGroupWaitBits(mbm_opts->event_group_handle,
                                             (BaseType_t)(MB_EVENT_STACK_STARTED),
@@ -115,12 +260,19 @@ static esp_err_t mbc_serial_master_delete(void *ctx)
     }
 
     mbm_iface->is_active = false;
+    // Requests queued after the task exited
+    mbc_async_drain(mbm_opts);
+    for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        vQueueDelete(mbm_opts->async_queue[prio]);
+        mbm_opts->async_queue[prio] = NULL;
+    }
     vTaskDelete(mbm_opts->task_handle);
     mbm_opts->task_handle = NULL;
     vEventGroupDelete(mbm_opts->event_group_handle);
     mbm_opts->event_group_handle = NULL;
     vSemaphoreDelete(mbm_opts->mbm_sema);
     mbm_opts->mbm_sema = NULL;
+    mbc_serial_master_pool_delete(mbm_opts);
     // delete mb_base instance and all its allocations
     mb_error = mbm_iface->mb_base->delete(mbm_iface->mb_base);
     MB_RETURN_ON_FALSE((mb_error == MB_ENOERR), ESP_ERR_INVALID_STATE, TAG,
@@ -153,115 +305,128 @@ static esp_err_t mbc_serial_master_set_descriptor(void *ctx, const mb_parameter_
     return ESP_OK;
 }
 
-// Send custom Modbus request defined as mb_param_request_t structure
-static esp_err_t mbc_serial_master_send_request(void *ctx, mb_param_request_t *request, void *data_ptr)
+// Send the request and wait for the response, the caller holds mbm_sema
+static mb_err_enum_t mbc_serial_master_request(void *ctx, const mb_param_request_t *request, void *data_ptr)
 {
     mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
     mbm_controller_iface_t *mbm_controller_iface = MB_MASTER_GET_IFACE(ctx);
-    MB_RETURN_ON_FALSE((request), ESP_ERR_INVALID_ARG, TAG, "mb request structure.");
-    MB_RETURN_ON_FALSE((data_ptr), ESP_ERR_INVALID_ARG, TAG, "mb incorrect data pointer.");
-
     mb_err_enum_t mb_error = MB_EBUSY;
 
-    if (xSemaphoreTake(mbm_opts->mbm_sema, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS)) == pdTRUE) {
-        uint8_t mb_slave_addr = request->slave_addr;
-        uint8_t mb_command = request->command;
-        uint16_t mb_offset = request->reg_start;
-        uint16_t mb_size = request->reg_size;
+    uint8_t mb_slave_addr = request->slave_addr;
+    uint8_t mb_command = request->command;
+    uint16_t mb_offset = request->reg_start;
+    uint16_t mb_size = request->reg_size;
 
-        // Set the buffer for callback function processing of received data
-        mbm_opts->reg_buffer_ptr = (uint8_t *)data_ptr;
-        mbm_opts->reg_buffer_size = mb_size;
+    // The abort requested before this request is not applicable
+    mb_port_timer_abort_clear(MB_BASE2PORT(mbm_controller_iface->mb_base));
 
-        // Calls appropriate request function to send request and waits response
-        switch (mb_command)
-        {
+    // Set the buffer for callback function processing of received data
+    mbm_opts->reg_buffer_ptr = (uint8_t *)data_ptr;
+    mbm_opts->reg_buffer_size = mb_size;
+
+    // Calls appropriate request function to send request and waits response
+    switch (mb_command)
+    {
 #if MB_FUNC_OTHER_REP_SLAVEID_ENABLED
-        case MB_FUNC_OTHER_REPORT_SLAVEID:
-            mb_error = mbm_rq_report_slave_id(mbm_controller_iface->mb_base, mb_slave_addr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_OTHER_REPORT_SLAVEID:
+        mb_error = mbm_rq_report_slave_id(mbm_controller_iface->mb_base, mb_slave_addr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_READ_COILS_ENABLED
-        case MB_FUNC_READ_COILS:
-            mb_error = mbm_rq_read_coils(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                         mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_READ_COILS:
+        mb_error = mbm_rq_read_coils(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                     mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_WRITE_COIL_ENABLED
-        case MB_FUNC_WRITE_SINGLE_COIL:
-            mb_error = mbm_rq_write_coil(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                         *(uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_WRITE_SINGLE_COIL:
+        mb_error = mbm_rq_write_coil(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                     *(uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_WRITE_MULTIPLE_COILS_ENABLED
-        case MB_FUNC_WRITE_MULTIPLE_COILS:
-            mb_error = mbm_rq_write_multi_coils(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                                mb_size, (uint8_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_WRITE_MULTIPLE_COILS:
+        mb_error = mbm_rq_write_multi_coils(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                            mb_size, (uint8_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_READ_DISCRETE_INPUTS_ENABLED
-        case MB_FUNC_READ_DISCRETE_INPUTS:
-            mb_error = mbm_rq_read_discrete_inputs(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                                    mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_READ_DISCRETE_INPUTS:
+        mb_error = mbm_rq_read_discrete_inputs(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                                mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_READ_HOLDING_ENABLED
-        case MB_FUNC_READ_HOLDING_REGISTER:
-            mb_error = mbm_rq_read_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                               mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_READ_HOLDING_REGISTER:
+        mb_error = mbm_rq_read_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                           mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_WRITE_HOLDING_ENABLED
-        case MB_FUNC_WRITE_REGISTER:
-            mb_error = mbm_rq_write_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                                *(uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_WRITE_REGISTER:
+        mb_error = mbm_rq_write_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                            *(uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_WRITE_MULTIPLE_HOLDING_ENABLED
-        case MB_FUNC_WRITE_MULTIPLE_REGISTERS:
-            mb_error = mbm_rq_write_multi_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr,
-                                                      mb_offset, mb_size, (uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_WRITE_MULTIPLE_REGISTERS:
+        mb_error = mbm_rq_write_multi_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr,
+                                                  mb_offset, mb_size, (uint16_t *)data_ptr, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_READWRITE_HOLDING_ENABLED
-        case MB_FUNC_READWRITE_MULTIPLE_REGISTERS:
-            mb_error = mbm_rq_rw_multi_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                                   mb_size, (uint16_t *)data_ptr,
-                                                   mb_offset, mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_READWRITE_MULTIPLE_REGISTERS:
+        mb_error = mbm_rq_rw_multi_holding_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                               mb_size, (uint16_t *)data_ptr,
+                                               mb_offset, mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
 
 #if MB_FUNC_READ_INPUT_ENABLED
-        case MB_FUNC_READ_INPUT_REGISTER:
-            mb_error = mbm_rq_read_inp_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
-                                           mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-            break;
+    case MB_FUNC_READ_INPUT_REGISTER:
+        mb_error = mbm_rq_read_inp_reg(mbm_controller_iface->mb_base, mb_slave_addr, mb_offset,
+                                       mb_size, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+        break;
 #endif
-        default:
-            mb_fn_handler_fp handler = NULL;
-            // check registered function handler
-            mb_error = mbm_get_handler(mbm_controller_iface->mb_base, mb_command, &handler);
-            if (mb_error == MB_ENOERR) {
-                // send the request for custom command
-                mb_error = mbm_rq_custom(mbm_controller_iface->mb_base, mb_slave_addr, mb_command,
-                                            data_ptr, (uint16_t)(mb_size << 1),
-                                            pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
-                ESP_LOGD(TAG, "%s: Send custom request (%u)", __FUNCTION__, mb_command);
-            } else {
-                ESP_LOGE(TAG, "%s: Incorrect or unsupported function in request (%u), error = (0x%x)",
-                            __FUNCTION__, mb_command, (int)mb_error);
-                mb_error = MB_ENOREG;
-            }
-            break;
+    default:
+        mb_fn_handler_fp handler = NULL;
+        // check registered function handler
+        mb_error = mbm_get_handler(mbm_controller_iface->mb_base, mb_command, &handler);
+        if (mb_error == MB_ENOERR) {
+            // send the request for custom command
+            mb_error = mbm_rq_custom(mbm_controller_iface->mb_base, mb_slave_addr, mb_command,
+                                        data_ptr, (uint16_t)(mb_size << 1),
+                                        pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS));
+            ESP_LOGD(TAG, "%s: Send custom request (%u)", __FUNCTION__, mb_command);
+        } else {
+            ESP_LOGE(TAG, "%s: Incorrect or unsupported function in request (%u), error = (0x%x)",
+                        __FUNCTION__, mb_command, (int)mb_error);
+            mb_error = MB_ENOREG;
         }
+        break;
+    }
+    return mb_error;
+}
+
+// Send custom Modbus request defined as mb_param_request_t structure
+static esp_err_t mbc_serial_master_send_request(void *ctx, mb_param_request_t *request, void *data_ptr)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+    MB_RETURN_ON_FALSE((request), ESP_ERR_INVALID_ARG, TAG, "mb request structure.");
+    MB_RETURN_ON_FALSE((data_ptr), ESP_ERR_INVALID_ARG, TAG, "mb incorrect data pointer.");
+
+    mb_err_enum_t mb_error = MB_EBUSY;
+
+    if (xSemaphoreTake(mbm_opts->mbm_sema, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS)) == pdTRUE) {
+        mb_error = mbc_serial_master_request(ctx, request, data_ptr);
     } else {
         ESP_LOGD(TAG, "%s:MBC semaphore take fail.", __func__);
     }
@@ -271,6 +436,66 @@ static esp_err_t mbc_serial_master_send_request(void *ctx, mb_param_request_t *r
     return MB_ERR_TO_ESP_ERR(mb_error);
 }
 
+// Queue the request for the async task
+static esp_err_t mbc_serial_master_send_request_async(void *ctx, const mb_param_request_t *request, void *data_ptr,
+                                                      mb_request_prio_t prio, mb_request_done_cb_t done_cb, void *cb_arg)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+    MB_RETURN_ON_FALSE((request), ESP_ERR_INVALID_ARG, TAG, "mb request structure.");
+    MB_RETURN_ON_FALSE((data_ptr), ESP_ERR_INVALID_ARG, TAG, "mb incorrect data pointer.");
+    MB_RETURN_ON_FALSE(((unsigned)prio < MB_REQUEST_PRIO_COUNT), ESP_ERR_INVALID_ARG, TAG,
+                       "mb incorrect request priority = (%u).", (unsigned)prio);
+    MB_RETURN_ON_FALSE((mbm_opts->async_task_handle), ESP_ERR_INVALID_STATE, TAG, "mb async task is not created.");
+
+    mbc_async_request_t item = {
+        .request = *request,
+        .data_ptr = data_ptr,
+        .done_cb = done_cb,
+        .cb_arg = cb_arg,
+        .generation = __atomic_load_n(&mbm_opts->async_generation[prio], __ATOMIC_ACQUIRE)
+    };
+    if (xQueueSend(mbm_opts->async_queue[prio], &item, 0) != pdTRUE) {
+        ESP_LOGD(TAG, "%s: async queue %u is full.", __func__, (unsigned)prio);
+        (void)__atomic_add_fetch(&mbm_opts->pool_stats.async_full[prio], 1, __ATOMIC_RELAXED);
+        return ESP_ERR_NO_MEM;
+    }
+    (void)xTaskNotifyGive(mbm_opts->async_task_handle);
+    return ESP_OK;
+}
+
+// Cancel the queued requests of a class and the classes below it: the async task completes them without sending
+static esp_err_t mbc_serial_master_cancel_requests(void *ctx, mb_request_prio_t prio)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+    MB_RETURN_ON_FALSE(((unsigned)prio < MB_REQUEST_PRIO_COUNT), ESP_ERR_INVALID_ARG, TAG,
+                       "mb incorrect request priority = (%u).", (unsigned)prio);
+    MB_RETURN_ON_FALSE((mbm_opts->async_task_handle), ESP_ERR_INVALID_STATE, TAG, "mb async task is not created.");
+    for (int cancel = prio; cancel < MB_REQUEST_PRIO_COUNT; cancel++) {
+        (void)__atomic_add_fetch(&mbm_opts->async_generation[cancel], 1, __ATOMIC_RELEASE);
+    }
+    return ESP_OK;
+}
+
+// Abort the request in progress (expires the respond timer)
+static esp_err_t mbc_serial_master_abort_request(void *ctx)
+{
+    mbm_controller_iface_t *mbm_controller_iface = MB_MASTER_GET_IFACE(ctx);
+    MB_RETURN_ON_FALSE((mbm_controller_iface->mb_base), ESP_ERR_INVALID_STATE, TAG, "mb stack is not created.");
+    bool aborted = mb_port_timer_respond_timeout_abort(MB_BASE2PORT(mbm_controller_iface->mb_base));
+    return aborted ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+// Set the respond timeout used from the next request
+static esp_err_t mbc_serial_master_set_response_time(void *ctx, uint32_t resp_time_ms)
+{
+    mbm_controller_iface_t *mbm_controller_iface = MB_MASTER_GET_IFACE(ctx);
+    MB_RETURN_ON_FALSE((mbm_controller_iface->mb_base), ESP_ERR_INVALID_STATE, TAG, "mb stack is not created.");
+    MB_RETURN_ON_FALSE((resp_time_ms >= MB_MASTER_MIN_TIMEOUT_MS_RESPOND), ESP_ERR_INVALID_ARG, TAG,
+                       "mb respond timeout is too short = (%u).", (unsigned)resp_time_ms);
+    mb_port_timer_set_response_time(MB_BASE2PORT(mbm_controller_iface->mb_base), resp_time_ms);
+    return ESP_OK;
+}
+
 static esp_err_t mbc_serial_master_get_cid_info(void *ctx, uint16_t cid, const mb_parameter_descriptor_t **param_buffer)
 {
     mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
@@ -321,6 +546,70 @@ static esp_err_t mbc_serial_master_set_request(void *ctx, uint16_t cid, mb_param
     return error;
 }
 
+// Take a zeroed data buffer for a parameter request: from the pool (no heap on the request path)
+// or from the heap when the static pool is disabled
+static uint8_t *mbc_serial_master_buf_alloc(void *ctx, size_t size)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+#if CONFIG_FMB_STATIC_POOL
+    uint8_t index = 0;
+    if (size > CONFIG_FMB_MASTER_POOL_BUFFER_SIZE) {
+        ESP_LOGE(TAG, "%s: parameter of %u bytes does not fit the pool buffers.", __func__, (unsigned)size);
+        (void)__atomic_add_fetch(&mbm_opts->pool_stats.buffer_failures, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    if (xQueueReceive(mbm_opts->pool_free, &index, 0) != pdTRUE) {
+        (void)__atomic_add_fetch(&mbm_opts->pool_stats.buffer_waits, 1, __ATOMIC_RELAXED);
+        if (xQueueReceive(mbm_opts->pool_free, &index, pdMS_TO_TICKS(MB_MAX_RESP_DELAY_MS)) != pdTRUE) {
+            ESP_LOGD(TAG, "%s: parameter buffer pool is exhausted.", __func__);
+            (void)__atomic_add_fetch(&mbm_opts->pool_stats.buffer_failures, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    }
+    uint16_t used = (uint16_t)(CONFIG_FMB_MASTER_POOL_BUFFERS - uxQueueMessagesWaiting(mbm_opts->pool_free));
+    uint16_t max_used = __atomic_load_n(&mbm_opts->pool_stats.buffers_max_used, __ATOMIC_RELAXED);
+    while ((used > max_used) &&
+           !__atomic_compare_exchange_n(&mbm_opts->pool_stats.buffers_max_used, &max_used, used,
+                                        false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    uint8_t *buf = mbm_opts->pool_arena + ((size_t)index * CONFIG_FMB_MASTER_POOL_BUFFER_SIZE);
+    memset(buf, 0, size);
+    return buf;
+#else
+    (void)mbm_opts;
+    MB_MASTER_ASSERT(xPortGetFreeHeapSize() > size);
+    return calloc(1, size);
+#endif
+}
+
+// Release the data buffer of a parameter request
+static void mbc_serial_master_buf_free(void *ctx, uint8_t *buf)
+{
+#if CONFIG_FMB_STATIC_POOL
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+    uint8_t index = (uint8_t)((buf - mbm_opts->pool_arena) / CONFIG_FMB_MASTER_POOL_BUFFER_SIZE);
+    MB_MASTER_ASSERT(index < CONFIG_FMB_MASTER_POOL_BUFFERS);
+    (void)xQueueSend(mbm_opts->pool_free, &index, 0);
+#else
+    free(buf);
+#endif
+}
+
+// Get the counters of the pools (parameter buffers and asynchronous queue slots)
+static esp_err_t mbc_serial_master_get_pool_stats(void *ctx, mb_pool_stats_t *stats)
+{
+    mb_master_options_t *mbm_opts = MB_MASTER_GET_OPTS(ctx);
+    MB_RETURN_ON_FALSE((stats), ESP_ERR_INVALID_ARG, TAG, "mb incorrect stats pointer.");
+    stats->buffers = mbm_opts->pool_stats.buffers;
+    stats->buffers_max_used = __atomic_load_n(&mbm_opts->pool_stats.buffers_max_used, __ATOMIC_RELAXED);
+    stats->buffer_waits = __atomic_load_n(&mbm_opts->pool_stats.buffer_waits, __ATOMIC_RELAXED);
+    stats->buffer_failures = __atomic_load_n(&mbm_opts->pool_stats.buffer_failures, __ATOMIC_RELAXED);
+    for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        stats->async_full[prio] = __atomic_load_n(&mbm_opts->pool_stats.async_full[prio], __ATOMIC_RELAXED);
+    }
+    return ESP_OK;
+}
+
 // Get parameter data for corresponding characteristic
 static esp_err_t mbc_serial_master_get_parameter(void *ctx, uint16_t cid, uint8_t *value, uint8_t *type)
 {
@@ -333,9 +622,8 @@ static esp_err_t mbc_serial_master_get_parameter(void *ctx, uint16_t cid, uint8_
 
     error = mbc_serial_master_set_request(ctx, cid, MB_PARAM_READ, &request, &reg_info);
     if ((error == ESP_OK) && (cid == reg_info.cid) && (request.slave_addr != MB_SLAVE_ADDR_PLACEHOLDER)) {
-        MB_MASTER_ASSERT(xPortGetFreeHeapSize() > (reg_info.mb_size << 1));
         // alloc buffer to store parameter data
-        data_ptr = calloc(1, (reg_info.mb_size << 1));
+        data_ptr = mbc_serial_master_buf_alloc(ctx, (reg_info.mb_size << 1));
         if (!data_ptr) {
             return ESP_ERR_INVALID_STATE;
         }
@@ -357,7 +645,7 @@ static esp_err_t mbc_serial_master_get_parameter(void *ctx, uint16_t cid, uint8_
             ESP_LOGD(TAG, "%s: Bad response to get cid(%u) = %s",
                         __FUNCTION__, (unsigned)reg_info.cid, (char *)esp_err_to_name(error));
         }
-        free(data_ptr);
+        mbc_serial_master_buf_free(ctx, data_ptr);
         // Set the type of parameter found in the table
         *type = reg_info.param_type;
     } else {
@@ -387,9 +675,8 @@ static esp_err_t mbc_serial_master_get_parameter_with(void *ctx, uint16_t cid, u
                      __FUNCTION__, (int)request.slave_addr, (int)uid, (unsigned)reg_info.cid);
         }
         request.slave_addr = uid; // override the UID
-        MB_MASTER_ASSERT(xPortGetFreeHeapSize() > (reg_info.mb_size << 1));
         // alloc buffer to store parameter data
-        data_ptr = calloc(1, (reg_info.mb_size << 1));
+        data_ptr = mbc_serial_master_buf_alloc(ctx, (reg_info.mb_size << 1));
         if (!data_ptr) {
             return ESP_ERR_INVALID_STATE;
         }
@@ -415,7 +702,7 @@ static esp_err_t mbc_serial_master_get_parameter_with(void *ctx, uint16_t cid, u
             ESP_LOGD(TAG, "%s: Bad response to get cid(%u) = %s",
                      __FUNCTION__, (unsigned)reg_info.cid, (char *)esp_err_to_name(error));
         }
-        free(data_ptr);
+        mbc_serial_master_buf_free(ctx, data_ptr);
         // Set the type of parameter found in the table
         *type = reg_info.param_type;
     }
@@ -440,8 +727,7 @@ static esp_err_t mbc_serial_master_set_parameter(void *ctx, uint16_t cid, uint8_
 
     error = mbc_serial_master_set_request(ctx, cid, MB_PARAM_WRITE, &request, &reg_info);
     if ((error == ESP_OK) && (cid == reg_info.cid) && (request.slave_addr != MB_SLAVE_ADDR_PLACEHOLDER)) {
-        MB_MASTER_ASSERT(xPortGetFreeHeapSize() > (reg_info.mb_size << 1));
-        data_ptr = calloc(1, (reg_info.mb_size << 1)); // alloc parameter buffer
+        data_ptr = mbc_serial_master_buf_alloc(ctx, (reg_info.mb_size << 1)); // alloc parameter buffer
         if (!data_ptr) {
             return ESP_ERR_INVALID_STATE;
         }
@@ -450,7 +736,7 @@ static esp_err_t mbc_serial_master_set_parameter(void *ctx, uint16_t cid, uint8_
                                               reg_info.param_type, reg_info.param_size);
         if (error != ESP_OK) {
             ESP_LOGE(TAG, "fail to set parameter data.");
-            free(data_ptr);
+            mbc_serial_master_buf_free(ctx, data_ptr);
             return ESP_ERR_INVALID_STATE;
         }
         // Send request to write characteristic data
@@ -462,7 +748,7 @@ static esp_err_t mbc_serial_master_set_parameter(void *ctx, uint16_t cid, uint8_
             ESP_LOGD(TAG, "%s: Bad response to set cid(%u) = %s",
                                     __FUNCTION__, (unsigned)reg_info.cid, (char *)esp_err_to_name(error));
         }
-        free(data_ptr);
+        mbc_serial_master_buf_free(ctx, data_ptr);
         // Set the type of parameter found in the table
         *type = reg_info.param_type;
     } else {
@@ -492,8 +778,7 @@ static esp_err_t mbc_serial_master_set_parameter_with(void *ctx, uint16_t cid, u
                      __FUNCTION__, (int)request.slave_addr, (int)uid, (unsigned)reg_info.cid);
         }
         request.slave_addr = uid; // override the UID
-        MB_MASTER_ASSERT(xPortGetFreeHeapSize() > (reg_info.mb_size << 1));
-        data_ptr = calloc(1, (reg_info.mb_size << 1)); // alloc parameter buffer
+        data_ptr = mbc_serial_master_buf_alloc(ctx, (reg_info.mb_size << 1)); // alloc parameter buffer
         if (!data_ptr) {
             return ESP_ERR_INVALID_STATE;
         }
@@ -502,7 +787,7 @@ static esp_err_t mbc_serial_master_set_parameter_with(void *ctx, uint16_t cid, u
                                               reg_info.param_type, reg_info.param_size);
         if (error != ESP_OK) {
             ESP_LOGE(TAG, "fail to set parameter data.");
-            free(data_ptr);
+            mbc_serial_master_buf_free(ctx, data_ptr);
             return ESP_ERR_INVALID_STATE;
         }
         // Send request to write characteristic data
@@ -517,7 +802,7 @@ static esp_err_t mbc_serial_master_set_parameter_with(void *ctx, uint16_t cid, u
             ESP_LOGD(TAG, "%s: Bad response to set cid(%u) = %s",
                      __FUNCTION__, (unsigned)reg_info.cid, (char *)esp_err_to_name(error));
         }
-        free(data_ptr);
+        mbc_serial_master_buf_free(ctx, data_ptr);
         // Set the type of parameter found in the table
         *type = reg_info.param_type;
     }
@@ -540,11 +825,25 @@ static void mbc_serial_master_iface_free(void *ctx)
             vTaskDelete(mbm_iface->opts.task_handle);
             mbm_iface->opts.task_handle = NULL;
         }
+        if (mbm_iface->opts.async_task_handle)
+        {
+            vTaskDelete(mbm_iface->opts.async_task_handle);
+            mbm_iface->opts.async_task_handle = NULL;
+        }
+        for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++)
+        {
+            if (mbm_iface->opts.async_queue[prio])
+            {
+                vQueueDelete(mbm_iface->opts.async_queue[prio]);
+                mbm_iface->opts.async_queue[prio] = NULL;
+            }
+        }
         if (mbm_iface->opts.event_group_handle)
         {
             vEventGroupDelete(mbm_iface->opts.event_group_handle);
             mbm_iface->opts.event_group_handle = NULL;
         }
+        mbc_serial_master_pool_delete(&mbm_iface->opts);
         free(mbm_iface); // free the memory allocated for interface
     }   
 }
@@ -565,6 +864,17 @@ static esp_err_t mbc_serial_master_controller_create(void **ctx)
     // Initialize interface properties
     mb_master_options_t *mbm_opts = &mbm_controller_iface->opts;
     mbm_opts->task_handle = NULL;
+    mbm_opts->async_task_handle = NULL;
+    mbm_opts->async_exit_sema = NULL;
+    for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        mbm_opts->async_queue[prio] = NULL;
+        mbm_opts->async_generation[prio] = 0;
+    }
+    memset(&mbm_opts->pool_stats, 0, sizeof(mbm_opts->pool_stats));
+#if CONFIG_FMB_STATIC_POOL
+    mbm_opts->pool_arena = NULL;
+    mbm_opts->pool_free = NULL;
+#endif
 
     // Initialization of active context of the modbus controller
     mbm_opts->event_group_handle = xEventGroupCreate();
@@ -585,6 +895,34 @@ static esp_err_t mbc_serial_master_controller_create(void **ctx)
                      "mb controller task creation error");
     MB_MASTER_ASSERT(mbm_opts->task_handle); // The task is created but handle is incorrect
 
+    // Queues (one per priority class) and task of the asynchronous requests
+    for (int prio = 0; prio < MB_REQUEST_PRIO_COUNT; prio++) {
+        mbm_opts->async_queue[prio] = xQueueCreate(CONFIG_FMB_MASTER_ASYNC_QUEUE_SIZE, sizeof(mbc_async_request_t));
+        MB_GOTO_ON_FALSE((mbm_opts->async_queue[prio]), ESP_ERR_NO_MEM, error, TAG, "mb async queue create error.");
+    }
+    status = xTaskCreatePinnedToCore((void *)&mbc_ser_master_async_task,
+                                     "mbc_ser_async",
+                                     MB_CONTROLLER_STACK_SIZE,
+                                     mbm_controller_iface,
+                                     MB_CONTROLLER_PRIORITY,
+                                     &mbm_opts->async_task_handle,
+                                     MB_PORT_TASK_AFFINITY);
+    MB_GOTO_ON_FALSE((status == pdPASS), ESP_ERR_INVALID_STATE, error, TAG,
+                     "mb controller async task creation error");
+
+#if CONFIG_FMB_STATIC_POOL
+    // Parameter buffer pool: allocated once here, the request path only takes and returns indexes
+    mbm_opts->pool_arena = heap_caps_malloc((size_t)CONFIG_FMB_MASTER_POOL_BUFFERS * CONFIG_FMB_MASTER_POOL_BUFFER_SIZE,
+                                            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    MB_GOTO_ON_FALSE((mbm_opts->pool_arena), ESP_ERR_NO_MEM, error, TAG, "mb parameter buffer pool alloc error.");
+    mbm_opts->pool_free = xQueueCreate(CONFIG_FMB_MASTER_POOL_BUFFERS, sizeof(uint8_t));
+    MB_GOTO_ON_FALSE((mbm_opts->pool_free), ESP_ERR_NO_MEM, error, TAG, "mb parameter buffer pool queue error.");
+    for (uint8_t index = 0; index < CONFIG_FMB_MASTER_POOL_BUFFERS; index++) {
+        (void)xQueueSend(mbm_opts->pool_free, &index, 0);
+    }
+    mbm_opts->pool_stats.buffers = CONFIG_FMB_MASTER_POOL_BUFFERS;
+#endif
+
     // Initialize public interface methods of the interface
     mbm_controller_iface->create = mbc_serial_master_create;
     mbm_controller_iface->delete = mbc_serial_master_delete;
@@ -597,6 +935,11 @@ static esp_err_t mbc_serial_master_controller_create(void **ctx)
     mbm_controller_iface->set_descriptor = mbc_serial_master_set_descriptor;
     mbm_controller_iface->set_parameter = mbc_serial_master_set_parameter;
     mbm_controller_iface->set_parameter_with = mbc_serial_master_set_parameter_with;
+    mbm_controller_iface->abort_request = mbc_serial_master_abort_request;
+    mbm_controller_iface->set_response_time = mbc_serial_master_set_response_time;
+    mbm_controller_iface->send_request_async = mbc_serial_master_send_request_async;
+    mbm_controller_iface->cancel_requests = mbc_serial_master_cancel_requests;
+    mbm_controller_iface->get_pool_stats = mbc_serial_master_get_pool_stats;
     mbm_controller_iface->mb_base = NULL;
     *ctx = mbm_controller_iface;
     return ESP_OK;
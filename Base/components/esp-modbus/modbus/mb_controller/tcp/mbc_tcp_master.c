@@ -621,6 +621,11 @@ esp_err_t mbc_tcp_master_controller_create(void ** ctx)
     mbm_controller_iface->set_descriptor = mbc_tcp_master_set_descriptor;
     mbm_controller_iface->set_parameter = mbc_tcp_master_set_parameter;
     mbm_controller_iface->set_parameter_with = mbc_tcp_master_set_parameter_with;
+    mbm_controller_iface->abort_request = NULL;
+    mbm_controller_iface->set_response_time = NULL;
+    mbm_controller_iface->send_request_async = NULL;
+    mbm_controller_iface->cancel_requests = NULL;
+    mbm_controller_iface->get_pool_stats = NULL;
 
     *ctx = mbm_controller_iface;
     return ESP_OK;
@@ -63,6 +63,14 @@ extern "C" {
 #define MB_PORT_SERIAL_ISR_FLAG                 (ESP_INTR_FLAG_LOWMED)
 #endif
 
+/*! \brief Heap capabilities for objects accessed from the timer ISR path.
+ *
+ * With the ISR dispatch method the timer callback runs while the flash cache may be
+ * disabled (NVS commits), so the port, timer, event and transport objects it touches
+ * must live in internal DRAM even if PSRAM is added to the heap.
+ */
+#define MB_PORT_ISR_MEM_CAPS                    (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
 /*! \brief The option represents the serial buffer size for RTU and ASCI.
  */
 #define MB_BUFFER_SIZE                          (CONFIG_FMB_BUFFER_SIZE)
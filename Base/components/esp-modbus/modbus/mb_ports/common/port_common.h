@@ -25,6 +25,7 @@ extern "C" {
 #define MB_SER_PDU_SIZE_MIN             (3)
 #define MB_TIMER_TICS_PER_MS            (20UL)                         // Define number of timer reloads per 1 mS
 #define MB_TIMER_TICK_TIME_US           (1000 / MB_TIMER_TICS_PER_MS) // 50uS = one discreet for timer
+#define MB_PORT_TIMER_ABORT_US          (MB_TIMER_TICK_TIME_US)        // Respond timeout used to abort the request
 #define MB_EVENT_QUEUE_TIMEOUT_MAX_MS   (3000)
 #define MB_EVENT_QUEUE_TIMEOUT          (pdMS_TO_TICKS(CONFIG_FMB_EVENT_QUEUE_TIMEOUT))
 #define MB_EVENT_QUEUE_TIMEOUT_MAX      (pdMS_TO_TICKS(MB_EVENT_QUEUE_TIMEOUT_MAX_MS))
@@ -178,6 +179,8 @@ void mb_port_timer_disable(mb_port_base_t *inst);
 void mb_port_timer_enable(mb_port_base_t *inst);
 void mb_port_timer_respond_timeout_enable(mb_port_base_t *inst);
 void mb_port_timer_convert_delay_enable(mb_port_base_t *inst);
+bool mb_port_timer_respond_timeout_abort(mb_port_base_t *inst);
+void mb_port_timer_abort_clear(mb_port_base_t *inst);
 void mb_port_set_cur_timer_mode(mb_port_base_t *inst, mb_timer_mode_enum_t tmr_mode);
 mb_timer_mode_enum_t mb_port_get_cur_timer_mode(mb_port_base_t *inst);
 void mb_port_timer_set_response_time(mb_port_base_t *inst, uint32_t resp_time_ms);
@@ -9,6 +9,7 @@
 #include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "sdkconfig.h"
 
 #include "port_common.h"
@@ -23,6 +24,13 @@ struct mb_port_event_t
     EventGroupHandle_t event_group_hdl;
     QueueHandle_t event_hdl;
     _Atomic(uint64_t) curr_trans_id;
+#if CONFIG_FMB_STATIC_POOL
+    // Storage of the FreeRTOS objects, allocated with the event object
+    StaticSemaphore_t resource_buf;
+    StaticEventGroup_t event_group_buf;
+    StaticQueue_t event_queue_buf;
+    uint8_t event_queue_storage[MB_EVENT_QUEUE_SIZE * sizeof(mb_event_t)];
+#endif
 };
 
 mb_err_enum_t mb_port_event_create(mb_port_base_t *inst)
@@ -30,16 +38,29 @@ mb_err_enum_t mb_port_event_create(mb_port_base_t *inst)
     mb_port_event_t *event_obj = NULL;
     mb_err_enum_t ret = MB_EILLSTATE;
     MB_RETURN_ON_FALSE((inst), MB_EILLSTATE, TAG, "mb event creation error.");
-    event_obj = (mb_port_event_t *)calloc(1, sizeof(mb_port_event_t));
+    event_obj = (mb_port_event_t *)heap_caps_calloc(1, sizeof(mb_port_event_t), MB_PORT_ISR_MEM_CAPS);
     MB_RETURN_ON_FALSE((event_obj), MB_EILLSTATE, TAG, "mb event creation error.");
     // Create modbus semaphore (mb resource).
+#if CONFIG_FMB_STATIC_POOL
+    event_obj->resource_hdl = xSemaphoreCreateBinaryStatic(&event_obj->resource_buf);
+#else
     event_obj->resource_hdl = xSemaphoreCreateBinary();
+#endif
     MB_GOTO_ON_FALSE((event_obj->resource_hdl), MB_EILLSTATE, error, TAG,
                             "%s, mb resource create failure.", inst->descr.parent_name);
+#if CONFIG_FMB_STATIC_POOL
+    event_obj->event_group_hdl = xEventGroupCreateStatic(&event_obj->event_group_buf);
+#else
     event_obj->event_group_hdl = xEventGroupCreate();
+#endif
     MB_GOTO_ON_FALSE((event_obj->event_group_hdl), MB_EILLSTATE, error, TAG,
                         "%s, event group create error.", inst->descr.parent_name);
+#if CONFIG_FMB_STATIC_POOL
+    event_obj->event_hdl = xQueueCreateStatic(MB_EVENT_QUEUE_SIZE, sizeof(mb_event_t),
+                                              event_obj->event_queue_storage, &event_obj->event_queue_buf);
+#else
     event_obj->event_hdl = xQueueCreate(MB_EVENT_QUEUE_SIZE, sizeof(mb_event_t));
+#endif
     MB_GOTO_ON_FALSE((event_obj->event_hdl), MB_EILLSTATE, error,  TAG, "%s, event queue create error.", inst->descr.parent_name);
     vQueueAddToRegistry(event_obj->event_hdl, TAG);
     inst->event_obj = event_obj;
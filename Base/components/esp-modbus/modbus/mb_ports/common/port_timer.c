@@ -11,6 +11,7 @@
 
 #include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 
 #include "port_common.h"
 #include "mb_types.h"
@@ -26,6 +27,7 @@ struct mb_port_timer_t
     _Atomic(uint32_t) response_time_ms;
     _Atomic(bool) timer_state;
     _Atomic(uint16_t) timer_mode;
+    _Atomic(bool) abort_req;
 };
 
 /* ----------------------- Static variables ---------------------------------*/
@@ -41,7 +43,7 @@ static void IRAM_ATTR timer_alarm_cb(void *param)
         inst->cb.tmr_expired(inst->arg); // Timer expired callback function
     }
     atomic_store(&(inst->timer_obj->timer_state), true);
-    ESP_EARLY_LOGD(TAG, "timer mode: (%d) triggered", mb_port_get_cur_timer_mode(inst));
+    ESP_DRAM_LOGD(DRAM_STR("mb_port.timer"), "timer mode: (%d) triggered", mb_port_get_cur_timer_mode(inst));
 }
 
 mb_err_enum_t mb_port_timer_create(mb_port_base_t *inst, uint16_t t35_timer_ticks)
@@ -51,11 +53,12 @@ mb_err_enum_t mb_port_timer_create(mb_port_base_t *inst, uint16_t t35_timer_tick
     // MB_RETURN_ON_FALSE((inst && !inst->timer_obj), MB_EILLSTATE, TAG,
     //                    "modbus timer is already created.");
     mb_err_enum_t ret = MB_EILLSTATE;
-    inst->timer_obj = (mb_port_timer_t *)calloc(1, sizeof(mb_port_timer_t));
+    inst->timer_obj = (mb_port_timer_t *)heap_caps_calloc(1, sizeof(mb_port_timer_t), MB_PORT_ISR_MEM_CAPS);
     MB_GOTO_ON_FALSE((inst && inst->timer_obj), MB_EILLSTATE, error, TAG, "mb timer allocation error.");
     inst->timer_obj->timer_handle = NULL;
     atomic_init(&(inst->timer_obj->timer_mode), MB_TMODE_T35);
     atomic_init(&(inst->timer_obj->timer_state), false);
+    atomic_init(&(inst->timer_obj->abort_req), false);
     // Set default response time according to kconfig
     atomic_init(&(inst->timer_obj->response_time_ms), MB_MASTER_TIMEOUT_MS_RESPOND);
     // Save timer reload value for Modbus T35 period
@@ -148,11 +151,36 @@ void mb_port_timer_respond_timeout_enable(mb_port_base_t *inst)
     uint64_t tout_us = (inst->timer_obj->response_time_ms * 1000);
 
     mb_port_set_cur_timer_mode(inst, MB_TMODE_RESPOND_TIMEOUT);
+    // The abort was requested while the frame was being sent, expire the respond timer at once
+    if (atomic_exchange(&(inst->timer_obj->abort_req), false)) {
+        tout_us = MB_PORT_TIMER_ABORT_US;
+    }
     ESP_LOGD(TAG, "%s, respond enable timeout (%u).", 
                 inst->descr.parent_name, (unsigned)mb_port_timer_get_response_time_ms(inst));
     mb_port_timer_us(inst, tout_us);
 }
 
+bool mb_port_timer_respond_timeout_abort(mb_port_base_t *inst)
+{
+    MB_RETURN_ON_FALSE((inst && inst->timer_obj), false, TAG, "timer is not initialized.");
+    // Leave the request for the respond timer if the frame is not sent yet
+    atomic_store(&(inst->timer_obj->abort_req), true);
+    if ((mb_port_get_cur_timer_mode(inst) == MB_TMODE_RESPOND_TIMEOUT)
+            && esp_timer_is_active(inst->timer_obj->timer_handle)
+            && atomic_exchange(&(inst->timer_obj->abort_req), false)) {
+        // Waiting for the response: the transaction completes with the respond timeout error
+        mb_port_timer_us(inst, MB_PORT_TIMER_ABORT_US);
+        ESP_LOGD(TAG, "%s, respond timeout aborted.", inst->descr.parent_name);
+        return true;
+    }
+    return false;
+}
+
+void mb_port_timer_abort_clear(mb_port_base_t *inst)
+{
+    atomic_store(&(inst->timer_obj->abort_req), false);
+}
+
 void mb_port_timer_delay(mb_port_base_t *inst, uint16_t timeout_ms)
 {
     uint64_t tout_us = (timeout_ms * 1000);
@@ -167,7 +195,7 @@ void mb_port_timer_disable(mb_port_base_t *inst)
     {
         if (!esp_timer_is_active(inst->timer_obj->timer_handle))
         {
-            ESP_EARLY_LOGD(TAG, "%s, timer stop, returns %d.", inst->descr.parent_name, (int)err);
+            ESP_DRAM_LOGD(DRAM_STR("mb_port.timer"), "%s, timer stop, returns %d.", inst->descr.parent_name, (int)err);
         }
     }
 }
@@ -5,6 +5,7 @@
  */
 #include <stdatomic.h>
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "mb_common.h"
 #include "port_common.h"
 #include "mb_config.h"
@@ -209,7 +210,7 @@ mb_err_enum_t mb_port_ser_create(mb_serial_opts_t *ser_opts, mb_port_base_t **in
     mb_ser_port_t *ser_port = NULL;
     esp_err_t err = ESP_OK;
     __attribute__((unused)) mb_err_enum_t ret = MB_EILLSTATE;
-    ser_port = (mb_ser_port_t*)calloc(1, sizeof(mb_ser_port_t));
+    ser_port = (mb_ser_port_t*)heap_caps_calloc(1, sizeof(mb_ser_port_t), MB_PORT_ISR_MEM_CAPS);
     MB_GOTO_ON_FALSE((ser_port && in_out_obj), MB_EILLSTATE, error, TAG, "mb serial port creation error.");
 
     CRITICAL_SECTION_INIT(ser_port->base.lock);
@@ -3,6 +3,8 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "rtu_transport.h"
 #include "port_serial_common.h"
 #include "port_common.h"
@@ -49,7 +51,7 @@ mb_err_enum_t mbm_rtu_transp_create(mb_serial_opts_t *ser_opts, void **in_out_in
     mb_err_enum_t ret = MB_ENOERR;
     mbm_rtu_transp_t *transp = NULL;
     mb_port_base_t *port_obj = NULL;
-    transp = (mbm_rtu_transp_t *)calloc(1, sizeof(mbm_rtu_transp_t));
+    transp = (mbm_rtu_transp_t *)heap_caps_calloc(1, sizeof(mbm_rtu_transp_t), MB_PORT_ISR_MEM_CAPS);
     MB_GOTO_ON_FALSE(transp, MB_EILLSTATE, error, TAG, "no mem for %s instance.", TAG);
     CRITICAL_SECTION_INIT(transp->base.lock);
     CRITICAL_SECTION_LOCK(transp->base.lock);
@@ -254,13 +256,13 @@ static bool mbm_rtu_transp_timer_expired(void *inst)
         case MB_TMODE_RESPOND_TIMEOUT:
             mb_port_event_set_err_type(transp->base.port_obj, EV_ERROR_RESPOND_TIMEOUT);
             need_poll = mb_port_event_post(transp->base.port_obj, EVENT(EV_ERROR_PROCESS));
-            ESP_EARLY_LOGD(TAG, "%p:EV_ERROR_RESPOND_TIMEOUT", transp->base.descr.parent);
+            ESP_DRAM_LOGD(DRAM_STR("mb_transp.rtu_master"), "%p:EV_ERROR_RESPOND_TIMEOUT", transp->base.descr.parent);
             break;
 
         case MB_TMODE_CONVERT_DELAY:
             /* If timer mode is convert delay, the master event then turns EV_MASTER_EXECUTE status. */
             need_poll = mb_port_event_post(transp->base.port_obj, EVENT(EV_EXECUTE));
-            ESP_EARLY_LOGD(TAG, "%p:MB_TMODE_CONVERT_DELAY", transp->base.descr.parent);
+            ESP_DRAM_LOGD(DRAM_STR("mb_transp.rtu_master"), "%p:MB_TMODE_CONVERT_DELAY", transp->base.descr.parent);
             break;
             
         default:
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+Prueba de humo del ejecutable de host de Base (destino linux)
+
+Arranca sala_maquinas.elf en un directorio temporal, hace de Consola por el
+pseudo-terminal y comprueba una transición de seguridad:
+
+  1. Con SYNC cada 100 ms y los dos ventiladores pedidos, algún relé de
+     base_gpio_out.txt pasa a 1.
+  2. Sin SYNC, el watchdog de comunicación dispara (log "WATCHDOG TIMEOUT")
+     y todos los relés de base_gpio_out.txt vuelven a 0 en menos de
+     WATCHDOG_MS + MARGIN_MS, y siguen a 0 (el escalonado de los
+     ventiladores no los vuelve a encender).
+
+Uso:
+  python3 host_test/watchdog_smoke.py [build_linux/sala_maquinas.elf]
+
+Sale con 0 si pasa y con 1 (y el log de Base) si falla.
+"""
+
+import os
+import re
+import select
+import subprocess
+import sys
+import tempfile
+import termios
+import threading
+import time
+import tty
+
+SYNC_PERIOD_S = 0.1          # CM_LINK_SYNC_INTERVAL_MS
+WATCHDOG_MS = 1000           # CONFIG_BASE_COMM_WATCHDOG_TIMEOUT_MS por defecto
+MARGIN_MS = 500              # Despacho de esp_timer + volcado de hal_gpio (10 ms)
+BOOT_TIMEOUT_S = 10.0        # Hasta el log con la ruta del pseudo-terminal
+RELAYS_ON_TIMEOUT_S = 3.0    # Con SYNC: hasta ver algún relé a 1
+HOLD_OFF_S = 0.5             # Tras el corte, sin SYNC, ningún relé vuelve a 1
+
+LIMIT_SWITCH_PIN = 21        # INCLINE_LIMIT_SWITCH_PIN: a 0, el homing termina al momento
+ESTOP_PIN = 23               # CONFIG_BASE_ESTOP_GPIO: a 0, seta en reposo (contacto NC cerrado)
+
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+PTY_LOG = re.compile(r"Enlace con la Consola en (/dev/\S+)")
+
+
+class BaseProcess:
+    """sala_maquinas.elf con el log recogido en segundo plano"""
+
+    def __init__(self, elf, workdir):
+        env = dict(os.environ,
+                   BASE_HAL_GPIO_IN=os.path.join(workdir, "base_gpio_in.txt"),
+                   BASE_HAL_GPIO_OUT=os.path.join(workdir, "base_gpio_out.txt"))
+        self.proc = subprocess.Popen([os.path.abspath(elf)], cwd=workdir, env=env,
+                                     stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        self.lines = []
+        self.lock = threading.Lock()
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        for raw in self.proc.stdout:
+            with self.lock:
+                self.lines.append(ANSI.sub("", raw.decode(errors="replace")).rstrip())
+
+    def wait_log(self, pattern, timeout_s, start=0):
+        """Primer match de pattern en el log (desde la línea start) o None"""
+        deadline = time.monotonic() + timeout_s
+        while time.monotonic() < deadline:
+            with self.lock:
+                for line in self.lines[start:]:
+                    m = re.search(pattern, line)
+                    if m:
+                        return m
+            if self.proc.poll() is not None:
+                return None
+            time.sleep(0.01)
+        return None
+
+    def log_len(self):
+        with self.lock:
+            return len(self.lines)
+
+    def dump_log(self):
+        with self.lock:
+            return "\n".join(self.lines)
+
+    def stop(self):
+        self.proc.terminate()
+        try:
+            self.proc.wait(timeout=2)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+
+
+def read_relays(path):
+    """{pin: nivel} de base_gpio_out.txt ({} si aún no existe)"""
+    relays = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                pin, _, level = line.strip().partition("=")
+                if pin and level:
+                    relays[int(pin)] = int(level)
+    except (FileNotFoundError, ValueError):
+        pass
+    return relays
+
+
+def sync_line():
+    # SYNC=speed,incline,fan_head,fan_chest,wax,training_mode,ramp_mode,profile_id,
+    #      tx_us,clock_offset_us,clock_valid (cm_schema.h)
+    tx_us = int(time.monotonic() * 1e6)
+    return ("SYNC=0.00,0.00,1,1,0,0,0,0,%d,0,0\n" % tx_us).encode()
+
+
+def drain(fd):
+    """Descarta las respuestas DATA para no llenar el pseudo-terminal"""
+    while select.select([fd], [], [], 0)[0]:
+        if not os.read(fd, 4096):
+            break
+
+
+def run(elf):
+    workdir = tempfile.mkdtemp(prefix="base_smoke_")
+    with open(os.path.join(workdir, "base_gpio_in.txt"), "w") as f:
+        f.write("%d=0\n%d=0\n" % (LIMIT_SWITCH_PIN, ESTOP_PIN))
+    out_path = os.path.join(workdir, "base_gpio_out.txt")
+
+    base = BaseProcess(elf, workdir)
+    try:
+        m = base.wait_log(PTY_LOG.pattern, BOOT_TIMEOUT_S)
+        if m is None:
+            return "Base no publicó la ruta del pseudo-terminal", base
+        fd = os.open(m.group(1), os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(fd)
+        termios.tcflush(fd, termios.TCIOFLUSH)
+
+        # 1. Con SYNC: los ventiladores encienden sus relés
+        deadline = time.monotonic() + RELAYS_ON_TIMEOUT_S
+        while True:
+            os.write(fd, sync_line())
+            drain(fd)
+            relays = read_relays(out_path)
+            if any(relays.values()):
+                break
+            if time.monotonic() > deadline:
+                return "Ningún relé a 1 con SYNC y ventiladores pedidos: %s" % relays, base
+            time.sleep(SYNC_PERIOD_S)
+        print("SYNC: relés %s" % relays)
+
+        # 2. Sin SYNC: watchdog y todos los relés a 0
+        log_start = base.log_len()
+        silence_start = time.monotonic()
+        deadline = silence_start + (WATCHDOG_MS + MARGIN_MS) / 1000.0
+        while True:
+            drain(fd)
+            relays = read_relays(out_path)
+            if relays and not any(relays.values()):
+                break
+            if time.monotonic() > deadline:
+                return "Relés sin cortar %d ms después del último SYNC: %s" % (
+                    WATCHDOG_MS + MARGIN_MS, relays), base
+            time.sleep(0.01)
+        cut_ms = (time.monotonic() - silence_start) * 1000.0
+        if base.wait_log(r"WATCHDOG TIMEOUT", 1.0, log_start) is None:
+            return "Relés a 0 pero sin log del watchdog", base
+        hold_end = time.monotonic() + HOLD_OFF_S
+        while time.monotonic() < hold_end:
+            drain(fd)
+            relays = read_relays(out_path)
+            if any(relays.values()):
+                return "Relés de nuevo a 1 tras el watchdog: %s" % relays, base
+            time.sleep(0.01)
+        print("Watchdog: relés %s a los %.0f ms sin SYNC" % (relays, cut_ms))
+        os.close(fd)
+        return None, base
+    finally:
+        base.stop()
+
+
+def main():
+    elf = sys.argv[1] if len(sys.argv) > 1 else "build_linux/sala_maquinas.elf"
+    if not os.path.isfile(elf):
+        print("No existe %s (compilar antes el destino linux)" % elf)
+        return 1
+    error, base = run(elf)
+    if error:
+        print("FALLO: %s\n--- log de Base ---\n%s" % (error, base.dump_log()))
+        return 1
+    print("OK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,316 @@
+/**
+ * @file actuators.c
+ * @brief Implementación de la capa de relés (ver actuators.h)
+ */
+
+#include "actuators.h"
+#include "persist.h"
+#include "base_hal.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "ACTUATORS";
+
+// ============================================================================
+// ASIGNACIÓN DE PINES (v6)
+// ============================================================================
+
+/** Indexada por act_relay_t (en DRAM: la leen las ISR) */
+static DRAM_ATTR const uint8_t k_relay_pins[ACT_RELAY_COUNT] = {
+    [ACT_RELAY_CHEST_FAN_SPEED] = 13,
+    [ACT_RELAY_CHEST_FAN_ON]    = 14,
+    [ACT_RELAY_WAX_PUMP]        = 25,
+    [ACT_RELAY_INCLINE_ON]      = 33,
+    [ACT_RELAY_INCLINE_DOWN]    = 32,
+    [ACT_RELAY_HEAD_FAN_ON]     = 26,
+    [ACT_RELAY_HEAD_FAN_SPEED]  = 27,
+};
+
+static const char *const k_relay_names[ACT_RELAY_COUNT] = {
+    [ACT_RELAY_CHEST_FAN_SPEED] = "pecho_sel",
+    [ACT_RELAY_CHEST_FAN_ON]    = "pecho_on",
+    [ACT_RELAY_WAX_PUMP]        = "cera",
+    [ACT_RELAY_INCLINE_ON]      = "incl_on",
+    [ACT_RELAY_INCLINE_DOWN]    = "incl_dir",
+    [ACT_RELAY_HEAD_FAN_ON]     = "cabeza_on",
+    [ACT_RELAY_HEAD_FAN_SPEED]  = "cabeza_sel",
+};
+
+/** Pares selector + ON/OFF */
+typedef struct {
+    act_relay_t selector;
+    act_relay_t on;
+} relay_pair_t;
+
+static const relay_pair_t k_pairs[] = {
+    { ACT_RELAY_CHEST_FAN_SPEED, ACT_RELAY_CHEST_FAN_ON },
+    { ACT_RELAY_INCLINE_DOWN,    ACT_RELAY_INCLINE_ON },
+    { ACT_RELAY_HEAD_FAN_SPEED,  ACT_RELAY_HEAD_FAN_ON },
+};
+
+#define PAIR_COUNT      (sizeof(k_pairs) / sizeof(k_pairs[0]))
+#define SELECTOR_MASK   (ACT_BIT(ACT_RELAY_CHEST_FAN_SPEED) | ACT_BIT(ACT_RELAY_INCLINE_DOWN) | \
+                         ACT_BIT(ACT_RELAY_HEAD_FAN_SPEED))
+#define ALL_RELAYS_MASK (ACT_BIT(ACT_RELAY_COUNT) - 1)
+
+/** Par de cada ventilador (indexada por act_fan_t) */
+static const relay_pair_t k_fans[ACT_FAN_COUNT] = {
+    [ACT_FAN_HEAD]  = { ACT_RELAY_HEAD_FAN_SPEED,  ACT_RELAY_HEAD_FAN_ON },
+    [ACT_FAN_CHEST] = { ACT_RELAY_CHEST_FAN_SPEED, ACT_RELAY_CHEST_FAN_ON },
+};
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+// Sombra de los relés y contadores (s_lock: tareas, esp_timer e ISR)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_relays = 0;
+static uint32_t s_cycles[ACT_RELAY_COUNT];
+static uint32_t s_forced_breaks = 0;    // Selectores pedidos con el ON/OFF cerrado
+
+// Peticiones
+static atomic_uchar s_fan_level[ACT_FAN_COUNT];
+static atomic_bool s_wax_request = false;
+static esp_timer_handle_t s_wax_timer = NULL;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+FORCE_INLINE_ATTR uint64_t relay_pins(uint32_t relays) {
+    uint64_t pins = 0;
+    for (int i = 0; i < ACT_RELAY_COUNT; i++) {
+        if (relays & ACT_BIT(i)) {
+            pins |= 1ULL << k_relay_pins[i];
+        }
+    }
+    return pins;
+}
+
+/** Una escritura por banco (ver base_hal_gpio_set()) */
+FORCE_INLINE_ATTR void gpio_out_set(uint32_t relays) {
+    base_hal_gpio_set(relay_pins(relays));
+}
+
+FORCE_INLINE_ATTR void gpio_out_clear(uint32_t relays) {
+    base_hal_gpio_clear(relay_pins(relays));
+}
+
+/**
+ * @brief Aplica un cambio de relés (con s_lock)
+ *
+ * Orden: abrir ON/OFF, mover selectores, cerrar ON/OFF.
+ *
+ * @return Relés cerrados en esta escritura (ciclos nuevos)
+ */
+static uint32_t write_locked(uint32_t set, uint32_t clear) {
+    uint32_t cur = s_relays;
+    uint32_t next = (cur | (set & ~clear)) & ~clear;
+
+    for (size_t i = 0; i < PAIR_COUNT; i++) {
+        uint32_t sel = ACT_BIT(k_pairs[i].selector);
+        uint32_t on = ACT_BIT(k_pairs[i].on);
+        if (((cur ^ next) & sel) && (cur & on)) {
+            next &= ~on;
+            s_forced_breaks++;
+        }
+    }
+
+    uint32_t opening = cur & ~next;
+    uint32_t closing = next & ~cur;
+    if (opening == 0 && closing == 0) {
+        return 0;
+    }
+    gpio_out_clear(opening & ~SELECTOR_MASK);
+    gpio_out_clear(opening & SELECTOR_MASK);
+    gpio_out_set(closing & SELECTOR_MASK);
+    gpio_out_set(closing & ~SELECTOR_MASK);
+    s_relays = next;
+
+    for (int i = 0; i < ACT_RELAY_COUNT; i++) {
+        if (closing & ACT_BIT(i)) {
+            s_cycles[i]++;
+        }
+    }
+    return closing;
+}
+
+/**
+ * @brief Publica los contadores en persist si hubo cierres (fuera de s_lock)
+ */
+static void publish_cycles(uint32_t closed) {
+    if (closed == 0) {
+        return;
+    }
+    uint32_t cycles[ACT_RELAY_COUNT];
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(cycles, s_cycles, sizeof(cycles));
+    taskEXIT_CRITICAL(&s_lock);
+    persist_set_relay_cycles(cycles, ACT_RELAY_COUNT);
+}
+
+/**
+ * @brief Siguiente etapa de un ventilador hacia el nivel pedido (con s_lock)
+ *
+ * Una etapa por paso: abrir el ON/OFF, mover el selector, cerrar el ON/OFF.
+ * Apagado, el selector vuelve a normal (posición de reposo).
+ */
+static uint32_t fan_stage_locked(act_fan_t fan) {
+    uint8_t level = atomic_load(&s_fan_level[fan]);
+    uint32_t sel = ACT_BIT(k_fans[fan].selector);
+    uint32_t on = ACT_BIT(k_fans[fan].on);
+    bool want_on = level != 0;
+    bool want_fast = level == 2;
+    bool is_on = (s_relays & on) != 0;
+    bool is_fast = (s_relays & sel) != 0;
+
+    if (is_on && (!want_on || is_fast != want_fast)) {
+        return write_locked(0, on);
+    }
+    if (is_fast != want_fast) {
+        return want_fast ? write_locked(sel, 0) : write_locked(0, sel);
+    }
+    if (want_on && !is_on) {
+        return write_locked(on, 0);
+    }
+    return 0;
+}
+
+static void wax_timer_callback(void *arg) {
+    ESP_LOGI(TAG, "Temporizador de bomba de cera finalizado, apagando relé.");
+    actuators_write(0, ACT_BIT(ACT_RELAY_WAX_PUMP));
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t actuators_init(void) {
+    // Pines a 0 ANTES de configurarlos como salidas: sin activación durante el boot
+    esp_err_t err = base_hal_gpio_outputs_init(relay_pins(ALL_RELAYS_MASK));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const esp_timer_create_args_t wax_timer_args = {
+        .callback = &wax_timer_callback,
+        .name = "wax_pump_timer"
+    };
+    err = esp_timer_create(&wax_timer_args, &s_wax_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (persist_boot_relay_cycles(s_cycles, ACT_RELAY_COUNT)) {
+        ESP_LOGI(TAG, "Ciclos de relé cargados desde NVS");
+    } else {
+        memset(s_cycles, 0, sizeof(s_cycles));
+        ESP_LOGI(TAG, "Sin ciclos de relé en NVS: contadores a 0");
+    }
+    return ESP_OK;
+}
+
+void actuators_write(uint32_t set, uint32_t clear) {
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t forced = s_forced_breaks;
+    uint32_t closed = write_locked(set, clear);
+    forced = s_forced_breaks - forced;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (forced != 0) {
+        ESP_LOGW(TAG, "Selector pedido con su ON/OFF cerrado: ON/OFF abierto (set=0x%02lX clear=0x%02lX)",
+                 set, clear);
+    }
+    publish_cycles(closed);
+}
+
+void IRAM_ATTR actuators_cut_from_isr(uint32_t clear) {
+    // Siempre se escribe: es la ruta de seguridad, no depende de la sombra
+    taskENTER_CRITICAL_ISR(&s_lock);
+    gpio_out_clear(clear & ~SELECTOR_MASK);
+    gpio_out_clear(clear & SELECTOR_MASK);
+    s_relays &= ~clear;
+    taskEXIT_CRITICAL_ISR(&s_lock);
+}
+
+void actuators_all_off(void) {
+    taskENTER_CRITICAL(&s_lock);
+    for (int fan = 0; fan < ACT_FAN_COUNT; fan++) {
+        atomic_store(&s_fan_level[fan], 0);
+    }
+    gpio_out_clear(ALL_RELAYS_MASK & ~SELECTOR_MASK);
+    gpio_out_clear(SELECTOR_MASK);
+    s_relays = 0;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (s_wax_timer != NULL && esp_timer_is_active(s_wax_timer)) {
+        esp_timer_stop(s_wax_timer);
+    }
+}
+
+uint32_t actuators_relays(void) {
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t relays = s_relays;
+    taskEXIT_CRITICAL(&s_lock);
+    return relays;
+}
+
+void actuators_set_fan(act_fan_t fan, uint8_t level) {
+    if ((unsigned)fan >= ACT_FAN_COUNT || level > 2) {
+        return;
+    }
+    if (atomic_exchange(&s_fan_level[fan], level) != level) {
+        ESP_LOGD(TAG, "Ventilador %s: %u", fan == ACT_FAN_HEAD ? "cabeza" : "pecho", level);
+    }
+}
+
+uint8_t actuators_fan_level(act_fan_t fan) {
+    return (unsigned)fan < ACT_FAN_COUNT ? atomic_load(&s_fan_level[fan]) : 0;
+}
+
+void actuators_wax_request(bool on) {
+    if (atomic_exchange(&s_wax_request, on) || !on) {
+        return;  // Solo el flanco de subida
+    }
+    ESP_LOGI(TAG, "Activando bomba de cera por %d segundos", ACTUATORS_WAX_PUMP_MS / 1000);
+    actuators_write(ACT_BIT(ACT_RELAY_WAX_PUMP), 0);
+    if (esp_timer_is_active(s_wax_timer)) {
+        esp_timer_stop(s_wax_timer);
+    }
+    if (esp_timer_start_once(s_wax_timer, (uint64_t)ACTUATORS_WAX_PUMP_MS * 1000) != ESP_OK) {
+        ESP_LOGE(TAG, "Error al iniciar timer de bomba de cera");
+        actuators_write(0, ACT_BIT(ACT_RELAY_WAX_PUMP));
+    }
+}
+
+void actuators_step(void) {
+    uint32_t closed = 0;
+    taskENTER_CRITICAL(&s_lock);
+    for (int fan = 0; fan < ACT_FAN_COUNT; fan++) {
+        closed |= fan_stage_locked((act_fan_t)fan);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    publish_cycles(closed);
+}
+
+void actuators_get_cycles(uint32_t out[ACT_RELAY_COUNT]) {
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(out, s_cycles, sizeof(s_cycles));
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void actuators_log_stats(void) {
+    uint32_t cycles[ACT_RELAY_COUNT];
+    actuators_get_cycles(cycles);
+    char line[160];
+    int len = 0;
+    for (int i = 0; i < ACT_RELAY_COUNT && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, " %s=%lu", k_relay_names[i], cycles[i]);
+    }
+    ESP_LOGI(TAG, "Ciclos de relé:%s (selector con ON/OFF cerrado: %lu)", line, s_forced_breaks);
+}
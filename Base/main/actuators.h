@@ -0,0 +1,140 @@
+/**
+ * @file actuators.h
+ * @brief Relés de Base: escritura solo en transiciones y contador de ciclos
+ *
+ * Todas las salidas de relé pasan por este módulo, que guarda el estado
+ * aplicado (sombra) y solo toca los registros GPIO cuando algo cambia. Los
+ * grupos de pines se escriben con los registros de set/clear del GPIO: un
+ * grupo del mismo banco cambia en una sola escritura, sin estados
+ * intermedios visibles para otras tareas.
+ *
+ * Pares selector + ON/OFF (ventiladores, dirección de la inclinación): el
+ * selector nunca conmuta con su ON/OFF cerrado (break-before-make). En una
+ * misma escritura se abren primero los ON/OFF, después se mueven los
+ * selectores y al final se cierran los ON/OFF. Los ventiladores (slot
+ * "relays") y la dirección de la inclinación (slot "incline") además separan
+ * cada etapa un paso, para dar tiempo a que el contacto se abra de verdad
+ * antes de mover el selector.
+ *
+ * Cada cierre de un relé (apagado -> encendido) cuenta un ciclo. Los
+ * contadores se publican en persist y sobreviven a los reinicios: sirven para
+ * el mantenimiento predictivo (vida mecánica de los relés).
+ */
+
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Duración de la bomba de cera por cada petición */
+#define ACTUATORS_WAX_PUMP_MS   5000
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/** Relés de la placa (lógica directa: 1 = ON) */
+typedef enum {
+    ACT_RELAY_CHEST_FAN_SPEED = 0,  ///< Relé 1 - Selector (NC=normal, NO=fuerte)
+    ACT_RELAY_CHEST_FAN_ON,         ///< Relé 2 - ON/OFF del ventilador de pecho
+    ACT_RELAY_WAX_PUMP,             ///< Relé 3 - Bomba de cera
+    ACT_RELAY_INCLINE_ON,           ///< Relé 4 - ON/OFF del actuador
+    ACT_RELAY_INCLINE_DOWN,         ///< Relé 5 - Selector dirección (NC=arriba, NO=abajo)
+    ACT_RELAY_HEAD_FAN_ON,          ///< Relé 6 - ON/OFF del ventilador de cabeza
+    ACT_RELAY_HEAD_FAN_SPEED,       ///< Relé 7 - Selector (NC=normal, NO=fuerte)
+    ACT_RELAY_COUNT
+} act_relay_t;
+
+#define ACT_BIT(relay)  (1u << (relay))
+
+typedef enum {
+    ACT_FAN_HEAD = 0,
+    ACT_FAN_CHEST,
+    ACT_FAN_COUNT
+} act_fan_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Configura los relés abiertos y carga los contadores de ciclos
+ *
+ * Los pines quedan a 0 antes de configurarlos como salida (sin pulsos en el
+ * arranque). Requiere persist_init() previo.
+ */
+esp_err_t actuators_init(void);
+
+/**
+ * @brief Abre y cierra relés (solo los que cambian)
+ *
+ * Un selector que cambia con su ON/OFF cerrado fuerza la apertura del ON/OFF
+ * (y no lo vuelve a cerrar en esta escritura).
+ *
+ * @param set   ACT_BIT() de los relés a cerrar
+ * @param clear ACT_BIT() de los relés a abrir
+ */
+void actuators_write(uint32_t set, uint32_t clear);
+
+/**
+ * @brief Abre relés desde una ISR (IRAM; solo registros GPIO y la sombra)
+ */
+void IRAM_ATTR actuators_cut_from_isr(uint32_t clear);
+
+/**
+ * @brief Safe state: abre todos los relés y anula las peticiones
+ *
+ * Ventiladores a 0 y bomba de cera parada; la dirección de la inclinación la
+ * repone el slot de inclinación al completar la parada.
+ */
+void actuators_all_off(void);
+
+/**
+ * @brief Estado aplicado de los relés (ACT_BIT())
+ */
+uint32_t actuators_relays(void);
+
+/**
+ * @brief Pide un nivel de ventilador (0 = OFF, 1 = normal, 2 = fuerte)
+ *
+ * Barato si no cambia: se puede llamar en cada SYNC. El slot "relays" lleva
+ * los relés al nivel pedido por etapas.
+ */
+void actuators_set_fan(act_fan_t fan, uint8_t level);
+
+/**
+ * @brief Nivel pedido de un ventilador
+ */
+uint8_t actuators_fan_level(act_fan_t fan);
+
+/**
+ * @brief Petición de la bomba de cera (campo wax del SYNC)
+ *
+ * Solo el flanco 0 -> 1 arranca la bomba durante ACTUATORS_WAX_PUMP_MS;
+ * mantener la petición a 1 no la alarga.
+ */
+void actuators_wax_request(bool on);
+
+/**
+ * @brief Un paso del slot "relays": una etapa por ventilador hacia su nivel
+ */
+void actuators_step(void);
+
+/**
+ * @brief Ciclos de cierre por relé (desde el primer arranque)
+ */
+void actuators_get_cycles(uint32_t out[ACT_RELAY_COUNT]);
+
+/**
+ * @brief Vuelca por log los ciclos por relé
+ */
+void actuators_log_stats(void);
+
+#endif // ACTUATORS_H
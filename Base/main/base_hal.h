@@ -0,0 +1,149 @@
+/**
+ * @file base_hal.h
+ * @brief Capa de abstracción del hardware de Base (GPIO, UART del enlace, almacenamiento)
+ *
+ * La lógica de control (protocolo, máquina de estados de la inclinación,
+ * seguridad, relés) solo habla con el hardware a través de esta capa, así
+ * que el mismo código compila para dos destinos:
+ *
+ * - ESP32 (base_hal_esp32.c): drivers de ESP-IDF y registros GPIO.
+ * - Linux (base_hal_linux.c, `idf.py --preview set-target linux`): el enlace
+ *   con la Consola es un pseudo-terminal, las salidas se vuelcan a un fichero
+ *   de texto y las entradas se leen de otro. Sirve para medir el camino
+ *   SYNC -> DATA y para pruebas de regresión sin la placa.
+ *
+ * Los temporizadores (esp_timer), NVS y FreeRTOS no necesitan capa propia:
+ * ESP-IDF los implementa también para el destino linux.
+ *
+ * Las funciones marcadas IRAM son seguras desde una ISR (en linux las "ISR"
+ * son callbacks llamados desde la tarea que vigila el fichero de entradas).
+ */
+
+#ifndef BASE_HAL_H
+#define BASE_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/** Flanco que dispara la ISR de una entrada */
+typedef enum {
+    BASE_HAL_EDGE_ANY,          ///< Ambos flancos
+    BASE_HAL_EDGE_RISING,       ///< Solo 0 -> 1
+} base_hal_edge_t;
+
+typedef void (*base_hal_isr_t)(void *arg);
+
+/** Configuración de una entrada digital */
+typedef struct {
+    int pin;
+    bool pull_up;               ///< Pull-up interno
+    bool glitch_filter;         ///< Filtro de glitches del periférico (si el chip lo tiene)
+    base_hal_edge_t edge;
+    base_hal_isr_t isr;         ///< IRAM; NULL = solo sondeo
+    void *arg;
+} base_hal_input_t;
+
+/** Contadores de errores del UART desde la última consulta */
+typedef struct {
+    uint32_t overruns;          ///< FIFO o buffer de recepción lleno
+    uint32_t errors;            ///< Error de trama o paridad
+} base_hal_uart_errors_t;
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+/**
+ * @brief Configura pines como salidas, a 0 antes de habilitarlas
+ *
+ * @param pins Máscara de pines (bit n = GPIO n)
+ */
+esp_err_t base_hal_gpio_outputs_init(uint64_t pins);
+
+/**
+ * @brief Pone a 1 los pines de la máscara (una escritura por banco; IRAM)
+ */
+void IRAM_ATTR base_hal_gpio_set(uint64_t pins);
+
+/**
+ * @brief Pone a 0 los pines de la máscara (una escritura por banco; IRAM)
+ */
+void IRAM_ATTR base_hal_gpio_clear(uint64_t pins);
+
+/**
+ * @brief Configura una entrada y, si tiene ISR, la engancha
+ *
+ * La primera llamada con ISR instala el servicio de interrupciones.
+ */
+esp_err_t base_hal_gpio_input_init(const base_hal_input_t *input);
+
+/**
+ * @brief Nivel de una entrada (IRAM)
+ */
+int IRAM_ATTR base_hal_gpio_read(int pin);
+
+/**
+ * @brief Espera activa en microsegundos (IRAM; filtros de glitches por software)
+ */
+void IRAM_ATTR base_hal_delay_us(uint32_t us);
+
+// ============================================================================
+// UART DEL ENLACE CON LA CONSOLA
+// ============================================================================
+
+/**
+ * @brief Abre el UART del enlace (8N1, sin control de flujo)
+ *
+ * @param baud    Velocidad (en linux solo cuenta para las marcas de tiempo)
+ * @param tx_pin  Pin TX (ignorado en linux)
+ * @param rx_pin  Pin RX (ignorado en linux)
+ * @param rx_buf  Tamaño del buffer de recepción
+ */
+esp_err_t base_hal_uart_init(int baud, int tx_pin, int rx_pin, size_t rx_buf);
+
+/**
+ * @brief Lee hasta len bytes
+ *
+ * @return Bytes leídos (0 si vence el timeout), -1 si hay error
+ */
+int base_hal_uart_read(uint8_t *buf, size_t len, TickType_t timeout);
+
+/**
+ * @brief Escribe len bytes (los deja en el buffer de transmisión)
+ *
+ * @return Bytes escritos, -1 si hay error
+ */
+int base_hal_uart_write(const char *data, size_t len);
+
+/**
+ * @brief Descarta lo recibido y no leído
+ */
+void base_hal_uart_flush(void);
+
+/**
+ * @brief Recoge los errores notificados por el driver desde la última consulta
+ *
+ * No bloquea; se llama fuera del camino SYNC -> DATA.
+ */
+void base_hal_uart_poll_errors(base_hal_uart_errors_t *out);
+
+// ============================================================================
+// ALMACENAMIENTO
+// ============================================================================
+
+/**
+ * @brief Inicializa NVS (borra la partición si está llena o es de otra versión)
+ *
+ * En linux NVS vive en el fichero que emula la flash.
+ */
+esp_err_t base_hal_storage_init(void);
+
+#endif // BASE_HAL_H
@@ -0,0 +1,197 @@
+/**
+ * @file base_hal_esp32.c
+ * @brief HAL de Base sobre los drivers de ESP-IDF (ver base_hal.h)
+ */
+
+#include "base_hal.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_intr_alloc.h"
+#include "esp_rom_sys.h"
+#include "nvs_flash.h"
+#include "driver/uart.h"
+#include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
+#include "soc/soc_caps.h"
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+#include "driver/gpio_filter.h"
+#endif
+
+static const char *TAG = "BASE_HAL";
+
+#define LINK_UART_PORT          UART_NUM_1
+#define LINK_UART_EVENT_QUEUE   16  // Solo se usan los eventos de error (contadores STATS)
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+static QueueHandle_t s_uart_event_queue = NULL;
+static bool s_isr_service = false;
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+esp_err_t base_hal_gpio_outputs_init(uint64_t pins) {
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (pins & (1ULL << pin)) {
+            gpio_reset_pin(pin);
+            gpio_set_level(pin, 0);
+        }
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = pins,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    return gpio_config(&io_conf);
+}
+
+void IRAM_ATTR base_hal_gpio_set(uint64_t pins) {
+    if ((uint32_t)pins != 0) {
+        GPIO.out_w1ts = (uint32_t)pins;
+    }
+    if ((pins >> 32) != 0) {
+        GPIO.out1_w1ts.val = (uint32_t)(pins >> 32);
+    }
+}
+
+void IRAM_ATTR base_hal_gpio_clear(uint64_t pins) {
+    if ((uint32_t)pins != 0) {
+        GPIO.out_w1tc = (uint32_t)pins;
+    }
+    if ((pins >> 32) != 0) {
+        GPIO.out1_w1tc.val = (uint32_t)(pins >> 32);
+    }
+}
+
+esp_err_t base_hal_gpio_input_init(const base_hal_input_t *input) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << input->pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = input->pull_up ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = input->isr == NULL ? GPIO_INTR_DISABLE :
+                     input->edge == BASE_HAL_EDGE_RISING ? GPIO_INTR_POSEDGE : GPIO_INTR_ANYEDGE
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    if (input->glitch_filter) {
+        gpio_glitch_filter_handle_t filter;
+        gpio_pin_glitch_filter_config_t filter_conf = {
+            .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+            .gpio_num = input->pin,
+        };
+        err = gpio_new_pin_glitch_filter(&filter_conf, &filter);
+        if (err == ESP_OK) {
+            err = gpio_glitch_filter_enable(filter);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+#endif
+    if (input->isr == NULL) {
+        return ESP_OK;
+    }
+    if (!s_isr_service) {
+        err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+        if (err != ESP_OK) {
+            return err;
+        }
+        s_isr_service = true;
+    }
+    return gpio_isr_handler_add(input->pin, input->isr, input->arg);
+}
+
+int IRAM_ATTR base_hal_gpio_read(int pin) {
+    return gpio_ll_get_level(&GPIO, pin);
+}
+
+void IRAM_ATTR base_hal_delay_us(uint32_t us) {
+    esp_rom_delay_us(us);
+}
+
+// ============================================================================
+// UART DEL ENLACE
+// ============================================================================
+
+esp_err_t base_hal_uart_init(int baud, int tx_pin, int rx_pin, size_t rx_buf) {
+    uart_config_t uart_config = {
+        .baud_rate = baud,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    // ISR en IRAM (CONFIG_UART_ISR_IN_IRAM): el FIFO de 128 bytes se llena en ~11 ms a
+    // 115200 baud, menos que lo que dura un commit NVS con la caché deshabilitada
+    esp_err_t err = uart_driver_install(LINK_UART_PORT, rx_buf, 0, LINK_UART_EVENT_QUEUE,
+                                        &s_uart_event_queue, ESP_INTR_FLAG_IRAM);
+    if (err == ESP_OK) {
+        err = uart_param_config(LINK_UART_PORT, &uart_config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(LINK_UART_PORT, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "UART%d configurado: %d baud, TX=%d, RX=%d", LINK_UART_PORT, baud, tx_pin, rx_pin);
+    }
+    return err;
+}
+
+int base_hal_uart_read(uint8_t *buf, size_t len, TickType_t timeout) {
+    return uart_read_bytes(LINK_UART_PORT, buf, len, timeout);
+}
+
+int base_hal_uart_write(const char *data, size_t len) {
+    return uart_write_bytes(LINK_UART_PORT, data, len);
+}
+
+void base_hal_uart_flush(void) {
+    uart_flush(LINK_UART_PORT);
+}
+
+void base_hal_uart_poll_errors(base_hal_uart_errors_t *out) {
+    out->overruns = 0;
+    out->errors = 0;
+    // Los eventos de datos se descartan: los bytes se leen con uart_read_bytes()
+    uart_event_t event;
+    while (xQueueReceive(s_uart_event_queue, &event, 0) == pdTRUE) {
+        switch (event.type) {
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                out->overruns++;
+                break;
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+                out->errors++;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// ============================================================================
+// ALMACENAMIENTO
+// ============================================================================
+
+esp_err_t base_hal_storage_init(void) {
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    return ret;
+}
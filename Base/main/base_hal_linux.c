@@ -0,0 +1,259 @@
+/**
+ * @file base_hal_linux.c
+ * @brief HAL de Base para el destino linux de ESP-IDF (ver base_hal.h)
+ *
+ * - Enlace: pseudo-terminal. Al arrancar se imprime la ruta del esclavo
+ *   (/dev/pts/N) para conectar la Consola, un script de pruebas o socat.
+ * - Salidas: estado en memoria; la tarea "hal_gpio" vuelca una línea
+ *   "pin=nivel" por salida a BASE_HAL_GPIO_OUT cuando cambia alguna.
+ * - Entradas: la misma tarea lee BASE_HAL_GPIO_IN (líneas "pin=nivel") cada
+ *   BASE_HAL_POLL_MS y llama a la ISR de los pines cuyo flanco coincide. Un
+ *   pin que no aparece en el fichero queda en reposo (1 con pull-up).
+ *
+ * Las rutas se pueden cambiar con las variables de entorno del mismo nombre.
+ *
+ * Ninguna función bloquea en una llamada al sistema: en el port POSIX de
+ * FreeRTOS una tarea bloqueada en read() o poll() no cede la CPU a las demás,
+ * así que las esperas se hacen con vTaskDelay().
+ */
+
+#define _GNU_SOURCE  // posix_openpt(), ptsname(), cfmakeraw()
+#include "base_hal.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+static const char *TAG = "BASE_HAL";
+
+#define BASE_HAL_GPIO_IN_DEFAULT    "base_gpio_in.txt"
+#define BASE_HAL_GPIO_OUT_DEFAULT   "base_gpio_out.txt"
+#define BASE_HAL_POLL_MS            10
+#define BASE_HAL_MAX_INPUTS         4
+#define BASE_HAL_MAX_PINS           64
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+static int s_pty = -1;
+static int s_pty_slave = -1;    // Abierto para que el maestro no lea EIO sin nadie conectado
+
+static atomic_ullong s_outputs = 0;
+static uint64_t s_output_pins = 0;
+static atomic_ullong s_inputs = 0;
+
+static base_hal_input_t s_input_cfg[BASE_HAL_MAX_INPUTS];
+static int s_input_count = 0;
+static TaskHandle_t s_gpio_task = NULL;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+static const char *env_or(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+    return (value != NULL && value[0] != '\0') ? value : fallback;
+}
+
+/**
+ * @brief Niveles del fichero de entradas sobre los actuales
+ */
+static uint64_t read_inputs_file(uint64_t levels) {
+    FILE *f = fopen(env_or("BASE_HAL_GPIO_IN", BASE_HAL_GPIO_IN_DEFAULT), "r");
+    if (f == NULL) {
+        return levels;
+    }
+    int pin;
+    int level;
+    while (fscanf(f, " %d = %d", &pin, &level) == 2) {
+        if (pin >= 0 && pin < BASE_HAL_MAX_PINS) {
+            levels = level ? (levels | (1ULL << pin)) : (levels & ~(1ULL << pin));
+        }
+    }
+    fclose(f);
+    return levels;
+}
+
+static void write_outputs_file(uint64_t levels) {
+    FILE *f = fopen(env_or("BASE_HAL_GPIO_OUT", BASE_HAL_GPIO_OUT_DEFAULT), "w");
+    if (f == NULL) {
+        return;
+    }
+    for (int pin = 0; pin < BASE_HAL_MAX_PINS; pin++) {
+        if (s_output_pins & (1ULL << pin)) {
+            fprintf(f, "%d=%d\n", pin, (int)((levels >> pin) & 1));
+        }
+    }
+    fclose(f);
+}
+
+/**
+ * @brief Tarea de los ficheros de GPIO: entradas -> ISR, salidas -> fichero
+ */
+static void gpio_task(void *arg) {
+    uint64_t written = ~0ULL;  // Fuerza el primer volcado
+    while (1) {
+        uint64_t before = atomic_load(&s_inputs);
+        uint64_t after = read_inputs_file(before);
+        if (after != before) {
+            atomic_store(&s_inputs, after);
+            for (int i = 0; i < s_input_count; i++) {
+                const base_hal_input_t *in = &s_input_cfg[i];
+                uint64_t bit = 1ULL << in->pin;
+                if (in->isr == NULL || ((before ^ after) & bit) == 0) {
+                    continue;
+                }
+                if (in->edge == BASE_HAL_EDGE_ANY || (after & bit) != 0) {
+                    in->isr(in->arg);
+                }
+            }
+        }
+
+        uint64_t outputs = atomic_load(&s_outputs);
+        if (outputs != written) {
+            write_outputs_file(outputs);
+            written = outputs;
+        }
+        vTaskDelay(pdMS_TO_TICKS(BASE_HAL_POLL_MS));
+    }
+}
+
+static esp_err_t start_gpio_task(void) {
+    if (s_gpio_task != NULL) {
+        return ESP_OK;
+    }
+    if (xTaskCreate(gpio_task, "hal_gpio", 4096, NULL, 12, &s_gpio_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "GPIO simulados: entradas en %s, salidas en %s",
+             env_or("BASE_HAL_GPIO_IN", BASE_HAL_GPIO_IN_DEFAULT),
+             env_or("BASE_HAL_GPIO_OUT", BASE_HAL_GPIO_OUT_DEFAULT));
+    return ESP_OK;
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+esp_err_t base_hal_gpio_outputs_init(uint64_t pins) {
+    atomic_fetch_and(&s_outputs, ~pins);
+    s_output_pins |= pins;
+    return start_gpio_task();
+}
+
+void base_hal_gpio_set(uint64_t pins) {
+    atomic_fetch_or(&s_outputs, pins);
+}
+
+void base_hal_gpio_clear(uint64_t pins) {
+    atomic_fetch_and(&s_outputs, ~pins);
+}
+
+esp_err_t base_hal_gpio_input_init(const base_hal_input_t *input) {
+    if (input->pin < 0 || input->pin >= BASE_HAL_MAX_PINS || s_input_count >= BASE_HAL_MAX_INPUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint64_t bit = 1ULL << input->pin;
+    uint64_t levels = input->pull_up ? (atomic_load(&s_inputs) | bit) : (atomic_load(&s_inputs) & ~bit);
+    atomic_store(&s_inputs, read_inputs_file(levels));
+    s_input_cfg[s_input_count++] = *input;
+    return start_gpio_task();
+}
+
+int base_hal_gpio_read(int pin) {
+    return (int)((atomic_load(&s_inputs) >> pin) & 1);
+}
+
+void base_hal_delay_us(uint32_t us) {
+    int64_t until = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < until) {
+    }
+}
+
+// ============================================================================
+// UART DEL ENLACE
+// ============================================================================
+
+esp_err_t base_hal_uart_init(int baud, int tx_pin, int rx_pin, size_t rx_buf) {
+    s_pty = posix_openpt(O_RDWR | O_NOCTTY);
+    if (s_pty < 0 || grantpt(s_pty) != 0 || unlockpt(s_pty) != 0) {
+        ESP_LOGE(TAG, "No se pudo crear el pseudo-terminal del enlace");
+        return ESP_FAIL;
+    }
+    const char *slave = ptsname(s_pty);
+    s_pty_slave = open(slave, O_RDWR | O_NOCTTY);
+    if (s_pty_slave < 0) {
+        return ESP_FAIL;
+    }
+
+    // Modo crudo: sin eco ni traducción de fin de línea
+    struct termios tio;
+    tcgetattr(s_pty_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(s_pty_slave, TCSANOW, &tio);
+    fcntl(s_pty, F_SETFL, fcntl(s_pty, F_GETFL) | O_NONBLOCK);
+
+    ESP_LOGI(TAG, "Enlace con la Consola en %s (%d baud simulados)", slave, baud);
+    return ESP_OK;
+}
+
+int base_hal_uart_read(uint8_t *buf, size_t len, TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
+    while (1) {
+        ssize_t n = read(s_pty, buf, len);
+        if (n > 0) {
+            return (int)n;
+        }
+        if (xTaskGetTickCount() - start >= timeout) {
+            return 0;
+        }
+        vTaskDelay(1);
+    }
+}
+
+int base_hal_uart_write(const char *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(s_pty, data + done, len - done);
+        if (n < 0) {
+            return done > 0 ? (int)done : -1;
+        }
+        done += (size_t)n;
+    }
+    return (int)done;
+}
+
+void base_hal_uart_flush(void) {
+    uint8_t discard[64];
+    while (read(s_pty, discard, sizeof(discard)) > 0) {
+    }
+}
+
+void base_hal_uart_poll_errors(base_hal_uart_errors_t *out) {
+    // Un pseudo-terminal no tiene errores de trama ni de paridad
+    out->overruns = 0;
+    out->errors = 0;
+}
+
+// ============================================================================
+// ALMACENAMIENTO
+// ============================================================================
+
+esp_err_t base_hal_storage_init(void) {
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    return ret;
+}
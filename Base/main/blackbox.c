@@ -0,0 +1,316 @@
+/**
+ * @file blackbox.c
+ * @brief Implementación de la caja negra de Base (ver blackbox.h)
+ */
+
+#include "blackbox.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_partition.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "BLACKBOX";
+
+#define BLACKBOX_RING_MAGIC         0x58424B42u  // "BKBX"
+#define BLACKBOX_POST_RECORDS       (BLACKBOX_POST_MS / BLACKBOX_PERIOD_MS)
+#define BLACKBOX_DUMP_TASK_STACK    3072
+#define BLACKBOX_DUMP_TASK_PRIO     2       // Por debajo de todas las tareas de control
+#define BLACKBOX_READ_WAIT_MS       20      // Espera máxima de la lectura por el enlace
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+/**
+ * Anillo en .noinit: no se inicializa en el arranque, así que tras un pánico
+ * o un watchdog conserva los últimos segundos antes del reinicio.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;
+    uint32_t head;              ///< Próxima posición a escribir
+    uint32_t count;             ///< Registros válidos
+    uint16_t seq;
+    cm_bbox_record_t records[BLACKBOX_RECORDS];
+} blackbox_ring_t;
+
+static __NOINIT_ATTR blackbox_ring_t s_ring;
+
+// Disparo: cualquier tarea pide, el slot congela, la tarea de volcado libera
+static atomic_uint s_trigger_reason = 0;    // CM_BBOX_REASON_* pedido (0 = ninguno)
+static atomic_bool s_frozen = false;        // Anillo congelado hasta terminar el volcado
+static atomic_uint s_events = 0;            // CM_BBOX_EVT_* para la siguiente muestra
+
+// Solo el slot "blackbox" (y la tarea de volcado con el anillo congelado)
+static int s_post_left = -1;                // Muestras tras el disparo (-1 = sin disparo)
+static uint32_t s_post_recorded = 0;
+static uint8_t s_reason = 0;
+
+// Partición: un hueco de slot_size por volcado
+static const esp_partition_t *s_part = NULL;
+static size_t s_slot_size = 0;
+static uint32_t s_slots = 0;
+static uint32_t s_last_seq = 0;             // Volcado más reciente (0 = ninguno)
+static SemaphoreHandle_t s_flash_lock = NULL;
+static TaskHandle_t s_dump_task_handle = NULL;
+
+static atomic_uint s_records = 0;
+static atomic_uint s_dropped = 0;
+static atomic_uint s_dumps = 0;
+static atomic_uint s_dump_failures = 0;
+static atomic_uint s_last_dump_ms = 0;
+
+// ============================================================================
+// VOLCADO A FLASH
+// ============================================================================
+
+static size_t slot_offset(uint32_t seq) {
+    return (size_t)((seq - 1) % s_slots) * s_slot_size;
+}
+
+static bool read_header(uint32_t seq, cm_bbox_header_t *hdr) {
+    if (esp_partition_read(s_part, slot_offset(seq), hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->magic == CM_BBOX_MAGIC && hdr->version == CM_BBOX_VERSION &&
+           hdr->record_size == sizeof(cm_bbox_record_t) && hdr->dump_seq == seq &&
+           hdr->record_count <= BLACKBOX_RECORDS;
+}
+
+/** Busca el volcado más reciente entre los huecos de la partición */
+static void scan_partition(void) {
+    for (uint32_t i = 0; i < s_slots; i++) {
+        cm_bbox_header_t hdr;
+        if (esp_partition_read(s_part, i * s_slot_size, &hdr, sizeof(hdr)) == ESP_OK &&
+            hdr.magic == CM_BBOX_MAGIC && hdr.version == CM_BBOX_VERSION &&
+            hdr.dump_seq > s_last_seq && (hdr.dump_seq - 1) % s_slots == i) {
+            s_last_seq = hdr.dump_seq;
+        }
+    }
+}
+
+static esp_err_t dump_to_partition(void) {
+    // Anillo congelado: ni el slot ni nadie lo modifica hasta el final
+    uint32_t count = s_ring.count;
+    uint32_t start = (s_ring.head + BLACKBOX_RECORDS - count) % BLACKBOX_RECORDS;
+    uint32_t seq = s_last_seq + 1;
+    size_t offset = slot_offset(seq);
+
+    cm_bbox_header_t hdr = {
+        .magic = CM_BBOX_MAGIC,
+        .version = CM_BBOX_VERSION,
+        .record_size = sizeof(cm_bbox_record_t),
+        .dump_seq = seq,
+        .record_count = (uint16_t)count,
+        .trigger_index = (uint16_t)(count > s_post_recorded ? count - 1 - s_post_recorded : 0),
+        .period_ms = BLACKBOX_PERIOD_MS,
+        .reason = s_reason,
+        .dropped = atomic_load(&s_dropped),
+    };
+
+    esp_err_t err = esp_partition_erase_range(s_part, offset, s_slot_size);
+    if (err == ESP_OK) {
+        // Primero los registros (por tramos si el anillo da la vuelta) y la
+        // cabecera al final: un volcado interrumpido no parece válido
+        uint32_t first = (start + count <= BLACKBOX_RECORDS) ? count : BLACKBOX_RECORDS - start;
+        err = esp_partition_write(s_part, offset + sizeof(hdr), &s_ring.records[start],
+                                  first * sizeof(cm_bbox_record_t));
+        if (err == ESP_OK && first < count) {
+            err = esp_partition_write(s_part, offset + sizeof(hdr) + first * sizeof(cm_bbox_record_t),
+                                      &s_ring.records[0], (count - first) * sizeof(cm_bbox_record_t));
+        }
+    }
+    if (err == ESP_OK) {
+        err = esp_partition_write(s_part, offset, &hdr, sizeof(hdr));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error volcando a '%s': %s", BLACKBOX_PARTITION_LABEL, esp_err_to_name(err));
+        return err;
+    }
+
+    s_last_seq = seq;
+    ESP_LOGW(TAG, "Volcado #%lu (motivo %u): %lu muestras, disparo en %u",
+             seq, s_reason, count, hdr.trigger_index);
+    return ESP_OK;
+}
+
+static void dump_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!atomic_load(&s_frozen)) {
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        xSemaphoreTake(s_flash_lock, portMAX_DELAY);
+        esp_err_t err = dump_to_partition();
+        xSemaphoreGive(s_flash_lock);
+        atomic_store(&s_last_dump_ms, (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+        atomic_fetch_add(err == ESP_OK ? &s_dumps : &s_dump_failures, 1);
+
+        // Reanudar la grabación con el anillo vacío
+        s_ring.head = 0;
+        s_ring.count = 0;
+        s_post_left = -1;
+        s_post_recorded = 0;
+        atomic_store(&s_dropped, 0);
+        atomic_store(&s_trigger_reason, 0);
+        atomic_store(&s_frozen, false);
+    }
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t blackbox_init(void) {
+    // Anillo recuperable solo tras un reinicio por fallo (la RAM no se borra)
+    esp_reset_reason_t rst = esp_reset_reason();
+    bool crash = (rst == ESP_RST_PANIC || rst == ESP_RST_INT_WDT ||
+                  rst == ESP_RST_TASK_WDT || rst == ESP_RST_WDT);
+    bool valid = s_ring.magic == BLACKBOX_RING_MAGIC && s_ring.capacity == BLACKBOX_RECORDS &&
+                 s_ring.head < BLACKBOX_RECORDS && s_ring.count <= BLACKBOX_RECORDS;
+    if (!(crash && valid && s_ring.count > 0)) {
+        memset(&s_ring, 0, sizeof(s_ring));
+        s_ring.magic = BLACKBOX_RING_MAGIC;
+        s_ring.capacity = BLACKBOX_RECORDS;
+    }
+
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                      BLACKBOX_PARTITION_LABEL);
+    if (s_part == NULL) {
+        ESP_LOGE(TAG, "Partición '%s' no encontrada: se graba sin volcados", BLACKBOX_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t dump_size = sizeof(cm_bbox_header_t) + BLACKBOX_RECORDS * sizeof(cm_bbox_record_t);
+    s_slot_size = (dump_size + s_part->erase_size - 1) / s_part->erase_size * s_part->erase_size;
+    s_slots = s_part->size / s_slot_size;
+    if (s_slots == 0) {
+        ESP_LOGE(TAG, "Partición '%s' menor que un volcado (%u bytes)",
+                 BLACKBOX_PARTITION_LABEL, (unsigned)s_slot_size);
+        s_part = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    scan_partition();
+
+    s_flash_lock = xSemaphoreCreateMutex();
+    if (s_flash_lock == NULL ||
+        xTaskCreate(dump_task, "blackbox_dump", BLACKBOX_DUMP_TASK_STACK, NULL,
+                    BLACKBOX_DUMP_TASK_PRIO, &s_dump_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando la tarea de volcado");
+        s_part = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Caja negra: %d muestras cada %d ms (%u bytes), %lu volcados en flash, último #%lu",
+             BLACKBOX_RECORDS, BLACKBOX_PERIOD_MS, (unsigned)sizeof(s_ring.records), s_slots, s_last_seq);
+
+    if (s_ring.count > 0) {
+        // Los segundos previos al reinicio, tal como quedaron en RAM
+        ESP_LOGW(TAG, "Reinicio por fallo (%d): volcando %lu muestras anteriores", rst, s_ring.count);
+        s_reason = CM_BBOX_REASON_RESET;
+        s_post_recorded = 0;
+        atomic_store(&s_trigger_reason, CM_BBOX_REASON_RESET);
+        atomic_store(&s_frozen, true);
+        xTaskNotifyGive(s_dump_task_handle);
+    }
+    return ESP_OK;
+}
+
+void blackbox_record(cm_bbox_record_t *rec) {
+    if (atomic_load(&s_frozen)) {
+        atomic_fetch_add(&s_dropped, 1);
+        return;
+    }
+
+    uint32_t reason = atomic_load(&s_trigger_reason);
+    bool trigger = (reason != 0 && s_post_left < 0);
+
+    rec->seq = s_ring.seq++;
+    rec->events = (uint8_t)atomic_exchange(&s_events, 0) | (trigger ? CM_BBOX_EVT_TRIGGER : 0);
+    s_ring.records[s_ring.head] = *rec;
+    s_ring.head = (s_ring.head + 1) % BLACKBOX_RECORDS;
+    if (s_ring.count < BLACKBOX_RECORDS) {
+        s_ring.count++;
+    }
+    atomic_fetch_add(&s_records, 1);
+
+    if (trigger) {
+        s_reason = (uint8_t)reason;
+        s_post_left = BLACKBOX_POST_RECORDS;
+        s_post_recorded = 0;
+    } else if (s_post_left > 0) {
+        s_post_recorded++;
+        if (--s_post_left == 0 && s_dump_task_handle != NULL) {
+            atomic_store(&s_frozen, true);
+            xTaskNotifyGive(s_dump_task_handle);
+        }
+    }
+}
+
+void blackbox_event(uint8_t evt) {
+    atomic_fetch_or(&s_events, evt);
+}
+
+void blackbox_trigger(uint8_t reason) {
+    unsigned int expected = 0;
+    atomic_compare_exchange_strong(&s_trigger_reason, &expected, reason);
+}
+
+bool blackbox_read_line(uint16_t dump, uint16_t line, uint8_t *data, size_t *len) {
+    *len = 0;
+    if (s_part == NULL || dump >= s_slots) {
+        return true;  // Volcado inexistente: respuesta vacía
+    }
+    if (xSemaphoreTake(s_flash_lock, pdMS_TO_TICKS(BLACKBOX_READ_WAIT_MS)) != pdTRUE) {
+        return false;
+    }
+
+    // s_last_seq lo escribe el volcado con el cerrojo tomado
+    uint32_t seq = s_last_seq - dump;
+    cm_bbox_header_t hdr;
+    if (dump < s_last_seq && read_header(seq, &hdr)) {
+        if (line == 0) {
+            memcpy(data, &hdr, sizeof(hdr));
+            *len = sizeof(hdr);
+        } else {
+            uint32_t first = (uint32_t)(line - 1) * CM_BBOX_RECORDS_PER_LINE;
+            if (first < hdr.record_count) {
+                uint32_t n = hdr.record_count - first;
+                if (n > CM_BBOX_RECORDS_PER_LINE) {
+                    n = CM_BBOX_RECORDS_PER_LINE;
+                }
+                size_t offset = slot_offset(seq) + sizeof(hdr) + first * sizeof(cm_bbox_record_t);
+                if (esp_partition_read(s_part, offset, data, n * sizeof(cm_bbox_record_t)) == ESP_OK) {
+                    *len = n * sizeof(cm_bbox_record_t);
+                }
+            }
+        }
+    }
+    xSemaphoreGive(s_flash_lock);
+    return true;
+}
+
+void blackbox_get_stats(blackbox_stats_t *out) {
+    out->records = atomic_load(&s_records);
+    out->dropped = atomic_load(&s_dropped);
+    out->dumps = atomic_load(&s_dumps);
+    out->dump_failures = atomic_load(&s_dump_failures);
+    out->last_dump_ms = atomic_load(&s_last_dump_ms);
+    out->last_dump_seq = s_last_seq;
+    out->last_reason = s_reason;
+}
+
+void blackbox_log_stats(void) {
+    blackbox_stats_t st;
+    blackbox_get_stats(&st);
+    ESP_LOGI(TAG, "Muestras=%lu perdidas=%lu volcados=%lu (fallidos %lu, último #%lu motivo %u en %lu ms)",
+             st.records, st.dropped, st.dumps, st.dump_failures, st.last_dump_seq,
+             st.last_reason, st.last_dump_ms);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file blackbox.h
+ * @brief Caja negra de Base: últimos segundos de estado a ritmo de control
+ *
+ * Un anillo binario en DRAM (.noinit: sobrevive a un reinicio por pánico o
+ * watchdog) guarda una muestra cm_bbox_record_t por marco menor del
+ * ejecutivo: consignas, valores reales, relés, VFD y eventos del enlace.
+ * Grabar es copiar 24 bytes desde el slot "blackbox" del ejecutivo, así que
+ * queda activa en producción (coste visible en las estadísticas del slot).
+ *
+ * Ante un fallo (watchdog, fin de carrera, E-Stop, safe state) se siguen
+ * grabando BLACKBOX_POST_MS para ver la reacción, el anillo se congela y una
+ * tarea de baja prioridad lo vuelca a la partición "blackbox" (un hueco por
+ * volcado, se conservan los más recientes que quepan). La Consola lo lee por
+ * RS485 con líneas BLACKBOX/BBOX (formato en cm_blackbox_format.h).
+ */
+
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "cm_blackbox_format.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Periodo de muestreo: el marco menor del ejecutivo */
+#define BLACKBOX_PERIOD_MS          50
+
+/** Muestras en el anillo */
+#define BLACKBOX_RECORDS            (CONFIG_BASE_BLACKBOX_SECONDS * 1000 / BLACKBOX_PERIOD_MS)
+
+/** Grabación tras el disparo antes de congelar el anillo */
+#define BLACKBOX_POST_MS            1000
+
+/** Partición de los volcados */
+#define BLACKBOX_PARTITION_LABEL    "blackbox"
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+typedef struct {
+    uint32_t records;           ///< Muestras grabadas desde el arranque
+    uint32_t dropped;           ///< Muestras perdidas con el anillo congelado
+    uint32_t dumps;             ///< Volcados escritos desde el arranque
+    uint32_t dump_failures;
+    uint32_t last_dump_ms;      ///< Duración del último volcado
+    uint32_t last_dump_seq;     ///< Número del volcado más reciente en flash (0 = ninguno)
+    uint8_t last_reason;        ///< CM_BBOX_REASON_* del último disparo
+} blackbox_stats_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Localiza la partición, recupera el anillo tras un reinicio por
+ * fallo y crea la tarea de volcado
+ */
+esp_err_t blackbox_init(void);
+
+/**
+ * @brief Graba una muestra (solo desde el slot "blackbox" del ejecutivo)
+ *
+ * Completa seq y events; el resto de campos los rellena el llamante.
+ */
+void blackbox_record(cm_bbox_record_t *rec);
+
+/**
+ * @brief Marca un evento en la siguiente muestra (cualquier tarea)
+ */
+void blackbox_event(uint8_t evt);
+
+/**
+ * @brief Pide un volcado (cualquier tarea). Mientras haya uno en curso las
+ * peticiones se ignoran: el motivo es el del primer fallo.
+ */
+void blackbox_trigger(uint8_t reason);
+
+/**
+ * @brief Lee una línea de un volcado para el enlace
+ *
+ * @param dump    0 = volcado más reciente, 1 = el anterior...
+ * @param line    0 = cabecera, n >= 1 = registros
+ * @param[out] data Al menos CM_BBOX_LINE_DATA_MAX bytes
+ * @param[out] len  Bytes leídos (0 si el volcado o la línea no existen)
+ * @return false si hay un volcado escribiéndose (no responder: la Consola reintenta)
+ */
+bool blackbox_read_line(uint16_t dump, uint16_t line, uint8_t *data, size_t *len);
+
+/**
+ * @brief Copia los contadores
+ */
+void blackbox_get_stats(blackbox_stats_t *out);
+
+/**
+ * @brief Vuelca por log los contadores
+ */
+void blackbox_log_stats(void);
+
+#endif // BLACKBOX_H
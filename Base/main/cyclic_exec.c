@@ -0,0 +1,216 @@
+/**
+ * @file cyclic_exec.c
+ * @brief Implementación del ejecutivo cíclico (ver cyclic_exec.h)
+ */
+
+#include "cyclic_exec.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "CYCLIC_EXEC";
+
+#define CYCLIC_EXEC_STACK   4096
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+static cyclic_slot_t s_slots[CYCLIC_EXEC_MAX_SLOTS];
+static size_t s_n_slots = 0;
+static uint32_t s_minor_ms = 0;
+static uint32_t s_minor_per_major = 0;
+
+/** Estadísticas: escritas solo por la tarea del ejecutivo, leídas con s_stats_lock */
+static cyclic_slot_stats_t s_stats[CYCLIC_EXEC_MAX_SLOTS];
+static int64_t s_last_release_us[CYCLIC_EXEC_MAX_SLOTS];
+static uint32_t s_frame_overruns = 0;
+static uint32_t s_frames_skipped = 0;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t s_task_handle = NULL;
+
+// ============================================================================
+// TAREA DEL EJECUTIVO
+// ============================================================================
+
+static void cyclic_exec_task(void *pvParameters) {
+    const TickType_t minor_ticks = pdMS_TO_TICKS(s_minor_ms);
+    const int64_t minor_us = (int64_t)s_minor_ms * 1000;
+
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t epoch_us = esp_timer_get_time();
+    uint64_t frame = 0;
+
+    ESP_LOGI(TAG, "Ejecutivo iniciado: marco menor %lu ms, marco mayor %lu ms, %u slots",
+             s_minor_ms, s_minor_ms * s_minor_per_major, (unsigned)s_n_slots);
+
+    for (;;) {
+        int64_t release_us = epoch_us + (int64_t)frame * minor_us;
+        uint32_t minor = (uint32_t)(frame % s_minor_per_major);
+
+        for (size_t i = 0; i < s_n_slots; i++) {
+            const cyclic_slot_t *slot = &s_slots[i];
+            if ((minor % slot->every) != slot->phase) {
+                continue;
+            }
+
+            int64_t start_us = esp_timer_get_time();
+            cyclic_ctx_t ctx = {
+                .release_us = release_us,
+                .period_us = (s_last_release_us[i] != 0) ? release_us - s_last_release_us[i]
+                                                         : (int64_t)slot->every * minor_us,
+                .minor_frame = minor,
+            };
+            s_last_release_us[i] = release_us;
+
+            slot->fn(&ctx);
+
+            int64_t exec_us = esp_timer_get_time() - start_us;
+            int64_t jitter_us = start_us - release_us;
+
+            taskENTER_CRITICAL(&s_stats_lock);
+            cyclic_slot_stats_t *st = &s_stats[i];
+            st->runs++;
+            st->jitter_total_us += jitter_us;
+            st->exec_total_us += exec_us;
+            if (jitter_us > st->jitter_max_us) {
+                st->jitter_max_us = jitter_us;
+            }
+            if (exec_us > st->exec_max_us) {
+                st->exec_max_us = exec_us;
+            }
+            if (exec_us > slot->budget_us) {
+                st->overruns++;
+            }
+            taskEXIT_CRITICAL(&s_stats_lock);
+        }
+
+        frame++;
+
+        // Esperar al inicio del siguiente marco. Si ya pasó, el marco se desbordó:
+        // se saltan los marcos perdidos para mantener la fase en lugar de encadenar ráfagas.
+        if (xTaskDelayUntil(&last_wake, minor_ticks) == pdFALSE) {
+            int64_t now_us = esp_timer_get_time();
+            int64_t late_frames = (now_us - epoch_us) / minor_us - (int64_t)frame + 1;
+            taskENTER_CRITICAL(&s_stats_lock);
+            s_frame_overruns++;
+            if (late_frames > 1) {
+                s_frames_skipped += (uint32_t)(late_frames - 1);
+            }
+            taskEXIT_CRITICAL(&s_stats_lock);
+            if (late_frames > 1) {
+                frame += (uint64_t)(late_frames - 1);
+                last_wake += minor_ticks * (TickType_t)(late_frames - 1);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t cyclic_exec_start(const cyclic_slot_t *slots, size_t n_slots,
+                            uint32_t minor_ms, uint32_t minor_per_major,
+                            UBaseType_t prio) {
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (slots == NULL || n_slots == 0 || n_slots > CYCLIC_EXEC_MAX_SLOTS ||
+        minor_per_major == 0 || pdMS_TO_TICKS(minor_ms) == 0 ||
+        pdMS_TO_TICKS(minor_ms) * portTICK_PERIOD_MS != minor_ms) {
+        ESP_LOGE(TAG, "Configuración de marcos inválida (%lu ms x %lu)", minor_ms, minor_per_major);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint64_t load_us = 0;
+    for (size_t i = 0; i < n_slots; i++) {
+        const cyclic_slot_t *slot = &slots[i];
+        if (slot->fn == NULL || slot->every == 0 || (minor_per_major % slot->every) != 0 ||
+            slot->phase >= slot->every) {
+            ESP_LOGE(TAG, "Slot '%s' no planificable (cada %u, fase %u)",
+                     slot->name, slot->every, slot->phase);
+            return ESP_ERR_INVALID_ARG;
+        }
+        load_us += (uint64_t)slot->budget_us * (minor_per_major / slot->every);
+    }
+
+    // Peor marco menor: suma de presupuestos de los slots que coinciden en él
+    for (uint32_t minor = 0; minor < minor_per_major; minor++) {
+        uint64_t frame_us = 0;
+        for (size_t i = 0; i < n_slots; i++) {
+            if ((minor % slots[i].every) == slots[i].phase) {
+                frame_us += slots[i].budget_us;
+            }
+        }
+        if (frame_us > (uint64_t)minor_ms * 1000) {
+            ESP_LOGE(TAG, "Marco menor %lu sobrecargado: %llu us > %lu ms",
+                     minor, (unsigned long long)frame_us, minor_ms);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memcpy(s_slots, slots, n_slots * sizeof(cyclic_slot_t));
+    memset(s_stats, 0, sizeof(s_stats));
+    memset(s_last_release_us, 0, sizeof(s_last_release_us));
+    s_n_slots = n_slots;
+    s_minor_ms = minor_ms;
+    s_minor_per_major = minor_per_major;
+
+    ESP_LOGI(TAG, "Carga planificada: %llu us por marco mayor de %lu ms (%.1f%%)",
+             (unsigned long long)load_us, minor_ms * minor_per_major,
+             100.0 * (double)load_us / ((double)minor_ms * minor_per_major * 1000.0));
+
+    if (xTaskCreate(cyclic_exec_task, "cyclic_exec", CYCLIC_EXEC_STACK, NULL, prio, &s_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea del ejecutivo");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t cyclic_exec_get_stats(size_t slot, cyclic_slot_stats_t *out) {
+    if (slot >= s_n_slots || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    taskENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats[slot];
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
+
+size_t cyclic_exec_slot_count(void) {
+    return s_n_slots;
+}
+
+const char *cyclic_exec_slot_name(size_t slot) {
+    return (slot < s_n_slots) ? s_slots[slot].name : NULL;
+}
+
+uint32_t cyclic_exec_frame_overruns(void) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    uint32_t overruns = s_frame_overruns;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return overruns;
+}
+
+void cyclic_exec_log_stats(void) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    uint32_t frame_overruns = s_frame_overruns;
+    uint32_t frames_skipped = s_frames_skipped;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    ESP_LOGI(TAG, "Marcos desbordados: %lu (saltados: %lu)", frame_overruns, frames_skipped);
+    for (size_t i = 0; i < s_n_slots; i++) {
+        cyclic_slot_stats_t st;
+        cyclic_exec_get_stats(i, &st);
+        if (st.runs == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-14s runs=%lu jitter med/máx=%lld/%lld us exec med/máx=%lld/%lld us overruns=%lu",
+                 s_slots[i].name, st.runs,
+                 st.jitter_total_us / st.runs, st.jitter_max_us,
+                 st.exec_total_us / st.runs, st.exec_max_us, st.overruns);
+    }
+}
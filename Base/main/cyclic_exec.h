@@ -0,0 +1,111 @@
+/**
+ * @file cyclic_exec.h
+ * @brief Ejecutivo cíclico dirigido por tiempo para las tareas de control de Base
+ *
+ * Una única tarea despierta con xTaskDelayUntil() al inicio de cada marco
+ * menor y ejecuta, en orden fijo, los slots que tocan en ese marco. Un marco
+ * mayor agrupa minor_per_major marcos menores; cada slot se ejecuta cada
+ * `every` marcos menores con un desfase `phase` para repartir la carga.
+ *
+ * Se mide por slot el jitter de liberación (inicio real - inicio planificado
+ * del marco), el tiempo de ejecución y los overruns (ejecución > presupuesto),
+ * y por marco los overruns (el marco no terminó antes del siguiente).
+ */
+
+#ifndef CYCLIC_EXEC_H
+#define CYCLIC_EXEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Número máximo de slots registrables */
+#define CYCLIC_EXEC_MAX_SLOTS   8
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/**
+ * @brief Contexto que recibe cada slot
+ */
+typedef struct {
+    int64_t release_us;     ///< Inicio planificado del marco actual (esp_timer)
+    int64_t period_us;      ///< Tiempo planificado desde la ejecución anterior del slot
+    uint32_t minor_frame;   ///< Índice del marco menor dentro del marco mayor
+} cyclic_ctx_t;
+
+typedef void (*cyclic_slot_fn_t)(const cyclic_ctx_t *ctx);
+
+/**
+ * @brief Definición de un slot
+ */
+typedef struct {
+    const char *name;
+    cyclic_slot_fn_t fn;
+    uint8_t every;          ///< Se ejecuta cada N marcos menores (divisor de minor_per_major)
+    uint8_t phase;          ///< Marco menor en el que se ejecuta (0..every-1)
+    uint32_t budget_us;     ///< Tiempo máximo de ejecución esperado
+} cyclic_slot_t;
+
+/**
+ * @brief Estadísticas de un slot (desde el arranque)
+ */
+typedef struct {
+    uint32_t runs;
+    uint32_t overruns;          ///< Ejecuciones que superaron budget_us
+    int64_t jitter_max_us;      ///< Máximo retraso sobre el inicio planificado
+    int64_t jitter_total_us;
+    int64_t exec_max_us;
+    int64_t exec_total_us;
+} cyclic_slot_stats_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Arranca el ejecutivo
+ *
+ * @param slots Tabla de slots (se copia)
+ * @param n_slots Número de slots (<= CYCLIC_EXEC_MAX_SLOTS)
+ * @param minor_ms Duración del marco menor (múltiplo del tick de FreeRTOS)
+ * @param minor_per_major Marcos menores por marco mayor
+ * @param prio Prioridad de la tarea del ejecutivo
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si la tabla no es planificable
+ */
+esp_err_t cyclic_exec_start(const cyclic_slot_t *slots, size_t n_slots,
+                            uint32_t minor_ms, uint32_t minor_per_major,
+                            UBaseType_t prio);
+
+/**
+ * @brief Copia las estadísticas de un slot
+ */
+esp_err_t cyclic_exec_get_stats(size_t slot, cyclic_slot_stats_t *out);
+
+/**
+ * @brief Número de slots registrados (0 antes de cyclic_exec_start)
+ */
+size_t cyclic_exec_slot_count(void);
+
+/**
+ * @brief Nombre de un slot (NULL si no existe)
+ */
+const char *cyclic_exec_slot_name(size_t slot);
+
+/**
+ * @brief Marcos menores que no terminaron antes del siguiente
+ */
+uint32_t cyclic_exec_frame_overruns(void);
+
+/**
+ * @brief Vuelca por log las estadísticas de todos los slots
+ */
+void cyclic_exec_log_stats(void);
+
+#endif // CYCLIC_EXEC_H
@@ -0,0 +1,174 @@
+/**
+ * @file incline_model.c
+ * @brief Implementación del modelo del actuador de inclinación (ver incline_model.h)
+ */
+
+#include "incline_model.h"
+#include "persist.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "INCLINE_MODEL";
+
+/** Paso del LMS normalizado (fracción del residuo corregida por referencia) */
+#define MODEL_LMS_STEP              0.3f
+
+/**
+ * Escala de la latencia de parada en el LMS (s). Sin ella el gradiente de la
+ * velocidad (segundos de pulso) domina y la latencia apenas se corrige.
+ */
+#define MODEL_LMS_LATENCY_SCALE_S   10.0f
+
+/** Peso de una nueva medida de latencia de arranque (media exponencial) */
+#define MODEL_LATENCY_ALPHA         0.2f
+
+/** Límites de los parámetros aprendidos */
+#define MODEL_RATE_MIN_FACTOR       0.5f
+#define MODEL_RATE_MAX_FACTOR       2.0f
+#define MODEL_LATENCY_MAX_MS        1000.0f
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+static incline_model_t s_model;
+
+/**
+ * Tiempos desde la última referencia (fin de carrera). Los segundos de relé
+ * ya descuentan la latencia de arranque; la inercia se suma por pulso.
+ */
+static struct {
+    float up_s;
+    float down_s;
+    uint32_t up_moves;
+    uint32_t down_moves;
+} s_acc;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+static void model_nominal(incline_model_t *m) {
+    m->up_pct_per_s = INCLINE_MODEL_NOMINAL_PCT_PER_S;
+    m->down_pct_per_s = INCLINE_MODEL_NOMINAL_PCT_PER_S;
+    m->start_latency_ms = 0.0f;
+    m->stop_latency_ms = 0.0f;
+    m->samples = 0;
+}
+
+static bool model_valid(const incline_model_t *m) {
+    float rate_min = INCLINE_MODEL_NOMINAL_PCT_PER_S * MODEL_RATE_MIN_FACTOR;
+    float rate_max = INCLINE_MODEL_NOMINAL_PCT_PER_S * MODEL_RATE_MAX_FACTOR;
+    return m->up_pct_per_s >= rate_min && m->up_pct_per_s <= rate_max &&
+           m->down_pct_per_s >= rate_min && m->down_pct_per_s <= rate_max &&
+           m->start_latency_ms >= 0.0f && m->start_latency_ms <= MODEL_LATENCY_MAX_MS &&
+           m->stop_latency_ms >= 0.0f && m->stop_latency_ms <= MODEL_LATENCY_MAX_MS;
+}
+
+static float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/** Segundos de movimiento de un pulso de on_us (descontada la latencia de arranque) */
+static float moving_s(int64_t on_us) {
+    float s = (float)on_us / 1e6f - s_model.start_latency_ms / 1000.0f;
+    return s > 0.0f ? s : 0.0f;
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+void incline_model_init(void) {
+    incline_model_t stored;
+    if (persist_boot_incline_model(&stored, sizeof(stored)) && model_valid(&stored)) {
+        s_model = stored;
+    } else {
+        model_nominal(&s_model);
+    }
+    incline_model_reference();
+    incline_model_log();
+}
+
+const incline_model_t *incline_model_get(void) {
+    return &s_model;
+}
+
+float incline_model_travel_pct(bool up, int64_t on_us) {
+    return (up ? s_model.up_pct_per_s : s_model.down_pct_per_s) * moving_s(on_us);
+}
+
+float incline_model_coast_pct(bool up) {
+    return (up ? s_model.up_pct_per_s : s_model.down_pct_per_s) * s_model.stop_latency_ms / 1000.0f;
+}
+
+float incline_model_min_step_pct(bool up) {
+    return incline_model_travel_pct(up, (int64_t)INCLINE_MODEL_MIN_ON_MS * 1000) + incline_model_coast_pct(up);
+}
+
+void incline_model_move_done(bool up, int64_t on_us) {
+    if (up) {
+        s_acc.up_s += moving_s(on_us);
+        s_acc.up_moves++;
+    } else {
+        s_acc.down_s += moving_s(on_us);
+        s_acc.down_moves++;
+    }
+}
+
+bool incline_model_limit_hit(float residual_pct, int64_t down_on_us) {
+    float down_s = s_acc.down_s + moving_s(down_on_us);
+    float coast_s = s_model.stop_latency_ms / 1000.0f;
+    bool learned = false;
+
+    if (fabsf(residual_pct) <= INCLINE_MODEL_MAX_RESIDUAL_PCT) {
+        // residuo = v_up·(T_up + n_up·L) − v_down·(T_down + n_down·L), con el
+        // pulso que llegó al fin de carrera sin inercia propia
+        float g_rate = s_acc.up_s + (float)s_acc.up_moves * coast_s;
+        float g_latency = (s_model.up_pct_per_s * (float)s_acc.up_moves -
+                           s_model.down_pct_per_s * (float)s_acc.down_moves) * MODEL_LMS_LATENCY_SCALE_S;
+        float norm = g_rate * g_rate + g_latency * g_latency;
+        if (norm > 1e-3f) {
+            float k = MODEL_LMS_STEP * residual_pct / norm;
+            s_model.up_pct_per_s = clampf(s_model.up_pct_per_s - k * g_rate,
+                                          INCLINE_MODEL_NOMINAL_PCT_PER_S * MODEL_RATE_MIN_FACTOR,
+                                          INCLINE_MODEL_NOMINAL_PCT_PER_S * MODEL_RATE_MAX_FACTOR);
+            s_model.stop_latency_ms = clampf(s_model.stop_latency_ms - k * g_latency * MODEL_LMS_LATENCY_SCALE_S * 1000.0f,
+                                             0.0f, MODEL_LATENCY_MAX_MS);
+            s_model.samples++;
+            persist_set_incline_model(&s_model, sizeof(s_model));
+            learned = true;
+        }
+        ESP_LOGI(TAG, "Referencia: residuo %.3f%% (subida %.1f s/%lu pulsos, bajada %.1f s/%lu pulsos)",
+                 residual_pct, s_acc.up_s, s_acc.up_moves, down_s, s_acc.down_moves);
+    } else {
+        ESP_LOGW(TAG, "Residuo %.2f%% fuera de rango: no se aprende", residual_pct);
+    }
+
+    incline_model_reference();
+    if (learned) {
+        incline_model_log();
+    }
+    return learned;
+}
+
+void incline_model_reference(void) {
+    memset(&s_acc, 0, sizeof(s_acc));
+}
+
+void incline_model_start_latency(int64_t latency_us) {
+    float ms = (float)latency_us / 1000.0f;
+    if (ms < 0.0f || ms > MODEL_LATENCY_MAX_MS) {
+        return;
+    }
+    s_model.start_latency_ms += MODEL_LATENCY_ALPHA * (ms - s_model.start_latency_ms);
+    persist_set_incline_model(&s_model, sizeof(s_model));
+    ESP_LOGD(TAG, "Latencia de arranque medida: %.0f ms (modelo %.0f ms)", ms, s_model.start_latency_ms);
+}
+
+void incline_model_log(void) {
+    ESP_LOGI(TAG, "Subida %.3f %%/s, bajada %.3f %%/s, latencia arranque/parada %.0f/%.0f ms (%lu referencias)",
+             s_model.up_pct_per_s, s_model.down_pct_per_s,
+             s_model.start_latency_ms, s_model.stop_latency_ms, s_model.samples);
+}
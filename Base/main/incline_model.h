@@ -0,0 +1,119 @@
+/**
+ * @file incline_model.h
+ * @brief Modelo aprendido del actuador de inclinación
+ *
+ * La posición del actuador no se mide: se estima por tiempo de relé. El
+ * modelo describe un pulso de relé con velocidades distintas al subir y al
+ * bajar, una latencia de arranque (relé ON → movimiento) y una latencia de
+ * parada (relé OFF → reposo, inercia incluida):
+ *
+ *   recorrido = velocidad × (t_on − latencia_arranque + latencia_parada)
+ *
+ * El control usa la latencia de parada para cortar el relé antes de llegar
+ * al objetivo, de forma que el actuador se detiene sobre él.
+ *
+ * Aprendizaje (solo la tarea del ejecutivo llama a este módulo):
+ * - Latencia de arranque: medida directa al subir desde el fin de carrera
+ *   (relé ON → flanco de liberación del fin de carrera).
+ * - Velocidad de subida y latencia de parada: cada vez que un descenso
+ *   calibrado alcanza el fin de carrera, la posición estimada en ese instante
+ *   debería ser 0%. El residuo corrige ambos parámetros (LMS normalizado)
+ *   con los tiempos acumulados desde la referencia anterior.
+ * - Velocidad de bajada: con un solo punto de referencia no es observable por
+ *   separado (escalar ambas velocidades no cambia el residuo), así que fija
+ *   la escala del porcentaje y se mantiene en su valor nominal.
+ *
+ * Los parámetros aprendidos se guardan en NVS mediante el servicio persist.
+ */
+
+#ifndef INCLINE_MODEL_H
+#define INCLINE_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Velocidad nominal del actuador: 0-15% en 40 segundos */
+#define INCLINE_MODEL_NOMINAL_PCT_PER_S     0.375f
+
+/** Tiempos mínimos de relé (evitan el traqueteo con cambios pequeños de consigna) */
+#define INCLINE_MODEL_MIN_ON_MS             250
+#define INCLINE_MODEL_MIN_OFF_MS            500
+
+/** Residuos mayores se descartan (fin de carrera ajeno al modelo, pérdida de pasos) */
+#define INCLINE_MODEL_MAX_RESIDUAL_PCT      3.0f
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+typedef struct {
+    float up_pct_per_s;         ///< Velocidad subiendo
+    float down_pct_per_s;       ///< Velocidad bajando (escala de referencia)
+    float start_latency_ms;     ///< Relé ON → inicio del movimiento
+    float stop_latency_ms;      ///< Relé OFF → reposo (inercia)
+    uint32_t samples;           ///< Referencias aprendidas desde valores nominales
+} incline_model_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Carga el modelo guardado (o el nominal). Requiere persist_init() previo.
+ */
+void incline_model_init(void);
+
+/**
+ * @brief Modelo actual (solo lectura)
+ */
+const incline_model_t *incline_model_get(void);
+
+/**
+ * @brief Recorrido previsto tras on_us con el relé activado (sin inercia)
+ */
+float incline_model_travel_pct(bool up, int64_t on_us);
+
+/**
+ * @brief Recorrido por inercia tras cortar el relé
+ */
+float incline_model_coast_pct(bool up);
+
+/**
+ * @brief Recorrido mínimo de un pulso (INCLINE_MODEL_MIN_ON_MS + inercia)
+ */
+float incline_model_min_step_pct(bool up);
+
+/**
+ * @brief Pulso terminado con corte de relé (acumula tiempos para el aprendizaje)
+ */
+void incline_model_move_done(bool up, int64_t on_us);
+
+/**
+ * @brief Descenso calibrado detenido por el fin de carrera
+ *
+ * @param residual_pct Posición estimada en el flanco (la real es 0%)
+ * @param down_on_us   Tiempo con el relé activado hasta el flanco
+ * @return true si el residuo se usó para aprender
+ */
+bool incline_model_limit_hit(float residual_pct, int64_t down_on_us);
+
+/**
+ * @brief Nueva referencia sin aprendizaje (homing, pérdida de calibración)
+ */
+void incline_model_reference(void);
+
+/**
+ * @brief Medida directa de la latencia de arranque
+ */
+void incline_model_start_latency(int64_t latency_us);
+
+/**
+ * @brief Vuelca por log los parámetros
+ */
+void incline_model_log(void);
+
+#endif // INCLINE_MODEL_H
@@ -5,16 +5,32 @@
 
 #include "vfd_driver.h"
 #include "speed_sensor.h"
+#include "speed_loop.h"
+#include "cyclic_exec.h"
+#include "persist.h"
+#include "incline_model.h"
+#include "blackbox.h"
+#include "stats_report.h"
+#include "motion_profile.h"
+#include "actuators.h"
+#include "base_hal.h"
+#include "cm_protocol.h"
+#include "cm_schema.h"
+#include "cm_line.h"
+#include "cm_clock.h"
+#include "cm_capture.h"
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
 #include "esp_timer.h"
-#include "nvs_flash.h"
-#include "driver/uart.h"
-#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "soc/soc_caps.h"
+#include "state_latch.h"
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
 
 // ===========================================================================
 // PROTOCOLO SYNC SIMPLIFICADO
@@ -28,156 +44,437 @@ typedef enum {
     INCLINE_MOTOR_HOMING
 } incline_motor_state_t;
 
-// Buffer para líneas UART
-#define UART_LINE_BUFFER_SIZE 128
 // ===========================================================================
 
 
 static const char *TAG = "SLAVE";
 
-// NOTA: Sensor Hall desconectado por problemas de ruido
-// La velocidad ahora se calcula desde la frecuencia real del VFD (registro 0x2103)
-// Fórmula: velocidad_kmh = vfd_freq_hz × (6.4 / 50.0) = vfd_freq_hz × 0.128
-// static float g_calibration_factor = 0.0174;  // YA NO SE USA - Sensor Hall deshabilitado
-#define SPEED_UPDATE_INTERVAL_MS 500
+// Velocidad real: por defecto desde la frecuencia real del VFD (registro 0x2103),
+// velocidad_kmh = vfd_freq_hz × (6.4 / 50.0) = vfd_freq_hz × 0.128.
+// Con CONFIG_BASE_SPEED_SENSOR_ENABLE viene del sensor Hall por captura MCPWM
+// (speed_sensor.c) y el VFD queda como respaldo si el sensor no es plausible
+#define SPEED_UPDATE_INTERVAL_MS 100
+#define SPEED_SENSOR_PLAUSIBLE_KMH 1.0f  // VFD por encima y sensor parado: sensor desconectado
+static uint32_t g_speed_sensor_fallbacks = 0;  // Solo slot "speed"
 
 // ===========================================================================
 // CONFIGURACIÓN UART (a Consola v2.1)
 // ===========================================================================
-#define UART_PORT_NUM       UART_NUM_1
 #define UART_BAUD_RATE      115200
 #define UART_TX_PIN         17  // Asignación v5
 #define UART_RX_PIN         16  // Asignación v5
 #define UART_BUF_SIZE 512
+#if CONFIG_BASE_VFD_SELF_TEST
+#define VFD_TEST_REQUEST_PREFIX "VFDTEST="  // Pruebas de latencia del VFD (solo banco de pruebas)
+#endif
 
 // ===========================================================================
 // ASIGNACIÓN DE PINES (v6)
 // ===========================================================================
-// #define SENSOR_SPEED_PIN        15 // DESHABILITADO: Sensor Hall desconectado físicamente por problemas de ruido
+// Sensor Hall de velocidad (CONFIG_BASE_SPEED_SENSOR_ENABLE): SPEED_SENSOR_GPIO en speed_sensor.c
 #define INCLINE_LIMIT_SWITCH_PIN 21 // (Entrada con pull-up interno)
-#define HEAD_FAN_ON_OFF_PIN     26 // Relé 6 - ON/OFF del ventilador
-#define HEAD_FAN_SPEED_PIN      27 // Relé 7 - Selector velocidad (NC=normal, NO=fuerte)
-#define CHEST_FAN_ON_OFF_PIN    14 // Relé 2 - ON/OFF del ventilador
-#define CHEST_FAN_SPEED_PIN     13 // Relé 1 - Selector velocidad (NC=normal, NO=fuerte)
-#define INCLINE_ON_OFF_PIN      33 // Relé 4 - ON/OFF del actuador
-#define INCLINE_DIRECTION_PIN   32 // Relé 5 - Selector dirección (NC=arriba, NO=abajo)
-#define WAX_PUMP_RELAY_PIN      25 // Relé 3
+// Relés 1-7 (ventiladores, actuador de inclinación, bomba de cera): actuators.c
+#if CONFIG_BASE_ESTOP_ENABLE
+#define ESTOP_INPUT_PIN         CONFIG_BASE_ESTOP_GPIO // Seta de emergencia (contacto NC a GND, pull-up interno)
+#define ESTOP_TRIPPED_LEVEL     1  // Contacto abierto (seta pulsada o cable cortado)
+#endif
 
 // ===========================================================================
 // GLOBALES DE ESTADO
 // ===========================================================================
-SemaphoreHandle_t g_speed_mutex;
-static bool g_emergency_state = false;
-static uint64_t g_last_command_time_us = 0;
-#define WATCHDOG_TIMEOUT_US (1000 * 1000) // 1000ms (1 segundo)
-static float g_real_speed_kmh = 0.0f;
-static float g_target_speed_kmh = 0.0f;
+//
+// El estado se reparte por dominios, sin un mutex global:
+// - Consignas y flags con varios escritores: atómicos de 32 bits (sin bloqueo).
+// - Estado interno de inclinación: propiedad exclusiva del slot "incline" del
+//   ejecutivo; el resto de tareas lo ven a través de g_incline_pub (latch) y
+//   le piden cambios con g_incline_requests.
+// - Las acciones lentas (Modbus, NVS) nunca se ejecutan dentro de una sección
+//   crítica.
+
+// --- Enlace / seguridad ---
+static atomic_bool g_emergency_state = false;
+// Watchdog de comunicación: esp_timer one-shot rearmado con cada trama válida
+static esp_timer_handle_t g_comm_watchdog_timer;
+static atomic_uint g_last_frame_us = 0;         // 32 bits bajos de esp_timer (diferencias módulo 2^32)
+static atomic_bool g_link_seen = false;         // Se recibió al menos una trama válida
+static atomic_uint g_watchdog_trips = 0;
+static atomic_uint g_watchdog_late_max_us = 0;  // Máximo retraso del disparo sobre el timeout
+static atomic_uint g_sync_ok_count = 0;         // SYNC válidos (caja negra: diferencias por muestra)
+static atomic_uint g_frames_bad_count = 0;      // Tramas inválidas o desconocidas
+static atomic_uint g_uart_overruns = 0;         // FIFO o buffer de recepción lleno
+static atomic_uint g_uart_errors = 0;           // Error de trama o paridad
+static atomic_uint g_line_overflows = 0;        // Líneas de más de CM_LINE_BUFFER_SIZE
+#define WATCHDOG_TIMEOUT_US ((uint64_t)CONFIG_BASE_COMM_WATCHDOG_TIMEOUT_MS * 1000ULL)
+#define WATCHDOG_STARTUP_GRACE_US (2000 * 1000ULL)  // Primer disparo posible a los 2 s del arranque
+static atomic_bool g_incline_sensor_fault = false;  // Error crítico: fin de carrera no funciona
+// Parada de emergencia (seta o trama EMERGENCY_STOP): la velocidad queda a 0
+// hasta que la Consola pida 0 km/h, para que no se rearranque sola
+static atomic_bool g_estop_rearm_required = false;
+static atomic_bool g_estop_input_active = false;    // Seta pulsada: no se sale del safe state
+static bool g_training_mode = false;  // Solo uart_rx_task. false = pantalla inicial, true = entrenando
+
+// --- Velocidad ---
+static _Atomic float g_real_speed_kmh = 0.0f;    // Escritor: slot "speed"
+static _Atomic float g_target_speed_kmh = 0.0f;  // Escritores: uart_rx_task, slot "profile", enter_safe_state
+
+// --- Inclinación: consignas y peticiones (cualquier tarea) ---
+static _Atomic float g_target_incline_pct = 0.0f;
+#define INCLINE_REQ_UNCALIBRATE  0x01  // Forzar homing cuando el motor se detenga
+#define INCLINE_REQ_HOMING       0x02  // Iniciar homing inmediatamente
+static atomic_uint g_incline_requests = 0;
+
+// --- Inclinación: estado interno (solo slot "incline" del ejecutivo) ---
 static float g_real_incline_pct = 0.0f;
-static float g_target_incline_pct = 0.0f;
 static bool g_incline_is_calibrated = false;
 static incline_motor_state_t g_incline_motor_state = INCLINE_MOTOR_STOPPED;
-#define INCLINE_SPEED_PCT_PER_MS (0.375f / 1000.0f)  // 0-15% en 40 segundos (0.375%/segundo)
+#define INCLINE_DEADBAND_PCT 0.1f           // Error mínimo para mover el actuador
 #define INCLINE_SAFETY_THRESHOLD_PCT -2.0f  // Si baja más de -2%, el fin de carrera falló
-static bool g_incline_sensor_fault = false;  // Error crítico: fin de carrera no funciona
+#define INCLINE_TIMEOUT_MARGIN_MS 5000      // Margen de los timeouts de homing y descenso a cero
+static int64_t g_move_on_us = 0;               // Activación del relé del pulso UP/DOWN en curso (0 = ninguno)
+static float g_move_start_pct = 0.0f;          // Posición al activar el relé
+static int64_t g_relay_off_us = 0;             // Último corte del relé (tiempo mínimo apagado)
+static int64_t g_selector_us = 0;              // Último cambio del selector de dirección
+#define INCLINE_SELECTOR_DEAD_MS 50            // Tiempo muerto entre ON/OFF y selector (un paso del slot)
 static float g_last_saved_incline_pct = 0.0f;  // Última posición guardada en NVS
 static uint32_t g_homing_timeout_ms = 5000;    // Timeout dinámico para homing (calculado desde NVS)
 static uint64_t g_homing_start_time_us = 0;    // Timestamp de inicio del homing
 static uint64_t g_descend_to_zero_start_time_us = 0;  // Timestamp de inicio de descenso a 0%
 static uint32_t g_descend_to_zero_timeout_ms = 0;     // Timeout dinámico para descenso a 0%
-static uint8_t g_head_fan_state = 0;
-static uint8_t g_chest_fan_state = 0;
-static uint8_t g_wax_pump_relay_state = 0;
-static bool g_training_mode = false;  // false = pantalla inicial, true = entrenando
-static esp_timer_handle_t wax_pump_timer_handle;
-#define WAX_PUMP_ACTIVATION_DURATION_MS 5000
+
+// --- Inclinación: estado publicado para el resto de tareas ---
+typedef struct {
+    float real_pct;
+    bool calibrated;
+    incline_motor_state_t motor_state;
+} incline_pub_t;
+static STATE_LATCH_T(incline_pub_t) g_incline_pub;
+
+// --- Ventiladores y bomba de cera: peticiones y relés en actuators.c ---
+
+// Fin de carrera: la ISR (IRAM, datos en DRAM) filtra el pulso, corta el relé
+// ON/OFF del actuador y marca el instante del flanco. El slot de inclinación
+// completa la parada y corrige la posición con ese instante en su siguiente
+// ejecución, también si el flanco llegó con la caché de flash deshabilitada
+#define LIMIT_SWITCH_GLITCH_US  5   // Duración mínima del nivel bajo (filtro en la ISR)
+static DRAM_ATTR atomic_bool s_limit_armed = false;    // Solo bajando u homing
+static DRAM_ATTR atomic_bool s_limit_latched = false;
+static DRAM_ATTR atomic_uint s_limit_edge_us = 0;      // 32 bits bajos de esp_timer
+static DRAM_ATTR atomic_bool s_release_armed = false;  // Subiendo desde el fin de carrera
+static DRAM_ATTR atomic_bool s_release_latched = false;
+static DRAM_ATTR atomic_uint s_release_edge_us = 0;    // Liberación: mide la latencia de arranque
+static DRAM_ATTR atomic_uint s_limit_glitches = 0;     // Pulsos descartados por el filtro
+
+// Seta de emergencia: la ISR pide el STOP al VFD y corta el actuador sin
+// esperar a ninguna tarea; el slot "estop" completa el safe state
+#define ESTOP_GLITCH_US         5   // Duración mínima del nivel de disparo
+static DRAM_ATTR atomic_bool s_estop_input_latched = false;
+
+// Reloj de Consola (adoptado de la estimación que llega en cada SYNC)
+static cm_clock_t g_clock;
+static portMUX_TYPE g_clock_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // ===========================================================================
 // TAREAS Y FUNCIONES DE BAJO NIVEL
 // ===========================================================================
 
 /**
- * @brief Guarda la posición actual de inclinación en NVS
+ * @brief Publica el estado de inclinación para las demás tareas
+ *
+ * Solo desde la tarea del ejecutivo (propietaria del estado de inclinación).
+ * La posición se entrega también al servicio de persistencia, que la guarda
+ * en RTC al momento y en NVS cuando el actuador queda parado.
+ */
+static void publish_incline_state(void) {
+    incline_pub_t pub = {
+        .real_pct = g_real_incline_pct,
+        .calibrated = g_incline_is_calibrated,
+        .motor_state = g_incline_motor_state,
+    };
+    state_latch_publish(&g_incline_pub, pub);
+    persist_set_incline_position(g_real_incline_pct);
+}
+
+/**
+ * @brief ISR del fin de carrera (IRAM; solo toca datos en DRAM y registros GPIO)
  *
- * Se guarda multiplicada por 100 como entero para evitar problemas de precisión float.
- * Esta posición se usa para calcular el timeout dinámico de homing en el próximo arranque.
+ * Pulsación: solo el primer flanco válido de cada descenso. Liberación: solo
+ * el primer flanco válido al subir desde el fin de carrera. El ESP32 no tiene
+ * filtro de glitches por pin: el nivel debe mantenerse LIMIT_SWITCH_GLITCH_US
+ * para descartar los picos que inducen los propios relés al conmutar. En
+ * chips con filtro hardware lo hace el periférico.
  */
-static void save_incline_position_to_nvs(float position_pct) {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (err == ESP_OK) {
-        int32_t position_x100 = (int32_t)(position_pct * 100.0f);  // Guardar como entero
-        nvs_set_i32(nvs_handle, "incline_pos", position_x100);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-        ESP_LOGD(TAG, "Posición de inclinación guardada en NVS: %.1f%%", position_pct);
+static void IRAM_ATTR limit_switch_isr(void *arg) {
+    uint32_t edge_us = (uint32_t)esp_timer_get_time();
+    uint32_t level = base_hal_gpio_read(INCLINE_LIMIT_SWITCH_PIN);
+    if (level == 0) {
+        if (!atomic_load_explicit(&s_limit_armed, memory_order_relaxed) ||
+            atomic_load_explicit(&s_limit_latched, memory_order_relaxed)) {
+            return;
+        }
+    } else if (!atomic_load_explicit(&s_release_armed, memory_order_relaxed) ||
+               atomic_load_explicit(&s_release_latched, memory_order_relaxed)) {
+        return;
+    }
+#if !SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    for (int i = 0; i < LIMIT_SWITCH_GLITCH_US; i++) {
+        base_hal_delay_us(1);
+        if (base_hal_gpio_read(INCLINE_LIMIT_SWITCH_PIN) != level) {
+            atomic_fetch_add_explicit(&s_limit_glitches, 1, memory_order_relaxed);
+            return;
+        }
+    }
+#endif
+    if (level == 0) {
+        // Cortar el actuador ya; el selector de dirección lo repone el slot
+        // (primero ON/OFF y después dirección, nunca al revés)
+        actuators_cut_from_isr(ACT_BIT(ACT_RELAY_INCLINE_ON));
+        atomic_store_explicit(&s_limit_edge_us, edge_us, memory_order_relaxed);
+        atomic_store_explicit(&s_limit_latched, true, memory_order_release);
+    } else {
+        atomic_store_explicit(&s_release_edge_us, edge_us, memory_order_relaxed);
+        atomic_store_explicit(&s_release_latched, true, memory_order_release);
     }
 }
 
+#if CONFIG_BASE_ESTOP_ENABLE
 /**
- * @brief Carga la posición de inclinación guardada desde NVS
+ * @brief ISR de la seta de emergencia (IRAM; solo datos en DRAM y registros GPIO)
  *
- * @return Posición en %, o 0.0 si no hay datos guardados
- */
-static float load_incline_position_from_nvs(void) {
-    nvs_handle_t nvs_handle;
-    float position_pct = 0.0f;
-
-    esp_err_t err = nvs_open("storage", NVS_READONLY, &nvs_handle);
-    if (err == ESP_OK) {
-        int32_t position_x100 = 0;
-        err = nvs_get_i32(nvs_handle, "incline_pos", &position_x100);
-        if (err == ESP_OK) {
-            position_pct = (float)position_x100 / 100.0f;
-            ESP_LOGI(TAG, "Posición de inclinación cargada desde NVS: %.1f%%", position_pct);
+ * vfd_driver_emergency_stop() aborta la transacción Modbus en curso y
+ * despierta a la tarea que envía el STOP; el resto del safe state (ventiladores,
+ * consignas) lo completa el slot "estop" en menos de un marco menor.
+ */
+static void IRAM_ATTR estop_input_isr(void *arg) {
+    for (int i = 0; i < ESTOP_GLITCH_US; i++) {
+        if (base_hal_gpio_read(ESTOP_INPUT_PIN) != ESTOP_TRIPPED_LEVEL) {
+            return;
         }
-        nvs_close(nvs_handle);
+        base_hal_delay_us(1);
+    }
+    actuators_cut_from_isr(ACT_BIT(ACT_RELAY_INCLINE_ON));
+    vfd_driver_emergency_stop();
+    atomic_store_explicit(&s_estop_input_latched, true, memory_order_release);
+}
+#endif
+
+/**
+ * @brief Empieza a capturar flancos del fin de carrera (al iniciar un descenso)
+ *
+ * Los flancos de subida (rebotes al soltar el fin de carrera) no se capturan.
+ */
+static void limit_switch_arm(void) {
+    if (!atomic_load(&s_limit_armed)) {
+        atomic_store(&s_limit_latched, false);
+        atomic_store(&s_limit_armed, true);
     }
+}
+
+/**
+ * @brief true si el fin de carrera se pulsó (ISR) o está pulsado (sondeo)
+ *
+ * @param[out] edge_us Instante del flanco (32 bits bajos de esp_timer); si
+ *                     no hubo flanco capturado, el instante del sondeo
+ */
+static bool limit_switch_hit(uint32_t *edge_us) {
+    if (atomic_load_explicit(&s_limit_latched, memory_order_acquire)) {
+        *edge_us = atomic_load_explicit(&s_limit_edge_us, memory_order_relaxed);
+        return true;
+    }
+    if (base_hal_gpio_read(INCLINE_LIMIT_SWITCH_PIN) == 0) {
+        *edge_us = (uint32_t)esp_timer_get_time();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Lleva el selector de dirección a su posición por etapas
+ *
+ * Como los ventiladores (actuators.c): el selector solo se mueve con ON/OFF
+ * abierto desde hace INCLINE_SELECTOR_DEAD_MS, y ON/OFF no se cierra hasta
+ * INCLINE_SELECTOR_DEAD_MS después de moverlo. Una etapa por paso del slot.
+ *
+ * @return true si el selector está en posición y asentado (se puede cerrar ON/OFF)
+ */
+static bool incline_selector_ready(bool down, int64_t now_us) {
+    const int64_t dead_us = (int64_t)INCLINE_SELECTOR_DEAD_MS * 1000;
+    uint32_t relays = actuators_relays();
+    bool is_down = (relays & ACT_BIT(ACT_RELAY_INCLINE_DOWN)) != 0;
+
+    if (is_down == down) {
+        return now_us - g_selector_us >= dead_us;
+    }
+    if (relays & ACT_BIT(ACT_RELAY_INCLINE_ON)) {
+        // Cambio de dirección en marcha (homing pedido durante un pulso UP)
+        actuators_write(0, ACT_BIT(ACT_RELAY_INCLINE_ON));
+        g_relay_off_us = now_us;
+        return false;
+    }
+    if (now_us - g_relay_off_us < dead_us) {
+        return false;
+    }
+    if (down) {
+        actuators_write(ACT_BIT(ACT_RELAY_INCLINE_DOWN), 0);
+    } else {
+        actuators_write(0, ACT_BIT(ACT_RELAY_INCLINE_DOWN));
+    }
+    g_selector_us = now_us;
+    return false;
+}
 
-    return position_pct;
+/**
+ * @brief Activa el actuador hacia abajo sin pisar un corte de la ISR
+ *
+ * Con el selector aún arriba solo avanza una etapa (ver
+ * incline_selector_ready()). Si el flanco llega entre la comprobación del
+ * slot y la activación, el relé se vuelve a cortar aquí en lugar de quedar
+ * encendido hasta el siguiente paso.
+ */
+static void incline_drive_down(int64_t now_us) {
+    if (!incline_selector_ready(true, now_us)) {
+        return;
+    }
+    actuators_write(ACT_BIT(ACT_RELAY_INCLINE_ON), 0);
+    if (atomic_load(&s_limit_latched)) {
+        actuators_write(0, ACT_BIT(ACT_RELAY_INCLINE_ON));
+    }
 }
 
+/**
+ * @brief Detiene el actuador de inclinación (solo desde la tarea del ejecutivo)
+ *
+ * Si corta un pulso UP/DOWN, la posición final es la del modelo: recorrido
+ * con el relé activado más la inercia tras el corte.
+ */
 static void stop_incline_motor(void) {
-    gpio_set_level(INCLINE_ON_OFF_PIN, 0);       // 0 = OFF - Apaga el actuador (HIGH=ON)
-    gpio_set_level(INCLINE_DIRECTION_PIN, 0);    // 0 = Resetear selector (arriba) por defecto (HIGH=ON)
+    // Solo abre ON/OFF: el selector vuelve a reposo (arriba) desde STOPPED,
+    // pasado el tiempo muerto (incline_selector_ready())
+    actuators_write(0, ACT_BIT(ACT_RELAY_INCLINE_ON));
+    int64_t now_us = esp_timer_get_time();
+    if (g_move_on_us != 0) {
+        bool up = g_incline_motor_state == INCLINE_MOTOR_UP;
+        float travel_pct = incline_model_travel_pct(up, now_us - g_move_on_us) + incline_model_coast_pct(up);
+        g_real_incline_pct = g_move_start_pct + (up ? travel_pct : -travel_pct);
+        incline_model_move_done(up, now_us - g_move_on_us);
+        g_move_on_us = 0;
+    }
+    g_relay_off_us = now_us;
     g_incline_motor_state = INCLINE_MOTOR_STOPPED;
+    atomic_store(&s_limit_armed, false);
+    atomic_store(&s_release_armed, false);
+}
 
-    // Guardar posición actual en NVS para protección de homing en próximo arranque
-    save_incline_position_to_nvs(g_real_incline_pct);
+/**
+ * @brief Inicia un pulso UP/DOWN (solo desde el estado STOPPED calibrado)
+ *
+ * El selector ya está en posición (incline_selector_ready()): el relé se
+ * cierra ahora y g_move_on_us es el instante real de activación.
+ */
+static void incline_move_start(bool up, int64_t now_us) {
+    g_incline_motor_state = up ? INCLINE_MOTOR_UP : INCLINE_MOTOR_DOWN;
+    g_move_on_us = now_us;
+    g_move_start_pct = g_real_incline_pct;
+    if (up) {
+        // Subiendo desde el fin de carrera: la liberación mide la latencia de arranque
+        if (base_hal_gpio_read(INCLINE_LIMIT_SWITCH_PIN) == 0) {
+            atomic_store(&s_release_latched, false);
+            atomic_store(&s_release_armed, true);
+        }
+        actuators_write(ACT_BIT(ACT_RELAY_INCLINE_ON), 0);
+    } else {
+        limit_switch_arm();
+        incline_drive_down(now_us);
+    }
 }
 
+/**
+ * @brief Estado seguro: VFD parado, relés abiertos, consignas a cero
+ *
+ * Llamado desde el callback del watchdog (tarea de esp_timer) y desde la tarea
+ * del ejecutivo (fallo de sensor). No toca el estado interno de inclinación:
+ * corta los relés del actuador y el slot de inclinación completa la parada en
+ * su siguiente ejecución.
+ */
 static void enter_safe_state(void) {
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    if (!g_emergency_state) {
+    if (!atomic_exchange(&g_emergency_state, true)) {
         ESP_LOGW(TAG, "⚠️ ENTERING SAFE STATE - Communication lost or emergency stop");
-        g_emergency_state = true;
+        blackbox_event(CM_BBOX_EVT_SAFE_ENTER);
+        blackbox_trigger(CM_BBOX_REASON_SAFE_STATE);  // Sin efecto si el llamante ya dio el motivo
     }
     vfd_driver_emergency_stop(); // <-- CORRECCIÓN DE SEGURIDAD
-    g_target_speed_kmh = 0.0f;
-    g_target_incline_pct = 0.0f;
-    g_head_fan_state = 0;
-    g_chest_fan_state = 0;
-    g_wax_pump_relay_state = 0;
-    gpio_set_level(HEAD_FAN_ON_OFF_PIN, 0);      // 0 = OFF (HIGH=ON)
-    gpio_set_level(HEAD_FAN_SPEED_PIN, 0);       // 0 = OFF (HIGH=ON)
-    gpio_set_level(CHEST_FAN_ON_OFF_PIN, 0);     // 0 = OFF (HIGH=ON)
-    gpio_set_level(CHEST_FAN_SPEED_PIN, 0);      // 0 = OFF (HIGH=ON)
-    gpio_set_level(WAX_PUMP_RELAY_PIN, 0);       // 0 = OFF (HIGH=ON)
-    stop_incline_motor();
-    if (esp_timer_is_active(wax_pump_timer_handle)) {
-        ESP_ERROR_CHECK(esp_timer_stop(wax_pump_timer_handle));
-    }
-    xSemaphoreGive(g_speed_mutex);
+    motion_profile_abort("safe state");
+    atomic_store(&g_target_speed_kmh, 0.0f);
+    atomic_store(&g_target_incline_pct, 0.0f);
+    actuators_all_off();  // Todos los relés en una escritura por banco
+    // Sin comunicación la Consola puede estar perdiendo alimentación: volcar ya
+    persist_flush_hint();
 }
 
+/**
+ * @brief Trama válida recibida: rearma el watchdog y sale del safe state
+ */
 static void reset_safe_state(void) {
-    if (g_emergency_state) {
+    atomic_store(&g_last_frame_us, (uint32_t)esp_timer_get_time());
+    atomic_store(&g_link_seen, true);
+    if (esp_timer_restart(g_comm_watchdog_timer, WATCHDOG_TIMEOUT_US) != ESP_OK) {
+        // No estaba armado (arranque o tras un disparo)
+        esp_timer_start_once(g_comm_watchdog_timer, WATCHDOG_TIMEOUT_US);
+    }
+
+    // Con la seta pulsada el enlace no saca del safe state
+    if (atomic_load(&g_estop_input_active)) {
+        return;
+    }
+
+    if (atomic_exchange(&g_emergency_state, false)) {
         ESP_LOGI(TAG, "✅ SAFE STATE reset. Communication restored.");
-        g_emergency_state = false;
+        blackbox_event(CM_BBOX_EVT_SAFE_EXIT);
         // Limpiar buffer UART para eliminar basura acumulada durante el timeout
-        uart_flush(UART_PORT_NUM);
+        base_hal_uart_flush();
         ESP_LOGD(TAG, "Buffer UART limpiado");
     }
-    g_last_command_time_us = esp_timer_get_time();
+}
+
+/**
+ * @brief Disparo del watchdog de comunicación (tarea de esp_timer)
+ *
+ * Solo se ejecuta si no llegó ninguna trama válida en WATCHDOG_TIMEOUT_US
+ * (o en el margen de arranque), así que no hay sondeo ni comparación de
+ * tiempos: la latencia de reacción es la del despacho de esp_timer.
+ */
+static void comm_watchdog_callback(void *arg) {
+    blackbox_event(CM_BBOX_EVT_WATCHDOG);
+    blackbox_trigger(CM_BBOX_REASON_WATCHDOG);
+    enter_safe_state();
+
+    uint32_t silence_us = (uint32_t)esp_timer_get_time() - atomic_load(&g_last_frame_us);
+    atomic_fetch_add(&g_watchdog_trips, 1);
+    if (atomic_load(&g_link_seen)) {
+        uint32_t late_us = silence_us > WATCHDOG_TIMEOUT_US ? silence_us - (uint32_t)WATCHDOG_TIMEOUT_US : 0;
+        if (late_us > atomic_load(&g_watchdog_late_max_us)) {
+            atomic_store(&g_watchdog_late_max_us, late_us);
+        }
+        ESP_LOGE(TAG, "¡WATCHDOG TIMEOUT! Sin tramas válidas en %lu ms (disparo +%lu us)",
+                 silence_us / 1000, late_us);
+    } else {
+        ESP_LOGE(TAG, "¡WATCHDOG TIMEOUT! Ninguna trama válida desde el arranque");
+    }
+    cm_capture_request_dump();  // Conservar el tráfico previo al fallo
+}
+
+/**
+ * @brief Parada de emergencia pedida por la seta o por la Consola
+ *
+ * El STOP al VFD sale antes que nada; después el safe state y el bloqueo de
+ * la velocidad hasta que la Consola pida 0 km/h.
+ */
+static void emergency_stop(const char *source, bool from_input) {
+    vfd_driver_emergency_stop();
+    atomic_store(&g_estop_rearm_required, true);
+    ESP_LOGE(TAG, "🛑 PARADA DE EMERGENCIA (%s)", source);
+    blackbox_event(CM_BBOX_EVT_ESTOP);
+    blackbox_trigger(from_input ? CM_BBOX_REASON_ESTOP_INPUT : CM_BBOX_REASON_ESTOP_LINK);
+    enter_safe_state();
 }
 
 /**
@@ -188,11 +485,7 @@ static void reset_safe_state(void) {
  * Este es un error CRÍTICO que requiere intervención técnica.
  */
 static void handle_incline_sensor_fault(void) {
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-
-    if (!g_incline_sensor_fault) {  // Solo registrar la primera vez
-        g_incline_sensor_fault = true;
-
+    if (!atomic_exchange(&g_incline_sensor_fault, true)) {  // Solo registrar la primera vez
         ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
         ESP_LOGE(TAG, "  ERROR CRÍTICO: FIN DE CARRERA NO DETECTADO");
         ESP_LOGE(TAG, "  Inclinación: %.2f%% (umbral: %.2f%%)",
@@ -201,76 +494,44 @@ static void handle_incline_sensor_fault(void) {
         ESP_LOGE(TAG, "  SISTEMA BLOQUEADO - Requiere servicio técnico");
         ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
 
-        // Guardar error en NVS para persistencia
-        nvs_handle_t nvs_handle;
-        esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-        if (err == ESP_OK) {
-            nvs_set_u8(nvs_handle, "incline_fault", 1);
-            nvs_commit(nvs_handle);
-            nvs_close(nvs_handle);
-            ESP_LOGI(TAG, "Error guardado en NVS");
-        }
+        // Guardar error en NVS para persistencia (tarea de persistencia)
+        persist_set_incline_fault();
     }
 
-    xSemaphoreGive(g_speed_mutex);
-
     // Detener todo y entrar en safe state
+    blackbox_event(CM_BBOX_EVT_SENSOR_FAULT);
+    blackbox_trigger(CM_BBOX_REASON_SENSOR_FAULT);
     stop_incline_motor();
     enter_safe_state();
 }
 
-static void wax_pump_timer_callback(void *arg) {
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    ESP_LOGI(TAG, "Temporizador de bomba de cera finalizado, apagando relé.");
-    gpio_set_level(WAX_PUMP_RELAY_PIN, 0);  // 0 = OFF (HIGH=ON)
-    g_wax_pump_relay_state = 0;
-    xSemaphoreGive(g_speed_mutex);
-}
-
 static void configure_gpios(void) {
-    // Primero, resetear y establecer todos los pines de relés en nivel bajo (0 = OFF)
-    // ANTES de configurarlos como salidas, para evitar activación durante boot
-    // Los relés tienen lógica directa: 0 = OFF, 1 = ON
-    gpio_reset_pin(HEAD_FAN_ON_OFF_PIN);
-    gpio_reset_pin(HEAD_FAN_SPEED_PIN);
-    gpio_reset_pin(CHEST_FAN_ON_OFF_PIN);
-    gpio_reset_pin(CHEST_FAN_SPEED_PIN);
-    gpio_reset_pin(INCLINE_ON_OFF_PIN);
-    gpio_reset_pin(INCLINE_DIRECTION_PIN);
-    gpio_reset_pin(WAX_PUMP_RELAY_PIN);
-
-    gpio_set_level(HEAD_FAN_ON_OFF_PIN, 0);      // 0 = OFF (HIGH=ON)
-    gpio_set_level(HEAD_FAN_SPEED_PIN, 0);       // 0 = selector velocidad por defecto (HIGH=ON)
-    gpio_set_level(CHEST_FAN_ON_OFF_PIN, 0);     // 0 = OFF (HIGH=ON)
-    gpio_set_level(CHEST_FAN_SPEED_PIN, 0);      // 0 = selector velocidad por defecto (HIGH=ON)
-    gpio_set_level(INCLINE_ON_OFF_PIN, 0);       // 0 = OFF (HIGH=ON)
-    gpio_set_level(INCLINE_DIRECTION_PIN, 0);    // 0 = selector dirección por defecto (HIGH=ON)
-    gpio_set_level(WAX_PUMP_RELAY_PIN, 0);       // 0 = OFF (HIGH=ON)
-
-    // Ahora configurar como salidas
-    uint64_t output_pin_mask = (1ULL << HEAD_FAN_ON_OFF_PIN) | (1ULL << HEAD_FAN_SPEED_PIN) |
-                               (1ULL << CHEST_FAN_ON_OFF_PIN) | (1ULL << CHEST_FAN_SPEED_PIN) |
-                               (1ULL << INCLINE_ON_OFF_PIN) | (1ULL << INCLINE_DIRECTION_PIN) |
-                               (1ULL << WAX_PUMP_RELAY_PIN);
-    gpio_config_t io_conf_output = {
-        .pin_bit_mask = output_pin_mask,
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+    // Relés abiertos antes de configurarlos como salidas (ver actuators.c)
+    ESP_ERROR_CHECK(actuators_init());
+
+    // Fin de carrera de inclinación (pull-up: lee 1 cuando no presionado, 0 cuando activado).
+    // ISR en ambos flancos: pulsación (activo a nivel bajo) y liberación
+    const base_hal_input_t limit_input = {
+        .pin = INCLINE_LIMIT_SWITCH_PIN,
+        .pull_up = true,
+        .glitch_filter = true,
+        .edge = BASE_HAL_EDGE_ANY,
+        .isr = limit_switch_isr,
     };
-    ESP_ERROR_CHECK(gpio_config(&io_conf_output));
-
-    // Configurar GPIO 35 como entrada para fin de carrera de inclinación
-    gpio_config_t io_conf_input = {
-        .pin_bit_mask = (1ULL << INCLINE_LIMIT_SWITCH_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,  // Pull-up: lee 1 cuando no presionado, 0 cuando activado
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+    ESP_ERROR_CHECK(base_hal_gpio_input_init(&limit_input));
+    ESP_LOGI(TAG, "GPIO %d configurado para fin de carrera de inclinación (pull-up interno, ISR en IRAM)", INCLINE_LIMIT_SWITCH_PIN);
+
+#if CONFIG_BASE_ESTOP_ENABLE
+    // Seta de emergencia: contacto NC a GND; abierto (pulsada o cable cortado) = parada
+    const base_hal_input_t estop_input = {
+        .pin = ESTOP_INPUT_PIN,
+        .pull_up = true,
+        .edge = BASE_HAL_EDGE_RISING,
+        .isr = estop_input_isr,
     };
-    ESP_ERROR_CHECK(gpio_config(&io_conf_input));
-    ESP_LOGI(TAG, "GPIO %d configurado para fin de carrera de inclinación (pull-up interno)", INCLINE_LIMIT_SWITCH_PIN);
+    ESP_ERROR_CHECK(base_hal_gpio_input_init(&estop_input));
+    ESP_LOGI(TAG, "GPIO %d configurado para seta de emergencia (NC, ISR en IRAM)", ESTOP_INPUT_PIN);
+#endif
 
     ESP_LOGI(TAG, "GPIOs configurados. Asignación v6 (Fin de carrera en GPIO 21 con pull-up interno).");
 }
@@ -284,38 +545,64 @@ static void configure_gpios(void) {
  */
 static esp_err_t send_line(const char *line) {
     int len = strlen(line);
-    int written = uart_write_bytes(UART_PORT_NUM, line, len);
+    int written = base_hal_uart_write(line, len);
     if (written < 0) {
         ESP_LOGE(TAG, "Error al enviar línea por UART");
         return ESP_FAIL;
     }
+    cm_capture_record(CM_CAPTURE_DIR_TX, line, (len > 0 && line[len - 1] == '\n') ? len - 1 : len, 0);
     ESP_LOGD(TAG, "Línea enviada: %s", line);
     return ESP_OK;
 }
 
 /**
- * @brief Envía respuesta DATA consolidada
- * Formato: DATA=<speed>,<incline>,<vfd_freq>,<vfd_fault>,<fan_head>,<fan_chest>,<incline_fault>
+ * @brief Envía respuesta DATA consolidada (formato definido en cm_schema.h)
+ *
+ * @param req SYNC al que se responde (NULL si no responde a un SYNC)
+ * @param req_rx_us Inicio de la trama SYNC en el reloj local (t2)
  */
-static void send_data_response(void) {
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    float real_speed = g_real_speed_kmh;  // Calculada desde VFD, NO desde sensor Hall
-    float real_incline = g_real_incline_pct;
-    uint8_t head_fan = g_head_fan_state;
-    uint8_t chest_fan = g_chest_fan_state;
-    uint8_t incline_fault = g_incline_sensor_fault ? 1 : 0;
-    xSemaphoreGive(g_speed_mutex);
+static void send_data_response(const cm_sync_msg_t *req, int64_t req_rx_us) {
+    cm_data_msg_t data;
+    incline_pub_t incline;
+    state_latch_read(&g_incline_pub, &incline);
+
+    data.real_speed_kmh = atomic_load(&g_real_speed_kmh);  // Sensor Hall o VFD (slot "speed")
+    data.real_incline_pct = incline.real_pct;
+    data.fan_head = actuators_fan_level(ACT_FAN_HEAD);
+    data.fan_chest = actuators_fan_level(ACT_FAN_CHEST);
+    data.incline_fault = atomic_load(&g_incline_sensor_fault) ? 1 : 0;
+
+    motion_profile_progress_t profile;
+    motion_profile_get_progress(&profile);
+    data.profile_id = profile.id;
+    data.profile_state = profile.state;
+    data.profile_segment = profile.segment;
+    data.profile_left_ms = profile.left_ms;
 
     // Obtener frecuencia real del VFD
-    float vfd_freq = vfd_driver_get_real_freq_hz();
+    data.vfd_freq_hz = vfd_driver_get_real_freq_hz();
 
     // Obtener código de fallo del VFD
     vfd_status_t vfd_status = vfd_driver_get_status();
-    uint8_t vfd_fault = (vfd_status == VFD_STATUS_OK) ? 0 : 1;
+    data.vfd_fault = (vfd_status == VFD_STATUS_OK) ? 0 : 1;
+
+    // Marcas de tiempo para la sincronización de reloj de Consola (t1, t2, t3 - t2)
+    if (req != NULL) {
+        int64_t turnaround_us = esp_timer_get_time() - req_rx_us;
+        data.sync_tx_us = req->tx_us;
+        data.rx_us = req_rx_us;
+        data.turnaround_us = (turnaround_us > 0) ? (uint32_t)turnaround_us : 0;
+    } else {
+        data.sync_tx_us = 0;
+        data.rx_us = 0;
+        data.turnaround_us = 0;
+    }
 
-    char buffer[128];
-    snprintf(buffer, sizeof(buffer), "DATA=%.2f,%.1f,%.2f,%d,%d,%d,%d\n",
-             real_speed, real_incline, vfd_freq, vfd_fault, head_fan, chest_fan, incline_fault);
+    char buffer[CM_SCHEMA_ASCII_MAX];
+    if (cm_data_encode_ascii(&data, buffer, sizeof(buffer)) == 0) {
+        ESP_LOGE(TAG, "Error al codificar DATA");
+        return;
+    }
     send_line(buffer);
 }
 
@@ -358,10 +645,7 @@ static void update_speed_target(float target_speed) {
         return;
     }
 
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    float old_target = g_target_speed_kmh;
-    g_target_speed_kmh = target_speed;
-    xSemaphoreGive(g_speed_mutex);
+    float old_target = atomic_exchange(&g_target_speed_kmh, target_speed);
 
     // Actualizar VFD si cambió el objetivo
     if (fabsf(target_speed - old_target) > 0.05f) {
@@ -370,11 +654,30 @@ static void update_speed_target(float target_speed) {
     }
 }
 
+/**
+ * @brief Selecciona el perfil de rampa del VFD (ramp_mode del SYNC)
+ */
+static void update_ramp_mode(uint8_t ramp_mode) {
+    switch (ramp_mode) {
+        case CM_RAMP_STOP:
+            vfd_driver_set_ramp(VFD_RAMP_STOP);
+            break;
+        case CM_RAMP_COOLDOWN:
+            vfd_driver_set_ramp(VFD_RAMP_COOLDOWN);
+            break;
+        default:
+            vfd_driver_set_ramp(VFD_RAMP_NORMAL);
+            break;
+    }
+}
+
 /**
  * @brief Actualiza objetivo de inclinación
  */
 static void update_incline_target(float target_incline) {
-    if (!g_incline_is_calibrated) {
+    incline_pub_t incline;
+    state_latch_read(&g_incline_pub, &incline);
+    if (!incline.calibrated) {
         ESP_LOGW(TAG, "Inclinación no calibrada, ignorando objetivo");
         return;
     }
@@ -385,9 +688,7 @@ static void update_incline_target(float target_incline) {
         return;
     }
 
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    g_target_incline_pct = target_incline;
-    xSemaphoreGive(g_speed_mutex);
+    atomic_store(&g_target_incline_pct, target_incline);
 
     ESP_LOGD(TAG, "Inclinación objetivo actualizada: %.1f%%", target_incline);
 }
@@ -397,118 +698,67 @@ static void update_incline_target(float target_incline) {
  */
 static void start_incline_calibration(void) {
     ESP_LOGI(TAG, "CALIBRATE_INCLINE: Iniciando rutina de homing");
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    g_incline_motor_state = INCLINE_MOTOR_HOMING;
-    g_incline_is_calibrated = false;
-    xSemaphoreGive(g_speed_mutex);
+    blackbox_event(CM_BBOX_EVT_CALIBRATE);
+    atomic_fetch_or(&g_incline_requests, INCLINE_REQ_HOMING);
 }
 
 /**
- * @brief Actualiza estado del ventilador de cabeza
+ * @brief Adopta la estimación de reloj que publica Consola en el SYNC
  */
-static void update_head_fan(int fan_state) {
-    if (fan_state < 0 || fan_state > 2) return;
-
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    g_head_fan_state = fan_state;
-    xSemaphoreGive(g_speed_mutex);
-
-    // Patrón selector + ON/OFF (lógica directa: 1 = ON, 0 = OFF)
-    if (fan_state == 0) {
-        // OFF
-        gpio_set_level(HEAD_FAN_ON_OFF_PIN, 0);  // 0 = OFF (HIGH=ON)
-        gpio_set_level(HEAD_FAN_SPEED_PIN, 0);   // Resetear selector por defecto (HIGH=ON)
-    } else if (fan_state == 1) {
-        // Normal: selector normal, activar
-        gpio_set_level(HEAD_FAN_SPEED_PIN, 0);   // 0 = normal (HIGH=ON)
-        gpio_set_level(HEAD_FAN_ON_OFF_PIN, 1);  // 1 = ON (HIGH=ON)
-    } else {
-        // Fuerte: selector fuerte, activar
-        gpio_set_level(HEAD_FAN_SPEED_PIN, 1);   // 1 = fuerte (HIGH=ON)
-        gpio_set_level(HEAD_FAN_ON_OFF_PIN, 1);  // 1 = ON (HIGH=ON)
+static void update_peer_clock(const cm_sync_msg_t *sync, int64_t rx_us) {
+    if (!sync->clock_valid) {
+        return;
     }
 
-    ESP_LOGD(TAG, "Ventilador cabeza: %d", fan_state);
+    // Consola publica (reloj Base - reloj Consola); aquí el par es Consola
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_adopt(&g_clock, rx_us, -sync->clock_offset_us);
+    taskEXIT_CRITICAL(&g_clock_lock);
 }
 
 /**
- * @brief Actualiza estado del ventilador de pecho
+ * @brief Procesa comando SYNC con todos los objetivos (formato en cm_schema.h)
+ * Responde automáticamente con DATA
+ *
+ * @param rx_us Instante en que se recibió el '\n' del SYNC
  */
-static void update_chest_fan(int fan_state) {
-    if (fan_state < 0 || fan_state > 2) return;
-
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-    g_chest_fan_state = fan_state;
-    xSemaphoreGive(g_speed_mutex);
-
-    // Patrón selector + ON/OFF (lógica directa: 1 = ON, 0 = OFF)
-    if (fan_state == 0) {
-        // OFF
-        gpio_set_level(CHEST_FAN_ON_OFF_PIN, 0);  // 0 = OFF (HIGH=ON)
-        gpio_set_level(CHEST_FAN_SPEED_PIN, 0);   // Resetear selector por defecto (HIGH=ON)
-    } else if (fan_state == 1) {
-        // Normal: selector normal, activar
-        gpio_set_level(CHEST_FAN_SPEED_PIN, 0);   // 0 = normal (HIGH=ON)
-        gpio_set_level(CHEST_FAN_ON_OFF_PIN, 1);  // 1 = ON (HIGH=ON)
+static void process_sync(const char *cmd_line, int64_t rx_us) {
+    cm_sync_msg_t sync;
+    bool sync_ok = cm_sync_decode_ascii(cmd_line, &sync);
+
+    // t2 = inicio de la trama (ver cm_clock_frame_start_us)
+    int64_t frame_rx_us = cm_clock_frame_start_us(rx_us, strlen(cmd_line) + 1, UART_BAUD_RATE);
+    if (sync_ok) {
+        reset_safe_state();  // Solo las tramas válidas alimentan el watchdog
+        update_peer_clock(&sync, frame_rx_us);
+        atomic_fetch_add(&g_sync_ok_count, 1);
     } else {
-        // Fuerte: selector fuerte, activar
-        gpio_set_level(CHEST_FAN_SPEED_PIN, 1);   // 1 = fuerte (HIGH=ON)
-        gpio_set_level(CHEST_FAN_ON_OFF_PIN, 1);  // 1 = ON (HIGH=ON)
-    }
-
-    ESP_LOGD(TAG, "Ventilador pecho: %d", fan_state);
-}
-
-/**
- * @brief Actualiza estado de la bomba de cera
- */
-static void update_wax_pump(int state) {
-    if (state == 1) {
-        ESP_LOGI(TAG, "Activando bomba de cera por 5 segundos");
-
-        xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-        gpio_set_level(WAX_PUMP_RELAY_PIN, 1);  // 1 = ON (HIGH=ON)
-        g_wax_pump_relay_state = 1;
-        xSemaphoreGive(g_speed_mutex);
-
-        esp_err_t err = esp_timer_start_once(wax_pump_timer_handle, WAX_PUMP_ACTIVATION_DURATION_MS * 1000);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Error al iniciar timer de bomba de cera");
-        }
+        atomic_fetch_add(&g_frames_bad_count, 1);
     }
-}
 
-/**
- * @brief Procesa comando SYNC con todos los objetivos
- * Formato: SYNC=speed,incline,fan_head,fan_chest,wax,training_mode
- * Responde automáticamente con DATA
- */
-static void process_sync(const char *cmd_line) {
     // BLOQUEO CRÍTICO: Si hay fallo del sensor, solo responder con DATA de error
-    if (g_incline_sensor_fault) {
+    if (atomic_load(&g_incline_sensor_fault)) {
         ESP_LOGW(TAG, "Sistema BLOQUEADO por fallo crítico - Rechazando comandos");
-        send_data_response();  // Enviar estado con incline_fault=1
+        send_data_response(sync_ok ? &sync : NULL, frame_rx_us);  // Enviar estado con incline_fault=1
         return;
     }
 
-    float target_speed, target_incline;
-    int fan_head, fan_chest, wax, training_mode;
-
-    // Parsear: SYNC=6.0,5.0,1,0,0,1
-    int parsed = sscanf(cmd_line, "SYNC=%f,%f,%d,%d,%d,%d",
-                        &target_speed, &target_incline,
-                        &fan_head, &fan_chest, &wax, &training_mode);
-
-    if (parsed != 6) {
+    if (!sync_ok) {
         ESP_LOGW(TAG, "Error al parsear SYNC: %s", cmd_line);
         return;
     }
 
+    float target_speed = sync.target_speed_kmh;
+    float target_incline = sync.target_incline_pct;
+    int fan_head = sync.fan_head;
+    int fan_chest = sync.fan_chest;
+    int wax = sync.wax_pump;
+    int training_mode = sync.training_mode;
+
     ESP_LOGD(TAG, "SYNC recibido: speed=%.2f incline=%.1f fans=%d,%d wax=%d training=%d",
              target_speed, target_incline, fan_head, fan_chest, wax, training_mode);
 
     // Actualizar training mode
-    xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
     bool prev_training_mode = g_training_mode;
     g_training_mode = (training_mode != 0);
 
@@ -518,42 +768,192 @@ static void process_sync(const char *cmd_line) {
         target_speed = 0.0f;
     }
 
+    // Tras una parada de emergencia la Consola debe pedir 0 km/h antes de volver a marchar
+    if (atomic_load(&g_estop_rearm_required)) {
+        if (target_speed == 0.0f && !atomic_load(&g_estop_input_active)) {
+            atomic_store(&g_estop_rearm_required, false);
+            ESP_LOGI(TAG, "Parada de emergencia rearmada (velocidad 0 recibida)");
+        } else {
+            target_speed = 0.0f;
+        }
+    }
+
     // Si salimos de training mode, forzar homing para volver a 0%
     if (prev_training_mode && !g_training_mode) {
         ESP_LOGI(TAG, "Saliendo de training mode - Forzando homing de inclinación");
-        g_incline_is_calibrated = false;  // Forzar recalibración
+        atomic_fetch_or(&g_incline_requests, INCLINE_REQ_UNCALIBRATE);  // Forzar recalibración
+    }
+
+    // Perfil de movimiento: mientras lo ejecuta Base, sus consignas mandan
+    if (!g_training_mode) {
+        motion_profile_abort("fin del entrenamiento");
     }
-    xSemaphoreGive(g_speed_mutex);
+    bool profile_owned = motion_profile_sync(sync.profile_id);
 
-    // Actualizar todos los objetivos
-    update_speed_target(target_speed);
-    update_incline_target(target_incline);
-    update_head_fan(fan_head);
-    update_chest_fan(fan_chest);
-    update_wax_pump(wax);
+    // Actualizar todos los objetivos (el perfil de rampa antes de la consigna que lo usa)
+    update_ramp_mode(sync.ramp_mode);
+    if (!profile_owned) {
+        update_speed_target(target_speed);
+        update_incline_target(target_incline);
+    }
+    actuators_set_fan(ACT_FAN_HEAD, fan_head);
+    actuators_set_fan(ACT_FAN_CHEST, fan_chest);
+    actuators_wax_request(wax != 0);
 
     // Responder siempre con DATA (valores reales)
-    send_data_response();
+    send_data_response(&sync, frame_rx_us);
 }
 
 /**
- * @brief Procesa un comando ASCII recibido
+ * @brief Procesa "PSEG=..." y "PROFILE=..." (perfil de movimiento, ver cm_schema.h)
+ *
+ * Solo se arranca entrenando y fuera del safe state. Responde con DATA al
+ * PROFILE para que Consola vea el arranque sin esperar al siguiente SYNC.
+ */
+static void process_profile(const char *cmd_line) {
+    cm_profile_seg_msg_t seg;
+    cm_profile_msg_t msg;
+
+    if (cm_profile_seg_decode_ascii(cmd_line, &seg)) {
+        motion_profile_load_segment(&seg);
+    } else if (cm_profile_decode_ascii(cmd_line, &msg)) {
+        if (!g_training_mode || atomic_load(&g_emergency_state) || atomic_load(&g_estop_rearm_required)) {
+            ESP_LOGW(TAG, "Perfil %u rechazado: fuera de entrenamiento o en safe state", msg.profile_id);
+        } else {
+            motion_profile_start(&msg, atomic_load(&g_target_speed_kmh), atomic_load(&g_target_incline_pct));
+        }
+        send_data_response(NULL, 0);
+    } else {
+        atomic_fetch_add(&g_frames_bad_count, 1);
+        ESP_LOGW(TAG, "Línea de perfil inválida: %s", cmd_line);
+    }
+}
+
+// ===========================================================================
+// LECTURA DE LA CAJA NEGRA (TAREA bbox_reply)
+// ===========================================================================
+//
+// La lectura de flash puede esperar a que termine un volcado: uart_rx_task
+// solo decodifica y encola la petición, y la responde una tarea de baja
+// prioridad, como STATS. Con la cola llena la petición se descarta (la
+// Consola reintenta).
+
+#define BBOX_REPLY_QUEUE_LEN    8       // La Consola pide 4 líneas por SYNC
+#define BBOX_REPLY_TASK_STACK   4096
+#define BBOX_REPLY_TASK_PRIO    STATS_REPORT_TASK_PRIO
+
+typedef struct {
+    uint16_t dump;
+    uint16_t line;
+} bbox_request_t;
+
+static QueueHandle_t s_bbox_queue = NULL;
+static atomic_uint g_bbox_dropped = 0;  // Peticiones descartadas con la cola llena
+
+/**
+ * @brief Envía la línea BBOX pedida
+ *
+ * Con un volcado escribiéndose en flash no responde: la Consola reintenta.
+ */
+static void send_blackbox_line(const bbox_request_t *req) {
+    uint8_t data[CM_BBOX_LINE_DATA_MAX];
+    size_t len;
+    if (!blackbox_read_line(req->dump, req->line, data, &len)) {
+        return;
+    }
+    char out[CM_LINE_BUFFER_SIZE];
+    size_t n = cm_bbox_line_encode(req->dump, req->line, data, len, out, sizeof(out) - 1);
+    if (n == 0) {
+        ESP_LOGE(TAG, "Línea BBOX no cabe en %d bytes", CM_LINE_BUFFER_SIZE);
+        return;
+    }
+    out[n++] = '\n';
+    out[n] = '\0';
+    send_line(out);
+}
+
+static void bbox_reply_task(void *pvParameters) {
+    bbox_request_t req;
+    while (1) {
+        if (xQueueReceive(s_bbox_queue, &req, portMAX_DELAY) == pdTRUE) {
+            send_blackbox_line(&req);
+        }
+    }
+}
+
+/**
+ * @brief Encola "BLACKBOX=volcado,línea" para bbox_reply_task (no bloquea)
  */
-static void process_command(const char *cmd_line) {
-    reset_safe_state();
+static void request_blackbox_line(const char *cmd_line) {
+    bbox_request_t req;
+    if (!cm_bbox_request_decode(cmd_line, &req.dump, &req.line)) {
+        atomic_fetch_add(&g_frames_bad_count, 1);
+        ESP_LOGW(TAG, "Petición BLACKBOX inválida: %s", cmd_line);
+        return;
+    }
+    if (s_bbox_queue == NULL || xQueueSend(s_bbox_queue, &req, 0) != pdTRUE) {
+        atomic_fetch_add(&g_bbox_dropped, 1);
+    }
+}
+
+static esp_err_t bbox_reply_init(void) {
+    s_bbox_queue = xQueueCreate(BBOX_REPLY_QUEUE_LEN, sizeof(bbox_request_t));
+    if (s_bbox_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(bbox_reply_task, "bbox_reply", BBOX_REPLY_TASK_STACK, NULL,
+                    BBOX_REPLY_TASK_PRIO, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
 
+/**
+ * @brief Procesa un comando ASCII recibido
+ *
+ * @param rx_us Instante en que se recibió el '\n'
+ */
+static void process_command(const char *cmd_line, int64_t rx_us) {
     ESP_LOGD(TAG, "Comando recibido: %s", cmd_line);
 
     // Protocolo SYNC simplificado
     if (strncmp(cmd_line, "SYNC=", 5) == 0) {
-        process_sync(cmd_line);
+        process_sync(cmd_line, rx_us);
+    }
+    // Parada de emergencia: se atiende antes que cualquier otra trama y sin esperar al SYNC
+    else if (strncmp(cmd_line, "EMERGENCY_STOP=", 15) == 0) {
+        emergency_stop("Consola", false);
+        send_data_response(NULL, 0);  // Responder con estado actual
     }
     // Comando de calibración (se mantiene para compatibilidad)
     else if (strncmp(cmd_line, "CALIBRATE_INCLINE=", 18) == 0) {
+        reset_safe_state();
         start_incline_calibration();
-        send_data_response();  // Responder con estado actual
+        send_data_response(NULL, 0);  // Responder con estado actual
+    }
+    // Perfil de movimiento: segmentos y arranque
+    else if (strncmp(cmd_line, CM_PROFILE_SEG_PREFIX, sizeof(CM_PROFILE_SEG_PREFIX) - 1) == 0 ||
+             strncmp(cmd_line, CM_PROFILE_PREFIX, sizeof(CM_PROFILE_PREFIX) - 1) == 0) {
+        process_profile(cmd_line);
+    }
+    // Estadísticas: las envía stats_report fuera de esta tarea
+    else if (strncmp(cmd_line, CM_STATS_REQUEST_PREFIX, sizeof(CM_STATS_REQUEST_PREFIX) - 1) == 0) {
+        stats_report_request();
+    }
+    // Lectura de la caja negra: la responde bbox_reply_task, sin tocar el watchdog
+    else if (strncmp(cmd_line, CM_BBOX_REQUEST_PREFIX, sizeof(CM_BBOX_REQUEST_PREFIX) - 1) == 0) {
+        request_blackbox_line(cmd_line);
+    }
+#if CONFIG_BASE_VFD_SELF_TEST
+    // Pruebas de latencia del VFD (banco de pruebas): resultado en el log y el heartbeat
+    else if (strncmp(cmd_line, VFD_TEST_REQUEST_PREFIX, sizeof(VFD_TEST_REQUEST_PREFIX) - 1) == 0) {
+        if (vfd_driver_request_self_test() == ESP_OK) {
+            ESP_LOGI(TAG, "Pruebas de latencia del VFD pedidas por el enlace");
+        }
     }
+#endif
     else {
+        atomic_fetch_add(&g_frames_bad_count, 1);
         ESP_LOGW(TAG, "Comando desconocido o no soportado: %s", cmd_line);
         // No enviamos ACK de error, simplemente ignoramos
     }
@@ -563,80 +963,231 @@ static void process_command(const char *cmd_line) {
 // PARSER ASCII SIMPLE (LÍNEA A LÍNEA)
 // ===========================================================================
 
+/**
+ * @brief Acumula los errores que notifica el UART (contadores STATS)
+ */
+static void drain_uart_events(void) {
+    base_hal_uart_errors_t errors;
+    base_hal_uart_poll_errors(&errors);
+    if (errors.overruns != 0) {
+        atomic_fetch_add(&g_uart_overruns, errors.overruns);
+    }
+    if (errors.errors != 0) {
+        atomic_fetch_add(&g_uart_errors, errors.errors);
+    }
+}
+
+/**
+ * @brief Contadores del enlace para la respuesta STATS (tarea stats_report)
+ */
+static void fill_link_stats(cm_stats_link_msg_t *out) {
+    out->uart_overruns = atomic_load(&g_uart_overruns);
+    out->uart_errors = atomic_load(&g_uart_errors);
+    out->line_overflows = atomic_load(&g_line_overflows);
+    out->frames_bad = atomic_load(&g_frames_bad_count);
+    out->watchdog_trips = atomic_load(&g_watchdog_trips);
+    out->watchdog_late_max_us = atomic_load(&g_watchdog_late_max_us);
+}
+
 /**
  * @brief Tarea de recepción UART - Lee líneas terminadas en \n
  */
 static void uart_rx_task(void *pvParameters) {
-    char line_buffer[UART_LINE_BUFFER_SIZE];
-    size_t line_pos = 0;
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
 
-    ESP_LOGI(TAG, "Tarea UART RX iniciada (modo ASCII). Escuchando en UART%d...", UART_PORT_NUM);
+    ESP_LOGI(TAG, "Tarea UART RX iniciada (modo ASCII). Escuchando al maestro...");
 
     while (1) {
         uint8_t byte;
-        int len = uart_read_bytes(UART_PORT_NUM, &byte, 1, pdMS_TO_TICKS(100));
+        int len = base_hal_uart_read(&byte, 1, pdMS_TO_TICKS(100));
 
         if (len > 0) {
-            // Detectar fin de línea
-            if (byte == '\n' || byte == '\r') {
-                if (line_pos > 0) {
-                    // Terminar string y procesar comando
-                    line_buffer[line_pos] = '\0';
-                    process_command(line_buffer);
-                    line_pos = 0;
+            switch (cm_line_reader_feed(&reader, byte)) {
+                case CM_LINE_READY: {
+                    int64_t rx_us = esp_timer_get_time();
+                    cm_capture_record(CM_CAPTURE_DIR_RX, reader.buf, strlen(reader.buf), 0);
+                    process_command(reader.buf, rx_us);
+                    drain_uart_events();  // Fuera del camino SYNC -> DATA
+                    break;
                 }
-            }
-            // Acumular caracteres (ignorar \r adicionales)
-            else if (byte >= 32 && byte < 127) {  // Solo caracteres imprimibles ASCII
-                if (line_pos < UART_LINE_BUFFER_SIZE - 1) {
-                    line_buffer[line_pos++] = byte;
-                } else {
-                    // Buffer lleno, descartar línea
+                case CM_LINE_OVERFLOW:
+                    // Buffer lleno, línea descartada
                     ESP_LOGW(TAG, "Línea demasiado larga, descartando");
-                    line_pos = 0;
-                }
+                    atomic_fetch_add(&g_line_overflows, 1);
+                    cm_capture_record(CM_CAPTURE_DIR_RX, reader.buf, CM_LINE_BUFFER_SIZE - 1,
+                                      CM_CAPTURE_FLAG_OVERFLOW);
+                    break;
+                default:
+                    break;
             }
+        } else {
+            drain_uart_events();
         }
     }
 }
 
+// ===========================================================================
+// SINCRONIZACIÓN DE RELOJ (API de nodo de cm_clock.h)
+// ===========================================================================
+
+int64_t cm_time_to_peer(int64_t local_us) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_t clock = g_clock;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return cm_clock_to_peer(&clock, local_us);
+}
+
+int64_t cm_time_from_peer(int64_t peer_us) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_t clock = g_clock;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return cm_clock_from_peer(&clock, peer_us);
+}
+
+bool cm_time_peer_synced(void) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    bool valid = g_clock.valid;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return valid;
+}
+
 // ===========================================================================
 // TAREAS RTOS
 // ===========================================================================
 
-static void speed_update_task(void *pvParameters) {
-    ESP_LOGI(TAG, "Tarea de actualización de velocidad iniciada (calculada desde VFD)");
+#if CONFIG_BASE_ESTOP_ENABLE
+/**
+ * @brief Slot del ejecutivo: seta de emergencia
+ *
+ * Completa la parada que inició la ISR (o la detecta por nivel si la seta ya
+ * estaba pulsada al arrancar) y mantiene el safe state mientras siga pulsada.
+ */
+static void estop_step(const cyclic_ctx_t *ctx) {
+    bool latched = atomic_exchange_explicit(&s_estop_input_latched, false, memory_order_acquire);
+    bool tripped = base_hal_gpio_read(ESTOP_INPUT_PIN) == ESTOP_TRIPPED_LEVEL;
+
+    if (tripped || latched) {
+        if (!atomic_exchange(&g_estop_input_active, true)) {
+            emergency_stop("seta", true);
+        }
+    } else if (atomic_exchange(&g_estop_input_active, false)) {
+        ESP_LOGW(TAG, "Seta de emergencia liberada: rearme con velocidad 0 desde la Consola");
+    }
+}
+#endif
+
+/**
+ * @brief Slot del ejecutivo: relés de los ventiladores
+ *
+ * Una etapa por paso hacia el nivel pedido (abrir, selector, cerrar): entre
+ * etapas pasa un marco menor, de sobra para que el contacto se abra.
+ */
+static void relays_step(const cyclic_ctx_t *ctx) {
+    actuators_step();
+}
+
+/**
+ * @brief Slot del ejecutivo: velocidad real de la cinta
+ *
+ * Con CONFIG_BASE_SPEED_SENSOR_ENABLE, la medida del sensor Hall (captura
+ * MCPWM, actualizada por diente). Si el VFD marcha pero el sensor no ve
+ * dientes (desconectado), o sin sensor, la frecuencia real del VFD.
+ */
+static void speed_update_step(const cyclic_ctx_t *ctx) {
+    // Obtener frecuencia real del VFD (registro 0x2103)
+    float vfd_freq_hz = vfd_driver_get_real_freq_hz();
+
+    // Convertir Hz a km/h usando la fórmula del VFD SU300
+    // velocidad_kmh = frecuencia_Hz × (6.4 / 50.0)
+    float new_real_speed = vfd_freq_hz * (6.4f / 50.0f);
+
+#if CONFIG_BASE_SPEED_SENSOR_ENABLE
+    float vfd_kmh = new_real_speed;
+    float sensor_kmh;
+    bool measured = false;
+    if (speed_sensor_get_speed_kmh(&sensor_kmh)) {
+        if (sensor_kmh > 0.0f || vfd_kmh < SPEED_SENSOR_PLAUSIBLE_KMH) {
+            new_real_speed = sensor_kmh;
+            measured = true;
+        } else {
+            g_speed_sensor_fallbacks++;
+        }
+    }
+#if CONFIG_BASE_SPEED_LOOP_ENABLE
+    // Lazo externo: solo con medida de la cinta y fuera de safe state
+    float trim_kmh = 0.0f;
+    if (measured && !atomic_load(&g_emergency_state)) {
+        trim_kmh = speed_loop_step(atomic_load(&g_target_speed_kmh), sensor_kmh, vfd_kmh,
+                                   (float)ctx->period_us / 1e6f);
+    } else {
+        speed_loop_reset();
+    }
+    vfd_driver_set_speed_trim(trim_kmh);
+#endif
+#endif
 
-    for (;;) {
-        vTaskDelay(pdMS_TO_TICKS(SPEED_UPDATE_INTERVAL_MS)); // 500ms
+    atomic_store(&g_real_speed_kmh, new_real_speed);
+}
 
-        // Obtener frecuencia real del VFD (registro 0x2103)
-        float vfd_freq_hz = vfd_driver_get_real_freq_hz();
+/**
+ * @brief Slot del ejecutivo: perfil de movimiento
+ *
+ * Va detrás de "estop" en el marco: una seta pulsada en este marco ya abortó
+ * el perfil antes de que salga una consigna. La inclinación solo se escribe
+ * cuando cambia (update_incline_target avisa si no está calibrada).
+ */
+static void profile_step(const cyclic_ctx_t *ctx) {
+    static float last_incline_pct = -1.0f;
+    float speed_kmh;
+    float incline_pct;
 
-        // Convertir Hz a km/h usando la fórmula del VFD SU300
-        // velocidad_kmh = frecuencia_Hz × (6.4 / 50.0)
-        float new_real_speed = vfd_freq_hz * (6.4f / 50.0f);
+    if (!motion_profile_step(ctx->release_us, &speed_kmh, &incline_pct)) {
+        last_incline_pct = -1.0f;
+        return;
+    }
+    if (atomic_load(&g_emergency_state) || atomic_load(&g_estop_rearm_required)) {
+        motion_profile_abort("safe state");
+        return;
+    }
 
-        xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-        g_real_speed_kmh = new_real_speed;
-        xSemaphoreGive(g_speed_mutex);
+    update_speed_target(speed_kmh);
+    if (incline_pct != last_incline_pct) {
+        last_incline_pct = incline_pct;
+        update_incline_target(incline_pct);
     }
 }
 
-static void incline_control_task(void *pvParameters) {
-    ESP_LOGI(TAG, "Tarea de control de inclinación iniciada");
+/**
+ * @brief Timeout para bajar desde from_pct hasta el fin de carrera
+ *
+ * La bajada es la escala de referencia del modelo y va siempre a la
+ * velocidad nominal; lo aprendido es la latencia de arranque, que se suma.
+ */
+static uint32_t incline_descend_timeout_ms(float from_pct) {
+    float travel_ms = fmaxf(from_pct, 0.0f) / INCLINE_MODEL_NOMINAL_PCT_PER_S * 1000.0f +
+                      incline_model_get()->start_latency_ms;
+    return (uint32_t)travel_ms + INCLINE_TIMEOUT_MARGIN_MS;
+}
+
+/**
+ * @brief Inicialización del control de inclinación (antes de arrancar el ejecutivo)
+ */
+static void incline_control_init(void) {
+    ESP_LOGI(TAG, "Control de inclinación iniciado");
 
-    // Cargar posición guardada desde NVS y calcular timeout dinámico
-    g_last_saved_incline_pct = load_incline_position_from_nvs();
+    // Cargar posición guardada (RTC o NVS) y calcular timeout dinámico
+    g_last_saved_incline_pct = persist_boot_incline_position();
+    incline_model_init();
 
-    // Calcular timeout dinámico: tiempo estimado para bajar desde posición guardada + 5s margen
-    // Fórmula: (posición_pct / 0.375%/s) * 1000ms + 5000ms
-    g_homing_timeout_ms = (uint32_t)((g_last_saved_incline_pct / 0.375f) * 1000.0f) + 5000;
-    ESP_LOGI(TAG, "Timeout dinámico de homing calculado: %lu ms (basado en posición guardada: %.1f%%)",
-             g_homing_timeout_ms, g_last_saved_incline_pct);
+    // Calcular timeout dinámico: tiempo estimado para bajar desde posición guardada + margen,
+    // con la latencia de arranque del modelo recién cargado
+    g_homing_timeout_ms = incline_descend_timeout_ms(g_last_saved_incline_pct);
+    ESP_LOGI(TAG, "Timeout dinámico de homing calculado: %lu ms (basado en posición guardada: %.1f%%, arranque %.0f ms)",
+             g_homing_timeout_ms, g_last_saved_incline_pct, incline_model_get()->start_latency_ms);
 
     // PROTECCIÓN CRÍTICA: Si hay fallo persistente del sensor, NO hacer homing
-    if (g_incline_sensor_fault) {
+    if (atomic_load(&g_incline_sensor_fault)) {
         ESP_LOGE(TAG, "Sistema bloqueado por fallo del sensor - Homing desactivado");
         g_incline_is_calibrated = false;
         g_incline_motor_state = INCLINE_MOTOR_STOPPED;
@@ -645,157 +1196,302 @@ static void incline_control_task(void *pvParameters) {
         g_incline_motor_state = INCLINE_MOTOR_HOMING;
         g_homing_start_time_us = esp_timer_get_time();  // Registrar inicio de homing
     }
+    publish_incline_state();
+}
 
-    uint64_t last_update_time_us = esp_timer_get_time();
+/**
+ * @brief Fin de carrera alcanzado (HOMING o DOWN): referencia 0%
+ *
+ * El relé ya lo cortó la ISR en el flanco, así que el actuador se detuvo sobre
+ * el fin de carrera y 0% es exacto. En un descenso calibrado, la posición
+ * estimada en el instante del flanco es el error acumulado del modelo desde la
+ * referencia anterior: se corrige aquí y el modelo aprende de él.
+ */
+static void incline_limit_reached(uint32_t edge_us) {
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    if (g_incline_motor_state == INCLINE_MOTOR_DOWN && g_incline_is_calibrated && g_move_on_us != 0) {
+        int64_t on_us = (int32_t)(edge_us - (uint32_t)g_move_on_us);
+        if (on_us < 0) {
+            on_us = 0;
+        }
+        incline_model_limit_hit(g_move_start_pct - incline_model_travel_pct(false, on_us), on_us);
+    } else {
+        incline_model_reference();
+    }
+    ESP_LOGI(TAG, "Fin de carrera: flanco detectado hace %lu us", now_us - edge_us);
+    blackbox_event(CM_BBOX_EVT_LIMIT_HIT);
 
-    for(;;) {
-        vTaskDelay(pdMS_TO_TICKS(50)); // <-- CORREGIDO (Errata)
-        uint64_t now_us = esp_timer_get_time();
-        uint64_t delta_us = now_us - last_update_time_us;
-        last_update_time_us = now_us;
-        float delta_ms = (float)delta_us / 1000.0f;
+    g_move_on_us = 0;  // Pulso terminado en el fin de carrera: no hay inercia que sumar
+    stop_incline_motor();
+    g_real_incline_pct = 0.0f;
+    atomic_store(&g_target_incline_pct, 0.0f);
+    g_incline_is_calibrated = true;
+}
 
-        xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
+/**
+ * @brief true si el pulso en curso ya cumplió INCLINE_MODEL_MIN_ON_MS
+ */
+static bool incline_min_on_elapsed(uint64_t now_us) {
+    return (int64_t)now_us - g_move_on_us >= (int64_t)INCLINE_MODEL_MIN_ON_MS * 1000;
+}
 
-        // PROTECCIÓN CRÍTICA: Si hay fallo del sensor, no hacer nada
-        if (g_incline_sensor_fault || g_emergency_state) {
-            xSemaphoreGive(g_speed_mutex);
-            continue;
+/**
+ * @brief Slot del ejecutivo: control de posición de inclinación
+ *
+ * La posición durante un pulso se calcula con el modelo del actuador desde la
+ * activación del relé hasta el inicio planificado del marco (no con el tiempo
+ * medido), de modo que el jitter de planificación no se convierte en error de
+ * posición. Los relés se conmutan al inicio del marco.
+ */
+static void incline_control_step(const cyclic_ctx_t *ctx) {
+    uint64_t now_us = ctx->release_us;
+
+    // PROTECCIÓN CRÍTICA: Si hay fallo del sensor o safe state, no hacer nada
+    if (atomic_load(&g_incline_sensor_fault) || atomic_load(&g_emergency_state)) {
+        // enter_safe_state() ya cortó los relés: completar la parada del estado interno
+        if (g_incline_motor_state != INCLINE_MOTOR_STOPPED) {
+            stop_incline_motor();
+            publish_incline_state();
         }
+        return;
+    }
 
-        switch (g_incline_motor_state) {
-            case INCLINE_MOTOR_STOPPED:
-                if (!g_incline_is_calibrated) {
-                    g_incline_motor_state = INCLINE_MOTOR_HOMING;
-                    g_homing_start_time_us = now_us;  // Registrar inicio de homing
-                } else {
-                    float error = g_target_incline_pct - g_real_incline_pct;
-                    if (fabs(error) > 0.1) {
-                        if (error > 0) {
-                            g_incline_motor_state = INCLINE_MOTOR_UP;
-                            gpio_set_level(INCLINE_DIRECTION_PIN, 0);  // 0 = arriba (HIGH=ON)
-                            gpio_set_level(INCLINE_ON_OFF_PIN, 1);     // 1 = ON (HIGH=ON)
-                        } else {
-                            g_incline_motor_state = INCLINE_MOTOR_DOWN;
-                            gpio_set_level(INCLINE_DIRECTION_PIN, 1);  // 1 = abajo (HIGH=ON)
-                            gpio_set_level(INCLINE_ON_OFF_PIN, 1);     // 1 = ON (HIGH=ON)
-
-                            // Si el objetivo es 0%, iniciar modo "descenso a cero"
-                            if (g_target_incline_pct == 0.0f) {
-                                g_descend_to_zero_start_time_us = now_us;
-                                // Timeout dinámico: tiempo para bajar desde posición actual + 5s margen
-                                g_descend_to_zero_timeout_ms = (uint32_t)((g_real_incline_pct / 0.375f) * 1000.0f) + 5000;
-                                ESP_LOGI(TAG, "Iniciando descenso a 0%% desde %.1f%% (timeout: %lu ms)",
-                                         g_real_incline_pct, g_descend_to_zero_timeout_ms);
-                            }
+    // Peticiones de otras tareas (solo esta tarea modifica el estado de inclinación)
+    unsigned requests = atomic_exchange(&g_incline_requests, 0);
+    if (requests & INCLINE_REQ_HOMING) {
+        g_incline_motor_state = INCLINE_MOTOR_HOMING;
+        g_incline_is_calibrated = false;
+        g_homing_start_time_us = now_us;  // Registrar inicio de homing
+        g_move_on_us = 0;                 // El pulso en curso pasa a ser homing
+        incline_model_reference();
+    } else if (requests & INCLINE_REQ_UNCALIBRATE) {
+        g_incline_is_calibrated = false;
+        incline_model_reference();
+    }
+
+    float target_pct = atomic_load(&g_target_incline_pct);
+    uint32_t edge_us;
+
+    if (g_incline_motor_state == INCLINE_MOTOR_HOMING || g_incline_motor_state == INCLINE_MOTOR_DOWN) {
+        limit_switch_arm();
+    }
+
+    switch (g_incline_motor_state) {
+        case INCLINE_MOTOR_STOPPED:
+            if (!g_incline_is_calibrated) {
+                g_incline_motor_state = INCLINE_MOTOR_HOMING;
+                g_homing_start_time_us = now_us;  // Registrar inicio de homing
+            } else {
+                float error = target_pct - g_real_incline_pct;
+                bool up = error > 0;
+                // Pulsos de al menos INCLINE_MODEL_MIN_ON_MS separados por
+                // INCLINE_MODEL_MIN_OFF_MS: sin traqueteo de relés con consignas
+                // que cambian poco a poco
+                float min_error = fmaxf(INCLINE_DEADBAND_PCT, incline_model_min_step_pct(up));
+                bool relay_rested = (int64_t)now_us - g_relay_off_us >= (int64_t)INCLINE_MODEL_MIN_OFF_MS * 1000;
+                if (fabsf(error) <= min_error) {
+                    incline_selector_ready(false, now_us);  // Reposo: selector arriba
+                } else if (incline_selector_ready(!up, now_us) && relay_rested) {
+                    incline_move_start(up, now_us);
+                    if (!up) {
+                        // Si el objetivo es 0%, iniciar modo "descenso a cero"
+                        if (target_pct == 0.0f) {
+                            g_descend_to_zero_start_time_us = now_us;
+                            // Timeout dinámico: tiempo para bajar desde posición actual + margen
+                            g_descend_to_zero_timeout_ms = incline_descend_timeout_ms(g_real_incline_pct);
+                            ESP_LOGI(TAG, "Iniciando descenso a 0%% desde %.1f%% (timeout: %lu ms)",
+                                     g_real_incline_pct, g_descend_to_zero_timeout_ms);
                         }
                     }
                 }
-                break;
-            case INCLINE_MOTOR_HOMING:
-                // PROTECCIÓN CRÍTICA: Verificar timeout de homing
-                {
-                    uint64_t homing_elapsed_ms = (now_us - g_homing_start_time_us) / 1000;
-                    if (homing_elapsed_ms > g_homing_timeout_ms) {
-                        ESP_LOGE(TAG, "⚠️ TIMEOUT DE HOMING EXCEDIDO: %llu ms > %lu ms",
-                                 homing_elapsed_ms, g_homing_timeout_ms);
+            }
+            break;
+        case INCLINE_MOTOR_HOMING:
+            // PROTECCIÓN CRÍTICA: Verificar timeout de homing
+            {
+                uint64_t homing_elapsed_ms = (now_us - g_homing_start_time_us) / 1000;
+                if (homing_elapsed_ms > g_homing_timeout_ms) {
+                    ESP_LOGE(TAG, "⚠️ TIMEOUT DE HOMING EXCEDIDO: %llu ms > %lu ms",
+                             homing_elapsed_ms, g_homing_timeout_ms);
+                    ESP_LOGE(TAG, "El fin de carrera no se detectó en el tiempo esperado");
+                    handle_incline_sensor_fault();
+                    break;
+                }
+            }
+
+            // Bajar hasta detectar fin de carrera
+            if (limit_switch_hit(&edge_us)) {
+                // Fin de carrera activado - calibración completada
+                ESP_LOGI(TAG, "✓ Homing de inclinación completado - Fin de carrera detectado");
+                incline_limit_reached(edge_us);
+                target_pct = 0.0f;
+            } else {
+                // Continuar bajando para buscar fin de carrera
+                incline_drive_down(now_us);
+            }
+            break;
+        case INCLINE_MOTOR_UP:
+            if (atomic_exchange(&s_release_latched, false)) {
+                uint32_t release_us = atomic_load(&s_release_edge_us);
+                incline_model_start_latency((int32_t)(release_us - (uint32_t)g_move_on_us));
+                atomic_store(&s_release_armed, false);
+            }
+            g_real_incline_pct = g_move_start_pct + incline_model_travel_pct(true, now_us - g_move_on_us);
+            // Corte anticipado: la inercia lleva el actuador hasta el objetivo
+            if (g_real_incline_pct + incline_model_coast_pct(true) >= target_pct && incline_min_on_elapsed(now_us)) {
+                stop_incline_motor();
+            }
+            break;
+        case INCLINE_MOTOR_DOWN:
+            // Verificar fin de carrera primero (seguridad y recalibración)
+            if (limit_switch_hit(&edge_us)) {
+                // Fin de carrera detectado - recalibrar a 0%
+                ESP_LOGI(TAG, "✓ Fin de carrera detectado durante descenso - Recalibrando a 0%%");
+                incline_limit_reached(edge_us);
+                target_pct = 0.0f;
+                g_descend_to_zero_start_time_us = 0;  // Reset timeout
+            } else {
+                // Continuar bajando normalmente
+                g_real_incline_pct = g_move_start_pct - incline_model_travel_pct(false, now_us - g_move_on_us);
+
+                // Si estamos en modo "descenso a cero" (target = 0%)
+                if (target_pct == 0.0f && g_descend_to_zero_start_time_us > 0) {
+                    // PROTECCIÓN CRÍTICA: Verificar timeout de descenso a cero
+                    uint64_t descend_elapsed_ms = (now_us - g_descend_to_zero_start_time_us) / 1000;
+                    if (descend_elapsed_ms > g_descend_to_zero_timeout_ms) {
+                        ESP_LOGE(TAG, "⚠️ TIMEOUT DE DESCENSO A CERO EXCEDIDO: %llu ms > %lu ms",
+                                 descend_elapsed_ms, g_descend_to_zero_timeout_ms);
                         ESP_LOGE(TAG, "El fin de carrera no se detectó en el tiempo esperado");
-                        xSemaphoreGive(g_speed_mutex);
+                        g_descend_to_zero_start_time_us = 0;  // Reset timeout
                         handle_incline_sensor_fault();
-                        xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
                         break;
                     }
-                }
-
-                // Bajar hasta detectar fin de carrera
-                if (gpio_get_level(INCLINE_LIMIT_SWITCH_PIN) == 0) {
-                    // Fin de carrera activado - calibración completada
-                    ESP_LOGI(TAG, "✓ Homing de inclinación completado - Fin de carrera detectado");
-                    stop_incline_motor();
-                    g_real_incline_pct = 0.0f;
-                    g_target_incline_pct = 0.0f;
-                    g_incline_is_calibrated = true;
-                } else {
-                    // Continuar bajando para buscar fin de carrera
-                    gpio_set_level(INCLINE_DIRECTION_PIN, 1);  // 1 = abajo (HIGH=ON)
-                    gpio_set_level(INCLINE_ON_OFF_PIN, 1);     // 1 = ON (HIGH=ON)
-                }
-                break;
-            case INCLINE_MOTOR_UP:
-                g_real_incline_pct += (delta_ms * INCLINE_SPEED_PCT_PER_MS);
-                if (g_real_incline_pct >= g_target_incline_pct) {
-                    stop_incline_motor();
-                    g_real_incline_pct = g_target_incline_pct;
-                }
-                break;
-            case INCLINE_MOTOR_DOWN:
-                // Verificar fin de carrera primero (seguridad y recalibración)
-                if (gpio_get_level(INCLINE_LIMIT_SWITCH_PIN) == 0) {
-                    // Fin de carrera detectado - recalibrar a 0%
-                    ESP_LOGI(TAG, "✓ Fin de carrera detectado durante descenso - Recalibrando a 0%%");
-                    stop_incline_motor();
-                    g_real_incline_pct = 0.0f;
-                    g_target_incline_pct = 0.0f;
-                    g_incline_is_calibrated = true;
-                    g_descend_to_zero_start_time_us = 0;  // Reset timeout
+                    // En modo descenso a cero: NO detenerse por cálculo, solo por fin de carrera
+                    // Continuar bajando hasta detectar el fin de carrera físico
                 } else {
-                    // Continuar bajando normalmente
-                    g_real_incline_pct -= (delta_ms * INCLINE_SPEED_PCT_PER_MS);
-
-                    // Si estamos en modo "descenso a cero" (target = 0%)
-                    if (g_target_incline_pct == 0.0f && g_descend_to_zero_start_time_us > 0) {
-                        // PROTECCIÓN CRÍTICA: Verificar timeout de descenso a cero
-                        uint64_t descend_elapsed_ms = (now_us - g_descend_to_zero_start_time_us) / 1000;
-                        if (descend_elapsed_ms > g_descend_to_zero_timeout_ms) {
-                            ESP_LOGE(TAG, "⚠️ TIMEOUT DE DESCENSO A CERO EXCEDIDO: %llu ms > %lu ms",
-                                     descend_elapsed_ms, g_descend_to_zero_timeout_ms);
-                            ESP_LOGE(TAG, "El fin de carrera no se detectó en el tiempo esperado");
-                            g_descend_to_zero_start_time_us = 0;  // Reset timeout
-                            xSemaphoreGive(g_speed_mutex);
-                            handle_incline_sensor_fault();
-                            xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-                            break;
-                        }
-                        // En modo descenso a cero: NO detenerse por cálculo, solo por fin de carrera
-                        // Continuar bajando hasta detectar el fin de carrera físico
-                    } else {
-                        // Modo normal (target > 0%): detenerse por cálculo
-                        // PROTECCIÓN CRÍTICA: Si bajó más allá del umbral, el sensor falló
-                        if (g_real_incline_pct < INCLINE_SAFETY_THRESHOLD_PCT) {
-                            xSemaphoreGive(g_speed_mutex);
-                            handle_incline_sensor_fault();
-                            xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-                            break;
-                        }
+                    // Modo normal (target > 0%): detenerse por cálculo
+                    // PROTECCIÓN CRÍTICA: Si bajó más allá del umbral, el sensor falló
+                    if (g_real_incline_pct < INCLINE_SAFETY_THRESHOLD_PCT) {
+                        handle_incline_sensor_fault();
+                        break;
+                    }
 
-                        if (g_real_incline_pct <= g_target_incline_pct) {
-                            stop_incline_motor();
-                            g_real_incline_pct = g_target_incline_pct;
-                        }
+                    // Corte anticipado: la inercia lleva el actuador hasta el objetivo
+                    if (g_real_incline_pct - incline_model_coast_pct(false) <= target_pct &&
+                        incline_min_on_elapsed(now_us)) {
+                        stop_incline_motor();
                     }
                 }
-                break;
-        }
-        xSemaphoreGive(g_speed_mutex);
+            }
+            break;
     }
-}
 
-static void watchdog_task(void *pvParameters) {
-    ESP_LOGI(TAG, "Tarea de watchdog iniciada (Timeout: %llu ms)", WATCHDOG_TIMEOUT_US / 1000);
-    vTaskDelay(pdMS_TO_TICKS(2000)); // <-- CORREGIDO (Errata)
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(100)); // <-- CORREGIDO (Errata)
-        if (g_emergency_state) {
-            continue;
-        }
-        uint64_t time_since_last_cmd = esp_timer_get_time() - g_last_command_time_us;
-        if (time_since_last_cmd > WATCHDOG_TIMEOUT_US) {
-            ESP_LOGE(TAG, "¡WATCHDOG TIMEOUT! No se recibió comando en %llu ms", WATCHDOG_TIMEOUT_US / 1000);
-            enter_safe_state();
-        }
+    // El watchdog pudo disparar durante este paso (después de la comprobación
+    // inicial) y un relé recién activado no debe quedar encendido hasta el siguiente
+    if (atomic_load(&g_emergency_state) && g_incline_motor_state != INCLINE_MOTOR_STOPPED) {
+        stop_incline_motor();
     }
+    publish_incline_state();
+}
+
+/** Diferencia de un contador acumulado desde la muestra anterior, saturada a 8 bits */
+static uint8_t blackbox_delta(atomic_uint *counter, uint32_t *last) {
+    uint32_t now = atomic_load(counter);
+    uint32_t delta = now - *last;
+    *last = now;
+    return delta > UINT8_MAX ? UINT8_MAX : (uint8_t)delta;
 }
 
+static int16_t blackbox_x100(float v) {
+    float scaled = roundf(v * 100.0f);
+    return scaled > INT16_MAX ? INT16_MAX : (scaled < INT16_MIN ? INT16_MIN : (int16_t)scaled);
+}
+
+/**
+ * @brief Slot del ejecutivo: una muestra de la caja negra por marco menor
+ *
+ * Va detrás de "incline" y "relays" para ver los relés que acaban de
+ * cambiar. Solo lee atómicos y el estado propio del ejecutivo: no bloquea.
+ */
+static void blackbox_step(const cyclic_ctx_t *ctx) {
+    static uint32_t s_last_sync_ok = 0;
+    static uint32_t s_last_frames_bad = 0;
+
+    uint32_t relays = actuators_relays();
+    vfd_status_t vfd = vfd_driver_get_status();
+
+    cm_bbox_record_t rec = {
+        .t_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .target_speed = blackbox_x100(atomic_load(&g_target_speed_kmh)),
+        .real_speed = blackbox_x100(atomic_load(&g_real_speed_kmh)),
+        .target_incline = blackbox_x100(atomic_load(&g_target_incline_pct)),
+        .real_incline = blackbox_x100(g_real_incline_pct),
+        .vfd_target_freq = (uint16_t)blackbox_x100(vfd_driver_get_target_freq_hz()),
+        .vfd_real_freq = (uint16_t)blackbox_x100(vfd_driver_get_real_freq_hz()),
+        .incline_state = (uint8_t)g_incline_motor_state,
+        .sync_ok = blackbox_delta(&g_sync_ok_count, &s_last_sync_ok),
+        .frames_bad = blackbox_delta(&g_frames_bad_count, &s_last_frames_bad),
+    };
+
+    rec.flags = (atomic_load(&g_emergency_state) ? CM_BBOX_FLAG_SAFE_STATE : 0) |
+                (atomic_load(&g_incline_sensor_fault) ? CM_BBOX_FLAG_INCLINE_FAULT : 0) |
+                (g_incline_is_calibrated ? CM_BBOX_FLAG_CALIBRATED : 0) |
+                (atomic_load(&g_link_seen) ? CM_BBOX_FLAG_LINK_SEEN : 0) |
+                (atomic_load(&g_estop_input_active) ? CM_BBOX_FLAG_ESTOP_INPUT : 0) |
+                (atomic_load(&g_estop_rearm_required) ? CM_BBOX_FLAG_ESTOP_REARM : 0) |
+                (vfd == VFD_STATUS_FAULT ? CM_BBOX_FLAG_VFD_FAULT : 0) |
+                (vfd == VFD_STATUS_DISCONNECTED ? CM_BBOX_FLAG_VFD_OFFLINE : 0);
+
+    // Relés aplicados (no las peticiones): se ven las etapas de cada cambio
+    rec.relays = (relays & ACT_BIT(ACT_RELAY_INCLINE_ON) ? CM_BBOX_RELAY_INCLINE_ON : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_INCLINE_DOWN) ? CM_BBOX_RELAY_INCLINE_DOWN : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_HEAD_FAN_ON) ? CM_BBOX_RELAY_HEAD_FAN : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_HEAD_FAN_SPEED) ? CM_BBOX_RELAY_HEAD_FAST : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_CHEST_FAN_ON) ? CM_BBOX_RELAY_CHEST_FAN : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_CHEST_FAN_SPEED) ? CM_BBOX_RELAY_CHEST_FAST : 0) |
+                 (relays & ACT_BIT(ACT_RELAY_WAX_PUMP) ? CM_BBOX_RELAY_WAX_PUMP : 0);
+
+    blackbox_record(&rec);
+}
+
+// ===========================================================================
+// EJECUTIVO CÍCLICO
+// ===========================================================================
+
+/**
+ * Marco menor de 50 ms, marco mayor de 500 ms (10 marcos menores):
+ *
+ *   marco:      0   1   2   3   4   5   6   7   8   9
+ *   estop       x   x   x   x   x   x   x   x   x   x    (50 ms, con CONFIG_BASE_ESTOP_ENABLE)
+ *   profile     x       x       x       x       x        (100 ms)
+ *   incline     x   x   x   x   x   x   x   x   x   x    (50 ms)
+ *   relays      x   x   x   x   x   x   x   x   x   x    (50 ms)
+ *   blackbox    x   x   x   x   x   x   x   x   x   x    (50 ms, tras incline y relays)
+ *   speed           x       x       x       x       x    (100 ms)
+ *
+ * uart_rx_task y vfd_control_task siguen siendo tareas propias porque
+ * bloquean en E/S (UART y Modbus); vfd_control_task se libera en fase
+ * con su periodo mediante espera absoluta. El watchdog de comunicación no
+ * sondea: es un esp_timer one-shot que rearma cada trama válida. El STOP de
+ * emergencia tampoco espera al ejecutivo: lo envía vfd_estop_task en cuanto
+ * lo pide la ISR de la seta; el slot "estop" solo completa el safe state.
+ */
+#define EXEC_MINOR_FRAME_MS     50
+#define EXEC_MINOR_PER_MAJOR    10
+#define EXEC_TASK_PRIO          7
+
+static const cyclic_slot_t k_exec_slots[] = {
+#if CONFIG_BASE_ESTOP_ENABLE
+    { .name = "estop",    .fn = estop_step,           .every = 1,  .phase = 0, .budget_us = 500 },
+#endif
+    { .name = "profile",  .fn = profile_step,         .every = 2,  .phase = 0, .budget_us = 500 },
+    { .name = "incline",  .fn = incline_control_step, .every = 1,  .phase = 0, .budget_us = 5000 },
+    { .name = "relays",   .fn = relays_step,          .every = 1,  .phase = 0, .budget_us = 200 },
+    { .name = "blackbox", .fn = blackbox_step,        .every = 1,  .phase = 0, .budget_us = 300 },
+    { .name = "speed",    .fn = speed_update_step,    .every = 2,  .phase = 1, .budget_us = 500 },
+};
+
 // ===========================================================================
 // FUNCIÓN PRINCIPAL
 // ===========================================================================
@@ -805,85 +1501,72 @@ void app_main(void) {
     ESP_LOGI(TAG, "  PROTOCOLO: ASCII Simple (UART Direct)");
     ESP_LOGI(TAG, "==============================================");
 
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    ESP_ERROR_CHECK(base_hal_storage_init());
 
-    g_speed_mutex = xSemaphoreCreateMutex();
-    if (g_speed_mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        return;
+    // Servicio de persistencia: carga lo guardado y vuelca en segundo plano
+    ESP_ERROR_CHECK(persist_init());
+
+    // Caja negra: recupera el anillo si el reinicio fue por pánico o watchdog
+    if (blackbox_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Caja negra sin volcados a flash");
     }
 
     // Verificar si hay un error crítico guardado de sesión anterior
-    nvs_handle_t nvs_handle;
-    ret = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (ret == ESP_OK) {
-        uint8_t fault_flag = 0;
-        ret = nvs_get_u8(nvs_handle, "incline_fault", &fault_flag);
-        if (ret == ESP_OK && fault_flag == 1) {
-            g_incline_sensor_fault = true;
-            ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
-            ESP_LOGE(TAG, "  ERROR CRÍTICO PERSISTENTE DETECTADO");
-            ESP_LOGE(TAG, "  Fallo del sensor de fin de carrera registrado");
-            ESP_LOGE(TAG, "  El sistema permanecerá BLOQUEADO hasta reparación");
-            ESP_LOGE(TAG, "  Para resetear: Borrar NVS y verificar sensor");
-            ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
-        }
-        nvs_close(nvs_handle);
+    if (persist_boot_incline_fault()) {
+        atomic_store(&g_incline_sensor_fault, true);
+        ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
+        ESP_LOGE(TAG, "  ERROR CRÍTICO PERSISTENTE DETECTADO");
+        ESP_LOGE(TAG, "  Fallo del sensor de fin de carrera registrado");
+        ESP_LOGE(TAG, "  El sistema permanecerá BLOQUEADO hasta reparación");
+        ESP_LOGE(TAG, "  Para resetear: Borrar NVS y verificar sensor");
+        ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
     }
 
     configure_gpios();
-    
-    const esp_timer_create_args_t wax_pump_timer_args = {
-            .callback = &wax_pump_timer_callback,
-            .name = "wax_pump_timer"
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&wax_pump_timer_args, &wax_pump_timer_handle));
-    ESP_LOGI(TAG, "Temporizador de bomba de cera creado.");
 
-    // speed_sensor_init();  // DESHABILITADO: Sensor Hall desconectado, velocidad se calcula desde VFD
+#if CONFIG_BASE_SPEED_SENSOR_ENABLE
+    ESP_ERROR_CHECK(speed_sensor_init());
+#endif
 
     ESP_LOGI(TAG, "Configurando UART para RS485...");
-    uart_config_t uart_config = {
-        .baud_rate = UART_BAUD_RATE,
-        .data_bits = UART_DATA_8_BITS,
-        .parity    = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, 0));
-    ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM,
-                                  UART_TX_PIN,
-                                  UART_RX_PIN,
-                                  UART_PIN_NO_CHANGE,
-                                  UART_PIN_NO_CHANGE));
-    ESP_LOGI(TAG, "UART%d configurado: %d baud, TX=%d, RX=%d",
-             UART_PORT_NUM, UART_BAUD_RATE, UART_TX_PIN, UART_RX_PIN);
+    ESP_ERROR_CHECK(base_hal_uart_init(UART_BAUD_RATE, UART_TX_PIN, UART_RX_PIN, UART_BUF_SIZE * 2));
+
+    // Captura de tráfico (no-op si CONFIG_CM_CAPTURE_ENABLE está desactivado)
+    if (cm_capture_init(CM_CAPTURE_NODE_BASE) != ESP_OK) {
+        ESP_LOGW(TAG, "Captura de enlace no disponible");
+    }
 
     // ========================================================================
     // CREAR TAREAS
     // ========================================================================
 
+    // Watchdog de comunicación (antes de uart_rx_task, que lo rearma): primer disparo posible tras el margen de arranque
+    // (la Consola empieza a enviar SYNC ~1 s después de arrancar)
+    const esp_timer_create_args_t watchdog_timer_args = {
+            .callback = &comm_watchdog_callback,
+            .name = "comm_watchdog"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&watchdog_timer_args, &g_comm_watchdog_timer));
+    ESP_ERROR_CHECK(esp_timer_start_once(g_comm_watchdog_timer, WATCHDOG_STARTUP_GRACE_US));
+    ESP_LOGI(TAG, "Watchdog de comunicación armado (timeout %d ms)", CONFIG_BASE_COMM_WATCHDOG_TIMEOUT_MS);
+
     xTaskCreate(uart_rx_task, "uart_rx_task", 4096, NULL, 10, NULL);
     ESP_LOGI(TAG, "Tarea UART RX creada");
 
     vfd_driver_init();
-    ESP_LOGI(TAG, "Controlador VFD (real) inicializado");
+    ESP_LOGI(TAG, "Controlador VFD inicializado");
 
-    xTaskCreate(speed_update_task, "speed_update_task", 4096, NULL, 5, NULL);
-    ESP_LOGI(TAG, "Tarea de actualización de velocidad creada");
+    // Velocidad e inclinación: ejecutivo cíclico con marcos fijos
+    incline_control_init();
+    ESP_ERROR_CHECK(cyclic_exec_start(k_exec_slots, sizeof(k_exec_slots) / sizeof(k_exec_slots[0]),
+                                      EXEC_MINOR_FRAME_MS, EXEC_MINOR_PER_MAJOR, EXEC_TASK_PRIO));
+    ESP_LOGI(TAG, "Ejecutivo cíclico creado (marco menor %d ms)", EXEC_MINOR_FRAME_MS);
 
-    xTaskCreate(incline_control_task, "incline_ctrl_task", 4096, NULL, 7, NULL); 
-    ESP_LOGI(TAG, "Tarea de control de inclinación creada");
+    // Respuesta a STATS (tras el ejecutivo: informa de sus slots)
+    ESP_ERROR_CHECK(stats_report_init(send_line, fill_link_stats));
 
-    xTaskCreate(watchdog_task, "watchdog_task", 2048, NULL, 6, NULL);
-    ESP_LOGI(TAG, "Tarea de watchdog creada (timeout: 1000ms)");
+    // Respuesta a BLACKBOX (lecturas de flash fuera de uart_rx_task)
+    ESP_ERROR_CHECK(bbox_reply_init());
 
     ESP_LOGI(TAG, "Sistema iniciado correctamente");
     ESP_LOGI(TAG, "Esperando comandos del Maestro...");
@@ -893,15 +1576,35 @@ void app_main(void) {
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(10000));  // 10 segundos // <-- CORREGIDO (Errata)
         
-        xSemaphoreTake(g_speed_mutex, portMAX_DELAY);
-        float r_speed = g_real_speed_kmh;
-        float t_speed = g_target_speed_kmh;
-        float r_incline = g_real_incline_pct;
-        float t_incline = g_target_incline_pct;
-        xSemaphoreGive(g_speed_mutex);
+        incline_pub_t incline;
+        state_latch_read(&g_incline_pub, &incline);
+        float r_speed = atomic_load(&g_real_speed_kmh);
+        float t_speed = atomic_load(&g_target_speed_kmh);
+        float r_incline = incline.real_pct;
+        float t_incline = atomic_load(&g_target_incline_pct);
 
         ESP_LOGI(TAG, "Heartbeat #%lu - Speed: %.2f/%.2f km/h, Incline: %.1f/%.1f %%",
                  heartbeat_count++, r_speed, t_speed,
                  r_incline, t_incline);
+        ESP_LOGI(TAG, "Watchdog: %u disparos, retraso máx del disparo %u us",
+                 atomic_load(&g_watchdog_trips), atomic_load(&g_watchdog_late_max_us));
+        ESP_LOGI(TAG, "Fin de carrera: %u pulsos espurios filtrados", atomic_load(&s_limit_glitches));
+        vfd_estop_stats_t estop;
+        vfd_driver_get_estop_stats(&estop);
+        ESP_LOGI(TAG, "E-Stop: %lu paradas (%lu con Modbus abortado), latencia última/máx %lu/%lu us, peor caso de la prueba %lu us",
+                 estop.stops, estop.aborts, estop.last_latency_us, estop.max_latency_us, estop.test_worst_us);
+        vfd_driver_log_rtt();
+#if CONFIG_BASE_SPEED_SENSOR_ENABLE
+        speed_sensor_log_stats();
+        ESP_LOGI(TAG, "Velocidad: %lu lecturas con respaldo del VFD (sensor sin dientes)", g_speed_sensor_fallbacks);
+#endif
+#if CONFIG_BASE_SPEED_LOOP_ENABLE
+        speed_loop_log();
+#endif
+        cyclic_exec_log_stats();
+        persist_log_stats();
+        actuators_log_stats();
+        blackbox_log_stats();
+        ESP_LOGI(TAG, "Caja negra: %u peticiones de lectura descartadas (cola llena)", atomic_load(&g_bbox_dropped));
     }
 }
\ No newline at end of file
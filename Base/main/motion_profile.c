@@ -0,0 +1,214 @@
+/**
+ * @file motion_profile.c
+ * @brief Implementación de los perfiles de movimiento (ver motion_profile.h)
+ */
+
+#include "motion_profile.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "PROFILE";
+
+typedef struct {
+    uint32_t duration_ms;
+    float speed_kmh;
+    float incline_pct;
+    uint8_t ramp;               ///< CM_PROFILE_RAMP_*
+} segment_t;
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+// Preparación (solo uart_rx_task)
+static segment_t s_staged[CM_PROFILE_MAX_SEGMENTS];
+static uint8_t s_staged_id = 0;
+static uint32_t s_staged_mask = 0;      // Bit i = segmento i recibido
+
+// Ejecución (s_lock: el safe state aborta desde cualquier contexto)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static segment_t s_run[CM_PROFILE_MAX_SEGMENTS];
+static uint8_t s_count = 0;
+static uint8_t s_id = 0;
+static uint8_t s_state = CM_PROFILE_IDLE;
+static uint8_t s_segment = 0;
+static uint64_t s_seg_start_us = 0;     // 0 = el perfil empieza en el siguiente paso
+static float s_from_speed_kmh = 0.0f;   // Consignas al empezar el segmento en curso
+static float s_from_incline_pct = 0.0f;
+static uint32_t s_left_ms = 0;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+static float quantize(float value, float step) {
+    return roundf(value / step) * step;
+}
+
+static float segment_value(float from, float to, bool ramp, float frac) {
+    return ramp ? from + (to - from) * frac : to;
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+bool motion_profile_load_segment(const cm_profile_seg_msg_t *seg) {
+    if (seg->profile_id == 0 || seg->index >= CM_PROFILE_MAX_SEGMENTS ||
+        seg->duration_ms == 0 || seg->duration_ms > MOTION_PROFILE_MAX_SEGMENT_MS ||
+        seg->speed_kmh < 0.0f || seg->speed_kmh > MOTION_PROFILE_MAX_SPEED_KMH ||
+        seg->incline_pct < 0.0f || seg->incline_pct > MOTION_PROFILE_MAX_INCLINE_PCT) {
+        ESP_LOGW(TAG, "Segmento %u del perfil %u fuera de rango", seg->index, seg->profile_id);
+        return false;
+    }
+
+    if (seg->profile_id != s_staged_id) {
+        s_staged_id = seg->profile_id;
+        s_staged_mask = 0;
+    }
+    s_staged[seg->index] = (segment_t){
+        .duration_ms = seg->duration_ms,
+        .speed_kmh = seg->speed_kmh,
+        .incline_pct = seg->incline_pct,
+        .ramp = seg->ramp,
+    };
+    s_staged_mask |= 1u << seg->index;
+    return true;
+}
+
+bool motion_profile_start(const cm_profile_msg_t *msg, float speed_kmh, float incline_pct) {
+    uint8_t id = msg->profile_id;
+    uint8_t count = msg->segment_count;
+    if (id == 0 || count == 0 || count > CM_PROFILE_MAX_SEGMENTS) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool started = (s_id == id && s_state != CM_PROFILE_IDLE);
+    taskEXIT_CRITICAL(&s_lock);
+    if (started) {
+        return true;  // Reenvío de Consola: DATA todavía no lo había confirmado
+    }
+
+    uint32_t needed = (1u << count) - 1;
+    if (id != s_staged_id || (s_staged_mask & needed) != needed) {
+        ESP_LOGW(TAG, "Perfil %u incompleto (segmentos 0x%04lX de %u)", id,
+                 id == s_staged_id ? s_staged_mask : 0, count);
+        return false;
+    }
+
+    uint32_t total_ms = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        total_ms += s_staged[i].duration_ms;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(s_run, s_staged, count * sizeof(segment_t));
+    s_count = count;
+    s_id = id;
+    s_state = CM_PROFILE_RUNNING;
+    s_segment = 0;
+    s_seg_start_us = 0;
+    s_from_speed_kmh = speed_kmh;
+    s_from_incline_pct = incline_pct;
+    s_left_ms = s_run[0].duration_ms;
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_staged_mask = 0;
+    ESP_LOGI(TAG, "Perfil %u arrancado: %u segmentos, %lu s", id, count, total_ms / 1000);
+    return true;
+}
+
+bool motion_profile_sync(uint8_t id) {
+    taskENTER_CRITICAL(&s_lock);
+    uint8_t running_id = s_id;
+    bool cancelled = (s_state == CM_PROFILE_RUNNING && s_id != id);
+    if (cancelled) {
+        s_state = CM_PROFILE_ABORTED;
+    }
+    bool owned = (id != 0 && s_id == id &&
+                  (s_state == CM_PROFILE_RUNNING || s_state == CM_PROFILE_DONE));
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (cancelled) {
+        ESP_LOGI(TAG, "Perfil %u cancelado por la Consola", running_id);
+    }
+    return owned;
+}
+
+void motion_profile_abort(const char *reason) {
+    taskENTER_CRITICAL(&s_lock);
+    bool aborted = (s_state == CM_PROFILE_RUNNING);
+    if (aborted) {
+        s_state = CM_PROFILE_ABORTED;
+    }
+    uint8_t id = s_id;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (aborted) {
+        ESP_LOGW(TAG, "Perfil %u abortado (%s)", id, reason);
+    }
+}
+
+bool motion_profile_step(uint64_t now_us, float *speed_kmh, float *incline_pct) {
+    taskENTER_CRITICAL(&s_lock);
+    if (s_state != CM_PROFILE_RUNNING) {
+        taskEXIT_CRITICAL(&s_lock);
+        return false;
+    }
+    if (s_seg_start_us == 0) {
+        s_seg_start_us = now_us;
+    }
+
+    // Segmentos cumplidos desde el paso anterior (el final de uno es el origen del siguiente)
+    uint8_t prev_segment = s_segment;
+    while (s_segment < s_count &&
+           now_us - s_seg_start_us >= (uint64_t)s_run[s_segment].duration_ms * 1000) {
+        s_seg_start_us += (uint64_t)s_run[s_segment].duration_ms * 1000;
+        s_from_speed_kmh = s_run[s_segment].speed_kmh;
+        s_from_incline_pct = s_run[s_segment].incline_pct;
+        s_segment++;
+    }
+
+    float speed;
+    float incline;
+    bool finished = (s_segment >= s_count);
+    if (finished) {
+        s_segment = s_count - 1;
+        s_state = CM_PROFILE_DONE;
+        s_left_ms = 0;
+        speed = s_run[s_segment].speed_kmh;
+        incline = s_run[s_segment].incline_pct;
+    } else {
+        const segment_t *seg = &s_run[s_segment];
+        uint64_t elapsed_us = now_us - s_seg_start_us;
+        float frac = (float)elapsed_us / ((float)seg->duration_ms * 1000.0f);
+        speed = segment_value(s_from_speed_kmh, seg->speed_kmh, seg->ramp & CM_PROFILE_RAMP_SPEED, frac);
+        incline = segment_value(s_from_incline_pct, seg->incline_pct, seg->ramp & CM_PROFILE_RAMP_INCLINE, frac);
+        s_left_ms = seg->duration_ms - (uint32_t)(elapsed_us / 1000);
+    }
+    uint8_t id = s_id;
+    uint8_t segment = s_segment;
+    taskEXIT_CRITICAL(&s_lock);
+
+    *speed_kmh = quantize(speed, MOTION_PROFILE_SPEED_STEP_KMH);
+    *incline_pct = quantize(incline, MOTION_PROFILE_INCLINE_STEP_PCT);
+
+    if (finished) {
+        ESP_LOGI(TAG, "Perfil %u terminado: %.1f km/h, %.1f%%", id, *speed_kmh, *incline_pct);
+    } else if (segment != prev_segment) {
+        ESP_LOGI(TAG, "Perfil %u: segmento %u", id, segment);
+    }
+    return true;
+}
+
+void motion_profile_get_progress(motion_profile_progress_t *out) {
+    taskENTER_CRITICAL(&s_lock);
+    out->id = s_id;
+    out->state = s_state;
+    out->segment = s_segment;
+    out->left_ms = s_left_ms;
+    taskEXIT_CRITICAL(&s_lock);
+}
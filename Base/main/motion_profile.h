@@ -0,0 +1,106 @@
+/**
+ * @file motion_profile.h
+ * @brief Perfiles de movimiento ejecutados en Base (segmentos de velocidad e inclinación)
+ *
+ * Consola envía una vez la lista de segmentos (PSEG/PROFILE, ver cm_schema.h)
+ * y el slot "profile" del ejecutivo calcula las consignas localmente: las
+ * rampas e intervalos no dependen del jitter del enlace ni generan una trama
+ * por paso.
+ *
+ * - Los segmentos llegan en líneas sueltas y se acumulan en un área de
+ *   preparación; PROFILE los pasa a ejecución solo si están todos.
+ * - Las consignas salen en pasos de MOTION_PROFILE_SPEED_STEP_KMH y
+ *   MOTION_PROFILE_INCLINE_STEP_PCT (la resolución de los botones de
+ *   Consola): una rampa lenta no reescribe el objetivo en cada paso.
+ * - Al terminar se mantienen las consignas del último segmento hasta que
+ *   Consola deje de pedir el perfil en el SYNC.
+ *
+ * uart_rx_task carga, arranca y cancela; el slot "profile" avanza; el safe
+ * state aborta desde cualquier contexto (esp_timer, ejecutivo o UART).
+ */
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cm_schema.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+#define MOTION_PROFILE_MAX_SEGMENT_MS   (60u * 60u * 1000u)  // 1 h por segmento
+#define MOTION_PROFILE_MAX_SPEED_KMH    20.0f   // Mismos límites que el SYNC
+#define MOTION_PROFILE_MAX_INCLINE_PCT  15.0f
+#define MOTION_PROFILE_SPEED_STEP_KMH   0.1f
+#define MOTION_PROFILE_INCLINE_STEP_PCT 0.1f
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/** Progreso para DATA */
+typedef struct {
+    uint8_t id;                 ///< Último perfil arrancado (0 = ninguno)
+    uint8_t state;              ///< CM_PROFILE_*
+    uint8_t segment;            ///< Segmento en curso (o el último, si terminó)
+    uint32_t left_ms;           ///< Tiempo que le queda al segmento en curso
+} motion_profile_progress_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Guarda un segmento en el área de preparación (línea PSEG)
+ *
+ * Un profile_id distinto del que se estaba preparando descarta los anteriores.
+ *
+ * @return false si el segmento está fuera de rango
+ */
+bool motion_profile_load_segment(const cm_profile_seg_msg_t *seg);
+
+/**
+ * @brief Arranca el perfil preparado (línea PROFILE)
+ *
+ * Las rampas del primer segmento parten de las consignas actuales. Repetir
+ * PROFILE de un perfil ya arrancado no tiene efecto.
+ *
+ * @param speed_kmh   Consigna de velocidad actual
+ * @param incline_pct Consigna de inclinación actual
+ * @return false si faltan segmentos o no coincide el profile_id
+ */
+bool motion_profile_start(const cm_profile_msg_t *msg, float speed_kmh, float incline_pct);
+
+/**
+ * @brief Aplica el profile_id de un SYNC
+ *
+ * Cancela el perfil en marcha si Consola pide otro (o ninguno).
+ *
+ * @return true si el perfil id está en marcha o terminado: sus consignas
+ *         mandan sobre las del SYNC
+ */
+bool motion_profile_sync(uint8_t id);
+
+/**
+ * @brief Aborta el perfil en marcha (safe state, fin del entrenamiento)
+ */
+void motion_profile_abort(const char *reason);
+
+/**
+ * @brief Un paso del perfil (slot "profile")
+ *
+ * @param now_us Instante del paso (el primero fija el inicio del perfil)
+ * @param[out] speed_kmh   Consigna de velocidad
+ * @param[out] incline_pct Consigna de inclinación
+ * @return true si hay consignas que aplicar (perfil en marcha o recién terminado)
+ */
+bool motion_profile_step(uint64_t now_us, float *speed_kmh, float *incline_pct);
+
+/**
+ * @brief Copia el progreso del perfil
+ */
+void motion_profile_get_progress(motion_profile_progress_t *out);
+
+#endif // MOTION_PROFILE_H
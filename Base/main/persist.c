@@ -0,0 +1,588 @@
+/**
+ * @file persist.c
+ * @brief Implementación del servicio de persistencia (ver persist.h)
+ */
+
+#include "persist.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "PERSIST";
+
+#define PERSIST_STACK           3072
+#define PERSIST_NVS_NAMESPACE   "storage"
+#define PERSIST_KEY_INCLINE_POS "incline_pos"
+#define PERSIST_KEY_INCLINE_FLT "incline_fault"
+#define PERSIST_KEY_INCLINE_MDL "incline_model"
+#define PERSIST_KEY_VFD_FP      "vfd_params_fp"
+#define PERSIST_KEY_RELAY_CYC   "relay_cycles"
+
+/** Valores pendientes de volcar (s_dirty) */
+#define PERSIST_DIRTY_INCLINE_POS   0x01
+#define PERSIST_DIRTY_INCLINE_FAULT 0x02
+#define PERSIST_DIRTY_INCLINE_MODEL 0x04
+#define PERSIST_DIRTY_VFD_FP        0x08
+#define PERSIST_DIRTY_RELAY_CYCLES  0x10
+
+/** Bits de notificación de la tarea */
+#define PERSIST_NOTIFY_CHANGE   0x01
+#define PERSIST_NOTIFY_FLUSH    0x02
+
+/** Marca de registro RTC válido */
+#define PERSIST_RTC_MAGIC       0x50525354  // "PRST"
+
+/** Valor de s_nvs_incline_x100 cuando NVS no tiene posición */
+#define PERSIST_X100_NONE       INT32_MIN
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+/**
+ * Copia en RTC: sobrevive a reinicios sin pérdida de alimentación. Se
+ * invalida escribiendo check el último, de modo que un reinicio a mitad de
+ * actualización deja un registro que no valida y se usa NVS.
+ */
+typedef struct {
+    uint32_t magic;
+    int32_t incline_x100;
+    uint32_t check;
+} persist_rtc_t;
+
+static RTC_NOINIT_ATTR persist_rtc_t s_rtc;
+
+/** Escritos por el control, consumidos por la tarea */
+static atomic_int s_pending_incline_x100 = 0;
+static atomic_uint s_dirty = 0;
+
+/** Último valor comprometido en NVS (solo bajo s_flush_mutex) */
+static int32_t s_nvs_incline_x100 = PERSIST_X100_NONE;
+static bool s_nvs_incline_fault = false;
+
+/**
+ * Modelo del actuador: blob opaco (lo interpreta incline_model). La copia
+ * pendiente se protege con s_model_lock; la de NVS solo bajo s_flush_mutex.
+ */
+static uint8_t s_pending_model[PERSIST_MODEL_MAX];
+static size_t s_pending_model_len = 0;
+static portMUX_TYPE s_model_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t s_nvs_model[PERSIST_MODEL_MAX];
+static size_t s_nvs_model_len = 0;
+
+/** Huella de los parámetros del VFD: pendiente (atómica) y guardada en NVS */
+static atomic_uint s_pending_vfd_fp = 0;
+static uint32_t s_nvs_vfd_fp = 0;
+static uint32_t s_boot_vfd_fp = 0;
+
+/** Ciclos por relé: pendientes (s_relay_lock) y guardados en NVS */
+static uint32_t s_pending_relay[PERSIST_RELAY_MAX];
+static size_t s_pending_relay_count = 0;
+static portMUX_TYPE s_relay_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_nvs_relay[PERSIST_RELAY_MAX];
+static size_t s_nvs_relay_count = 0;
+
+/** Valores de arranque */
+static float s_boot_incline_pct = 0.0f;
+static bool s_boot_incline_fault = false;
+
+static persist_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static SemaphoreHandle_t s_flush_mutex = NULL;
+static TaskHandle_t s_task_handle = NULL;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+static uint32_t rtc_check(int32_t x100) {
+    return ~(PERSIST_RTC_MAGIC ^ (uint32_t)x100);
+}
+
+static bool rtc_valid(void) {
+    return s_rtc.magic == PERSIST_RTC_MAGIC && s_rtc.check == rtc_check(s_rtc.incline_x100);
+}
+
+static void rtc_store(int32_t x100) {
+    s_rtc.check = 0;
+    s_rtc.magic = PERSIST_RTC_MAGIC;
+    s_rtc.incline_x100 = x100;
+    s_rtc.check = rtc_check(x100);
+}
+
+static void stats_commit(esp_err_t err, int64_t elapsed_us) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    if (err == ESP_OK) {
+        s_stats.nvs_writes++;
+        s_stats.commit_total_us += elapsed_us;
+        if (elapsed_us > s_stats.commit_max_us) {
+            s_stats.commit_max_us = elapsed_us;
+        }
+    } else {
+        s_stats.nvs_errors++;
+    }
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void stats_unchanged(void) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.nvs_unchanged++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+/**
+ * @brief Vuelca a NVS los valores pendientes que difieren de lo ya guardado
+ *
+ * Los valores que fallan se vuelven a marcar como pendientes.
+ */
+static void persist_flush(TickType_t wait) {
+    if (xSemaphoreTake(s_flush_mutex, wait) != pdTRUE) {
+        return;
+    }
+
+    unsigned dirty = atomic_exchange(&s_dirty, 0);
+    if (dirty == 0) {
+        xSemaphoreGive(s_flush_mutex);
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.flushes++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(PERSIST_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "nvs_open falló: %s", esp_err_to_name(err));
+        atomic_fetch_or(&s_dirty, dirty);
+        stats_commit(err, 0);
+        xSemaphoreGive(s_flush_mutex);
+        return;
+    }
+
+    if (dirty & PERSIST_DIRTY_INCLINE_FAULT) {
+        if (s_nvs_incline_fault) {
+            stats_unchanged();
+        } else {
+            int64_t start_us = esp_timer_get_time();
+            err = nvs_set_u8(nvs_handle, PERSIST_KEY_INCLINE_FLT, 1);
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            stats_commit(err, esp_timer_get_time() - start_us);
+            if (err == ESP_OK) {
+                s_nvs_incline_fault = true;
+                ESP_LOGI(TAG, "Fallo de fin de carrera guardado en NVS");
+            } else {
+                atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_FAULT);
+            }
+        }
+    }
+
+    if (dirty & PERSIST_DIRTY_INCLINE_POS) {
+        int32_t x100 = atomic_load(&s_pending_incline_x100);
+        if (x100 == s_nvs_incline_x100) {
+            stats_unchanged();
+        } else {
+            int64_t start_us = esp_timer_get_time();
+            err = nvs_set_i32(nvs_handle, PERSIST_KEY_INCLINE_POS, x100);
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            stats_commit(err, esp_timer_get_time() - start_us);
+            if (err == ESP_OK) {
+                s_nvs_incline_x100 = x100;
+                ESP_LOGD(TAG, "Posición de inclinación guardada en NVS: %.2f%%", (float)x100 / 100.0f);
+            } else {
+                atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_POS);
+            }
+        }
+    }
+
+    if (dirty & PERSIST_DIRTY_INCLINE_MODEL) {
+        uint8_t model[PERSIST_MODEL_MAX];
+        taskENTER_CRITICAL(&s_model_lock);
+        size_t len = s_pending_model_len;
+        memcpy(model, s_pending_model, len);
+        taskEXIT_CRITICAL(&s_model_lock);
+
+        if (len == s_nvs_model_len && memcmp(model, s_nvs_model, len) == 0) {
+            stats_unchanged();
+        } else {
+            int64_t start_us = esp_timer_get_time();
+            err = nvs_set_blob(nvs_handle, PERSIST_KEY_INCLINE_MDL, model, len);
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            stats_commit(err, esp_timer_get_time() - start_us);
+            if (err == ESP_OK) {
+                memcpy(s_nvs_model, model, len);
+                s_nvs_model_len = len;
+                ESP_LOGD(TAG, "Modelo de inclinación guardado en NVS");
+            } else {
+                atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_MODEL);
+            }
+        }
+    }
+
+    if (dirty & PERSIST_DIRTY_VFD_FP) {
+        uint32_t fp = atomic_load(&s_pending_vfd_fp);
+        if (fp == s_nvs_vfd_fp) {
+            stats_unchanged();
+        } else {
+            int64_t start_us = esp_timer_get_time();
+            err = nvs_set_u32(nvs_handle, PERSIST_KEY_VFD_FP, fp);
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            stats_commit(err, esp_timer_get_time() - start_us);
+            if (err == ESP_OK) {
+                s_nvs_vfd_fp = fp;
+                ESP_LOGI(TAG, "Huella de parámetros del VFD guardada en NVS: 0x%08lX", fp);
+            } else {
+                atomic_fetch_or(&s_dirty, PERSIST_DIRTY_VFD_FP);
+            }
+        }
+    }
+
+    if (dirty & PERSIST_DIRTY_RELAY_CYCLES) {
+        uint32_t cycles[PERSIST_RELAY_MAX];
+        taskENTER_CRITICAL(&s_relay_lock);
+        size_t count = s_pending_relay_count;
+        memcpy(cycles, s_pending_relay, count * sizeof(cycles[0]));
+        taskEXIT_CRITICAL(&s_relay_lock);
+
+        if (count == s_nvs_relay_count && memcmp(cycles, s_nvs_relay, count * sizeof(cycles[0])) == 0) {
+            stats_unchanged();
+        } else {
+            int64_t start_us = esp_timer_get_time();
+            err = nvs_set_blob(nvs_handle, PERSIST_KEY_RELAY_CYC, cycles, count * sizeof(cycles[0]));
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            stats_commit(err, esp_timer_get_time() - start_us);
+            if (err == ESP_OK) {
+                memcpy(s_nvs_relay, cycles, count * sizeof(cycles[0]));
+                s_nvs_relay_count = count;
+                ESP_LOGD(TAG, "Ciclos de relé guardados en NVS");
+            } else {
+                atomic_fetch_or(&s_dirty, PERSIST_DIRTY_RELAY_CYCLES);
+            }
+        }
+    }
+
+    nvs_close(nvs_handle);
+    xSemaphoreGive(s_flush_mutex);
+}
+
+/**
+ * @brief Último volcado antes de esp_restart()
+ */
+static void persist_shutdown_handler(void) {
+    persist_flush(pdMS_TO_TICKS(100));
+}
+
+// ============================================================================
+// TAREA DE PERSISTENCIA
+// ============================================================================
+
+static void persist_task(void *pvParameters) {
+    bool pending = false;
+    TickType_t first_dirty = 0;
+
+    for (;;) {
+        uint32_t bits = 0;
+        bool notified = xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(PERSIST_IDLE_MS)) == pdTRUE;
+
+        if (atomic_load(&s_dirty) == 0) {
+            pending = false;
+            continue;
+        }
+        if (!pending) {
+            pending = true;
+            first_dirty = xTaskGetTickCount();
+        }
+
+        // Volcar si no hubo cambios en PERSIST_IDLE_MS, si se pidió, o si el
+        // valor lleva demasiado tiempo pendiente (actuador que no para nunca)
+        bool idle = !notified;
+        bool overdue = (xTaskGetTickCount() - first_dirty) >= pdMS_TO_TICKS(PERSIST_MAX_DEFER_MS);
+        if (idle || (bits & PERSIST_NOTIFY_FLUSH) || overdue) {
+            persist_flush(portMAX_DELAY);
+            pending = atomic_load(&s_dirty) != 0;
+            first_dirty = xTaskGetTickCount();
+        }
+    }
+}
+
+// ============================================================================
+// PRUEBA DE ESTRÉS (CONFIG_BASE_NVS_STRESS_TEST)
+// ============================================================================
+
+#if CONFIG_BASE_NVS_STRESS_TEST
+#define PERSIST_STRESS_KEY          "nvs_stress"
+#define PERSIST_STRESS_LOG_US       (10 * 1000 * 1000)
+
+/**
+ * @brief Escribe y compromete un blob sin pausa (solo banco de pruebas)
+ *
+ * Comparte s_flush_mutex con el servicio para no intercalar commits.
+ */
+static void persist_stress_task(void *pvParameters) {
+    static uint8_t blob[CONFIG_BASE_NVS_STRESS_BLOB_SIZE];
+    uint32_t commits = 0;
+    uint32_t errors = 0;
+    int64_t commit_max_us = 0;
+    int64_t next_log_us = esp_timer_get_time() + PERSIST_STRESS_LOG_US;
+
+    ESP_LOGW(TAG, "PRUEBA DE ESTRÉS NVS ACTIVA: blobs de %d bytes sin pausa", CONFIG_BASE_NVS_STRESS_BLOB_SIZE);
+
+    for (uint32_t seq = 0;; seq++) {
+        memset(blob, (int)(seq & 0xFF), sizeof(blob));  // Valor distinto: NVS escribe siempre
+
+        xSemaphoreTake(s_flush_mutex, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+        nvs_handle_t nvs_handle;
+        esp_err_t err = nvs_open(PERSIST_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+        if (err == ESP_OK) {
+            err = nvs_set_blob(nvs_handle, PERSIST_STRESS_KEY, blob, sizeof(blob));
+            if (err == ESP_OK) {
+                err = nvs_commit(nvs_handle);
+            }
+            nvs_close(nvs_handle);
+        }
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        xSemaphoreGive(s_flush_mutex);
+
+        if (err == ESP_OK) {
+            commits++;
+            if (elapsed_us > commit_max_us) {
+                commit_max_us = elapsed_us;
+            }
+        } else {
+            errors++;
+        }
+
+        if (esp_timer_get_time() >= next_log_us) {
+            ESP_LOGW(TAG, "Estrés NVS: %lu commits, %lu errores, commit máx %lld us",
+                     commits, errors, commit_max_us);
+            next_log_us += PERSIST_STRESS_LOG_US;
+        }
+        vTaskDelay(1);  // Dejar correr a IDLE (task watchdog)
+    }
+}
+#endif
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t persist_init(void) {
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(PERSIST_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_OK) {
+        int32_t x100 = 0;
+        if (nvs_get_i32(nvs_handle, PERSIST_KEY_INCLINE_POS, &x100) == ESP_OK) {
+            s_nvs_incline_x100 = x100;
+        }
+        uint8_t fault_flag = 0;
+        if (nvs_get_u8(nvs_handle, PERSIST_KEY_INCLINE_FLT, &fault_flag) == ESP_OK && fault_flag == 1) {
+            s_nvs_incline_fault = true;
+        }
+        size_t model_len = sizeof(s_nvs_model);
+        if (nvs_get_blob(nvs_handle, PERSIST_KEY_INCLINE_MDL, s_nvs_model, &model_len) == ESP_OK) {
+            s_nvs_model_len = model_len;
+        }
+        uint32_t fp = 0;
+        if (nvs_get_u32(nvs_handle, PERSIST_KEY_VFD_FP, &fp) == ESP_OK) {
+            s_nvs_vfd_fp = fp;
+        }
+        size_t relay_len = sizeof(s_nvs_relay);
+        if (nvs_get_blob(nvs_handle, PERSIST_KEY_RELAY_CYC, s_nvs_relay, &relay_len) == ESP_OK) {
+            s_nvs_relay_count = relay_len / sizeof(s_nvs_relay[0]);
+        }
+        nvs_close(nvs_handle);
+    }
+    s_boot_incline_fault = s_nvs_incline_fault;
+    s_boot_vfd_fp = s_nvs_vfd_fp;
+    atomic_store(&s_pending_vfd_fp, s_nvs_vfd_fp);
+
+    // La copia RTC es más reciente que NVS si el reinicio no fue en frío
+    esp_reset_reason_t reason = esp_reset_reason();
+    int32_t boot_x100;
+    if (reason != ESP_RST_POWERON && rtc_valid()) {
+        boot_x100 = s_rtc.incline_x100;
+        ESP_LOGI(TAG, "Posición de inclinación recuperada de RTC: %.2f%% (reinicio %d)",
+                 (float)boot_x100 / 100.0f, reason);
+        if (boot_x100 != s_nvs_incline_x100) {
+            atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_POS);
+        }
+    } else if (s_nvs_incline_x100 != PERSIST_X100_NONE) {
+        boot_x100 = s_nvs_incline_x100;
+        ESP_LOGI(TAG, "Posición de inclinación cargada desde NVS: %.2f%%", (float)boot_x100 / 100.0f);
+    } else {
+        boot_x100 = 0;
+    }
+    s_boot_incline_pct = (float)boot_x100 / 100.0f;
+    atomic_store(&s_pending_incline_x100, boot_x100);
+    rtc_store(boot_x100);
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_flush_mutex = xSemaphoreCreateMutex();
+    if (s_flush_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(persist_task, "persist", PERSIST_STACK, NULL, PERSIST_TASK_PRIO, &s_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de persistencia");
+        return ESP_FAIL;
+    }
+    esp_register_shutdown_handler(persist_shutdown_handler);
+#if CONFIG_BASE_NVS_STRESS_TEST
+    xTaskCreate(persist_stress_task, "nvs_stress", PERSIST_STACK, NULL, PERSIST_TASK_PRIO, NULL);
+#endif
+    return ESP_OK;
+}
+
+float persist_boot_incline_position(void) {
+    return s_boot_incline_pct;
+}
+
+bool persist_boot_incline_fault(void) {
+    return s_boot_incline_fault;
+}
+
+void persist_set_incline_position(float position_pct) {
+    int32_t x100 = (int32_t)(position_pct * 100.0f);  // Guardar como entero
+    if (atomic_exchange(&s_pending_incline_x100, x100) == x100) {
+        return;
+    }
+    rtc_store(x100);
+    atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_POS);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.updates++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (s_task_handle != NULL) {
+        xTaskNotify(s_task_handle, PERSIST_NOTIFY_CHANGE, eSetBits);
+    }
+}
+
+bool persist_boot_incline_model(void *out, size_t len) {
+    if (s_nvs_model_len != len) {
+        return false;  // Sin modelo guardado o de otra versión
+    }
+    memcpy(out, s_nvs_model, len);
+    return true;
+}
+
+void persist_set_incline_model(const void *model, size_t len) {
+    if (len > PERSIST_MODEL_MAX) {
+        ESP_LOGE(TAG, "Modelo de %u bytes > %d", (unsigned)len, PERSIST_MODEL_MAX);
+        return;
+    }
+    taskENTER_CRITICAL(&s_model_lock);
+    memcpy(s_pending_model, model, len);
+    s_pending_model_len = len;
+    taskEXIT_CRITICAL(&s_model_lock);
+    atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_MODEL);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.updates++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (s_task_handle != NULL) {
+        xTaskNotify(s_task_handle, PERSIST_NOTIFY_CHANGE, eSetBits);
+    }
+}
+
+uint32_t persist_boot_vfd_fingerprint(void) {
+    return s_boot_vfd_fp;
+}
+
+void persist_set_vfd_fingerprint(uint32_t fingerprint) {
+    if (atomic_exchange(&s_pending_vfd_fp, fingerprint) == fingerprint) {
+        return;
+    }
+    atomic_fetch_or(&s_dirty, PERSIST_DIRTY_VFD_FP);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.updates++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (s_task_handle != NULL) {
+        xTaskNotify(s_task_handle, PERSIST_NOTIFY_CHANGE, eSetBits);
+    }
+}
+
+bool persist_boot_relay_cycles(uint32_t *out, size_t count) {
+    if (s_nvs_relay_count != count) {
+        return false;  // Sin contadores guardados o de otra placa
+    }
+    memcpy(out, s_nvs_relay, count * sizeof(out[0]));
+    return true;
+}
+
+void persist_set_relay_cycles(const uint32_t *cycles, size_t count) {
+    if (count > PERSIST_RELAY_MAX) {
+        ESP_LOGE(TAG, "%u contadores de relé > %d", (unsigned)count, PERSIST_RELAY_MAX);
+        return;
+    }
+    taskENTER_CRITICAL(&s_relay_lock);
+    memcpy(s_pending_relay, cycles, count * sizeof(cycles[0]));
+    s_pending_relay_count = count;
+    taskEXIT_CRITICAL(&s_relay_lock);
+    atomic_fetch_or(&s_dirty, PERSIST_DIRTY_RELAY_CYCLES);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.updates++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (s_task_handle != NULL) {
+        xTaskNotify(s_task_handle, PERSIST_NOTIFY_CHANGE, eSetBits);
+    }
+}
+
+void persist_set_incline_fault(void) {
+    atomic_fetch_or(&s_dirty, PERSIST_DIRTY_INCLINE_FAULT);
+    if (s_task_handle != NULL) {
+        xTaskNotify(s_task_handle, PERSIST_NOTIFY_FLUSH, eSetBits);
+    }
+}
+
+void persist_flush_hint(void) {
+    if (s_task_handle == NULL || atomic_load(&s_dirty) == 0) {
+        return;
+    }
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.flush_hints++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    xTaskNotify(s_task_handle, PERSIST_NOTIFY_FLUSH, eSetBits);
+}
+
+void persist_get_stats(persist_stats_t *out) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+void persist_log_stats(void) {
+    persist_stats_t st;
+    persist_get_stats(&st);
+    ESP_LOGI(TAG, "Cambios=%lu volcados=%lu (forzados=%lu) escrituras NVS=%lu sin cambio=%lu errores=%lu commit med/máx=%lld/%lld us",
+             st.updates, st.flushes, st.flush_hints, st.nvs_writes, st.nvs_unchanged, st.nvs_errors,
+             st.nvs_writes ? st.commit_total_us / st.nvs_writes : 0, st.commit_max_us);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file persist.h
+ * @brief Servicio de persistencia asíncrona de Base (NVS + memoria RTC)
+ *
+ * Los lazos de control no escriben en flash: publican el último valor y una
+ * tarea de baja prioridad lo vuelca a NVS agrupando escrituras. El flush se
+ * hace cuando el valor lleva PERSIST_IDLE_MS sin cambiar (actuador parado),
+ * cuando se pide explícitamente (indicio de pérdida de alimentación, reinicio)
+ * o tras PERSIST_MAX_DEFER_MS con cambios pendientes.
+ *
+ * La posición de inclinación se copia además en memoria RTC (RTC_NOINIT), que
+ * sobrevive a reinicios por software, watchdog o brownout: al arrancar se usa
+ * la copia RTC si es válida y la de NVS si no (arranque en frío).
+ */
+
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Tiempo sin cambios tras el cual se vuelcan los valores pendientes */
+#define PERSIST_IDLE_MS         3000
+
+/** Retardo máximo de un valor pendiente aunque siga cambiando */
+#define PERSIST_MAX_DEFER_MS    60000
+
+/** Prioridad de la tarea de persistencia (por debajo de control y enlace) */
+#define PERSIST_TASK_PRIO       2
+
+/** Tamaño máximo del modelo del actuador de inclinación */
+#define PERSIST_MODEL_MAX       32
+
+/** Relés con contador de ciclos */
+#define PERSIST_RELAY_MAX       8
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/**
+ * @brief Contadores desde el arranque
+ */
+typedef struct {
+    uint32_t updates;           ///< Cambios de valor publicados (cada uno actualiza la copia RTC)
+    uint32_t flushes;           ///< Volcados ejecutados (idle, forzados o por plazo)
+    uint32_t flush_hints;       ///< Volcados forzados por persist_flush_hint()
+    uint32_t nvs_writes;        ///< nvs_commit() realizados
+    uint32_t nvs_unchanged;     ///< Volcados omitidos: el valor ya estaba en NVS
+    uint32_t nvs_errors;
+    int64_t commit_max_us;      ///< Duración máxima de nvs_set + nvs_commit
+    int64_t commit_total_us;
+} persist_stats_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Carga los valores guardados y arranca la tarea de persistencia
+ *
+ * Requiere nvs_flash_init() previo.
+ */
+esp_err_t persist_init(void);
+
+/**
+ * @brief Posición de inclinación al arrancar (RTC si es válida, si no NVS)
+ */
+float persist_boot_incline_position(void);
+
+/**
+ * @brief true si hay un fallo del fin de carrera registrado en NVS
+ */
+bool persist_boot_incline_fault(void);
+
+/**
+ * @brief Publica la posición de inclinación actual
+ *
+ * Barato (sin flash): se puede llamar en cada ciclo de control. Actualiza la
+ * copia RTC y marca NVS como pendiente si el valor cambió. Un solo escritor.
+ */
+void persist_set_incline_position(float position_pct);
+
+/**
+ * @brief Modelo del actuador guardado en NVS
+ *
+ * @return false si no hay modelo guardado o su tamaño no es len (otra versión)
+ */
+bool persist_boot_incline_model(void *out, size_t len);
+
+/**
+ * @brief Publica el modelo del actuador (se vuelca con el resto de pendientes)
+ *
+ * Copia el blob (hasta PERSIST_MODEL_MAX bytes); se puede llamar desde
+ * cualquier tarea.
+ */
+void persist_set_incline_model(const void *model, size_t len);
+
+/**
+ * @brief Huella de los parámetros del VFD verificados (ver vfd_params.h)
+ *
+ * @return 0 si no hay huella guardada
+ */
+uint32_t persist_boot_vfd_fingerprint(void);
+
+/**
+ * @brief Publica la huella de los parámetros del VFD tras verificarlos
+ *
+ * Solo se escribe en NVS si cambia respecto a la guardada.
+ */
+void persist_set_vfd_fingerprint(uint32_t fingerprint);
+
+/**
+ * @brief Ciclos por relé guardados en NVS (ver actuators.h)
+ *
+ * @return false si no hay contadores guardados o son de otro número de relés
+ */
+bool persist_boot_relay_cycles(uint32_t *out, size_t count);
+
+/**
+ * @brief Publica los ciclos por relé (se vuelcan con el resto de pendientes)
+ *
+ * Se puede llamar en cada cierre de un relé y desde cualquier tarea: los
+ * volcados se agrupan como los de la posición de inclinación.
+ */
+void persist_set_relay_cycles(const uint32_t *cycles, size_t count);
+
+/**
+ * @brief Registra el fallo del fin de carrera (se vuelca de inmediato)
+ */
+void persist_set_incline_fault(void);
+
+/**
+ * @brief Indicio de pérdida de alimentación: vuelca lo pendiente cuanto antes
+ *
+ * No bloquea; el volcado lo hace la tarea de persistencia.
+ */
+void persist_flush_hint(void);
+
+/**
+ * @brief Copia los contadores
+ */
+void persist_get_stats(persist_stats_t *out);
+
+/**
+ * @brief Vuelca por log los contadores
+ */
+void persist_log_stats(void);
+
+#endif // PERSIST_H
@@ -0,0 +1,73 @@
+/**
+ * @file speed_loop.c
+ * @brief Implementación del lazo externo de velocidad (ver speed_loop.h)
+ */
+
+#include "speed_loop.h"
+#include "esp_log.h"
+#include <math.h>
+
+static const char *TAG = "SPEED_LOOP";
+
+// ============================================================================
+// VARIABLES PRIVADAS (solo slot de velocidad)
+// ============================================================================
+
+static float s_trim_kmh = 0.0f;
+static float s_integ_kmh = 0.0f;
+static float s_last_error_kmh = 0.0f;
+static uint32_t s_steps = 0;
+static uint32_t s_held = 0;         // Pasos con el integrador congelado (saturación o rampa)
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+float speed_loop_step(float target_kmh, float measured_kmh, float vfd_kmh, float dt_s) {
+    if (target_kmh < SPEED_LOOP_MIN_TARGET_KMH) {
+        speed_loop_reset();
+        return 0.0f;
+    }
+    s_steps++;
+
+    float error = target_kmh - measured_kmh;
+    float limit = target_kmh * SPEED_LOOP_TRIM_MAX_PCT / 100.0f;
+    float max_step = SPEED_LOOP_TRIM_RATE_KMH_S * dt_s;
+
+    // Rampa del VFD en curso: la cinta sigue a la rampa, no a la carga
+    bool ramping = fabsf(vfd_kmh - (target_kmh + s_trim_kmh)) > SPEED_LOOP_SETTLED_KMH;
+
+    float integ = s_integ_kmh;
+    if (!ramping) {
+        integ += SPEED_LOOP_KI * error * dt_s;
+    }
+    float out = SPEED_LOOP_KP * error + integ;
+
+    // Límite de amplitud y de variación
+    float clipped = fminf(fmaxf(out, -limit), limit);
+    clipped = fminf(fmaxf(clipped, s_trim_kmh - max_step), s_trim_kmh + max_step);
+
+    // Anti-windup: no acumular si la salida recortada impide seguir en el
+    // sentido del error
+    bool saturated = (clipped != out) && ((out > clipped) == (error > 0.0f));
+    if (ramping || saturated) {
+        s_held++;
+    } else {
+        s_integ_kmh = fminf(fmaxf(integ, -limit), limit);
+    }
+
+    s_trim_kmh = clipped;
+    s_last_error_kmh = error;
+    return s_trim_kmh;
+}
+
+void speed_loop_reset(void) {
+    s_trim_kmh = 0.0f;
+    s_integ_kmh = 0.0f;
+    s_last_error_kmh = 0.0f;
+}
+
+void speed_loop_log(void) {
+    ESP_LOGI(TAG, "Corrección %+.2f km/h (integrador %+.2f), último error %+.2f km/h, %lu/%lu pasos congelados",
+             s_trim_kmh, s_integ_kmh, s_last_error_kmh, s_held, s_steps);
+}
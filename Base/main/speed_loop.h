@@ -0,0 +1,60 @@
+/**
+ * @file speed_loop.h
+ * @brief Lazo externo de velocidad de la cinta (corrección de la consigna del VFD)
+ *
+ * El VFD recibe km/h × KPH_TO_HZ_RATIO en lazo abierto: con el corredor
+ * encima el motor desliza y la cinta va más lenta que la consigna. Este lazo
+ * PI compara la velocidad medida por el sensor Hall con el objetivo y suma
+ * una corrección (en km/h) a la consigna que se envía al VFD:
+ *
+ * - Limitada a ±SPEED_LOOP_TRIM_MAX_PCT del objetivo y con variación máxima
+ *   SPEED_LOOP_TRIM_RATE_KMH_S (no compite con la rampa del VFD).
+ * - Anti-windup: el integrador no avanza mientras la salida está saturada
+ *   (por límite o por rampa) en el sentido del error, ni mientras el VFD
+ *   todavía no alcanzó la consigna (rampa de aceleración en curso).
+ *
+ * Solo lo llama el slot de velocidad del ejecutivo.
+ */
+
+#ifndef SPEED_LOOP_H
+#define SPEED_LOOP_H
+
+#include <stdint.h>
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+#define SPEED_LOOP_KP               0.4f    // km/h de corrección por km/h de error
+#define SPEED_LOOP_KI               0.3f    // 1/s
+#define SPEED_LOOP_TRIM_MAX_PCT     10.0f   // Corrección máxima respecto al objetivo
+#define SPEED_LOOP_TRIM_RATE_KMH_S  0.5f    // Variación máxima de la corrección
+#define SPEED_LOOP_SETTLED_KMH      0.3f    // VFD a menos de esto de su consigna: rampa terminada
+#define SPEED_LOOP_MIN_TARGET_KMH   0.5f    // Por debajo la cinta está parada (igual que vfd_driver)
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Un paso del lazo
+ *
+ * @param target_kmh   Velocidad objetivo
+ * @param measured_kmh Velocidad medida de la cinta
+ * @param vfd_kmh      Velocidad equivalente a la frecuencia real del VFD
+ * @param dt_s         Tiempo desde el paso anterior
+ * @return Corrección a sumar al objetivo antes de convertir a Hz
+ */
+float speed_loop_step(float target_kmh, float measured_kmh, float vfd_kmh, float dt_s);
+
+/**
+ * @brief Anula la corrección y el integrador (parada, safe state, sin medida)
+ */
+void speed_loop_reset(void);
+
+/**
+ * @brief Vuelca por log el estado del lazo
+ */
+void speed_loop_log(void);
+
+#endif // SPEED_LOOP_H
@@ -1,66 +1,241 @@
 #include "speed_sensor.h"
-#include "driver/pulse_cnt.h" // <-- API NUEVA Y CORRECTA
+#include "state_latch.h"
+#include "driver/mcpwm_cap.h"
 #include "driver/gpio.h"       // Para configurar pull-down
+#include "soc/soc_caps.h"
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "esp_timer.h" // <-- CORRECCIÓN AÑADIDA
+#include "esp_timer.h"
+#include <stdatomic.h>
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+#include "driver/gpio_filter.h"
+#endif
 
 static const char *TAG_SPEED = "SPEED_SENSOR";
 
 // Asignación de Pines v5
-#define PCNT_GPIO       15 // Pin v5 para "Sensor Hall Velocidad" (Corona 12 dientes)
+#define SPEED_SENSOR_GPIO   15 // Pin v5 para "Sensor Hall Velocidad" (Corona 12 dientes)
 
-static pcnt_unit_handle_t pcnt_unit = NULL;
+// ============================================================================
+// ESTADO DE LA ISR (DRAM; la ISR no usa coma flotante)
+// ============================================================================
 
-void speed_sensor_init(void) {
-    ESP_LOGI(TAG_SPEED, "Inicializando sensor de velocidad (PCNT) en GPIO %d", PCNT_GPIO);
+/** Última medida: dientes y ticks de captura de la ventana */
+typedef struct {
+    uint32_t teeth;
+    uint32_t ticks;
+} speed_window_t;
+
+static DRAM_ATTR STATE_LATCH_T(speed_window_t) s_window;
+static DRAM_ATTR atomic_uint s_last_edge_us = 0;    // Último diente aceptado (32 bits bajos de esp_timer)
+
+static DRAM_ATTR struct {
+    uint32_t min_period_ticks;
+    uint32_t min_window_ticks;
+    uint32_t stop_ticks;
+    uint32_t last_cap;
+    bool have_last;
+    uint32_t median[SPEED_SENSOR_MEDIAN_LEN];
+    uint32_t median_count;
+    uint32_t median_next;
+    uint32_t outlier_run;
+    uint32_t win_ticks;
+    uint32_t win_teeth;
+} s_isr;
+
+static DRAM_ATTR atomic_uint s_edges = 0;
+static DRAM_ATTR atomic_uint s_glitches = 0;
+static DRAM_ATTR atomic_uint s_outliers = 0;
+static DRAM_ATTR atomic_uint s_estimates = 0;
+
+static uint32_t s_ticks_per_us = 0;     // 0 = sensor no inicializado
+
+// ============================================================================
+// ISR DE CAPTURA
+// ============================================================================
+
+static uint32_t IRAM_ATTR median_of(const uint32_t *v, uint32_t n) {
+    uint32_t s[SPEED_SENSOR_MEDIAN_LEN];
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t x = v[i];
+        uint32_t j = i;
+        while (j > 0 && s[j - 1] > x) {
+            s[j] = s[j - 1];
+            j--;
+        }
+        s[j] = x;
+    }
+    return s[n / 2];
+}
+
+static void IRAM_ATTR window_reset(void) {
+    s_isr.median_count = 0;
+    s_isr.median_next = 0;
+    s_isr.outlier_run = 0;
+    s_isr.win_ticks = 0;
+    s_isr.win_teeth = 0;
+}
+
+static bool IRAM_ATTR speed_capture_isr(mcpwm_cap_channel_handle_t cap_chan,
+                                        const mcpwm_capture_event_data_t *edata, void *user_data) {
+    uint32_t cap = edata->cap_value;
+    atomic_fetch_add_explicit(&s_edges, 1, memory_order_relaxed);
+
+    if (!s_isr.have_last) {
+        s_isr.have_last = true;
+        s_isr.last_cap = cap;
+        return false;
+    }
+
+    uint32_t period = cap - s_isr.last_cap;  // El contador da la vuelta: diferencia módulo 2^32
+    if (period < s_isr.min_period_ticks) {
+        // Glitch: se ignora el flanco y el periodo sigue contando desde el anterior
+        atomic_fetch_add_explicit(&s_glitches, 1, memory_order_relaxed);
+        return false;
+    }
+    s_isr.last_cap = cap;
+
+    if (period > s_isr.stop_ticks) {
+        // Primer diente tras una parada: el periodo no es una velocidad
+        speed_window_t stopped = { 0 };
+        state_latch_publish(&s_window, stopped);
+        window_reset();
+        return false;
+    }
+
+    // Mediana de los últimos periodos aceptados; un periodo aislado muy distinto
+    // se descarta, pero si se repite es un cambio real y entra en la mediana
+    bool outlier = false;
+    if (s_isr.median_count >= 3) {
+        uint32_t m = median_of(s_isr.median, s_isr.median_count);
+        uint32_t dev = period > m ? period - m : m - period;
+        outlier = (uint64_t)dev * 100 > (uint64_t)m * SPEED_SENSOR_OUTLIER_PCT;
+    }
+    if (outlier && ++s_isr.outlier_run < 3) {
+        atomic_fetch_add_explicit(&s_outliers, 1, memory_order_relaxed);
+        return false;
+    }
+    s_isr.outlier_run = 0;
+    atomic_store_explicit(&s_last_edge_us, (uint32_t)esp_timer_get_time(), memory_order_relaxed);
+    s_isr.median[s_isr.median_next] = period;
+    s_isr.median_next = (s_isr.median_next + 1) % SPEED_SENSOR_MEDIAN_LEN;
+    if (s_isr.median_count < SPEED_SENSOR_MEDIAN_LEN) {
+        s_isr.median_count++;
+    }
+
+    // Una medida por diente a baja velocidad, cada N dientes a alta velocidad
+    s_isr.win_ticks += period;
+    s_isr.win_teeth++;
+    if (s_isr.win_ticks >= s_isr.min_window_ticks) {
+        speed_window_t w = {
+            .teeth = s_isr.win_teeth,
+            .ticks = s_isr.win_ticks,
+        };
+        state_latch_publish(&s_window, w);
+        atomic_fetch_add_explicit(&s_estimates, 1, memory_order_relaxed);
+        s_isr.win_ticks = 0;
+        s_isr.win_teeth = 0;
+    }
+    return false;
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t speed_sensor_init(void) {
+    ESP_LOGI(TAG_SPEED, "Inicializando sensor de velocidad (captura MCPWM) en GPIO %d", SPEED_SENSOR_GPIO);
 
     // Configurar GPIO con pull-down para evitar lecturas flotantes cuando el sensor no está conectado
     gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << PCNT_GPIO),
+        .pin_bit_mask = (1ULL << SPEED_SENSOR_GPIO),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_ENABLE,
         .intr_type = GPIO_INTR_DISABLE,
     };
     ESP_ERROR_CHECK(gpio_config(&io_conf));
-    ESP_LOGI(TAG_SPEED, "GPIO %d configurado con pull-down para evitar ruido", PCNT_GPIO);
 
-    pcnt_unit_config_t unit_config = {
-        .low_limit = -1000,
-        .high_limit = 1000,
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    gpio_glitch_filter_handle_t filter;
+    gpio_pin_glitch_filter_config_t filter_conf = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = SPEED_SENSOR_GPIO,
     };
-    ESP_ERROR_CHECK(pcnt_new_unit(&unit_config, &pcnt_unit));
+    ESP_ERROR_CHECK(gpio_new_pin_glitch_filter(&filter_conf, &filter));
+    ESP_ERROR_CHECK(gpio_glitch_filter_enable(filter));
+#endif
 
-    pcnt_glitch_filter_config_t filter_config = {
-        .max_glitch_ns = 1000, // Ignora picos de ruido de menos de 1us
+    mcpwm_cap_timer_handle_t cap_timer = NULL;
+    mcpwm_capture_timer_config_t timer_conf = {
+        .clk_src = MCPWM_CAPTURE_CLK_SRC_DEFAULT,
+        .group_id = 0,
     };
-    ESP_ERROR_CHECK(pcnt_unit_set_glitch_filter(pcnt_unit, &filter_config));
+    ESP_ERROR_CHECK(mcpwm_new_capture_timer(&timer_conf, &cap_timer));
 
-    pcnt_chan_config_t chan_config = {
-        .edge_gpio_num = PCNT_GPIO,
-        .level_gpio_num = -1,
+    mcpwm_cap_channel_handle_t cap_chan = NULL;
+    mcpwm_capture_channel_config_t chan_conf = {
+        .gpio_num = SPEED_SENSOR_GPIO,
+        .prescale = 1,
+        .flags.pos_edge = true,
+        .flags.neg_edge = false,
     };
-    pcnt_channel_handle_t pcnt_chan = NULL;
-    ESP_ERROR_CHECK(pcnt_new_channel(pcnt_unit, &chan_config, &pcnt_chan));
-
-    // Configurar cómo contamos (Corregido para la nueva API)
-    ESP_ERROR_CHECK(pcnt_channel_set_edge_action(pcnt_chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD));
-    ESP_ERROR_CHECK(pcnt_channel_set_level_action(pcnt_chan, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_KEEP));
-
-    ESP_ERROR_CHECK(pcnt_unit_enable(pcnt_unit));
-    ESP_ERROR_CHECK(pcnt_unit_clear_count(pcnt_unit));
-    ESP_ERROR_CHECK(pcnt_unit_start(pcnt_unit));
-    
-    ESP_LOGI(TAG_SPEED, "Sensor de velocidad (PCNT) inicializado y contando.");
+    ESP_ERROR_CHECK(mcpwm_new_capture_channel(cap_timer, &chan_conf, &cap_chan));
+
+    uint32_t resolution_hz = 0;
+    ESP_ERROR_CHECK(mcpwm_capture_timer_get_resolution(cap_timer, &resolution_hz));
+    uint32_t ticks_per_us = resolution_hz / 1000000;
+    s_isr.min_period_ticks = SPEED_SENSOR_MIN_PERIOD_US * ticks_per_us;
+    s_isr.min_window_ticks = SPEED_SENSOR_MIN_WINDOW_US * ticks_per_us;
+    s_isr.stop_ticks = SPEED_SENSOR_STOP_US * ticks_per_us;
+    s_isr.have_last = false;
+    window_reset();
+
+    mcpwm_capture_event_callbacks_t cbs = {
+        .on_cap = speed_capture_isr,
+    };
+    ESP_ERROR_CHECK(mcpwm_capture_channel_register_event_callbacks(cap_chan, &cbs, NULL));
+    ESP_ERROR_CHECK(mcpwm_capture_channel_enable(cap_chan));
+    ESP_ERROR_CHECK(mcpwm_capture_timer_enable(cap_timer));
+    ESP_ERROR_CHECK(mcpwm_capture_timer_start(cap_timer));
+    s_ticks_per_us = ticks_per_us;
+
+    ESP_LOGI(TAG_SPEED, "Sensor de velocidad (captura MCPWM, %lu ticks/us) inicializado", ticks_per_us);
+    return ESP_OK;
 }
 
-int speed_sensor_get_pulse_count(void) {
-    int pulse_count = 0;
-    if (pcnt_unit) {
-        ESP_ERROR_CHECK(pcnt_unit_get_count(pcnt_unit, &pulse_count));
-        ESP_ERROR_CHECK(pcnt_unit_clear_count(pcnt_unit)); // Resetear
+bool speed_sensor_get_speed_kmh(float *kmh) {
+    if (s_ticks_per_us == 0) {
+        return false;
     }
-    return pulse_count;
-}
\ No newline at end of file
+    speed_window_t w;
+    state_latch_read(&s_window, &w);
+
+    uint32_t since_edge_us = (uint32_t)esp_timer_get_time() - atomic_load(&s_last_edge_us);
+    if (w.teeth == 0 || since_edge_us > SPEED_SENSOR_STOP_US) {
+        *kmh = 0.0f;
+        return true;
+    }
+
+    float period_us = (float)w.ticks / (float)s_ticks_per_us / (float)w.teeth;
+    // Sin diente todavía: el periodo actual es al menos el tiempo transcurrido
+    if ((float)since_edge_us > period_us) {
+        period_us = (float)since_edge_us;
+    }
+    *kmh = SPEED_SENSOR_KMH_PER_HZ * 1e6f / period_us;
+    return true;
+}
+
+void speed_sensor_get_stats(speed_sensor_stats_t *out) {
+    out->edges = atomic_load(&s_edges);
+    out->glitches = atomic_load(&s_glitches);
+    out->outliers = atomic_load(&s_outliers);
+    out->estimates = atomic_load(&s_estimates);
+}
+
+void speed_sensor_log_stats(void) {
+    speed_sensor_stats_t st;
+    speed_sensor_get_stats(&st);
+    ESP_LOGI(TAG_SPEED, "Flancos=%lu glitches=%lu atípicos=%lu medidas=%lu",
+             st.edges, st.glitches, st.outliers, st.estimates);
+}
@@ -1,17 +1,87 @@
 #ifndef SPEED_SENSOR_H
 #define SPEED_SENSOR_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 /**
- * @brief Inicializa el periférico Pulse Counter (PCNT) en el GPIO 34.
+ * @file speed_sensor.h
+ * @brief Velocidad real de la cinta medida por captura de periodo (MCPWM)
+ *
+ * El sensor Hall de la corona (12 dientes) entra en un canal de captura MCPWM
+ * que marca cada flanco de subida con el contador del timer de captura. La
+ * ISR calcula el periodo entre dientes y lo filtra:
+ * - Periodos menores que SPEED_SENSOR_MIN_PERIOD_US son glitches: el flanco
+ *   se ignora (el ESP32 no tiene filtro hardware en la entrada de captura; en
+ *   chips con filtro de glitches por pin se activa además el del GPIO).
+ * - Mediana de los últimos SPEED_SENSOR_MEDIAN_LEN periodos: un periodo que
+ *   se aparta más de SPEED_SENSOR_OUTLIER_PCT de la mediana se descarta, salvo
+ *   que se repita (cambio real de velocidad).
+ *
+ * Se publica una medida por diente a baja velocidad y una cada N dientes a
+ * alta velocidad (los necesarios para cubrir SPEED_SENSOR_MIN_WINDOW_US).
  */
-void speed_sensor_init(void);
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** km/h por cada diente/s (docs/CALIBRACION.md: 10.00 km/h = 575.1 pulsos/s) */
+#define SPEED_SENSOR_KMH_PER_HZ         0.0174f
+
+/** Periodo mínimo plausible (≈58 km/h); menos es ruido */
+#define SPEED_SENSOR_MIN_PERIOD_US      300
+
+/** Ventana mínima de una medida: a alta velocidad se agrupan dientes */
+#define SPEED_SENSOR_MIN_WINDOW_US      20000
+
+/** Sin flancos durante este tiempo la cinta se considera parada (≈0.07 km/h) */
+#define SPEED_SENSOR_STOP_US            250000
+
+/** Longitud del filtro de mediana y desviación máxima respecto a ella */
+#define SPEED_SENSOR_MEDIAN_LEN         5
+#define SPEED_SENSOR_OUTLIER_PCT        40
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+typedef struct {
+    uint32_t edges;             ///< Flancos capturados
+    uint32_t glitches;          ///< Flancos descartados por periodo demasiado corto
+    uint32_t outliers;          ///< Periodos descartados por el filtro de mediana
+    uint32_t estimates;         ///< Medidas publicadas
+} speed_sensor_stats_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Configura la captura MCPWM en el GPIO del sensor y arranca la medida
+ */
+esp_err_t speed_sensor_init(void);
+
+/**
+ * @brief Última velocidad medida
+ *
+ * Entre dientes la velocidad se acota con el tiempo transcurrido desde el
+ * último flanco, de modo que una frenada se ve antes del siguiente diente.
+ *
+ * @param[out] kmh Velocidad (0 si la cinta está parada)
+ * @return false si el sensor no está inicializado
+ */
+bool speed_sensor_get_speed_kmh(float *kmh);
+
+/**
+ * @brief Copia los contadores
+ */
+void speed_sensor_get_stats(speed_sensor_stats_t *out);
 
 /**
- * @brief Obtiene el número acumulado de pulsos desde el último reseteo.
- * @return int El número de pulsos.
+ * @brief Vuelca por log los contadores
  */
-int speed_sensor_get_pulse_count(void);
+void speed_sensor_log_stats(void);
 
-#endif // SPEED_SENSOR_H
\ No newline at end of file
+#endif // SPEED_SENSOR_H
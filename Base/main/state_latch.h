@@ -0,0 +1,52 @@
+/**
+ * @file state_latch.h
+ * @brief Publicación de estado sin bloqueos para un único escritor
+ *
+ * Variante "latch" del seqlock: el estado se guarda en dos copias y el
+ * contador de secuencia indica cuál pueden leer los lectores mientras el
+ * escritor modifica la otra. A diferencia de un seqlock clásico, el lector
+ * nunca espera a que el escritor termine (no hay estado "escritura en curso"),
+ * por lo que una tarea de mayor prioridad en el mismo núcleo que lee mientras
+ * el escritor está expropiado no puede quedarse bloqueada. Solo reintenta si el
+ * escritor publicó mientras copiaba.
+ *
+ * Uso:
+ *   static STATE_LATCH_T(mi_estado_t) s_pub;
+ *   state_latch_publish(&s_pub, nuevo);   // solo desde la tarea propietaria
+ *   mi_estado_t copia;
+ *   state_latch_read(&s_pub, &copia);     // desde cualquier tarea (no ISR)
+ */
+
+#ifndef STATE_LATCH_H
+#define STATE_LATCH_H
+
+#include <stdatomic.h>
+
+/** Declara un latch para el tipo dado */
+#define STATE_LATCH_T(type)     struct { atomic_uint seq; type copy[2]; }
+
+/** Publica un valor (un solo escritor) */
+#define state_latch_publish(latch, value)                                      \
+    do {                                                                       \
+        __typeof__((latch)->copy[0]) _latch_v = (value);                       \
+        atomic_fetch_add_explicit(&(latch)->seq, 1, memory_order_relaxed);     \
+        atomic_thread_fence(memory_order_seq_cst);  /* Lectores -> copy[1] */  \
+        (latch)->copy[0] = _latch_v;                                           \
+        atomic_thread_fence(memory_order_seq_cst);                             \
+        atomic_fetch_add_explicit(&(latch)->seq, 1, memory_order_relaxed);     \
+        atomic_thread_fence(memory_order_seq_cst);  /* Lectores -> copy[0] */  \
+        (latch)->copy[1] = _latch_v;                                           \
+    } while (0)
+
+/** Lee una copia coherente del último valor publicado */
+#define state_latch_read(latch, out)                                           \
+    do {                                                                       \
+        unsigned _latch_s;                                                     \
+        do {                                                                   \
+            _latch_s = atomic_load_explicit(&(latch)->seq, memory_order_acquire); \
+            *(out) = (latch)->copy[_latch_s & 1];                              \
+            atomic_thread_fence(memory_order_acquire);                         \
+        } while (atomic_load_explicit(&(latch)->seq, memory_order_relaxed) != _latch_s); \
+    } while (0)
+
+#endif // STATE_LATCH_H
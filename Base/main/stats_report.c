@@ -0,0 +1,233 @@
+/**
+ * @file stats_report.c
+ * @brief Implementación del informe STATS (ver stats_report.h)
+ */
+
+#include "stats_report.h"
+#include "cyclic_exec.h"
+#include "persist.h"
+#include "vfd_driver.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include <string.h>
+
+static const char *TAG = "STATS";
+
+#define STATS_REPORT_TASK_STACK     4096
+
+// ============================================================================
+// VARIABLES PRIVADAS (solo la tarea de informe)
+// ============================================================================
+
+static stats_report_send_fn_t s_send = NULL;
+static stats_report_link_fn_t s_fill_link = NULL;
+static TaskHandle_t s_task_handle = NULL;
+static int64_t s_prev_report_us = 0;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static TaskStatus_t s_status[CM_STATS_MAX_TASKS];
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Contadores del informe anterior: el reparto de CPU es del intervalo entre peticiones
+typedef struct {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_runtime_t;
+
+static task_runtime_t s_prev[CM_STATS_MAX_TASKS];
+static size_t s_prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE s_prev_total = 0;
+
+static configRUN_TIME_COUNTER_TYPE prev_runtime(TaskHandle_t handle) {
+    for (size_t i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].handle == handle) {
+            return s_prev[i].runtime;
+        }
+    }
+    return 0;  // Tarea creada después del informe anterior
+}
+#endif
+#endif
+
+// ============================================================================
+// INFORME
+// ============================================================================
+
+static void send_encoded(size_t len, const char *line) {
+    if (len == 0) {
+        ESP_LOGW(TAG, "Línea STATS no cabe en %d bytes", CM_SCHEMA_ASCII_MAX);
+        return;
+    }
+    s_send(line);
+    vTaskDelay(pdMS_TO_TICKS(STATS_REPORT_LINE_GAP_MS));
+}
+
+/**
+ * @brief Envía una línea STASK por tarea
+ *
+ * @return Número de líneas enviadas
+ */
+static uint8_t report_tasks(bool *runtime_stats) {
+    *runtime_stats = false;
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_status, CM_STATS_MAX_TASKS, &total);
+    if (n == 0) {
+        ESP_LOGW(TAG, "Más de %d tareas: sin reparto por tarea", CM_STATS_MAX_TASKS);
+        return 0;
+    }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    // Cada núcleo suma su tiempo: la capacidad del intervalo es total × núcleos
+    uint64_t capacity = (uint64_t)(configRUN_TIME_COUNTER_TYPE)(total - s_prev_total) * portNUM_PROCESSORS;
+    *runtime_stats = true;
+#endif
+
+    char line[CM_SCHEMA_ASCII_MAX];
+    for (UBaseType_t i = 0; i < n; i++) {
+        cm_stats_task_msg_t msg = {
+            .index = (uint8_t)i,
+            .stack_free = s_status[i].usStackHighWaterMark,
+            .prio = (uint8_t)s_status[i].uxCurrentPriority,
+        };
+        cm_name16_set(&msg.name, s_status[i].pcTaskName);
+        BaseType_t core = xTaskGetCoreID(s_status[i].xHandle);
+        msg.core = (core == tskNO_AFFINITY) ? 255 : (uint8_t)core;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        configRUN_TIME_COUNTER_TYPE delta = s_status[i].ulRunTimeCounter - prev_runtime(s_status[i].xHandle);
+        msg.cpu_permille = capacity > 0 ? (uint32_t)((uint64_t)delta * 1000 / capacity) : 0;
+#endif
+        send_encoded(cm_stats_task_encode_ascii(&msg, line, sizeof(line)), line);
+    }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    for (UBaseType_t i = 0; i < n; i++) {
+        s_prev[i].handle = s_status[i].xHandle;
+        s_prev[i].runtime = s_status[i].ulRunTimeCounter;
+    }
+    s_prev_count = n;
+    s_prev_total = total;
+#endif
+    return (uint8_t)n;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Envía una línea SSLOT por slot del ejecutivo
+ */
+static uint8_t report_slots(void) {
+    char line[CM_SCHEMA_ASCII_MAX];
+    size_t n = cyclic_exec_slot_count();
+    if (n > CM_STATS_MAX_SLOTS) {
+        n = CM_STATS_MAX_SLOTS;
+    }
+    for (size_t i = 0; i < n; i++) {
+        cyclic_slot_stats_t st;
+        cyclic_exec_get_stats(i, &st);
+        cm_stats_slot_msg_t msg = {
+            .index = (uint8_t)i,
+            .runs = st.runs,
+            .overruns = st.overruns,
+            .jitter_avg_us = st.runs ? (uint32_t)(st.jitter_total_us / st.runs) : 0,
+            .jitter_max_us = (uint32_t)st.jitter_max_us,
+            .exec_avg_us = st.runs ? (uint32_t)(st.exec_total_us / st.runs) : 0,
+            .exec_max_us = (uint32_t)st.exec_max_us,
+        };
+        cm_name16_set(&msg.name, cyclic_exec_slot_name(i));
+        send_encoded(cm_stats_slot_encode_ascii(&msg, line, sizeof(line)), line);
+    }
+    return (uint8_t)n;
+}
+
+static void send_report(void) {
+    char line[CM_SCHEMA_ASCII_MAX];
+    int64_t now_us = esp_timer_get_time();
+
+    bool runtime_stats;
+    uint8_t task_count = report_tasks(&runtime_stats);
+    uint8_t slot_count = report_slots();
+
+    vfd_modbus_stats_t mb;
+    vfd_driver_get_modbus_stats(&mb);
+    cm_stats_mb_msg_t mb_msg = {
+        .transactions = mb.transactions,
+        .errors = mb.errors,
+        .timeouts = mb.timeouts,
+        .invalid = mb.invalid,
+        .retries = mb.retries,
+        .timeout_ms = mb.timeout_ms,
+        .rtt_p50_ms = mb.rtt_p50_ms,
+        .rtt_p99_ms = mb.rtt_p99_ms,
+    };
+    send_encoded(cm_stats_mb_encode_ascii(&mb_msg, line, sizeof(line)), line);
+
+    cm_stats_link_msg_t link = {0};
+    s_fill_link(&link);
+    send_encoded(cm_stats_link_encode_ascii(&link, line, sizeof(line)), line);
+
+    persist_stats_t ps;
+    persist_get_stats(&ps);
+    cm_stats_nvs_msg_t nvs = {
+        .writes = ps.nvs_writes,
+        .errors = ps.nvs_errors,
+        .flush_hints = ps.flush_hints,
+        .commit_max_us = (uint32_t)ps.commit_max_us,
+    };
+    send_encoded(cm_stats_nvs_encode_ascii(&nvs, line, sizeof(line)), line);
+
+    // SSYS al final: cierra la respuesta
+    cm_stats_sys_msg_t sys = {
+        .uptime_s = (uint32_t)(now_us / 1000000),
+        .window_ms = (uint32_t)((now_us - s_prev_report_us) / 1000),
+        .heap_free = esp_get_free_heap_size(),
+        .heap_min = esp_get_minimum_free_heap_size(),
+        .runtime_stats = runtime_stats ? 1 : 0,
+        .task_count = task_count,
+        .slot_count = slot_count,
+        .frame_overruns = cyclic_exec_frame_overruns(),
+    };
+    send_encoded(cm_stats_sys_encode_ascii(&sys, line, sizeof(line)), line);
+    s_prev_report_us = now_us;
+
+    ESP_LOGD(TAG, "Informe enviado: %u tareas, %u slots en %lld us",
+             task_count, slot_count, esp_timer_get_time() - now_us);
+}
+
+static void stats_report_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        send_report();
+    }
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t stats_report_init(stats_report_send_fn_t send, stats_report_link_fn_t fill_link) {
+    if (send == NULL || fill_link == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_send = send;
+    s_fill_link = fill_link;
+    if (xTaskCreate(stats_report_task, "stats_report", STATS_REPORT_TASK_STACK, NULL,
+                    STATS_REPORT_TASK_PRIO, &s_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+#if !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    ESP_LOGW(TAG, "Sin CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS: STATS sin reparto de CPU");
+#endif
+    return ESP_OK;
+}
+
+void stats_report_request(void) {
+    if (s_task_handle != NULL) {
+        xTaskNotifyGive(s_task_handle);
+    }
+}
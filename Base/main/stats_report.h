@@ -0,0 +1,55 @@
+/**
+ * @file stats_report.h
+ * @brief Respuesta a la petición STATS de la Consola (salud de Base en campo)
+ *
+ * uart_rx_task solo despierta a la tarea de informe y sigue atendiendo SYNC:
+ * el recorrido de las tareas de FreeRTOS, los cálculos y el envío de las
+ * líneas (formato en cm_schema.h) van en una tarea de baja prioridad, fuera
+ * del camino SYNC/DATA. Entre línea y línea se deja pasar el enlace para que
+ * un DATA nunca espere más que una línea STATS ya en el FIFO.
+ *
+ * El reparto de CPU por tarea se mide entre dos peticiones consecutivas
+ * (requiere CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, reloj esp_timer).
+ */
+
+#ifndef STATS_REPORT_H
+#define STATS_REPORT_H
+
+#include "esp_err.h"
+#include "cm_schema.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Prioridad de la tarea de informe (por encima de persist, por debajo del control) */
+#define STATS_REPORT_TASK_PRIO      3
+
+/** Pausa entre líneas de la respuesta */
+#define STATS_REPORT_LINE_GAP_MS    5
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/** Envía una línea terminada en '\n' por el enlace */
+typedef esp_err_t (*stats_report_send_fn_t)(const char *line);
+
+/** Rellena los contadores del enlace (propiedad de main.c) */
+typedef void (*stats_report_link_fn_t)(cm_stats_link_msg_t *out);
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Crea la tarea de informe (tras arrancar el ejecutivo)
+ */
+esp_err_t stats_report_init(stats_report_send_fn_t send, stats_report_link_fn_t fill_link);
+
+/**
+ * @brief Pide un informe (no bloquea; las peticiones seguidas se agrupan)
+ */
+void stats_report_request(void);
+
+#endif // STATS_REPORT_H
@@ -8,11 +8,18 @@
 
 // --- Includes ---
 #include "vfd_driver.h"
+#include "vfd_params.h"
+#include "persist.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "driver/uart.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
+#include <stdio.h>
 
 // Includes de ESP-MODBUS
 #include "esp_modbus_master.h"
@@ -46,9 +53,9 @@
 #define VFD_CMD_RUN_FWD    0x0001
 #define VFD_CMD_STOP       0x0005 // (F-STOP)
 
-// Registros de parámetros (para configuración inicial)
-#define VFD_REG_F0_01      0x0001 // (Fuente de Comando)
-#define VFD_REG_F0_02      0x0002 // (Fuente de Frecuencia)
+// Parámetros de configuración: tabla en vfd_params.c
+#define VFD_PARAMS_RETRY_MS        5000 // Reintento de la verificación si falla
+#define VFD_PARAMS_RECHECK_LOST_MS 3000 // Enlace caído más que esto: ¿VFD sustituido?
 
 // --- Constantes del Driver ---
 // CALIBRADO con hardware real: 10.00 km/h = 78.10 Hz
@@ -60,6 +67,35 @@
 #define VFD_TASK_PRIO      8
 #define VFD_POLL_MS        200 // (Frecuencia de actualización de velocidad)
 
+// Parada de emergencia: tarea propia por encima de uart_rx_task (10) y de la
+// tarea de control, para ganar el bus Modbus en cuanto quede libre
+#define VFD_ESTOP_TASK_STACK  3072
+#define VFD_ESTOP_TASK_PRIO   12
+#define VFD_ESTOP_RETRY_MS    20   // Reintento del STOP si el VFD no responde
+#define VFD_ESTOP_RETRY_MAX_MS 1000 // Sin respuesta seguida, el intervalo se dobla hasta aquí
+// Prueba de latencia al arrancar: la petición cae en distintos puntos de una
+// lectura Modbus (envío de la trama y espera de la respuesta, ~20 ms a 9600 baud)
+#define VFD_ESTOP_TEST_RUNS     8
+#define VFD_ESTOP_TEST_STEP_US  3000
+#define VFD_ESTOP_TEST_WAIT_MS  2000
+
+// Timeout de respuesta adaptativo (ver vfd_transaction)
+#define VFD_MB_TIMEOUT_INIT_MS      300   // Hasta tener VFD_RTT_MIN_SAMPLES respuestas
+#define VFD_MB_TIMEOUT_MIN_MS       50    // Mínimo que admite esp-modbus
+#define VFD_MB_TIMEOUT_MAX_MS       1000
+#define VFD_MB_TIMEOUT_P99_FACTOR   3     // Timeout = factor × p99 del tiempo de respuesta
+#define VFD_MB_ATTEMPTS             3     // Intentos por transacción (cada reintento dobla el timeout)
+#define VFD_RTT_MIN_SAMPLES         32
+#define VFD_RTT_WINDOW_SAMPLES      512   // Llena, la ventana se reduce a la mitad (olvida lo antiguo)
+
+// Ciclo de control: escrituras y lecturas encoladas de una vez (ver vfd_cycle_run)
+#define VFD_CYCLE_MAX_OPS           4     // Consigna + marcha/paro + frecuencia real + código de fallo
+// Prueba de prioridad (arranque o VFDTEST): escrituras HIGH con la cola LOW llena de lecturas
+#define VFD_PRIO_TEST_LOAD          (CONFIG_FMB_MASTER_ASYNC_QUEUE_SIZE - 1)
+#define VFD_PRIO_TEST_RUNS          8
+#define VFD_PRIO_TEST_STEP_MS       7     // No múltiplo de una lectura: cae en distintos puntos
+#define VFD_PRIO_TEST_WAIT_MS       2000
+
 // ===========================================================================
 // VARIABLES GLOBALES (ESTÁTICAS)
 // ===========================================================================
@@ -69,16 +105,69 @@ static const char *TAG_VFD = "VFD_DRIVER_MODBUS";
 // Handle del maestro Modbus
 static void *master_handle = NULL;
 
-// Variables de estado protegidas por mutex
-static SemaphoreHandle_t vfd_mutex = NULL;
-static vfd_status_t g_vfd_status = VFD_STATUS_DISCONNECTED;
-static float g_target_kph = 0.0;
-static float g_current_freq_hz = 0.0;
-static float g_vfd_real_freq_hz = 0.0;  // Frecuencia real leída del VFD (0x2103)
-static bool g_emergency_stop = false;
-
-// Tarea de control
+// Estado compartido sin mutex: los getters y setters se llaman desde los slots
+// del ejecutivo, que no pueden esperar a que vfd_control_task suelte un lock
+static atomic_uint g_vfd_status = VFD_STATUS_DISCONNECTED;  // vfd_status_t
+static _Atomic float g_target_kph = 0.0f;
+static _Atomic float g_trim_kph = 0.0f;  // Corrección del lazo de velocidad (speed_loop)
+static _Atomic float g_current_freq_hz = 0.0f;
+static _Atomic float g_vfd_real_freq_hz = 0.0f;  // Frecuencia real leída del VFD (0x2103)
+static atomic_uint s_ramp_req = VFD_RAMP_NORMAL;  // vfd_ramp_t pedido por main.c
+
+// Parada de emergencia: sin mutex (vfd_driver_emergency_stop se llama desde ISR)
+static DRAM_ATTR atomic_bool s_estop_latched = false;  // Hasta el siguiente vfd_driver_set_speed()
+static DRAM_ATTR atomic_bool s_stop_pending = false;   // STOP pedido y aún no confirmado por el VFD
+static DRAM_ATTR atomic_uint s_stop_req_us = 0;        // Petición (32 bits bajos de esp_timer)
+static atomic_uint s_estop_stops = 0;
+static atomic_uint s_estop_aborts = 0;                 // Transacciones en curso abortadas
+static atomic_uint s_estop_last_us = 0;
+static atomic_uint s_estop_max_us = 0;
+static atomic_uint s_estop_test_worst_us = 0;          // Peor caso de la última prueba (arranque o VFDTEST)
+static atomic_uint s_prio_test_worst_us = 0;           // Escritura HIGH con la cola saturada, última prueba
+static esp_timer_handle_t s_estop_test_timer = NULL;
+#if CONFIG_BASE_VFD_SELF_TEST
+static atomic_bool s_self_test_req = false;            // vfd_driver_request_self_test()
+#endif
+
+// Contadores de transacciones Modbus (vfd_control_task y vfd_estop_task)
+static atomic_uint s_mb_transactions = 0;
+static atomic_uint s_mb_errors = 0;
+static atomic_uint s_mb_timeouts = 0;
+static atomic_uint s_mb_invalid = 0;
+static atomic_uint s_mb_retries = 0;
+
+// Tiempo de respuesta del VFD (s_rtt_lock) y timeout derivado
+static portMUX_TYPE s_rtt_lock = portMUX_INITIALIZER_UNLOCKED;
+static vfd_rtt_histogram_t s_rtt_boot;              // Desde el arranque (solo se expone)
+static uint32_t s_rtt_window[VFD_RTT_BUCKETS];      // Ventana con olvido: decide el timeout
+static uint32_t s_rtt_window_n = 0;
+static atomic_uint s_mb_timeout_ms = VFD_MB_TIMEOUT_INIT_MS;     // Timeout del primer intento
+static atomic_uint s_mb_timeout_applied = VFD_MB_TIMEOUT_INIT_MS; // Último dado a esp-modbus
+static atomic_bool s_mb_timeout_learned = false;
+
+// Transacciones del ciclo de control en vuelo (solo vfd_control_task y el callback de esp-modbus)
+typedef struct {
+    mb_param_request_t req;
+    uint16_t data;          // Valor a escribir o respuesta (Big Endian)
+    mb_request_prio_t prio; // Clase en la cola de esp-modbus
+    bool queued;            // Entregada a esp-modbus (si no, err ya es el resultado)
+    esp_err_t err;
+    int64_t done_us;        // Fin de la transacción (callback)
+} vfd_cycle_op_t;
+
+static vfd_cycle_op_t s_cycle_ops[VFD_CYCLE_MAX_OPS];
+static int s_cycle_count = 0;
+static atomic_int s_cycle_pending = 0;
+static SemaphoreHandle_t s_cycle_done = NULL;
+
+// Carga de lecturas LOW de la prueba de prioridad (vfd_prio_self_test)
+static uint16_t s_prio_load_data[VFD_PRIO_TEST_LOAD];
+static atomic_bool s_prio_load_run = false;
+static atomic_int s_prio_load_inflight = 0;
+
+// Tareas
 static TaskHandle_t vfd_task_handle = NULL;
+static TaskHandle_t vfd_estop_task_handle = NULL;
 
 // ===========================================================================
 // PROTOTIPOS DE FUNCIONES PRIVADAS
@@ -86,93 +175,404 @@ static TaskHandle_t vfd_task_handle = NULL;
 
 static esp_err_t vfd_modbus_init(void);
 static void vfd_control_task(void *pvParameters);
+static void vfd_estop_task(void *pvParameters);
+static void vfd_estop_request(void);
+static void vfd_self_test_run(void);
+static esp_err_t vfd_transaction(mb_param_request_t *req, void *data);
+static esp_err_t vfd_transaction_from(mb_param_request_t *req, void *data, int attempt, esp_err_t err);
+static uint32_t rtt_percentile_ms(const uint32_t *buckets, uint32_t total, uint32_t permille);
 static esp_err_t vfd_write_register(uint16_t reg_addr, uint16_t value);
-static esp_err_t vfd_read_register(uint16_t reg_addr, uint16_t *value);
-static esp_err_t vfd_check_and_configure_params(void);
+static esp_err_t vfd_read_registers(uint16_t reg_addr, uint16_t count, uint16_t *values);
+static esp_err_t vfd_check_and_configure_params(bool allow_skip);
+static esp_err_t vfd_apply_ramp(vfd_ramp_t ramp, vfd_ramp_t applied);
+static void vfd_cycle_begin(void);
+static int vfd_cycle_add(uint8_t command, uint16_t reg_addr, uint16_t value);
+static void vfd_cycle_run(void);
+static esp_err_t vfd_cycle_result(int op, uint16_t *value);
 
 // ===========================================================================
 // IMPLEMENTACIÓN DE LA API PÚBLICA (vfd_driver.h)
 // ===========================================================================
 
 void vfd_driver_init(void) {
-    vfd_mutex = xSemaphoreCreateMutex();
-    if (vfd_mutex == NULL) {
-        ESP_LOGE(TAG_VFD, "Error creando vfd_mutex");
+    s_cycle_done = xSemaphoreCreateBinary();
+    if (s_cycle_done == NULL) {
+        ESP_LOGE(TAG_VFD, "Error creando s_cycle_done");
         return;
     }
 
     if (vfd_modbus_init() != ESP_OK) {
         ESP_LOGE(TAG_VFD, "Fallo al inicializar Modbus");
-        g_vfd_status = VFD_STATUS_FAULT;
+        atomic_store(&g_vfd_status, VFD_STATUS_FAULT);
         return;
     }
 
     // Tarea que gestiona el envío periódico de comandos
     xTaskCreate(vfd_control_task, "vfd_control_task", VFD_TASK_STACK, NULL, VFD_TASK_PRIO, &vfd_task_handle);
+    // Tarea que envía el STOP de emergencia (atiende peticiones anteriores a su creación)
+    xTaskCreate(vfd_estop_task, "vfd_estop_task", VFD_ESTOP_TASK_STACK, NULL, VFD_ESTOP_TASK_PRIO, &vfd_estop_task_handle);
     ESP_LOGI(TAG_VFD, "VFD Driver (Modbus Real) inicializado. Tarea creada.");
 }
 
 void vfd_driver_set_speed(float kph) {
-    if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        g_target_kph = kph;
-        g_emergency_stop = false; // Asumimos que fijar velocidad cancela el E-Stop
-        xSemaphoreGive(vfd_mutex);
-    } else {
-        ESP_LOGW(TAG_VFD, "No se pudo tomar mutex para set_speed");
-    }
+    atomic_store(&g_target_kph, kph);
+    atomic_store(&s_estop_latched, false); // Asumimos que fijar velocidad cancela el E-Stop
+}
+
+void vfd_driver_set_speed_trim(float trim_kph) {
+    atomic_store(&g_trim_kph, trim_kph);
 }
 
-void vfd_driver_emergency_stop(void) {
-    if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        g_emergency_stop = true;
-        g_target_kph = 0.0; // Forzar velocidad a 0
-        xSemaphoreGive(vfd_mutex);
+void vfd_driver_set_ramp(vfd_ramp_t ramp) {
+    atomic_store(&s_ramp_req, (unsigned)ramp);
+}
+
+void IRAM_ATTR vfd_driver_emergency_stop(void) {
+    // La marcha queda bloqueada hasta el siguiente vfd_driver_set_speed()
+    atomic_store(&s_estop_latched, true);
+    vfd_estop_request();
+}
+
+void vfd_driver_get_estop_stats(vfd_estop_stats_t *out) {
+    out->stops = atomic_load(&s_estop_stops);
+    out->aborts = atomic_load(&s_estop_aborts);
+    out->last_latency_us = atomic_load(&s_estop_last_us);
+    out->max_latency_us = atomic_load(&s_estop_max_us);
+    out->test_worst_us = atomic_load(&s_estop_test_worst_us);
+}
+
+void vfd_driver_get_modbus_stats(vfd_modbus_stats_t *out) {
+    out->transactions = atomic_load(&s_mb_transactions);
+    out->errors = atomic_load(&s_mb_errors);
+    out->timeouts = atomic_load(&s_mb_timeouts);
+    out->invalid = atomic_load(&s_mb_invalid);
+    out->retries = atomic_load(&s_mb_retries);
+    out->timeout_ms = atomic_load(&s_mb_timeout_ms);
+
+    taskENTER_CRITICAL(&s_rtt_lock);
+    uint32_t n = s_rtt_window_n;
+    out->rtt_p50_ms = n > 0 ? rtt_percentile_ms(s_rtt_window, n, 500) : 0;
+    out->rtt_p99_ms = n > 0 ? rtt_percentile_ms(s_rtt_window, n, 990) : 0;
+    taskEXIT_CRITICAL(&s_rtt_lock);
+    out->high_test_worst_us = atomic_load(&s_prio_test_worst_us);
+}
+
+void vfd_driver_get_rtt_histogram(vfd_rtt_histogram_t *out) {
+    taskENTER_CRITICAL(&s_rtt_lock);
+    *out = s_rtt_boot;
+    taskEXIT_CRITICAL(&s_rtt_lock);
+}
+
+void vfd_driver_log_rtt(void) {
+    vfd_modbus_stats_t mb;
+    vfd_driver_get_modbus_stats(&mb);
+    vfd_rtt_histogram_t hist;
+    vfd_driver_get_rtt_histogram(&hist);
+
+    ESP_LOGI(TAG_VFD, "Modbus: p50 %lu ms, p99 %lu ms, máx %lu us, timeout %lu ms%s, %lu reintentos, "
+             "parada HIGH %lu us (prueba)",
+             mb.rtt_p50_ms, mb.rtt_p99_ms, hist.max_us, mb.timeout_ms,
+             atomic_load(&s_mb_timeout_learned) ? "" : " (inicial)", mb.retries, mb.high_test_worst_us);
+
+    // Memoria fija de esp-modbus (CONFIG_FMB_STATIC_POOL): agotamientos desde el arranque
+    mb_pool_stats_t pool;
+    if (mbc_master_get_pool_stats(master_handle, &pool) == ESP_OK) {
+        ESP_LOGI(TAG_VFD, "Pools Modbus: búferes %u/%u, %lu esperas, %lu fallos; colas llenas H/N/L %lu/%lu/%lu",
+                 pool.buffers_max_used, pool.buffers, pool.buffer_waits, pool.buffer_failures,
+                 pool.async_full[MB_REQUEST_PRIO_HIGH], pool.async_full[MB_REQUEST_PRIO_NORMAL],
+                 pool.async_full[MB_REQUEST_PRIO_LOW]);
+    }
+
+    // Solo los tramos con respuestas: "desde-hasta ms:cuenta"
+    char line[192];
+    int len = 0;
+    for (int i = 0; i < VFD_RTT_BUCKETS && len < (int)sizeof(line); i++) {
+        if (hist.buckets[i] == 0) {
+            continue;
+        }
+        if (i == VFD_RTT_BUCKETS - 1) {
+            len += snprintf(line + len, sizeof(line) - len, " %d+:%lu", i * VFD_RTT_BUCKET_MS, hist.buckets[i]);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, " %d-%d:%lu",
+                            i * VFD_RTT_BUCKET_MS, (i + 1) * VFD_RTT_BUCKET_MS, hist.buckets[i]);
+        }
+    }
+    if (len > 0) {
+        ESP_LOGI(TAG_VFD, "Histograma RTT (%lu respuestas):%s", hist.samples, line);
     }
+}
 
-    // Forzamos la tarea para que actúe ya
-    if (vfd_task_handle) {
-        xTaskNotifyGive(vfd_task_handle);
+esp_err_t vfd_driver_request_self_test(void) {
+#if CONFIG_BASE_VFD_SELF_TEST
+    if (vfd_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
+    atomic_store(&s_self_test_req, true);
+    xTaskNotifyGive(vfd_task_handle);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
 }
 
 vfd_status_t vfd_driver_get_status(void) {
-    vfd_status_t status;
-    if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        status = g_vfd_status;
-        xSemaphoreGive(vfd_mutex);
-    } else {
-        status = VFD_STATUS_FAULT; // Si no podemos leer, algo va mal
-    }
-    return status;
+    return (vfd_status_t)atomic_load(&g_vfd_status);
 }
 
 float vfd_driver_get_target_freq_hz(void) {
-    float freq;
-    if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        freq = g_current_freq_hz;
-        xSemaphoreGive(vfd_mutex);
-    } else {
-        freq = 0.0f;
-    }
-    return freq;
+    return atomic_load(&g_current_freq_hz);
 }
 
 float vfd_driver_get_real_freq_hz(void) {
-    float freq;
-    if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        freq = g_vfd_real_freq_hz;
-        xSemaphoreGive(vfd_mutex);
-    } else {
-        freq = 0.0f;
-    }
-    return freq;
+    return atomic_load(&g_vfd_real_freq_hz);
 }
 
 // ===========================================================================
 // IMPLEMENTACIÓN DE FUNCIONES PRIVADAS (MODBUS Y TAREA)
 // ===========================================================================
 
+/**
+ * @brief true si la escritura es parte de la parada (STOP o frecuencia 0)
+ */
+static bool vfd_is_stop_write(uint16_t reg_addr, uint16_t value) {
+    return (reg_addr == VFD_REG_CONTROL && value == VFD_CMD_STOP) ||
+           (reg_addr == VFD_REG_FREQ && value == 0);
+}
+
+/**
+ * @brief true si la escritura es un tiempo de rampa (perfil E-Stop con el enclavamiento)
+ */
+static bool vfd_is_ramp_write(uint16_t reg_addr) {
+    return reg_addr == VFD_PARAMS_REG_ACCEL || reg_addr == VFD_PARAMS_REG_DECEL;
+}
+
+/**
+ * @brief Límite superior del tramo del histograma que alcanza el percentil
+ *
+ * @param permille Percentil en tantos por mil (990 = p99)
+ */
+static uint32_t rtt_percentile_ms(const uint32_t *buckets, uint32_t total, uint32_t permille) {
+    uint32_t target = (total * permille + 999) / 1000;
+    uint32_t acc = 0;
+    for (int i = 0; i < VFD_RTT_BUCKETS; i++) {
+        acc += buckets[i];
+        if (acc >= target) {
+            return (uint32_t)(i + 1) * VFD_RTT_BUCKET_MS;
+        }
+    }
+    return VFD_RTT_BUCKETS * VFD_RTT_BUCKET_MS;
+}
+
+/**
+ * @brief Registra una respuesta válida y recalcula el timeout
+ */
+static void rtt_record(uint32_t rtt_us) {
+    uint32_t bucket = rtt_us / (VFD_RTT_BUCKET_MS * 1000);
+    if (bucket >= VFD_RTT_BUCKETS) {
+        bucket = VFD_RTT_BUCKETS - 1;
+    }
+
+    taskENTER_CRITICAL(&s_rtt_lock);
+    s_rtt_boot.buckets[bucket]++;
+    s_rtt_boot.samples++;
+    if (rtt_us > s_rtt_boot.max_us) {
+        s_rtt_boot.max_us = rtt_us;
+    }
+    s_rtt_window[bucket]++;
+    if (++s_rtt_window_n >= VFD_RTT_WINDOW_SAMPLES) {
+        s_rtt_window_n = 0;
+        for (int i = 0; i < VFD_RTT_BUCKETS; i++) {
+            s_rtt_window[i] /= 2;
+            s_rtt_window_n += s_rtt_window[i];
+        }
+    }
+    bool enough = s_rtt_window_n >= VFD_RTT_MIN_SAMPLES;
+    uint32_t p99_ms = enough ? rtt_percentile_ms(s_rtt_window, s_rtt_window_n, 990) : 0;
+    taskEXIT_CRITICAL(&s_rtt_lock);
+
+    if (!enough) {
+        return;
+    }
+    uint32_t timeout_ms = VFD_MB_TIMEOUT_P99_FACTOR * p99_ms;
+    if (timeout_ms < VFD_MB_TIMEOUT_MIN_MS) {
+        timeout_ms = VFD_MB_TIMEOUT_MIN_MS;
+    } else if (timeout_ms > VFD_MB_TIMEOUT_MAX_MS) {
+        timeout_ms = VFD_MB_TIMEOUT_MAX_MS;
+    }
+    atomic_store(&s_mb_timeout_ms, timeout_ms);
+    if (!atomic_exchange(&s_mb_timeout_learned, true)) {
+        ESP_LOGI(TAG_VFD, "Timeout de respuesta aprendido: %lu ms (p99 %lu ms en %d respuestas)",
+                 timeout_ms, p99_ms, VFD_RTT_MIN_SAMPLES);
+    }
+}
+
+/**
+ * @brief Da a esp-modbus el timeout de la siguiente trama (solo si cambia)
+ */
+static void vfd_apply_timeout(uint32_t timeout_ms) {
+    if (atomic_exchange(&s_mb_timeout_applied, timeout_ms) != timeout_ms) {
+        mbc_master_set_response_time(master_handle, timeout_ms);
+    }
+}
+
+/**
+ * @brief Una transacción Modbus con el VFD, con reintentos y contada en las estadísticas
+ *
+ * El timeout de respuesta es VFD_MB_TIMEOUT_P99_FACTOR veces el p99 del tiempo
+ * de respuesta medido: una respuesta perdida cuesta unas decenas de ms y no
+ * retiene un segundo la tarea de control. Cada reintento dobla el timeout
+ * (margen para un VFD más lento de lo aprendido, p. ej. escribiendo en su
+ * EEPROM); tras VFD_MB_ATTEMPTS intentos el llamante da el VFD por
+ * desconectado. Las transacciones abortadas por un STOP de emergencia no se
+ * reintentan: el bus pasa a vfd_estop_task.
+ */
+static esp_err_t vfd_transaction(mb_param_request_t *req, void *data) {
+    return vfd_transaction_from(req, data, 0, ESP_FAIL);
+}
+
+/**
+ * @brief true si el error admite reintento (el VFD no respondió o respondió mal)
+ */
+static bool vfd_is_retryable(esp_err_t err) {
+    return err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_RESPONSE;
+}
+
+/**
+ * @brief Traduce el timeout de una transacción abortada por vfd_estop_task
+ *
+ * mbc_master_abort_request() hace volver la transacción en curso con
+ * ESP_ERR_TIMEOUT. Con un STOP pendiente, un timeout fuera de vfd_estop_task
+ * es ese aborto (ya contado en s_estop_aborts), no un VFD que no responde:
+ * se devuelve ESP_ERR_INVALID_STATE, que no se cuenta como error, no se
+ * reintenta y no cambia el estado del VFD.
+ */
+static esp_err_t vfd_estop_abort_err(esp_err_t err) {
+    if (err == ESP_ERR_TIMEOUT && atomic_load(&s_stop_pending) &&
+        xTaskGetCurrentTaskHandle() != vfd_estop_task_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return err;
+}
+
+/**
+ * @brief Cuenta un intento en las estadísticas (y su tiempo de respuesta si hubo respuesta)
+ */
+static void vfd_count_attempt(esp_err_t err, uint32_t rtt_us) {
+    atomic_fetch_add(&s_mb_transactions, 1);
+    if (err == ESP_OK) {
+        rtt_record(rtt_us);
+        return;
+    }
+    atomic_fetch_add(&s_mb_errors, 1);
+    if (err == ESP_ERR_TIMEOUT) {
+        atomic_fetch_add(&s_mb_timeouts, 1);
+    } else if (err == ESP_ERR_INVALID_RESPONSE) {
+        atomic_fetch_add(&s_mb_invalid, 1);  // CRC, trama o excepción del VFD
+    }
+}
+
+/**
+ * @brief Un intento con el timeout dado, contado en las estadísticas
+ *
+ * @return ESP_ERR_INVALID_STATE si lo abortó un STOP de emergencia (sin contar)
+ */
+static esp_err_t vfd_send_attempt(mb_param_request_t *req, void *data, uint32_t timeout_ms) {
+    vfd_apply_timeout(timeout_ms);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = vfd_estop_abort_err(mbc_master_send_request(master_handle, req, data));
+    if (err != ESP_ERR_INVALID_STATE) {
+        vfd_count_attempt(err, (uint32_t)(esp_timer_get_time() - start_us));
+    }
+    return err;
+}
+
+/**
+ * @brief vfd_transaction() a partir del intento attempt (err: resultado del anterior)
+ *
+ * El ciclo de control hace el primer intento en bloque (vfd_cycle_run) y
+ * sigue aquí con los que fallan.
+ */
+static esp_err_t vfd_transaction_from(mb_param_request_t *req, void *data, int attempt, esp_err_t err) {
+    uint32_t timeout_ms = atomic_load(&s_mb_timeout_ms);
+    for (int i = 1; i <= attempt; i++) {
+        timeout_ms = timeout_ms * 2 < VFD_MB_TIMEOUT_MAX_MS ? timeout_ms * 2 : VFD_MB_TIMEOUT_MAX_MS;
+    }
+
+    for (; attempt < VFD_MB_ATTEMPTS; attempt++) {
+        if (attempt > 0) {
+            if (atomic_load(&s_stop_pending) && xTaskGetCurrentTaskHandle() != vfd_estop_task_handle) {
+                break;
+            }
+            atomic_fetch_add(&s_mb_retries, 1);
+            ESP_LOGW(TAG_VFD, "Reintento %d de 0x%04X (%s), timeout %lu ms",
+                     attempt, req->reg_start, esp_err_to_name(err), timeout_ms);
+        }
+        err = vfd_send_attempt(req, data, timeout_ms);
+        if (err == ESP_ERR_INVALID_STATE) {
+            break;  // Abortada por un STOP de emergencia: el bus pasa a vfd_estop_task
+        }
+        if (!vfd_is_retryable(err)) {
+            break;  // Hecho, o argumento o estado del stack: reintentar no cambia nada
+        }
+        timeout_ms = timeout_ms * 2 < VFD_MB_TIMEOUT_MAX_MS ? timeout_ms * 2 : VFD_MB_TIMEOUT_MAX_MS;
+    }
+    return err;
+}
+
+/**
+ * @brief true si la escritura puede salir con el estado del E-Stop
+ *
+ * Con un E-Stop en curso solo salen escrituras de parada: una marcha
+ * iniciada antes de la petición no puede volver a arrancar el motor.
+ * Enclavado y con el STOP ya confirmado también se admite la rampa del E-Stop
+ */
+static bool vfd_write_allowed(uint16_t reg_addr, uint16_t value) {
+    bool pending = atomic_load(&s_stop_pending);
+    return !((pending || atomic_load(&s_estop_latched)) && !vfd_is_stop_write(reg_addr, value) &&
+             (pending || !vfd_is_ramp_write(reg_addr)));
+}
+
+/**
+ * @brief Estado del VFD tras una escritura (ESP_ERR_INVALID_STATE: no salió, sin cambios)
+ */
+static void vfd_write_result(uint16_t reg_addr, esp_err_t err) {
+    if (err == ESP_ERR_INVALID_STATE) {
+        return;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG_VFD, "Error al escribir en registro 0x%04X: %s", reg_addr, esp_err_to_name(err));
+    }
+    atomic_store(&g_vfd_status, err == ESP_OK ? VFD_STATUS_OK : VFD_STATUS_DISCONNECTED); // Error: asumimos desconexión
+}
+
+/**
+ * @brief Estado del VFD tras una lectura y conversión de la respuesta
+ */
+static void vfd_read_result(uint16_t reg_addr, uint16_t count, esp_err_t err,
+                            const uint16_t *data_be, uint16_t *out_values) {
+    if (err == ESP_ERR_INVALID_STATE) {
+        return;  // Cedida a un STOP de emergencia
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG_VFD, "Error al LEER registro 0x%04X (%u): %s", reg_addr, count, esp_err_to_name(err));
+
+        // Si la comunicación falla, actualizamos el estado global
+        atomic_store(&g_vfd_status, VFD_STATUS_DISCONNECTED);
+    } else {
+        // Convertir de Big Endian (Modbus) a Little Endian (ESP32)
+        for (uint16_t i = 0; i < count; i++) {
+            out_values[i] = __builtin_bswap16(data_be[i]);
+        }
+        ESP_LOGD(TAG_VFD, "Lectura exitosa de registro 0x%04X: valor=0x%04X (%u)", reg_addr, out_values[0], count);
+    }
+}
+
 static esp_err_t vfd_write_register(uint16_t reg_addr, uint16_t value) {
+    if (!vfd_write_allowed(reg_addr, value)) {
+        ESP_LOGD(TAG_VFD, "Escritura 0x%04X=0x%04X descartada (E-Stop)", reg_addr, value);
+        return ESP_ERR_INVALID_STATE;
+    }
+
     mb_param_request_t req = {
         .slave_addr = VFD_SLAVE_ID,
         .command = MB_FUNC_WRITE_SINGLE_REGISTER,
@@ -180,188 +580,706 @@ static esp_err_t vfd_write_register(uint16_t reg_addr, uint16_t value) {
         .reg_size = 1
     };
 
-    esp_err_t err = mbc_master_send_request(master_handle, &req, &value);
-
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG_VFD, "Error al escribir en registro 0x%04X: %s", reg_addr, esp_err_to_name(err));
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            g_vfd_status = VFD_STATUS_DISCONNECTED; // Asumimos desconexión
-            xSemaphoreGive(vfd_mutex);
-        }
-    } else {
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            g_vfd_status = VFD_STATUS_OK;
-            xSemaphoreGive(vfd_mutex);
-        }
-    }
+    esp_err_t err = vfd_transaction(&req, &value);
+    vfd_write_result(reg_addr, err);
     return err;
 }
 
 /**
- * @brief Lee un único registro (16 bits) del VFD.
+ * @brief Lee count registros consecutivos (16 bits) del VFD en una transacción.
  */
-static esp_err_t vfd_read_register(uint16_t reg_addr, uint16_t *out_value) {
-    if (out_value == NULL) {
+static esp_err_t vfd_read_registers(uint16_t reg_addr, uint16_t count, uint16_t *out_values) {
+    if (out_values == NULL || count == 0 || count > VFD_PARAMS_BATCH_MAX) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    // STOP pendiente: el bus es de vfd_estop_task
+    if (atomic_load(&s_stop_pending)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
     // Buffer para la respuesta (Modbus es Big Endian)
-    uint16_t read_data_be;
+    uint16_t read_data_be[VFD_PARAMS_BATCH_MAX];
 
     mb_param_request_t req = {
         .slave_addr = VFD_SLAVE_ID,
         .command = MB_FUNC_READ_HOLDING_REGISTERS, // Función 0x03
         .reg_start = reg_addr,
-        .reg_size = 1 // Leer 1 solo registro
+        .reg_size = count
     };
 
-    esp_err_t err = mbc_master_send_request(master_handle, &req, &read_data_be);
+    esp_err_t err = vfd_transaction(&req, read_data_be);
+    vfd_read_result(reg_addr, count, err, read_data_be, out_values);
+    return err;
+}
 
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG_VFD, "Error al LEER registro 0x%04X: %s", reg_addr, esp_err_to_name(err));
+/**
+ * @brief Verifica la tabla de parámetros del VFD (ver vfd_params.h)
+ *
+ * @param allow_skip Omitir si la huella guardada coincide (arranque)
+ */
+static esp_err_t vfd_check_and_configure_params(bool allow_skip) {
+    uint32_t fingerprint = vfd_params_fingerprint();
+    if (allow_skip && persist_boot_vfd_fingerprint() == fingerprint) {
+        ESP_LOGI(TAG_VFD, "Parámetros del VFD ya verificados (huella 0x%08lX), se omite la comprobación",
+                 fingerprint);
+        return ESP_OK;
+    }
 
-        // Si la comunicación falla, actualizamos el estado global
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            g_vfd_status = VFD_STATUS_DISCONNECTED;
-            xSemaphoreGive(vfd_mutex);
-        }
+    ESP_LOGI(TAG_VFD, "Verificando parámetros del VFD...");
+    esp_err_t err = vfd_params_sync(vfd_read_registers, vfd_write_register, NULL);
+    if (err == ESP_OK) {
+        persist_set_vfd_fingerprint(fingerprint);
+        ESP_LOGI(TAG_VFD, "VFD configurado para control por Modbus.");
+    }
+    return err;
+}
+
+/**
+ * @brief Escribe los tiempos de rampa de un perfil, solo los que cambian
+ *
+ * Cada escritura va a la EEPROM del VFD: pocas por sesión (pausas y
+ * enfriamiento), y ninguna si el perfil no cambia los dos tiempos.
+ *
+ * @param applied Perfil vigente en el VFD (VFD_RAMP_COUNT = desconocido: se lee)
+ */
+static esp_err_t vfd_apply_ramp(vfd_ramp_t ramp, vfd_ramp_t applied) {
+    const vfd_ramp_profile_t *to = vfd_params_ramp(ramp);
+    uint16_t current[2];  // F0-17, F0-18
+
+    if (applied < VFD_RAMP_COUNT) {
+        current[0] = vfd_params_ramp(applied)->accel_ds;
+        current[1] = vfd_params_ramp(applied)->decel_ds;
     } else {
-        // Convertir de Big Endian (Modbus) a Little Endian (ESP32)
-        *out_value = __builtin_bswap16(read_data_be);
-        ESP_LOGD(TAG_VFD, "Lectura exitosa de registro 0x%04X: valor=0x%04X", reg_addr, *out_value);
+        esp_err_t err = vfd_read_registers(VFD_PARAMS_REG_ACCEL, 2, current);
+        if (err != ESP_OK) {
+            return err;
+        }
     }
 
+    esp_err_t err = ESP_OK;
+    if (current[0] != to->accel_ds) {
+        err = vfd_write_register(VFD_PARAMS_REG_ACCEL, to->accel_ds);
+    }
+    if (err == ESP_OK && current[1] != to->decel_ds) {
+        err = vfd_write_register(VFD_PARAMS_REG_DECEL, to->decel_ds);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG_VFD, "Rampa %s: aceleración %.1f s, deceleración %.1f s",
+                 to->name, to->accel_ds / 10.0f, to->decel_ds / 10.0f);
+    }
     return err;
 }
 
-static esp_err_t vfd_check_and_configure_params(void) {
-    ESP_LOGI(TAG_VFD, "Configurando VFD (Fuente de Comando y Frecuencia)...");
+// ---------------------------------------------------------------------------
+// Ciclo de control en bloque
+// ---------------------------------------------------------------------------
 
-    // Corrección según Manual: F0-01 = 2 (RS485)
-    if (vfd_write_register(VFD_REG_F0_01, 2) != ESP_OK) {
-        ESP_LOGE(TAG_VFD, "Error configurando F0-01 (Fuente de Comando)");
-        return ESP_FAIL;
+/**
+ * @brief Completado de una transacción del ciclo (tarea asíncrona de esp-modbus)
+ */
+static void vfd_cycle_done_cb(void *arg, esp_err_t err) {
+    vfd_cycle_op_t *op = (vfd_cycle_op_t *)arg;
+    op->err = vfd_estop_abort_err(err);  // Abortada en curso: como las canceladas en cola
+    op->done_us = esp_timer_get_time();
+    if (atomic_fetch_sub(&s_cycle_pending, 1) == 1) {
+        xSemaphoreGive(s_cycle_done);
     }
-    vTaskDelay(pdMS_TO_TICKS(50)); // Pausa entre comandos
+}
 
-    // Corrección según Manual: F0-02 = 9 (Comunicación)
-    if (vfd_write_register(VFD_REG_F0_02, 9) != ESP_OK) {
-        ESP_LOGE(TAG_VFD, "Error configurando F0-02 (Fuente de Frecuencia)");
-        return ESP_FAIL;
+static void vfd_cycle_begin(void) {
+    s_cycle_count = 0;
+}
+
+/**
+ * @brief Añade una transacción de un registro al ciclo
+ *
+ * Clase en la cola de esp-modbus: las escrituras de parada van en HIGH
+ * (adelantan a todo lo encolado y un E-Stop no las cancela), el resto de
+ * escrituras en NORMAL y las lecturas de sondeo en LOW. Las que no pueden
+ * salir (escritura no permitida con el E-Stop, lectura con un STOP
+ * pendiente) quedan con ESP_ERR_INVALID_STATE, como en vfd_write_register()
+ * y vfd_read_registers().
+ *
+ * @return Índice para vfd_cycle_result()
+ */
+static int vfd_cycle_add(uint8_t command, uint16_t reg_addr, uint16_t value) {
+    configASSERT(s_cycle_count < VFD_CYCLE_MAX_OPS);
+    vfd_cycle_op_t *op = &s_cycle_ops[s_cycle_count];
+    op->req = (mb_param_request_t){
+        .slave_addr = VFD_SLAVE_ID,
+        .command = command,
+        .reg_start = reg_addr,
+        .reg_size = 1
+    };
+    op->data = value;
+    op->err = ESP_ERR_INVALID_STATE;
+    if (command == MB_FUNC_WRITE_SINGLE_REGISTER) {
+        op->prio = vfd_is_stop_write(reg_addr, value) ? MB_REQUEST_PRIO_HIGH : MB_REQUEST_PRIO_NORMAL;
+        op->queued = vfd_write_allowed(reg_addr, value);
+    } else {
+        op->prio = MB_REQUEST_PRIO_LOW;
+        op->queued = !atomic_load(&s_stop_pending);
     }
+    return s_cycle_count++;
+}
 
-    ESP_LOGI(TAG_VFD, "VFD configurado para control por Modbus.");
-    return ESP_OK;
+/**
+ * @brief Ejecuta las transacciones del ciclo y espera a que terminen todas
+ *
+ * Se entregan de una vez a esp-modbus (mbc_master_send_request_async), que
+ * las envía seguidas, sin las esperas entre escritura y lectura de cuando
+ * cada una bloqueaba la tarea. Las que fallan siguen con los reintentos de
+ * vfd_transaction_from(), ya de una en una. Un STOP de emergencia cancela
+ * las que aún no han salido (vfd_estop_task): terminan con
+ * ESP_ERR_INVALID_STATE y una marcha encolada no llega al VFD.
+ */
+static void vfd_cycle_run(void) {
+    vfd_apply_timeout(atomic_load(&s_mb_timeout_ms));
+    int64_t start_us = esp_timer_get_time();
+
+    atomic_store(&s_cycle_pending, 1);  // Referencia propia hasta haber entregado todas
+    for (int i = 0; i < s_cycle_count; i++) {
+        vfd_cycle_op_t *op = &s_cycle_ops[i];
+        if (!op->queued) {
+            continue;
+        }
+        atomic_fetch_add(&s_cycle_pending, 1);
+        esp_err_t err = mbc_master_send_request_async(master_handle, &op->req, &op->data, op->prio,
+                                                      vfd_cycle_done_cb, op);
+        if (err != ESP_OK) {
+            // Cola llena o stack parado: la transacción va por la vía síncrona
+            atomic_fetch_sub(&s_cycle_pending, 1);
+            op->queued = false;
+            op->err = vfd_transaction(&op->req, &op->data);
+        }
+    }
+    if (atomic_fetch_sub(&s_cycle_pending, 1) != 1) {
+        xSemaphoreTake(s_cycle_done, portMAX_DELAY);  // esp-modbus completa siempre cada petición
+    }
+
+    // Salen una detrás de otra: cada una empieza al terminar la anterior (el
+    // ciclo las añade ya por clase: parada, resto de escrituras, lecturas)
+    int64_t prev_us = start_us;
+    for (int i = 0; i < s_cycle_count; i++) {
+        vfd_cycle_op_t *op = &s_cycle_ops[i];
+        if (!op->queued) {
+            continue;
+        }
+        if (op->err != ESP_ERR_INVALID_STATE) {  // Cancelada o abortada por el E-Stop: no cuenta
+            vfd_count_attempt(op->err, (uint32_t)(op->done_us - prev_us));
+        }
+        prev_us = op->done_us;
+        if (vfd_is_retryable(op->err) &&
+            (op->req.command != MB_FUNC_WRITE_SINGLE_REGISTER || vfd_write_allowed(op->req.reg_start, op->data))) {
+            op->err = vfd_transaction_from(&op->req, &op->data, 1, op->err);
+        }
+    }
+
+    for (int i = 0; i < s_cycle_count; i++) {
+        vfd_cycle_op_t *op = &s_cycle_ops[i];
+        if (op->req.command == MB_FUNC_WRITE_SINGLE_REGISTER) {
+            vfd_write_result(op->req.reg_start, op->err);
+        } else {
+            uint16_t data_be = op->data;
+            vfd_read_result(op->req.reg_start, 1, op->err, &data_be, &op->data);
+        }
+    }
+}
+
+/**
+ * @brief Resultado de una transacción del ciclo (lecturas: valor ya convertido)
+ */
+static esp_err_t vfd_cycle_result(int op, uint16_t *value) {
+    if (value != NULL) {
+        *value = s_cycle_ops[op].data;
+    }
+    return s_cycle_ops[op].err;
 }
 
 static void vfd_control_task(void *pvParameters) {
     // 1. Configurar los parámetros del VFD al arrancar
     // Esperamos hasta que la configuración sea exitosa
-    while(vfd_check_and_configure_params() != ESP_OK) {
+    while(vfd_check_and_configure_params(true) != ESP_OK) {
         ESP_LOGE(TAG_VFD, "Reintentando configuración del VFD en 5s...");
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            g_vfd_status = VFD_STATUS_FAULT; // Fallo de config inicial
-            xSemaphoreGive(vfd_mutex);
-        }
+        atomic_store(&g_vfd_status, VFD_STATUS_FAULT); // Fallo de config inicial
         vTaskDelay(pdMS_TO_TICKS(5000));
     }
 
     ESP_LOGI(TAG_VFD, "Configuración VFD exitosa. Iniciando bucle de control.");
 
+    // Con el motor parado, medir el peor caso de la parada de emergencia
+    // y el de una escritura de parada con la cola de sondeo saturada
+    vfd_self_test_run();
+
     // 2. Bucle de control principal (MODIFICADO)
+    // Liberación en fase fija (múltiplos de VFD_POLL_MS), no VFD_POLL_MS tras el final
+    // del ciclo anterior: la duración variable de las transacciones Modbus no acumula deriva.
+    TickType_t next_release = xTaskGetTickCount() + pdMS_TO_TICKS(VFD_POLL_MS);
+    TickType_t lost_since = 0;           // Primer ciclo sin respuesta (0 = enlace bien)
+    bool params_ok = true;
+    TickType_t params_retry = 0;
+    vfd_ramp_t ramp_applied = VFD_RAMP_COUNT;  // Desconocido: el VFD guarda el último perfil
     while (1) {
-        // Espera VFD_POLL_MS o una notificación de E-Stop
-        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(VFD_POLL_MS));
-
-        float kph;
-        bool estop;
-
-        // Copia segura de variables globales
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            kph = g_target_kph;
-            estop = g_emergency_stop;
-            xSemaphoreGive(vfd_mutex);
+        // Espera al siguiente instante de liberación o a una notificación de E-Stop
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next_release - now) > 0) {
+            if (ulTaskNotifyTake(pdTRUE, next_release - now) == 0) {
+                next_release += pdMS_TO_TICKS(VFD_POLL_MS);
+            }
+            // E-Stop: ciclo inmediato sin mover la fase
         } else {
-            ESP_LOGW(TAG_VFD, "Task no pudo tomar mutex (lectura), saltando ciclo");
+            // Ciclo desbordado (timeouts Modbus): re-fasar sin encadenar ráfagas
+            next_release = now + pdMS_TO_TICKS(VFD_POLL_MS);
+        }
+
+#if CONFIG_BASE_VFD_SELF_TEST
+        // Pruebas de latencia pedidas por el enlace: ocupan el bus unos segundos
+        if (atomic_exchange(&s_self_test_req, false)) {
+            vfd_self_test_run();
+            next_release = xTaskGetTickCount() + pdMS_TO_TICKS(VFD_POLL_MS);
             continue;
         }
+#endif
+
+        float kph = atomic_load(&g_target_kph);
+        float trim_kph = atomic_load(&g_trim_kph);
+        bool estop = atomic_load(&s_estop_latched);
+
+        // Parámetros pendientes de verificar (VFD reaparecido tras una pérdida larga)
+        if (!params_ok && (int32_t)(xTaskGetTickCount() - params_retry) >= 0) {
+            params_ok = vfd_check_and_configure_params(false) == ESP_OK;
+            params_retry = xTaskGetTickCount() + pdMS_TO_TICKS(VFD_PARAMS_RETRY_MS);
+            ramp_applied = VFD_RAMP_COUNT;  // La tabla restaura los tiempos del perfil normal
+        }
+
+        // Perfil de rampa antes de la consigna: una sola escritura de frecuencia
+        // basta para que el VFD recorra la rampa. Con el E-Stop el STOP ya salió
+        // (vfd_estop_task) y aquí solo se acorta la deceleración
+        vfd_ramp_t ramp = estop ? VFD_RAMP_ESTOP : (vfd_ramp_t)atomic_load(&s_ramp_req);
+        if (ramp != ramp_applied) {
+            ramp_applied = vfd_apply_ramp(ramp, ramp_applied) == ESP_OK ? ramp : VFD_RAMP_COUNT;
+        }
 
-        // --- SECCIÓN DE ESCRITURA (Sin cambios) ---
+        // --- CICLO MODBUS: escrituras y lecturas encoladas de una vez ---
+        float freq_hz = 0.0f;
+        vfd_cycle_begin();
         if (estop || kph < 0.5) {
             // --- PARADA ---
-            vfd_write_register(VFD_REG_CONTROL, VFD_CMD_STOP);
-            vTaskDelay(pdMS_TO_TICKS(10));
-            vfd_write_register(VFD_REG_FREQ, 0);
-
-            if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-                g_current_freq_hz = 0.0f;
-                xSemaphoreGive(vfd_mutex);
-            }
+            vfd_cycle_add(MB_FUNC_WRITE_SINGLE_REGISTER, VFD_REG_CONTROL, VFD_CMD_STOP);
+            vfd_cycle_add(MB_FUNC_WRITE_SINGLE_REGISTER, VFD_REG_FREQ, 0);
         } else {
             // --- MARCHA ---
             // Usar constante calibrada KPH_TO_HZ_RATIO = 7.8125 (NO la fórmula antigua 3.0)
-            float freq_hz = kph * KPH_TO_HZ_RATIO;
+            // La corrección del lazo de velocidad compensa el deslizamiento con carga
+            freq_hz = (kph + trim_kph) * KPH_TO_HZ_RATIO;
             uint16_t freq_centi_hz = (uint16_t)(freq_hz * 100.0f);
 
-            vfd_write_register(VFD_REG_FREQ, freq_centi_hz);
-            vTaskDelay(pdMS_TO_TICKS(10));
-            vfd_write_register(VFD_REG_CONTROL, VFD_CMD_RUN_FWD);
-
-            if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-                g_current_freq_hz = freq_hz;
-                xSemaphoreGive(vfd_mutex);
-            }
+            vfd_cycle_add(MB_FUNC_WRITE_SINGLE_REGISTER, VFD_REG_FREQ, freq_centi_hz);
+            vfd_cycle_add(MB_FUNC_WRITE_SINGLE_REGISTER, VFD_REG_CONTROL, VFD_CMD_RUN_FWD);
         }
+        // Frecuencia real (0x2103) y código de fallo (0x2104)
+        int real_freq_op = vfd_cycle_add(MB_FUNC_READ_HOLDING_REGISTERS, VFD_REG_REAL_FREQ, 0);
+        int fault_op = vfd_cycle_add(MB_FUNC_READ_HOLDING_REGISTERS, VFD_REG_FAULT_CODE, 0);
+        vfd_cycle_run();
 
-        // --- SECCIÓN DE LECTURA ---
-        vTaskDelay(pdMS_TO_TICKS(20)); // Pequeña pausa entre escritura y lectura
+        atomic_store(&g_current_freq_hz, freq_hz);
 
-        // Leer frecuencia real del VFD (registro 0x2103)
+        // --- SECCIÓN DE LECTURA ---
         uint16_t real_freq_centihz = 0;
-        esp_err_t read_freq_err = vfd_read_register(VFD_REG_REAL_FREQ, &real_freq_centihz);
+        esp_err_t read_freq_err = vfd_cycle_result(real_freq_op, &real_freq_centihz);
 
         if (read_freq_err == ESP_OK) {
             float real_freq_hz = real_freq_centihz / 100.0f;
 
             // Almacenar frecuencia real leída
-            if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-                g_vfd_real_freq_hz = real_freq_hz;
-                xSemaphoreGive(vfd_mutex);
-            }
+            atomic_store(&g_vfd_real_freq_hz, real_freq_hz);
 
             // Log periódico para debugging (cada 10 ciclos = 2 segundos)
             static uint8_t log_counter = 0;
             if (++log_counter >= 10) {
                 log_counter = 0;
                 ESP_LOGI(TAG_VFD, "VFD Real: %.2f Hz | Target: %.2f Hz | Speed: %.1f km/h",
-                         real_freq_hz, g_current_freq_hz, kph);
+                         real_freq_hz, freq_hz, kph);
             }
         }
 
-        // Leer código de fallo (registro 0x2104)
         uint16_t fault_code = 0;
-        esp_err_t read_fault_err = vfd_read_register(VFD_REG_FAULT_CODE, &fault_code);
+        esp_err_t read_fault_err = vfd_cycle_result(fault_op, &fault_code);
+        if (read_fault_err == ESP_ERR_INVALID_STATE) {
+            continue;  // Lectura cedida a un STOP de emergencia: estado sin cambios
+        }
 
         // Actualizar el estado global basado en la lectura
-        if (xSemaphoreTake(vfd_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            if (read_fault_err != ESP_OK) {
-                // El estado (DISCONNECTED) ya fue fijado por vfd_read_register()
-                ESP_LOGW(TAG_VFD, "No se pudo leer el estado de fallo (¿desconectado?)");
-            } else {
-                // La comunicación fue exitosa, analizamos el resultado
-                if (fault_code != 0) {
-                    ESP_LOGE(TAG_VFD, "¡FALLO VFD DETECTADO! Código: 0x%04X", fault_code);
-                    g_vfd_status = VFD_STATUS_FAULT;
-                } else {
-                    // Comunicación OK, Sin Fallo
-                    g_vfd_status = VFD_STATUS_OK;
-                }
+        if (read_fault_err != ESP_OK) {
+            // El estado (DISCONNECTED) ya fue fijado por vfd_read_result()
+            ESP_LOGW(TAG_VFD, "No se pudo leer el estado de fallo (¿desconectado?)");
+            if (lost_since == 0) {
+                lost_since = xTaskGetTickCount() | 1;
+            }
+            continue;
+        }
+        if (lost_since != 0 &&
+            xTaskGetTickCount() - lost_since >= pdMS_TO_TICKS(VFD_PARAMS_RECHECK_LOST_MS)) {
+            // Puede ser otro variador o uno repuesto: la huella ya no vale
+            ESP_LOGW(TAG_VFD, "VFD de vuelta tras %lu ms sin respuesta: verificando parámetros",
+                     pdTICKS_TO_MS(xTaskGetTickCount() - lost_since));
+            persist_set_vfd_fingerprint(0);
+            params_ok = false;
+            params_retry = xTaskGetTickCount();
+        }
+        lost_since = 0;
+        // La comunicación fue exitosa, analizamos el resultado
+        if (fault_code != 0) {
+            ESP_LOGE(TAG_VFD, "¡FALLO VFD DETECTADO! Código: 0x%04X", fault_code);
+            atomic_store(&g_vfd_status, VFD_STATUS_FAULT);
+        } else {
+            // Comunicación OK, Sin Fallo
+            atomic_store(&g_vfd_status, VFD_STATUS_OK);
+        }
+    }
+}
+
+// ===========================================================================
+// PARADA DE EMERGENCIA
+// ===========================================================================
+
+/**
+ * @brief Pide el STOP a vfd_estop_task (IRAM: se llama desde ISR)
+ *
+ * Solo la primera petición de una ráfaga fija el instante desde el que se
+ * mide la latencia.
+ */
+static void IRAM_ATTR vfd_estop_request(void) {
+    if (!atomic_load(&s_stop_pending)) {
+        atomic_store(&s_stop_req_us, (uint32_t)esp_timer_get_time());
+    }
+    atomic_store(&s_stop_pending, true);
+
+    TaskHandle_t task = vfd_estop_task_handle;
+    if (task == NULL) {
+        return;  // La tarea atiende la petición al crearse
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * @brief Envía el STOP en cuanto se pide, sin esperar a vfd_control_task
+ *
+ * Si hay una transacción Modbus en curso se aborta: vuelve con timeout al
+ * terminar de enviarse su trama en lugar de esperar la respuesta hasta
+ * response_tout_ms. Las que el ciclo de control tiene encoladas se cancelan.
+ * Esta tarea tiene más prioridad que vfd_control_task y que la tarea
+ * asíncrona de esp-modbus (mbc_ser_async), así que es la siguiente en tomar
+ * el bus. Latencia = petición → respuesta del VFD al STOP.
+ */
+/**
+ * @brief Envía el STOP de emergencia hasta que el VFD lo confirma
+ *
+ * El primer envío de cada petición es una transacción completa (con
+ * reintentos). Si falla, el VFD queda DISCONNECTED y se sigue con un solo
+ * intento cada vez, con el intervalo doblándose hasta VFD_ESTOP_RETRY_MAX_MS
+ * y un único log por corte: con la Consola apagada (watchdog) o el VFD sin
+ * alimentación esto puede durar horas. Una parada confirmada tras un corte
+ * no entra en las latencias: mediría el corte, no la parada.
+ */
+static void vfd_estop_task(void *pvParameters) {
+    uint32_t failures = 0;                  // Envíos fallidos de la petición en curso
+    uint32_t retry_ms = VFD_ESTOP_RETRY_MS;
+    while (1) {
+        if (!atomic_load(&s_stop_pending)) {
+            failures = 0;
+            retry_ms = VFD_ESTOP_RETRY_MS;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // Lo encolado por vfd_control_task no sale (una marcha no puede seguir al STOP),
+        // salvo las escrituras de parada (HIGH), y lo que está en curso se aborta
+        mbc_master_cancel_requests(master_handle, MB_REQUEST_PRIO_NORMAL);
+        if (mbc_master_abort_request(master_handle) == ESP_OK) {
+            atomic_fetch_add(&s_estop_aborts, 1);
+        }
+
+        mb_param_request_t req = {
+            .slave_addr = VFD_SLAVE_ID,
+            .command = MB_FUNC_WRITE_SINGLE_REGISTER,
+            .reg_start = VFD_REG_CONTROL,
+            .reg_size = 1
+        };
+        uint16_t value = VFD_CMD_STOP;
+        esp_err_t err = failures == 0 ? vfd_transaction(&req, &value)
+                                      : vfd_send_attempt(&req, &value, atomic_load(&s_mb_timeout_ms));
+        if (err != ESP_OK) {
+            if (failures++ == 0) {
+                ESP_LOGE(TAG_VFD, "E-Stop: STOP no confirmado (%s), VFD sin respuesta; reintentando "
+                         "cada vez más espaciado (hasta %d ms)", esp_err_to_name(err), VFD_ESTOP_RETRY_MAX_MS);
+            }
+            atomic_store(&g_vfd_status, VFD_STATUS_DISCONNECTED);
+            vTaskDelay(pdMS_TO_TICKS(retry_ms));
+            retry_ms = retry_ms * 2 < VFD_ESTOP_RETRY_MAX_MS ? retry_ms * 2 : VFD_ESTOP_RETRY_MAX_MS;
+            continue;
+        }
+
+        uint32_t latency_us = (uint32_t)esp_timer_get_time() - atomic_load(&s_stop_req_us);
+        atomic_store(&s_stop_pending, false);
+        atomic_fetch_add(&s_estop_stops, 1);
+        if (failures == 0) {
+            atomic_store(&s_estop_last_us, latency_us);
+            if (latency_us > atomic_load(&s_estop_max_us)) {
+                atomic_store(&s_estop_max_us, latency_us);
             }
-            xSemaphoreGive(vfd_mutex);
+            ESP_LOGW(TAG_VFD, "E-Stop: STOP confirmado por el VFD en %lu us", latency_us);
         } else {
-             ESP_LOGW(TAG_VFD, "Task no pudo tomar mutex (escritura estado)");
+            atomic_store(&g_vfd_status, VFD_STATUS_OK);
+            ESP_LOGW(TAG_VFD, "E-Stop: VFD de nuevo con respuesta, STOP confirmado tras %lu envíos fallidos "
+                     "(%lu ms; fuera de las latencias)", failures, latency_us / 1000);
+        }
+        failures = 0;
+        retry_ms = VFD_ESTOP_RETRY_MS;
+
+        // vfd_control_task completa la parada (frecuencia 0) en su ciclo
+        if (vfd_task_handle) {
+            xTaskNotifyGive(vfd_task_handle);
+        }
+    }
+}
+
+// ===========================================================================
+// PRUEBAS DE LATENCIA
+// ===========================================================================
+
+static void vfd_estop_test_cb(void *arg) {
+    vfd_estop_request();
+}
+
+/**
+ * @brief true si las pruebas de latencia pueden enviar STOP sin efecto: sin
+ *        consigna de marcha y con el VFD leído parado
+ *
+ * Base puede reiniciarse con el motor en marcha: el VFD sigue a la última
+ * consigna y un STOP de prueba lo pararía.
+ */
+static bool vfd_self_test_allowed(void) {
+    uint16_t real_freq_centihz = 0;
+    if (atomic_load(&g_target_kph) >= 0.5f ||
+        vfd_read_registers(VFD_REG_REAL_FREQ, 1, &real_freq_centihz) != ESP_OK || real_freq_centihz != 0) {
+        ESP_LOGW(TAG_VFD, "Pruebas de latencia omitidas: VFD en marcha o sin respuesta");
+        return false;
+    }
+    return true;
+}
+
+/** @brief Contadores que las pruebas de latencia no deben alterar */
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t invalid;
+    uint32_t retries;
+    uint32_t estop_stops;
+    uint32_t estop_aborts;
+    uint32_t estop_last_us;
+    uint32_t estop_max_us;
+} vfd_counters_snapshot_t;
+
+static void vfd_counters_save(vfd_counters_snapshot_t *snap) {
+    snap->transactions = atomic_load(&s_mb_transactions);
+    snap->errors = atomic_load(&s_mb_errors);
+    snap->timeouts = atomic_load(&s_mb_timeouts);
+    snap->invalid = atomic_load(&s_mb_invalid);
+    snap->retries = atomic_load(&s_mb_retries);
+    snap->estop_stops = atomic_load(&s_estop_stops);
+    snap->estop_aborts = atomic_load(&s_estop_aborts);
+    snap->estop_last_us = atomic_load(&s_estop_last_us);
+    snap->estop_max_us = atomic_load(&s_estop_max_us);
+}
+
+static void vfd_counters_restore(const vfd_counters_snapshot_t *snap) {
+    atomic_store(&s_mb_transactions, snap->transactions);
+    atomic_store(&s_mb_errors, snap->errors);
+    atomic_store(&s_mb_timeouts, snap->timeouts);
+    atomic_store(&s_mb_invalid, snap->invalid);
+    atomic_store(&s_mb_retries, snap->retries);
+    atomic_store(&s_estop_stops, snap->estop_stops);
+    atomic_store(&s_estop_aborts, snap->estop_aborts);
+    atomic_store(&s_estop_last_us, snap->estop_last_us);
+    atomic_store(&s_estop_max_us, snap->estop_max_us);
+}
+
+/**
+ * @brief Mide la latencia de la parada con el bus ocupado
+ *
+ * Lanza VFD_ESTOP_TEST_RUNS peticiones de STOP (sin enclavar el E-Stop)
+ * mientras esta tarea hace una lectura, cada una desplazada
+ * VFD_ESTOP_TEST_STEP_US más que la anterior, y guarda la peor. Al
+ * arrancar y con VFDTEST=1 (CONFIG_BASE_VFD_SELF_TEST), siempre con el
+ * motor parado (vfd_self_test_allowed): el STOP no cambia nada. Los
+ * contadores Modbus y de E-Stop quedan como estaban antes de la prueba.
+ */
+static void vfd_estop_self_test(void) {
+    if (s_estop_test_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = &vfd_estop_test_cb,
+            .name = "vfd_estop_test"
+        };
+        if (esp_timer_create(&args, &s_estop_test_timer) != ESP_OK) {
+            ESP_LOGW(TAG_VFD, "E-Stop: sin timer para la prueba de latencia");
+            return;
         }
     }
+
+    vfd_counters_snapshot_t snap;
+    vfd_counters_save(&snap);
+
+    uint32_t worst_us = 0;
+    int runs = 0;
+    for (int i = 0; i < VFD_ESTOP_TEST_RUNS; i++) {
+        uint32_t stops = atomic_load(&s_estop_stops);
+        esp_timer_start_once(s_estop_test_timer, (uint64_t)(i + 1) * VFD_ESTOP_TEST_STEP_US);
+        uint16_t dummy;
+        vfd_read_registers(VFD_REG_REAL_FREQ, 1, &dummy);  // Transacción que el STOP interrumpe
+
+        TickType_t start = xTaskGetTickCount();
+        while (atomic_load(&s_estop_stops) == stops &&
+               xTaskGetTickCount() - start < pdMS_TO_TICKS(VFD_ESTOP_TEST_WAIT_MS)) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        if (atomic_load(&s_estop_stops) == stops) {
+            ESP_LOGW(TAG_VFD, "E-Stop: prueba %d sin STOP confirmado", i);
+            continue;
+        }
+        uint32_t latency_us = atomic_load(&s_estop_last_us);
+        if (latency_us > worst_us) {
+            worst_us = latency_us;
+        }
+        runs++;
+    }
+
+    // Las estadísticas de uso real no incluyen la prueba
+    uint32_t test_aborts = atomic_load(&s_estop_aborts) - snap.estop_aborts;
+    vfd_counters_restore(&snap);
+    atomic_store(&s_estop_test_worst_us, worst_us);
+    ESP_LOGI(TAG_VFD, "E-Stop: latencia peor caso %lu us (%d/%d pruebas, %lu con transacción abortada)",
+             worst_us, runs, VFD_ESTOP_TEST_RUNS, test_aborts);
+}
+
+
+/**
+ * @brief Completado de una lectura de carga: se vuelve a encolar mientras dure la prueba
+ */
+static void vfd_prio_load_cb(void *arg, esp_err_t err) {
+    uint16_t *data = (uint16_t *)arg;
+    if (atomic_load(&s_prio_load_run)) {
+        mb_param_request_t req = {
+            .slave_addr = VFD_SLAVE_ID,
+            .command = MB_FUNC_READ_HOLDING_REGISTERS,
+            .reg_start = VFD_REG_REAL_FREQ,
+            .reg_size = 1
+        };
+        if (mbc_master_send_request_async(master_handle, &req, data, MB_REQUEST_PRIO_LOW,
+                                          vfd_prio_load_cb, data) == ESP_OK) {
+            return;
+        }
+    }
+    atomic_fetch_sub(&s_prio_load_inflight, 1);
+}
+
+/**
+ * @brief Encola un STOP en la clase dada y devuelve cuánto tardó (0 = falló)
+ *
+ * Va por el completado del ciclo (vfd_cycle_done_cb) pero sin vfd_cycle_run:
+ * la espera en cola no es tiempo de respuesta del VFD y no debe entrar en
+ * el timeout adaptativo.
+ */
+static uint32_t vfd_prio_probe(mb_request_prio_t prio) {
+    vfd_cycle_op_t *op = &s_cycle_ops[0];
+    op->req = (mb_param_request_t){
+        .slave_addr = VFD_SLAVE_ID,
+        .command = MB_FUNC_WRITE_SINGLE_REGISTER,
+        .reg_start = VFD_REG_CONTROL,
+        .reg_size = 1
+    };
+    op->data = VFD_CMD_STOP;
+    op->err = ESP_FAIL;
+    atomic_store(&s_cycle_pending, 1);
+    int64_t start_us = esp_timer_get_time();
+    if (mbc_master_send_request_async(master_handle, &op->req, &op->data, prio, vfd_cycle_done_cb, op) != ESP_OK) {
+        return 0;
+    }
+    xSemaphoreTake(s_cycle_done, portMAX_DELAY);
+    return op->err == ESP_OK ? (uint32_t)(op->done_us - start_us) : 0;
+}
+
+/**
+ * @brief Mide la latencia de una escritura HIGH con el sondeo saturado
+ *
+ * Mantiene VFD_PRIO_TEST_LOAD lecturas LOW en la cola de esp-modbus (cada
+ * una se vuelve a encolar al terminar) y escribe VFD_PRIO_TEST_RUNS STOP en
+ * HIGH, desplazados VFD_PRIO_TEST_STEP_MS para caer en distintos puntos de
+ * la lectura en curso. Latencia = entrega → respuesta del VFD; el peor caso
+ * debe quedar en una transacción en curso más la propia, no en la cola
+ * entera. Una escritura más en LOW da la referencia sin prioridades. Solo
+ * con el motor parado: el STOP no cambia nada. Los contadores Modbus quedan
+ * como estaban antes de la prueba.
+ */
+static void vfd_prio_self_test(void) {
+    vfd_counters_snapshot_t snap;
+    vfd_counters_save(&snap);
+
+    atomic_store(&s_prio_load_run, true);
+    for (int i = 0; i < VFD_PRIO_TEST_LOAD; i++) {
+        atomic_fetch_add(&s_prio_load_inflight, 1);
+        vfd_prio_load_cb(&s_prio_load_data[i], ESP_OK);  // Primer envío
+    }
+
+    uint32_t worst_us = 0;
+    int runs = 0;
+    for (int i = 0; i < VFD_PRIO_TEST_RUNS; i++) {
+        vTaskDelay(pdMS_TO_TICKS(VFD_PRIO_TEST_STEP_MS * (i + 1)));
+        uint32_t latency_us = vfd_prio_probe(MB_REQUEST_PRIO_HIGH);
+        if (latency_us == 0) {
+            ESP_LOGW(TAG_VFD, "Prioridad Modbus: prueba %d sin respuesta al STOP", i);
+            continue;
+        }
+        if (latency_us > worst_us) {
+            worst_us = latency_us;
+        }
+        runs++;
+    }
+    uint32_t fifo_us = vfd_prio_probe(MB_REQUEST_PRIO_LOW);
+    int load = atomic_load(&s_prio_load_inflight);
+
+    // Las lecturas de carga terminan sin volver a encolarse
+    atomic_store(&s_prio_load_run, false);
+    TickType_t start = xTaskGetTickCount();
+    while (atomic_load(&s_prio_load_inflight) > 0 &&
+           xTaskGetTickCount() - start < pdMS_TO_TICKS(VFD_PRIO_TEST_WAIT_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+
+    vfd_counters_restore(&snap);
+    atomic_store(&s_prio_test_worst_us, worst_us);
+    ESP_LOGI(TAG_VFD, "Prioridad Modbus: escritura HIGH peor caso %lu us con %d lecturas LOW en cola "
+             "(%d/%d pruebas; en LOW: %lu us)", worst_us, load, runs, VFD_PRIO_TEST_RUNS, fifo_us);
+}
+
+/**
+ * @brief Ambas pruebas (al arrancar y con VFDTEST=1), en vfd_control_task y
+ *        solo con el motor parado
+ */
+static void vfd_self_test_run(void) {
+    if (!vfd_self_test_allowed()) {
+        return;
+    }
+    vfd_estop_self_test();
+    vfd_prio_self_test();
 }
 
 static esp_err_t vfd_modbus_init(void) {
@@ -372,7 +1290,7 @@ static esp_err_t vfd_modbus_init(void) {
         .mode = MB_RTU,  // Modo RTU de esp-modbus
         .port = VFD_UART_PORT,
         .uid = VFD_SLAVE_ID,
-        .response_tout_ms = 1000,
+        .response_tout_ms = VFD_MB_TIMEOUT_INIT_MS,  // Después, adaptativo (vfd_transaction)
         .test_tout_us = 0,
         .baudrate = VFD_BAUD_RATE,
         .data_bits = UART_DATA_8_BITS,
@@ -1,6 +1,7 @@
 #ifndef VFD_DRIVER_H
 #define VFD_DRIVER_H
 
+#include <stdint.h>
 #include "esp_err.h"
 
 // Estados públicos del VFD que el main.c puede consultar
@@ -10,6 +11,48 @@ typedef enum {
     VFD_STATUS_FAULT
 } vfd_status_t;
 
+// Perfiles de rampa: tiempos de aceleración/deceleración programados en el VFD
+typedef enum {
+    VFD_RAMP_NORMAL,    ///< Cambios de velocidad del usuario
+    VFD_RAMP_STOP,      ///< Pausa (STOP) y reanudación
+    VFD_RAMP_COOLDOWN,  ///< Enfriamiento: deceleración lenta hasta 0
+    VFD_RAMP_ESTOP,     ///< Parada de emergencia (automático con el E-Stop enclavado)
+    VFD_RAMP_COUNT
+} vfd_ramp_t;
+
+// Contadores de la parada de emergencia
+typedef struct {
+    uint32_t stops;             ///< STOP confirmados por el VFD desde el arranque
+    uint32_t aborts;            ///< Transacciones Modbus en curso abortadas por un STOP
+    uint32_t last_latency_us;   ///< Petición → STOP confirmado, última parada sin corte del VFD
+    uint32_t max_latency_us;    ///< Ídem, máximo desde el arranque
+    uint32_t test_worst_us;     ///< Peor caso de la última prueba de latencia, al arrancar o VFDTEST (0 = sin medir)
+} vfd_estop_stats_t;
+
+// Contadores de las transacciones Modbus con el VFD (desde el arranque)
+typedef struct {
+    uint32_t transactions;      ///< Tramas enviadas (cada reintento cuenta)
+    uint32_t errors;            ///< Todas las fallidas
+    uint32_t timeouts;          ///< Sin respuesta (incluye las abortadas por un E-Stop)
+    uint32_t invalid;           ///< Respuesta con CRC o trama inválida, o excepción del VFD
+    uint32_t retries;           ///< Reintentos tras un timeout o una respuesta inválida
+    uint32_t timeout_ms;        ///< Timeout de respuesta vigente
+    uint32_t rtt_p50_ms;        ///< Mediana del tiempo de respuesta (ventana reciente)
+    uint32_t rtt_p99_ms;        ///< Percentil 99 del tiempo de respuesta (ventana reciente)
+    uint32_t high_test_worst_us; ///< Peor caso de una escritura de parada con la cola saturada (última prueba: arranque o VFDTEST)
+} vfd_modbus_stats_t;
+
+// Histograma del tiempo de respuesta del VFD: petición -> respuesta válida,
+// incluido el envío de la trama a 9600 baud
+#define VFD_RTT_BUCKETS     32
+#define VFD_RTT_BUCKET_MS   5   // El último tramo incluye todas las más lentas
+
+typedef struct {
+    uint32_t buckets[VFD_RTT_BUCKETS];  ///< Respuestas por tramo de VFD_RTT_BUCKET_MS (desde el arranque)
+    uint32_t samples;
+    uint32_t max_us;
+} vfd_rtt_histogram_t;
+
 /**
  * @brief Inicializa el UART2 (Modbus), el nodo Modbus y crea la tarea de control del VFD.
  */
@@ -24,15 +67,75 @@ void vfd_driver_init(void);
  */
 void vfd_driver_set_speed(float kph);
 
+/**
+ * @brief Fija la corrección del lazo de velocidad (km/h sumados al objetivo).
+ * Se ignora con la cinta parada. Segura desde cualquier tarea.
+ *
+ * @param trim_kph Corrección en km/h (0 = lazo abierto).
+ */
+void vfd_driver_set_speed_trim(float trim_kph);
+
+/**
+ * @brief Selecciona el perfil de rampa del VFD.
+ * Con una sola consigna el VFD recorre la rampa del perfil. La tarea del VFD
+ * escribe los tiempos antes de la siguiente consigna, solo si cambian. Segura
+ * desde cualquier tarea.
+ *
+ * @param ramp Perfil (VFD_RAMP_ESTOP lo aplica el propio driver con el E-Stop).
+ */
+void vfd_driver_set_ramp(vfd_ramp_t ramp);
+
 /**
  * @brief Envía un comando de paro inmediato al VFD.
- * Esta función es segura para llamar desde cualquier tarea o ISR (ej. watchdog).
+ * Esta función es segura para llamar desde cualquier tarea o ISR (IRAM, sin
+ * mutex). Aborta la transacción Modbus en curso y una tarea dedicada envía el
+ * STOP en cuanto el bus queda libre. La marcha queda bloqueada hasta el
+ * siguiente vfd_driver_set_speed().
  */
 void vfd_driver_emergency_stop(void);
 
+/**
+ * @brief Copia los contadores de la parada de emergencia.
+ *
+ * @param[out] out Contadores y latencias.
+ */
+void vfd_driver_get_estop_stats(vfd_estop_stats_t *out);
+
+/**
+ * @brief Copia los contadores de transacciones Modbus.
+ *
+ * @param[out] out Contadores.
+ */
+void vfd_driver_get_modbus_stats(vfd_modbus_stats_t *out);
+
+/**
+ * @brief Copia el histograma del tiempo de respuesta del VFD.
+ *
+ * @param[out] out Histograma desde el arranque.
+ */
+void vfd_driver_get_rtt_histogram(vfd_rtt_histogram_t *out);
+
+/**
+ * @brief Vuelca por log el histograma y la política de timeout vigente.
+ */
+void vfd_driver_log_rtt(void);
+
+/**
+ * @brief Repite las pruebas de latencia de la parada (E-Stop y escritura HIGH
+ * con el sondeo saturado) que se hacen al arrancar. No bloquea: las ejecuta vfd_control_task al
+ * inicio de su siguiente ciclo, solo con la cinta sin consigna y el VFD
+ * leído parado. Resultados en test_worst_us y high_test_worst_us.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED sin CONFIG_BASE_VFD_SELF_TEST
+ */
+esp_err_t vfd_driver_request_self_test(void);
+
 /**
  * @brief Obtiene el estado de salud actual del controlador del VFD.
  *
+ * Como el resto de getters de estado y frecuencia, no bloquea (lee un
+ * atómico): se puede llamar desde los slots del ejecutivo.
+ *
  * @return vfd_status_t Estado actual.
  */
 vfd_status_t vfd_driver_get_status(void);
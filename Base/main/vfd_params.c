@@ -0,0 +1,175 @@
+/**
+ * @file vfd_params.c
+ * @brief Tabla de parámetros del SU300 y verificación (ver vfd_params.h)
+ */
+
+#include "vfd_params.h"
+#include "cm_schema.h"
+#include "esp_log.h"
+#include <stddef.h>
+
+static const char *TAG = "VFD_PARAMS";
+
+// ============================================================================
+// TABLA DE PARÁMETROS
+// ============================================================================
+
+// Valores (unidades del manual: frecuencias en 0.01 Hz, tiempos en 0.1 s)
+#define VFD_PARAMS_MAX_FREQ_CHZ     16000   // 160.00 Hz: 20 km/h = 156.25 Hz con margen
+#define VFD_PARAMS_ACCEL_DS         150     // 15.0 s de 0 a la frecuencia máxima
+#define VFD_PARAMS_DECEL_DS         100     // 10.0 s de la frecuencia máxima a 0
+#define VFD_PARAMS_BAUD_9600        3       // F5-00: código de 9600 baudios
+#define VFD_PARAMS_PARITY_NONE      0       // F5-02: 8N1
+
+// Perfiles de rampa a partir de km/h/s: los tiempos del VFD son de 0 a la
+// frecuencia máxima, 160 Hz = 20.48 km/h con KPH_TO_HZ_RATIO (7.8125 Hz/km/h)
+#define VFD_PARAMS_MAX_KMH          20.48f
+#define VFD_RAMP_DS(kmh_s)          ((uint16_t)(VFD_PARAMS_MAX_KMH / (kmh_s) * 10.0f + 0.5f))
+#define VFD_RAMP_STOP_DECEL_DS      VFD_RAMP_DS(5.0f)                   // Pausa: 5 km/h/s (~4 s)
+#define VFD_RAMP_COOLDOWN_DECEL_DS  VFD_RAMP_DS(CM_RAMP_COOLDOWN_KMH_S) // 10 km/h en 2 min
+#define VFD_RAMP_ESTOP_DECEL_DS     VFD_RAMP_DS(7.0f)                   // E-Stop: 7 km/h/s (~3 s)
+
+/** Ordenada por registro: las lecturas agrupadas recorren la tabla en orden */
+static const vfd_param_t s_params[] = {
+    { 0x0001,               2,                       VFD_PARAM_WRITE, "F0-01 fuente de comando (RS485)" },
+    { 0x0002,               9,                       VFD_PARAM_WRITE, "F0-02 fuente de frecuencia (comunicación)" },
+    { 0x000A,               VFD_PARAMS_MAX_FREQ_CHZ, VFD_PARAM_WRITE, "F0-10 frecuencia máxima" },
+    { 0x000C,               VFD_PARAMS_MAX_FREQ_CHZ, VFD_PARAM_WRITE, "F0-12 frecuencia límite superior" },
+    { VFD_PARAMS_REG_ACCEL, VFD_PARAMS_ACCEL_DS,     VFD_PARAM_WRITE, "F0-17 tiempo de aceleración" },
+    { VFD_PARAMS_REG_DECEL, VFD_PARAMS_DECEL_DS,     VFD_PARAM_WRITE, "F0-18 tiempo de deceleración" },
+    { 0x0500,               VFD_PARAMS_BAUD_9600,    VFD_PARAM_CHECK, "F5-00 velocidad del enlace" },
+    { 0x0502,               VFD_PARAMS_PARITY_NONE,  VFD_PARAM_CHECK, "F5-02 formato del enlace" },
+};
+
+#define VFD_PARAMS_COUNT (sizeof(s_params) / sizeof(s_params[0]))
+
+/** Indexada por vfd_ramp_t. La aceleración solo cambia en el perfil normal */
+static const vfd_ramp_profile_t s_ramps[VFD_RAMP_COUNT] = {
+    [VFD_RAMP_NORMAL]   = { VFD_PARAMS_ACCEL_DS, VFD_PARAMS_DECEL_DS,        "normal" },
+    [VFD_RAMP_STOP]     = { VFD_PARAMS_ACCEL_DS, VFD_RAMP_STOP_DECEL_DS,     "pausa" },
+    [VFD_RAMP_COOLDOWN] = { VFD_PARAMS_ACCEL_DS, VFD_RAMP_COOLDOWN_DECEL_DS, "enfriamiento" },
+    [VFD_RAMP_ESTOP]    = { VFD_PARAMS_ACCEL_DS, VFD_RAMP_ESTOP_DECEL_DS,    "E-Stop" },
+};
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+/**
+ * @brief Último índice del grupo que empieza en first (una sola lectura)
+ */
+static size_t batch_end(size_t first) {
+    size_t last = first;
+    while (last + 1 < VFD_PARAMS_COUNT) {
+        uint16_t next = s_params[last + 1].reg;
+        if (next - s_params[last].reg > VFD_PARAMS_BATCH_GAP ||
+            next - s_params[first].reg >= VFD_PARAMS_BATCH_MAX) {
+            break;
+        }
+        last++;
+    }
+    return last;
+}
+
+/**
+ * @brief Compara un parámetro y, si hace falta, lo escribe y lo vuelve a leer
+ */
+static esp_err_t apply_param(const vfd_param_t *p, uint16_t current,
+                             vfd_params_read_fn_t read, vfd_params_write_fn_t write,
+                             vfd_params_result_t *res) {
+    if (current == p->value) {
+        return ESP_OK;
+    }
+    if (p->action == VFD_PARAM_CHECK) {
+        ESP_LOGW(TAG, "%s = %u (se esperaba %u): revisar en el panel del VFD",
+                 p->name, current, p->value);
+        res->mismatches++;
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "%s: %u -> %u", p->name, current, p->value);
+    esp_err_t err = write(p->reg, p->value);
+    if (err == ESP_OK) {
+        res->writes++;
+        uint16_t readback = 0;
+        res->reads++;
+        err = read(p->reg, 1, &readback);
+        if (err == ESP_OK && readback != p->value) {
+            ESP_LOGE(TAG, "%s no quedó escrito (leído %u)", p->name, readback);
+            err = ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error configurando %s: %s", p->name, esp_err_to_name(err));
+    }
+    return err;
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+uint32_t vfd_params_fingerprint(void) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < VFD_PARAMS_COUNT; i++) {
+        const uint8_t bytes[4] = {
+            (uint8_t)(s_params[i].reg >> 8), (uint8_t)s_params[i].reg,
+            (uint8_t)(s_params[i].value >> 8), (uint8_t)s_params[i].value,
+        };
+        for (size_t b = 0; b < sizeof(bytes); b++) {
+            h = (h ^ bytes[b]) * 16777619u;
+        }
+    }
+    return h;
+}
+
+esp_err_t vfd_params_sync(vfd_params_read_fn_t read, vfd_params_write_fn_t write,
+                          vfd_params_result_t *result) {
+    vfd_params_result_t res = {0};
+    esp_err_t ret = ESP_OK;
+
+    for (size_t first = 0; first < VFD_PARAMS_COUNT;) {
+        size_t last = batch_end(first);
+        uint16_t base = s_params[first].reg;
+        uint16_t values[VFD_PARAMS_BATCH_MAX];
+
+        res.reads++;
+        esp_err_t err = read(base, (uint16_t)(s_params[last].reg - base + 1), values);
+        for (size_t i = first; i <= last; i++) {
+            const vfd_param_t *p = &s_params[i];
+            uint16_t current;
+            if (err == ESP_OK) {
+                current = values[p->reg - base];
+            } else {
+                // Grupo rechazado o perdido: parámetro a parámetro
+                res.reads++;
+                esp_err_t single = read(p->reg, 1, &current);
+                if (single != ESP_OK) {
+                    ESP_LOGE(TAG, "Error leyendo %s: %s", p->name, esp_err_to_name(single));
+                    if (p->action == VFD_PARAM_WRITE) {
+                        ret = single;
+                    }
+                    continue;
+                }
+            }
+            if (apply_param(p, current, read, write, &res) != ESP_OK) {
+                ret = ESP_FAIL;
+            }
+        }
+        first = last + 1;
+    }
+
+    ESP_LOGI(TAG, "Parámetros del VFD %s: %u lecturas, %u escritos, %u avisos",
+             ret == ESP_OK ? "verificados" : "incompletos", res.reads, res.writes, res.mismatches);
+    if (result != NULL) {
+        *result = res;
+    }
+    return ret;
+}
+
+const vfd_ramp_profile_t *vfd_params_ramp(vfd_ramp_t ramp) {
+    if ((unsigned)ramp >= VFD_RAMP_COUNT) {
+        ramp = VFD_RAMP_NORMAL;
+    }
+    return &s_ramps[ramp];
+}
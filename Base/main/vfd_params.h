@@ -0,0 +1,114 @@
+/**
+ * @file vfd_params.h
+ * @brief Parámetros del VFD SU300 que Base necesita (tabla declarativa)
+ *
+ * La tabla de vfd_params.c lista los parámetros de los que depende el
+ * control (fuente de comando y frecuencia, rampas, frecuencia máxima y
+ * enlace). Al arrancar se leen agrupados en pocas peticiones Modbus y solo se
+ * escriben los que difieren, para no gastar la EEPROM del variador.
+ *
+ * La huella de la tabla se guarda en NVS (persist) tras una verificación
+ * correcta: si al arrancar coincide, el VFD ya está configurado y se omite la
+ * comprobación. Cambiar cualquier valor de la tabla cambia la huella y fuerza
+ * una verificación. La huella solo vale para el variador con el que se
+ * comprobó: vfd_driver vuelve a verificar cuando el VFD reaparece tras una
+ * pérdida prolongada del enlace (variador sustituido o repuesto).
+ *
+ * Los tiempos de rampa (F0-17/F0-18) de la tabla son los del perfil normal.
+ * vfd_driver los cambia en marcha según el perfil (vfd_params_ramp()): pausa,
+ * enfriamiento y E-Stop tienen su propia deceleración, así que basta una
+ * consigna para que el VFD haga la rampa completa.
+ */
+
+#ifndef VFD_PARAMS_H
+#define VFD_PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "vfd_driver.h"
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Registros por lectura agrupada (función 0x03) */
+#define VFD_PARAMS_BATCH_MAX    16
+
+/** Hueco máximo entre parámetros de una misma lectura agrupada */
+#define VFD_PARAMS_BATCH_GAP    8
+
+/** Registros de tiempo de rampa (consecutivos: una lectura los trae juntos) */
+#define VFD_PARAMS_REG_ACCEL    0x0011  // F0-17
+#define VFD_PARAMS_REG_DECEL    0x0012  // F0-18
+
+// ============================================================================
+// TIPOS
+// ============================================================================
+
+/** Qué hacer si el valor leído no coincide */
+typedef enum {
+    VFD_PARAM_WRITE,    ///< Escribir el valor de la tabla y verificarlo
+    VFD_PARAM_CHECK     ///< Solo avisar (p. ej. enlace: escribirlo cortaría la comunicación)
+} vfd_param_action_t;
+
+typedef struct {
+    uint16_t reg;               ///< Dirección Modbus (Fx-yy = 0x0x00 + yy)
+    uint16_t value;
+    vfd_param_action_t action;
+    const char *name;           ///< Para el log ("F0-01 fuente de comando")
+} vfd_param_t;
+
+/** Lee count registros consecutivos desde reg */
+typedef esp_err_t (*vfd_params_read_fn_t)(uint16_t reg, uint16_t count, uint16_t *out);
+
+/** Escribe un registro */
+typedef esp_err_t (*vfd_params_write_fn_t)(uint16_t reg, uint16_t value);
+
+/** Resultado de la última verificación */
+typedef struct {
+    uint8_t reads;              ///< Peticiones de lectura
+    uint8_t writes;             ///< Parámetros escritos
+    uint8_t mismatches;         ///< VFD_PARAM_CHECK distintos (solo aviso)
+    bool skipped;               ///< Omitida por huella coincidente
+} vfd_params_result_t;
+
+/** Tiempos de rampa de un perfil (0.1 s de 0 a la frecuencia máxima) */
+typedef struct {
+    uint16_t accel_ds;
+    uint16_t decel_ds;
+    const char *name;
+} vfd_ramp_profile_t;
+
+// ============================================================================
+// API
+// ============================================================================
+
+/**
+ * @brief Huella de la tabla (FNV-1a sobre registros y valores)
+ */
+uint32_t vfd_params_fingerprint(void);
+
+/**
+ * @brief Lee la tabla del VFD y escribe lo que difiere
+ *
+ * Cada escritura se vuelve a leer para confirmarla. Si una lectura agrupada
+ * falla (p. ej. el VFD rechaza un registro del hueco), ese grupo se lee
+ * parámetro a parámetro.
+ *
+ * @param read   Lectura de registros del VFD
+ * @param write  Escritura de un registro del VFD
+ * @param[out] result Contadores (puede ser NULL)
+ * @return ESP_OK si todos los VFD_PARAM_WRITE quedaron con el valor de la tabla
+ */
+esp_err_t vfd_params_sync(vfd_params_read_fn_t read, vfd_params_write_fn_t write,
+                          vfd_params_result_t *result);
+
+/**
+ * @brief Tiempos de rampa de un perfil
+ *
+ * @param ramp Perfil (fuera de rango = VFD_RAMP_NORMAL)
+ */
+const vfd_ramp_profile_t *vfd_params_ramp(vfd_ramp_t ramp);
+
+#endif // VFD_PARAMS_H
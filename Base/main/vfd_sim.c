@@ -0,0 +1,179 @@
+/**
+ * @file vfd_sim.c
+ * @brief VFD simulado para el destino linux (misma API que vfd_driver.h)
+ *
+ * Sustituye a vfd_driver.c en el ejecutable de host: no hay Modbus. La
+ * frecuencia real sigue a la consigna con los tiempos de rampa del perfil
+ * activo (vfd_params_ramp()), como haría el SU300, así que las rampas de
+ * pausa, enfriamiento y E-Stop se ven en el DATA igual que en la máquina.
+ */
+
+#include "vfd_driver.h"
+#include "vfd_params.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+
+static const char *TAG = "VFD_SIM";
+
+#define KPH_TO_HZ_RATIO     (50.0f / 6.4f)  // Mismo que vfd_driver.c
+#define VFD_SIM_MAX_FREQ_HZ 160.0f          // F0-10: los tiempos de rampa son de 0 a este valor
+#define VFD_SIM_STEP_MS     50
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static float s_target_kph = 0.0f;
+static float s_trim_kph = 0.0f;
+static float s_target_hz = 0.0f;
+static float s_real_hz = 0.0f;
+static atomic_uint s_ramp_req = VFD_RAMP_NORMAL;
+static DRAM_ATTR atomic_bool s_estop_latched = false;  // Hasta el siguiente vfd_driver_set_speed()
+static DRAM_ATTR atomic_uint s_estop_req_us = 0;      // 32 bits bajos de esp_timer (0 = sin petición)
+static atomic_uint s_estop_stops = 0;
+static atomic_uint s_estop_last_us = 0;
+static atomic_uint s_estop_max_us = 0;
+static atomic_uint s_steps = 0;
+
+// ============================================================================
+// FUNCIONES PRIVADAS
+// ============================================================================
+
+/**
+ * @brief Hz que recorre la rampa en un paso (tiempos del VFD en 0.1 s)
+ */
+static float ramp_step_hz(uint16_t time_ds) {
+    if (time_ds == 0) {
+        return VFD_SIM_MAX_FREQ_HZ;
+    }
+    return VFD_SIM_MAX_FREQ_HZ * VFD_SIM_STEP_MS / (time_ds * 100.0f);
+}
+
+static void vfd_sim_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(VFD_SIM_STEP_MS));
+
+        bool estop = atomic_load(&s_estop_latched);
+        uint32_t req_us = atomic_exchange(&s_estop_req_us, 0);
+        if (req_us != 0) {
+            // El STOP "llega" al VFD en el siguiente paso
+            uint32_t latency_us = (uint32_t)esp_timer_get_time() - req_us;
+            atomic_store(&s_estop_last_us, latency_us);
+            if (latency_us > atomic_load(&s_estop_max_us)) {
+                atomic_store(&s_estop_max_us, latency_us);
+            }
+            atomic_fetch_add(&s_estop_stops, 1);
+            ESP_LOGW(TAG, "STOP de emergencia (%lu us)", (unsigned long)latency_us);
+        }
+
+        const vfd_ramp_profile_t *ramp =
+            vfd_params_ramp(estop ? VFD_RAMP_ESTOP : (vfd_ramp_t)atomic_load(&s_ramp_req));
+
+        taskENTER_CRITICAL(&s_lock);
+        float kph = s_target_kph;
+        s_target_hz = (estop || kph < 0.5f) ? 0.0f : (kph + s_trim_kph) * KPH_TO_HZ_RATIO;
+        if (s_real_hz < s_target_hz) {
+            s_real_hz += ramp_step_hz(ramp->accel_ds);
+            if (s_real_hz > s_target_hz) {
+                s_real_hz = s_target_hz;
+            }
+        } else if (s_real_hz > s_target_hz) {
+            s_real_hz -= ramp_step_hz(ramp->decel_ds);
+            if (s_real_hz < s_target_hz) {
+                s_real_hz = s_target_hz;
+            }
+        }
+        taskEXIT_CRITICAL(&s_lock);
+
+        atomic_fetch_add(&s_steps, 1);
+    }
+}
+
+// ============================================================================
+// API PÚBLICA (vfd_driver.h)
+// ============================================================================
+
+void vfd_driver_init(void) {
+    xTaskCreate(vfd_sim_task, "vfd_sim_task", 3072, NULL, 9, NULL);
+    ESP_LOGI(TAG, "VFD simulado: rampas de vfd_params, sin Modbus");
+}
+
+void vfd_driver_set_speed(float kph) {
+    taskENTER_CRITICAL(&s_lock);
+    s_target_kph = kph;
+    taskEXIT_CRITICAL(&s_lock);
+    atomic_store(&s_estop_latched, false);
+}
+
+void vfd_driver_set_speed_trim(float trim_kph) {
+    taskENTER_CRITICAL(&s_lock);
+    s_trim_kph = trim_kph;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void vfd_driver_set_ramp(vfd_ramp_t ramp) {
+    atomic_store(&s_ramp_req, (unsigned)ramp);
+}
+
+void IRAM_ATTR vfd_driver_emergency_stop(void) {
+    atomic_store(&s_estop_latched, true);
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    atomic_store(&s_estop_req_us, now_us != 0 ? now_us : 1);
+}
+
+void vfd_driver_get_estop_stats(vfd_estop_stats_t *out) {
+    out->stops = atomic_load(&s_estop_stops);
+    out->aborts = 0;
+    out->last_latency_us = atomic_load(&s_estop_last_us);
+    out->max_latency_us = atomic_load(&s_estop_max_us);
+    out->test_worst_us = 0;
+}
+
+void vfd_driver_get_modbus_stats(vfd_modbus_stats_t *out) {
+    // Una "transacción" por paso de la simulación, sin fallos
+    out->transactions = atomic_load(&s_steps);
+    out->errors = 0;
+    out->timeouts = 0;
+    out->invalid = 0;
+    out->retries = 0;
+    out->timeout_ms = 0;
+    out->rtt_p50_ms = 0;
+    out->rtt_p99_ms = 0;
+    out->high_test_worst_us = 0;
+}
+
+void vfd_driver_get_rtt_histogram(vfd_rtt_histogram_t *out) {
+    *out = (vfd_rtt_histogram_t){0};
+}
+
+void vfd_driver_log_rtt(void) {
+    // Sin Modbus: no hay tiempos de respuesta que medir
+}
+
+esp_err_t vfd_driver_request_self_test(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+vfd_status_t vfd_driver_get_status(void) {
+    return VFD_STATUS_OK;
+}
+
+float vfd_driver_get_target_freq_hz(void) {
+    taskENTER_CRITICAL(&s_lock);
+    float hz = s_target_hz;
+    taskEXIT_CRITICAL(&s_lock);
+    return hz;
+}
+
+float vfd_driver_get_real_freq_hz(void) {
+    taskENTER_CRITICAL(&s_lock);
+    float hz = s_real_hz;
+    taskEXIT_CRITICAL(&s_lock);
+    return hz;
+}
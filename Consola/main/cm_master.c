@@ -7,6 +7,11 @@
  */
 
 #include "cm_master.h"
+#include "cm_protocol.h"
+#include "cm_schema.h"
+#include "cm_line.h"
+#include "cm_clock.h"
+#include "cm_capture.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -15,6 +20,7 @@
 #include "esp_timer.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 static const char *TAG = "CM_MASTER";
 
@@ -23,9 +29,12 @@ static const char *TAG = "CM_MASTER";
 // ============================================================================
 
 #define UART_BUF_SIZE            512
-#define LINE_BUFFER_SIZE         128
-#define SYNC_INTERVAL_MS         100  // SYNC cada 100ms
-#define CONNECTION_TIMEOUT_MS    1000 // Sin respuesta en 1s = desconectado
+#define SYNC_INTERVAL_MS         CM_LINK_SYNC_INTERVAL_MS       // SYNC cada 100ms
+#define CONNECTION_TIMEOUT_MS    CM_LINK_CONNECTION_TIMEOUT_MS  // Sin respuesta en 1s = desconectado
+#define BBOX_LINES_PER_CYCLE     4    // Líneas BLACKBOX por ciclo (~10 ms de respuesta cada una)
+#define BBOX_STALL_CYCLES        20   // Ciclos sin ninguna línea nueva antes de abandonar
+#define PROFILE_RETRY_CYCLES     5    // Reenvío del perfil si DATA no lo confirma (500 ms)
+#define PROFILE_MAX_SENDS        4
 
 // ============================================================================
 // VARIABLES PRIVADAS
@@ -56,11 +65,56 @@ static uint8_t g_target_head_fan = 0;
 static uint8_t g_target_chest_fan = 0;
 static uint8_t g_target_wax_pump = 0;
 static bool g_training_mode = false;  // false = pantalla inicial, true = entrenando
+static uint8_t g_target_ramp_mode = CM_RAMP_NORMAL;
+
+/** Estimador del reloj de Base (alimentado por cada par SYNC/DATA) */
+static cm_clock_t g_clock;
+static portMUX_TYPE g_clock_lock = portMUX_INITIALIZER_UNLOCKED;
 
 /** Handles de tareas */
 static TaskHandle_t g_master_task_handle = NULL;
 static TaskHandle_t g_uart_rx_task_handle = NULL;
 
+/** Lectura de la caja negra de Base (protegida por g_master_mutex) */
+typedef struct {
+    cm_master_bbox_state_t state;
+    uint16_t dump;
+    bool have_header;
+    cm_bbox_header_t header;
+    cm_bbox_record_t *records;  ///< header.record_count registros
+    uint8_t *received;          ///< Bitmap de líneas de registros recibidas
+    uint32_t lines;             ///< Líneas de registros (sin la cabecera)
+    uint32_t received_count;
+    uint32_t cursor;            ///< Siguiente línea a pedir (índice desde 0)
+    uint32_t progress;          ///< Líneas aceptadas (cabecera incluida)
+    uint32_t last_progress;
+    uint8_t stall_cycles;
+} bbox_fetch_t;
+
+static bbox_fetch_t g_bbox = { .state = CM_MASTER_BBOX_IDLE };
+
+/** Perfil de movimiento pedido a Base (protegido por g_master_mutex) */
+typedef struct {
+    cm_profile_seg_msg_t segs[CM_PROFILE_MAX_SEGMENTS];
+    uint8_t count;
+    uint8_t id;                 ///< En el SYNC (0 = ninguno)
+    uint8_t last_id;            ///< Último pedido (para el siguiente id y el estado)
+    bool pending;               ///< Sin confirmar por DATA: reenviar
+    uint8_t sends;
+    uint8_t cycles;             ///< Ciclos desde el último envío
+    cm_master_profile_status_t status;
+} profile_req_t;
+
+static profile_req_t g_profile;
+
+/** Respuesta STATS en curso (solo uart_rx_task) y última completa (g_master_mutex) */
+static cm_master_base_stats_t g_stats_pending;
+static uint8_t g_stats_pending_tasks = 0;
+static uint8_t g_stats_pending_slots = 0;
+static cm_master_base_stats_t g_stats;
+static bool g_stats_valid = false;
+static int64_t g_stats_rx_us = 0;
+
 // ============================================================================
 // FUNCIONES PRIVADAS - ENVÍO
 // ============================================================================
@@ -75,6 +129,7 @@ static esp_err_t send_line(const char *line) {
         ESP_LOGE(TAG, "Error al enviar línea por UART");
         return ESP_FAIL;
     }
+    cm_capture_record(CM_CAPTURE_DIR_TX, line, (len > 0 && line[len - 1] == '\n') ? len - 1 : len, 0);
     ESP_LOGD(TAG, "Enviado: %s", line);
     return ESP_OK;
 }
@@ -98,12 +153,23 @@ static esp_err_t send_command_int(const char *cmd, int value) {
 }
 
 /**
- * @brief Envía SYNC con todos los objetivos: SYNC=speed,incline,fan_head,fan_chest,wax,training_mode
+ * @brief Envía SYNC con todos los objetivos (formato definido en cm_schema.h)
+ *
+ * Completa los campos de reloj: t1 y la estimación actual del offset de Base.
  */
-static esp_err_t send_sync(float speed, float incline, uint8_t fan_head, uint8_t fan_chest, uint8_t wax, bool training_mode) {
-    char buffer[128];
-    snprintf(buffer, sizeof(buffer), "SYNC=%.2f,%.2f,%d,%d,%d,%d\n",
-             speed, incline, fan_head, fan_chest, wax, training_mode ? 1 : 0);
+static esp_err_t send_sync(cm_sync_msg_t *sync) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_t clock = g_clock;
+    taskEXIT_CRITICAL(&g_clock_lock);
+
+    char buffer[CM_SCHEMA_ASCII_MAX];
+    sync->tx_us = esp_timer_get_time();
+    sync->clock_offset_us = cm_clock_offset_at(&clock, sync->tx_us);
+    sync->clock_valid = clock.valid ? 1 : 0;
+    if (cm_sync_encode_ascii(sync, buffer, sizeof(buffer)) == 0) {
+        ESP_LOGE(TAG, "Error al codificar SYNC");
+        return ESP_FAIL;
+    }
     return send_line(buffer);
 }
 
@@ -112,40 +178,99 @@ static esp_err_t send_sync(float speed, float incline, uint8_t fan_head, uint8_t
 // ============================================================================
 
 /**
- * @brief Procesa respuesta DATA=<speed>,<incline>,<vfd_freq>,<vfd_fault>,<fan_head>,<fan_chest>,<incline_fault>
+ * @brief Completa un intercambio SYNC/DATA en el estimador de reloj
+ *
+ * @param rx_us Instante en que se completó la línea DATA
  */
-static void process_data_response(const char *line) {
-    float speed, incline, vfd_freq;
-    int vfd_fault, fan_head, fan_chest, incline_fault = 0;
+static void update_peer_clock(const cm_data_msg_t *data, size_t line_len, int64_t rx_us) {
+    if (data->sync_tx_us == 0) {
+        return;  // DATA que no responde a un SYNC (p. ej. CALIBRATE_INCLINE)
+    }
+
+    // Instantes de inicio de trama en ambos sentidos (ver cm_clock_frame_start_us)
+    int64_t t4 = cm_clock_frame_start_us(rx_us, line_len + 1, CM_MASTER_BAUD_RATE);
+    int64_t t3 = data->rx_us + data->turnaround_us;
 
-    // Intentar parsear formato nuevo (7 campos)
-    int parsed = sscanf(line, "DATA=%f,%f,%f,%d,%d,%d,%d",
-                        &speed, &incline, &vfd_freq,
-                        &vfd_fault, &fan_head, &fan_chest, &incline_fault);
+    taskENTER_CRITICAL(&g_clock_lock);
+    uint32_t steps = g_clock.steps;
+    cm_clock_add_exchange(&g_clock, data->sync_tx_us, data->rx_us, t3, t4);
+    bool stepped = (g_clock.steps != steps);
+    taskEXIT_CRITICAL(&g_clock_lock);
 
-    // Compatibilidad con formato antiguo (6 campos)
-    if (parsed < 6) {
+    if (stepped) {
+        ESP_LOGW(TAG, "Salto en el reloj de Base (¿reinicio?), resincronizando");
+    }
+}
+
+/**
+ * @brief Progreso del perfil pedido según un DATA (con g_master_mutex)
+ *
+ * Al terminar, las consignas del SYNC pasan a ser las del último segmento
+ * (las que Base mantiene) y el SYNC deja de pedir el perfil. Si Base lo
+ * abortó, la inclinación se queda donde está.
+ *
+ * @return CM_PROFILE_DONE o CM_PROFILE_ABORTED si el perfil acaba de terminar
+ */
+static uint8_t profile_update_locked(const cm_data_msg_t *data) {
+    if (g_profile.last_id == 0 || data->profile_id != g_profile.last_id ||
+        data->profile_state == CM_PROFILE_IDLE) {
+        return CM_PROFILE_IDLE;
+    }
+    g_profile.pending = false;
+    g_profile.status.state = data->profile_state;
+    g_profile.status.segment = data->profile_segment;
+    g_profile.status.left_ms = data->profile_left_ms;
+
+    if (g_profile.id == 0 || data->profile_state == CM_PROFILE_RUNNING) {
+        return CM_PROFILE_IDLE;
+    }
+    if (data->profile_state == CM_PROFILE_DONE) {
+        g_target_speed_kmh = g_profile.segs[g_profile.count - 1].speed_kmh;
+        g_target_incline_pct = g_profile.segs[g_profile.count - 1].incline_pct;
+    } else {
+        g_target_incline_pct = data->real_incline_pct;
+    }
+    g_profile.id = 0;
+    return data->profile_state;
+}
+
+/**
+ * @brief Procesa respuesta DATA (formato definido en cm_schema.h)
+ */
+static void process_data_response(const char *line, int64_t rx_us) {
+    cm_data_msg_t data;
+    if (!cm_data_decode_ascii(line, &data)) {
         ESP_LOGW(TAG, "Error al parsear DATA: %s", line);
         return;
     }
 
+    update_peer_clock(&data, strlen(line), rx_us);
+
     xSemaphoreTake(g_master_mutex, portMAX_DELAY);
-    g_real_speed_kmh = speed;
-    g_current_incline_pct = incline;
-    g_vfd_freq_hz = vfd_freq;
-    g_vfd_fault = (uint8_t)vfd_fault;
-    g_head_fan_state = (uint8_t)fan_head;
-    g_chest_fan_state = (uint8_t)fan_chest;
-    g_incline_sensor_fault = (uint8_t)incline_fault;
+    g_real_speed_kmh = data.real_speed_kmh;
+    g_current_incline_pct = data.real_incline_pct;
+    g_vfd_freq_hz = data.vfd_freq_hz;
+    g_vfd_fault = data.vfd_fault;
+    g_head_fan_state = data.fan_head;
+    g_chest_fan_state = data.fan_chest;
+    g_incline_sensor_fault = data.incline_fault;
     g_last_response_us = esp_timer_get_time();
     g_connected = true;
+    uint8_t profile_end = profile_update_locked(&data);
     xSemaphoreGive(g_master_mutex);
 
+    if (profile_end == CM_PROFILE_DONE) {
+        ESP_LOGI(TAG, "Perfil %u terminado en Base", data.profile_id);
+    } else if (profile_end == CM_PROFILE_ABORTED) {
+        ESP_LOGW(TAG, "Perfil %u abortado por Base", data.profile_id);
+    }
+
     ESP_LOGD(TAG, "DATA: speed=%.2f incline=%.1f vfd_freq=%.2f vfd_fault=%d fans=%d,%d incline_fault=%d",
-             speed, incline, vfd_freq, vfd_fault, fan_head, fan_chest, incline_fault);
+             data.real_speed_kmh, data.real_incline_pct, data.vfd_freq_hz, data.vfd_fault,
+             data.fan_head, data.fan_chest, data.incline_fault);
 
     // Alerta crítica si se detecta fallo del sensor
-    if (incline_fault != 0) {
+    if (data.incline_fault != 0) {
         ESP_LOGE(TAG, "═══════════════════════════════════════════════════");
         ESP_LOGE(TAG, "  ALERTA CRÍTICA: Fallo del sensor de inclinación");
         ESP_LOGE(TAG, "  Sistema bloqueado - Requiere servicio técnico");
@@ -153,14 +278,296 @@ static void process_data_response(const char *line) {
     }
 }
 
+// ============================================================================
+// FUNCIONES PRIVADAS - CAJA NEGRA
+// ============================================================================
+
+static bool bbox_line_received(uint32_t idx) {
+    return (g_bbox.received[idx / 8] >> (idx % 8)) & 1;
+}
+
+/**
+ * @brief Cabecera recibida: reserva el volcado (con g_master_mutex tomado)
+ */
+static void bbox_accept_header(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        g_bbox.state = CM_MASTER_BBOX_EMPTY;
+        return;
+    }
+    cm_bbox_header_t hdr;
+    if (len != sizeof(hdr)) {
+        g_bbox.state = CM_MASTER_BBOX_FAILED;
+        return;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.magic != CM_BBOX_MAGIC || hdr.version != CM_BBOX_VERSION ||
+        hdr.record_size != sizeof(cm_bbox_record_t)) {
+        ESP_LOGW(TAG, "Caja negra: formato de Base no soportado (versión %u)", hdr.version);
+        g_bbox.state = CM_MASTER_BBOX_FAILED;
+        return;
+    }
+
+    g_bbox.header = hdr;
+    g_bbox.have_header = true;
+    g_bbox.lines = cm_bbox_line_count(hdr.record_count) - 1;
+    g_bbox.progress++;
+    if (hdr.record_count == 0) {
+        g_bbox.state = CM_MASTER_BBOX_DONE;
+        return;
+    }
+    g_bbox.records = malloc(hdr.record_count * sizeof(cm_bbox_record_t));
+    g_bbox.received = calloc((g_bbox.lines + 7) / 8, 1);
+    if (g_bbox.records == NULL || g_bbox.received == NULL) {
+        ESP_LOGE(TAG, "Caja negra: sin memoria para %u registros", hdr.record_count);
+        g_bbox.state = CM_MASTER_BBOX_FAILED;
+    }
+}
+
+/**
+ * @brief Línea de registros recibida (con g_master_mutex tomado)
+ *
+ * @return true si completa el volcado
+ */
+static bool bbox_accept_records(uint16_t line_no, const uint8_t *data, size_t len) {
+    if (line_no == 0 || line_no > g_bbox.lines || bbox_line_received(line_no - 1)) {
+        return false;
+    }
+    uint32_t idx = line_no - 1;
+    uint32_t first = idx * CM_BBOX_RECORDS_PER_LINE;
+    uint32_t n = g_bbox.header.record_count - first;
+    if (n > CM_BBOX_RECORDS_PER_LINE) {
+        n = CM_BBOX_RECORDS_PER_LINE;
+    }
+    if (len != n * sizeof(cm_bbox_record_t)) {
+        return false;
+    }
+
+    memcpy(&g_bbox.records[first], data, len);
+    g_bbox.received[idx / 8] |= (uint8_t)(1 << (idx % 8));
+    g_bbox.received_count++;
+    g_bbox.progress++;
+    if (g_bbox.received_count == g_bbox.lines) {
+        g_bbox.state = CM_MASTER_BBOX_DONE;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Procesa una línea BBOX (formato en cm_blackbox_format.h)
+ */
+static void process_bbox_response(const char *line) {
+    uint16_t dump, line_no;
+    uint8_t data[CM_BBOX_LINE_DATA_MAX];
+    size_t len;
+    if (!cm_bbox_line_decode(line, &dump, &line_no, data, &len)) {
+        ESP_LOGW(TAG, "Línea BBOX inválida (se volverá a pedir)");
+        return;
+    }
+
+    bool done = false;
+    cm_bbox_header_t hdr;
+    cm_bbox_record_t trigger = {0};
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    if (g_bbox.state == CM_MASTER_BBOX_FETCHING && dump == g_bbox.dump) {
+        if (line_no == 0) {
+            if (!g_bbox.have_header) {
+                bbox_accept_header(data, len);
+                done = (g_bbox.state == CM_MASTER_BBOX_DONE);
+            }
+        } else if (g_bbox.have_header) {
+            done = bbox_accept_records(line_no, data, len);
+        }
+    }
+    hdr = g_bbox.header;
+    if (done && hdr.trigger_index < hdr.record_count) {
+        trigger = g_bbox.records[hdr.trigger_index];
+    }
+    xSemaphoreGive(g_master_mutex);
+
+    if (done) {
+        ESP_LOGI(TAG, "Caja negra #%lu leída: motivo %u, %u muestras cada %u ms, disparo en %u, %lu perdidas",
+                 hdr.dump_seq, hdr.reason, hdr.record_count, hdr.period_ms, hdr.trigger_index, hdr.dropped);
+        if (hdr.record_count > 0) {
+            ESP_LOGI(TAG, "  Disparo: t=%lu ms vel %.2f/%.2f km/h incl %.2f/%.2f %% VFD %.2f/%.2f Hz flags=0x%02X relés=0x%02X eventos=0x%02X",
+                     trigger.t_ms, trigger.real_speed / 100.0f, trigger.target_speed / 100.0f,
+                     trigger.real_incline / 100.0f, trigger.target_incline / 100.0f,
+                     trigger.vfd_real_freq / 100.0f, trigger.vfd_target_freq / 100.0f,
+                     trigger.flags, trigger.relays, trigger.events);
+        }
+    }
+}
+
+/**
+ * @brief Pide a Base las siguientes líneas que faltan (tarea maestro, tras el SYNC)
+ */
+static void bbox_request_lines(void) {
+    uint16_t req[BBOX_LINES_PER_CYCLE];
+    int n = 0;
+
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    if (g_bbox.state != CM_MASTER_BBOX_FETCHING) {
+        xSemaphoreGive(g_master_mutex);
+        return;
+    }
+    if (g_bbox.progress != g_bbox.last_progress) {
+        g_bbox.last_progress = g_bbox.progress;
+        g_bbox.stall_cycles = 0;
+    } else if (++g_bbox.stall_cycles > BBOX_STALL_CYCLES) {
+        ESP_LOGW(TAG, "Caja negra: Base no responde, lectura abandonada (%lu/%lu líneas)",
+                 g_bbox.received_count, g_bbox.lines);
+        g_bbox.state = CM_MASTER_BBOX_FAILED;
+        xSemaphoreGive(g_master_mutex);
+        return;
+    }
+
+    uint16_t dump = g_bbox.dump;
+    if (!g_bbox.have_header) {
+        req[n++] = 0;
+    } else {
+        // Recorrido circular desde el cursor: las perdidas se vuelven a pedir en la siguiente vuelta
+        for (uint32_t i = 0; i < g_bbox.lines && n < BBOX_LINES_PER_CYCLE; i++) {
+            uint32_t idx = (g_bbox.cursor + i) % g_bbox.lines;
+            if (!bbox_line_received(idx)) {
+                req[n++] = (uint16_t)(idx + 1);
+                g_bbox.cursor = (idx + 1) % g_bbox.lines;
+            }
+        }
+    }
+    xSemaphoreGive(g_master_mutex);
+
+    for (int i = 0; i < n; i++) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), CM_BBOX_REQUEST_PREFIX "%u,%u\n", dump, req[i]);
+        send_line(buffer);
+    }
+}
+
+// ============================================================================
+// FUNCIONES PRIVADAS - PERFIL DE MOVIMIENTO
+// ============================================================================
+
+/**
+ * @brief Envía el perfil pedido si DATA aún no lo confirmó (tarea maestro, tras el SYNC)
+ *
+ * El SYNC de este ciclo ya lleva el profile_id: Base no aplica las consignas
+ * del SYNC de un perfil que todavía no ha arrancado hasta recibirlo entero.
+ */
+static void profile_send_lines(void) {
+    cm_profile_seg_msg_t segs[CM_PROFILE_MAX_SEGMENTS];
+    cm_profile_msg_t msg;
+
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    if (!g_profile.pending || g_profile.id == 0 || g_profile.cycles++ % PROFILE_RETRY_CYCLES != 0) {
+        xSemaphoreGive(g_master_mutex);
+        return;
+    }
+    if (g_profile.sends >= PROFILE_MAX_SENDS) {
+        ESP_LOGW(TAG, "Perfil %u sin confirmar por Base tras %u envíos, abandonado",
+                 g_profile.id, g_profile.sends);
+        g_profile.pending = false;
+        g_profile.id = 0;
+        xSemaphoreGive(g_master_mutex);
+        return;
+    }
+    g_profile.sends++;
+    msg.profile_id = g_profile.id;
+    msg.segment_count = g_profile.count;
+    memcpy(segs, g_profile.segs, g_profile.count * sizeof(segs[0]));
+    xSemaphoreGive(g_master_mutex);
+
+    char buffer[CM_SCHEMA_ASCII_MAX];
+    for (uint8_t i = 0; i < msg.segment_count; i++) {
+        if (cm_profile_seg_encode_ascii(&segs[i], buffer, sizeof(buffer)) > 0) {
+            send_line(buffer);
+        }
+    }
+    if (cm_profile_encode_ascii(&msg, buffer, sizeof(buffer)) > 0) {
+        send_line(buffer);
+    }
+}
+
+// ============================================================================
+// FUNCIONES PRIVADAS - ESTADÍSTICAS DE BASE
+// ============================================================================
+
+/**
+ * @brief Procesa una línea de la respuesta STATS (formato en cm_schema.h)
+ *
+ * Las líneas se acumulan en g_stats_pending; SSYS cierra la respuesta y solo
+ * se publica si llegaron todas las STASK/SSLOT que anuncia.
+ *
+ * @return false si la línea no es de STATS
+ */
+static bool process_stats_response(const char *line) {
+    if (strncmp(line, CM_STATS_TASK_PREFIX, sizeof(CM_STATS_TASK_PREFIX) - 1) == 0) {
+        cm_stats_task_msg_t msg;
+        if (cm_stats_task_decode_ascii(line, &msg) && msg.index < CM_STATS_MAX_TASKS) {
+            if (msg.index == 0) {
+                // Primera línea de una respuesta nueva
+                g_stats_pending_tasks = 0;
+                g_stats_pending_slots = 0;
+            }
+            g_stats_pending.tasks[msg.index] = msg;
+            g_stats_pending_tasks++;
+        }
+    }
+    else if (strncmp(line, CM_STATS_SLOT_PREFIX, sizeof(CM_STATS_SLOT_PREFIX) - 1) == 0) {
+        cm_stats_slot_msg_t msg;
+        if (cm_stats_slot_decode_ascii(line, &msg) && msg.index < CM_STATS_MAX_SLOTS) {
+            g_stats_pending.slots[msg.index] = msg;
+            g_stats_pending_slots++;
+        }
+    }
+    else if (strncmp(line, CM_STATS_MB_PREFIX, sizeof(CM_STATS_MB_PREFIX) - 1) == 0) {
+        cm_stats_mb_decode_ascii(line, &g_stats_pending.mb);
+    }
+    else if (strncmp(line, CM_STATS_LINK_PREFIX, sizeof(CM_STATS_LINK_PREFIX) - 1) == 0) {
+        cm_stats_link_decode_ascii(line, &g_stats_pending.link);
+    }
+    else if (strncmp(line, CM_STATS_NVS_PREFIX, sizeof(CM_STATS_NVS_PREFIX) - 1) == 0) {
+        cm_stats_nvs_decode_ascii(line, &g_stats_pending.nvs);
+    }
+    else if (strncmp(line, CM_STATS_SYS_PREFIX, sizeof(CM_STATS_SYS_PREFIX) - 1) == 0) {
+        cm_stats_sys_msg_t sys;
+        if (cm_stats_sys_decode_ascii(line, &sys)) {
+            if (sys.task_count == g_stats_pending_tasks && sys.slot_count == g_stats_pending_slots) {
+                g_stats_pending.sys = sys;
+                xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+                g_stats = g_stats_pending;
+                g_stats_valid = true;
+                g_stats_rx_us = esp_timer_get_time();
+                xSemaphoreGive(g_master_mutex);
+            } else {
+                ESP_LOGW(TAG, "STATS incompleto (%u/%u tareas, %u/%u slots), descartado",
+                         g_stats_pending_tasks, sys.task_count, g_stats_pending_slots, sys.slot_count);
+            }
+        }
+        g_stats_pending_tasks = 0;
+        g_stats_pending_slots = 0;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Procesa una línea recibida del esclavo
+ *
+ * @param rx_us Instante en que se recibió el '\n'
  */
-static void process_response(const char *line) {
+static void process_response(const char *line, int64_t rx_us) {
     ESP_LOGD(TAG, "Recibido: %s", line);
 
     if (strncmp(line, "DATA=", 5) == 0) {
-        process_data_response(line);
+        process_data_response(line, rx_us);
+    }
+    else if (strncmp(line, CM_BBOX_LINE_PREFIX, sizeof(CM_BBOX_LINE_PREFIX) - 1) == 0) {
+        process_bbox_response(line);
+    }
+    else if (process_stats_response(line)) {
+        // Línea de la respuesta STATS
     }
     else {
         ESP_LOGW(TAG, "Línea desconocida: %s", line);
@@ -175,8 +582,8 @@ static void process_response(const char *line) {
  * @brief Tarea de recepción UART - Lee líneas terminadas en \n
  */
 static void uart_rx_task(void *pvParameters) {
-    char line_buffer[LINE_BUFFER_SIZE];
-    size_t line_pos = 0;
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
 
     ESP_LOGI(TAG, "Tarea UART RX iniciada (modo ASCII)");
 
@@ -185,23 +592,20 @@ static void uart_rx_task(void *pvParameters) {
         int len = uart_read_bytes(CM_MASTER_UART_PORT, &byte, 1, pdMS_TO_TICKS(100));
 
         if (len > 0) {
-            // Detectar fin de línea
-            if (byte == '\n' || byte == '\r') {
-                if (line_pos > 0) {
-                    // Terminar string y procesar respuesta
-                    line_buffer[line_pos] = '\0';
-                    process_response(line_buffer);
-                    line_pos = 0;
+            switch (cm_line_reader_feed(&reader, byte)) {
+                case CM_LINE_READY: {
+                    int64_t rx_us = esp_timer_get_time();
+                    cm_capture_record(CM_CAPTURE_DIR_RX, reader.buf, strlen(reader.buf), 0);
+                    process_response(reader.buf, rx_us);
+                    break;
                 }
-            }
-            // Acumular caracteres (ignorar \r adicionales)
-            else if (byte >= 32 && byte < 127) {  // Solo caracteres imprimibles ASCII
-                if (line_pos < LINE_BUFFER_SIZE - 1) {
-                    line_buffer[line_pos++] = byte;
-                } else {
+                case CM_LINE_OVERFLOW:
                     ESP_LOGW(TAG, "Línea demasiado larga, descartando");
-                    line_pos = 0;
-                }
+                    cm_capture_record(CM_CAPTURE_DIR_RX, reader.buf, CM_LINE_BUFFER_SIZE - 1,
+                                      CM_CAPTURE_FLAG_OVERFLOW);
+                    break;
+                default:
+                    break;
             }
         }
     }
@@ -213,6 +617,8 @@ static void uart_rx_task(void *pvParameters) {
  * - Envía SYNC cada 100ms con todos los objetivos
  * - Recibe DATA con todos los valores reales
  * - Monitorea timeout de conexión
+ * - Reenvía el perfil de movimiento hasta que DATA lo confirma
+ * - Intercala las peticiones de una lectura de la caja negra en curso
  */
 static void master_task(void *pvParameters) {
     ESP_LOGI(TAG, "Tarea maestro iniciada (protocolo SYNC simplificado)");
@@ -234,23 +640,34 @@ static void master_task(void *pvParameters) {
             if (g_connected) {
                 ESP_LOGW(TAG, "Desconectado del esclavo (timeout)");
                 g_connected = false;
+                cm_capture_request_dump();  // Conservar el tráfico previo al fallo
             }
         }
 
         // 2. Leer todos los objetivos actuales
-        float target_speed = g_target_speed_kmh;
-        float target_incline = g_target_incline_pct;
-        uint8_t target_fan_head = g_target_head_fan;
-        uint8_t target_fan_chest = g_target_chest_fan;
-        uint8_t target_wax = g_target_wax_pump;
-        bool training_mode = g_training_mode;
+        cm_sync_msg_t sync = {
+            .target_speed_kmh = g_target_speed_kmh,
+            .target_incline_pct = g_target_incline_pct,
+            .fan_head = g_target_head_fan,
+            .fan_chest = g_target_chest_fan,
+            .wax_pump = g_target_wax_pump,
+            .training_mode = g_training_mode ? 1 : 0,
+            .ramp_mode = g_target_ramp_mode,
+            .profile_id = g_profile.id,
+        };
         xSemaphoreGive(g_master_mutex);
 
         // 3. Enviar SYNC cada 100ms (siempre, haya cambios o no)
         if ((now_us - last_sync_us) >= (SYNC_INTERVAL_MS * 1000)) {
-            send_sync(target_speed, target_incline, target_fan_head, target_fan_chest, target_wax, training_mode);
+            send_sync(&sync);
             last_sync_us = now_us;
         }
+
+        // 4. Perfil de movimiento pendiente de confirmar
+        profile_send_lines();
+
+        // 5. Caja negra: unas pocas líneas detrás del SYNC
+        bbox_request_lines();
     }
 }
 
@@ -261,6 +678,8 @@ static void master_task(void *pvParameters) {
 esp_err_t cm_master_init(void) {
     ESP_LOGI(TAG, "Inicializando CM Master (Protocolo ASCII)...");
 
+    cm_clock_reset(&g_clock);
+
     // Crear mutex
     g_master_mutex = xSemaphoreCreateMutex();
     if (g_master_mutex == NULL) {
@@ -304,6 +723,11 @@ esp_err_t cm_master_init(void) {
              CM_MASTER_UART_PORT, CM_MASTER_BAUD_RATE,
              CM_MASTER_TX_PIN, CM_MASTER_RX_PIN);
 
+    // Captura de tráfico (no-op si CONFIG_CM_CAPTURE_ENABLE está desactivado)
+    if (cm_capture_init(CM_CAPTURE_NODE_CONSOLA) != ESP_OK) {
+        ESP_LOGW(TAG, "Captura de enlace no disponible");
+    }
+
     return ESP_OK;
 }
 
@@ -358,6 +782,108 @@ esp_err_t cm_master_calibrate_incline(void) {
     return send_command_int("CALIBRATE_INCLINE", 1);
 }
 
+esp_err_t cm_master_emergency_stop(void) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;  // No inicializado aún
+    }
+    // Primero la trama: no espera al siguiente SYNC
+    esp_err_t err = send_command_int("EMERGENCY_STOP", 1);
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    g_target_speed_kmh = 0.0f;  // Los SYNC siguientes rearman Base con 0 km/h
+    xSemaphoreGive(g_master_mutex);
+
+    ESP_LOGW(TAG, "EMERGENCY_STOP enviado");
+    return err;
+}
+
+esp_err_t cm_master_blackbox_fetch(uint16_t dump) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;  // No inicializado aún
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    free(g_bbox.records);
+    free(g_bbox.received);
+    g_bbox = (bbox_fetch_t){ .state = CM_MASTER_BBOX_FETCHING, .dump = dump };
+    xSemaphoreGive(g_master_mutex);
+
+    ESP_LOGI(TAG, "Leyendo caja negra de Base (volcado %u)", dump);
+    return ESP_OK;
+}
+
+cm_master_bbox_state_t cm_master_blackbox_state(uint8_t *progress_pct) {
+    if (g_master_mutex == NULL) {
+        return CM_MASTER_BBOX_IDLE;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    cm_master_bbox_state_t state = g_bbox.state;
+    if (progress_pct != NULL) {
+        if (state == CM_MASTER_BBOX_DONE) {
+            *progress_pct = 100;
+        } else {
+            *progress_pct = (g_bbox.lines > 0) ? (uint8_t)(g_bbox.received_count * 100 / g_bbox.lines) : 0;
+        }
+    }
+    xSemaphoreGive(g_master_mutex);
+    return state;
+}
+
+size_t cm_master_blackbox_get(cm_bbox_header_t *header, cm_bbox_record_t *records, size_t max_records) {
+    if (g_master_mutex == NULL) {
+        return 0;
+    }
+    size_t n = 0;
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    if (g_bbox.state == CM_MASTER_BBOX_DONE) {
+        *header = g_bbox.header;
+        n = g_bbox.header.record_count < max_records ? g_bbox.header.record_count : max_records;
+        if (n > 0) {
+            memcpy(records, g_bbox.records, n * sizeof(cm_bbox_record_t));
+        }
+    }
+    xSemaphoreGive(g_master_mutex);
+    return n;
+}
+
+bool cm_master_blackbox_trigger(cm_bbox_header_t *header, cm_bbox_record_t *trigger) {
+    if (g_master_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    bool done = (g_bbox.state == CM_MASTER_BBOX_DONE);
+    if (done) {
+        *header = g_bbox.header;
+        *trigger = (cm_bbox_record_t){0};
+        if (g_bbox.header.trigger_index < g_bbox.header.record_count) {
+            *trigger = g_bbox.records[g_bbox.header.trigger_index];
+        }
+    }
+    xSemaphoreGive(g_master_mutex);
+    return done;
+}
+
+esp_err_t cm_master_request_stats(void) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;  // No inicializado aún
+    }
+    return send_command_int("STATS", 1);
+}
+
+bool cm_master_get_base_stats(cm_master_base_stats_t *out, uint32_t *age_ms) {
+    if (g_master_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    bool valid = g_stats_valid;
+    if (valid) {
+        *out = g_stats;
+        if (age_ms != NULL) {
+            *age_ms = (uint32_t)((esp_timer_get_time() - g_stats_rx_us) / 1000);
+        }
+    }
+    xSemaphoreGive(g_master_mutex);
+    return valid;
+}
+
 bool cm_master_is_connected(void) {
     if (g_master_mutex == NULL) {
         return false;  // No inicializado aún
@@ -456,6 +982,77 @@ esp_err_t cm_master_set_training_mode(bool enabled) {
     return ESP_OK;
 }
 
+esp_err_t cm_master_set_ramp_mode(uint8_t ramp_mode) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    bool changed = (g_target_ramp_mode != ramp_mode);
+    g_target_ramp_mode = ramp_mode;
+    xSemaphoreGive(g_master_mutex);
+    if (changed) {
+        ESP_LOGI(TAG, "Perfil de rampa: %u", ramp_mode);
+    }
+    return ESP_OK;
+}
+
+esp_err_t cm_master_run_profile(const cm_profile_seg_msg_t *segs, uint8_t count) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (segs == NULL || count == 0 || count > CM_PROFILE_MAX_SEGMENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    uint8_t id = (g_profile.last_id == 255) ? 1 : g_profile.last_id + 1;
+    for (uint8_t i = 0; i < count; i++) {
+        g_profile.segs[i] = segs[i];
+        g_profile.segs[i].profile_id = id;
+        g_profile.segs[i].index = i;
+    }
+    g_profile.count = count;
+    g_profile.id = id;
+    g_profile.last_id = id;
+    g_profile.pending = true;
+    g_profile.sends = 0;
+    g_profile.cycles = 0;
+    g_profile.status = (cm_master_profile_status_t){ .state = CM_PROFILE_IDLE };
+    xSemaphoreGive(g_master_mutex);
+
+    ESP_LOGI(TAG, "Perfil %u: %u segmentos", id, count);
+    return ESP_OK;
+}
+
+esp_err_t cm_master_cancel_profile(void) {
+    if (g_master_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    bool active = (g_profile.id != 0);
+    if (active) {
+        g_profile.id = 0;
+        g_profile.pending = false;
+        g_target_incline_pct = g_current_incline_pct;
+    }
+    xSemaphoreGive(g_master_mutex);
+
+    if (active) {
+        ESP_LOGI(TAG, "Perfil cancelado");
+    }
+    return ESP_OK;
+}
+
+bool cm_master_get_profile_status(cm_master_profile_status_t *out) {
+    if (g_master_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(g_master_mutex, portMAX_DELAY);
+    bool requested = (g_profile.last_id != 0);
+    *out = g_profile.status;
+    xSemaphoreGive(g_master_mutex);
+    return requested;
+}
+
 bool cm_master_get_incline_sensor_fault(void) {
     if (g_master_mutex == NULL) {
         return false;  // No inicializado aún
@@ -465,3 +1062,28 @@ bool cm_master_get_incline_sensor_fault(void) {
     xSemaphoreGive(g_master_mutex);
     return fault;
 }
+
+// ============================================================================
+// SINCRONIZACIÓN DE RELOJ (API de nodo de cm_clock.h)
+// ============================================================================
+
+int64_t cm_time_to_peer(int64_t local_us) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_t clock = g_clock;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return cm_clock_to_peer(&clock, local_us);
+}
+
+int64_t cm_time_from_peer(int64_t peer_us) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    cm_clock_t clock = g_clock;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return cm_clock_from_peer(&clock, peer_us);
+}
+
+bool cm_time_peer_synced(void) {
+    taskENTER_CRITICAL(&g_clock_lock);
+    bool valid = g_clock.valid;
+    taskEXIT_CRITICAL(&g_clock_lock);
+    return valid;
+}
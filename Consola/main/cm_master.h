@@ -12,6 +12,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "cm_blackbox_format.h"
+#include "cm_schema.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,6 +84,16 @@ esp_err_t cm_master_set_incline(float incline_pct);
  */
 esp_err_t cm_master_calibrate_incline(void);
 
+/**
+ * @brief Envía EMERGENCY_STOP al esclavo y fija la velocidad objetivo a 0
+ *
+ * Base para el VFD sin esperar al siguiente SYNC y no vuelve a marchar hasta
+ * recibir 0 km/h.
+ *
+ * @return ESP_OK si éxito, error en caso contrario
+ */
+esp_err_t cm_master_emergency_stop(void);
+
 /**
  * @brief Obtiene el estado de comunicación
  *
@@ -143,6 +155,17 @@ esp_err_t cm_master_set_relay(uint8_t relay_id, uint8_t state);
  */
 esp_err_t cm_master_set_training_mode(bool enabled);
 
+/**
+ * @brief Establece el perfil de rampa del VFD (va en cada SYNC)
+ *
+ * Llamar antes de cm_master_set_speed() para que la consigna salga ya con su
+ * perfil: Base programa la rampa en el VFD y este la recorre solo.
+ *
+ * @param ramp_mode CM_RAMP_NORMAL, CM_RAMP_STOP o CM_RAMP_COOLDOWN
+ * @return ESP_OK si éxito, error en caso contrario
+ */
+esp_err_t cm_master_set_ramp_mode(uint8_t ramp_mode);
+
 /**
  * @brief Obtiene el estado del sensor de fin de carrera de inclinación
  *
@@ -150,6 +173,131 @@ esp_err_t cm_master_set_training_mode(bool enabled);
  */
 bool cm_master_get_incline_sensor_fault(void);
 
+// ============================================================================
+// PERFILES DE MOVIMIENTO (ejecutados por Base)
+// ============================================================================
+
+/** Estado del último perfil pedido, según DATA */
+typedef struct {
+    uint8_t state;              ///< CM_PROFILE_* (IDLE mientras Base no lo confirma)
+    uint8_t segment;            ///< Segmento en curso
+    uint32_t left_ms;           ///< Tiempo que le queda al segmento
+} cm_master_profile_status_t;
+
+/**
+ * @brief Pide a Base que ejecute un perfil de segmentos de velocidad e inclinación
+ *
+ * Las líneas PSEG/PROFILE salen detrás del SYNC y se repiten hasta que DATA
+ * confirma el perfil. Mientras Base lo ejecuta, las consignas de velocidad e
+ * inclinación del SYNC no se aplican; al terminar pasan a ser las del último
+ * segmento (Base ya las mantiene).
+ *
+ * @param segs  Segmentos (profile_id e index los rellena esta función)
+ * @param count 1..CM_PROFILE_MAX_SEGMENTS
+ * @return ESP_OK si se aceptó, ESP_ERR_INVALID_ARG o ESP_ERR_INVALID_STATE
+ */
+esp_err_t cm_master_run_profile(const cm_profile_seg_msg_t *segs, uint8_t count);
+
+/**
+ * @brief Cancela el perfil pedido (lo cancela el siguiente SYNC)
+ *
+ * La consigna de inclinación pasa a ser la inclinación real: el actuador se
+ * queda donde está. La de velocidad la fija el llamante.
+ */
+esp_err_t cm_master_cancel_profile(void);
+
+/**
+ * @brief Estado del último perfil pedido
+ *
+ * @return false si no se ha pedido ningún perfil
+ */
+bool cm_master_get_profile_status(cm_master_profile_status_t *out);
+
+// ============================================================================
+// CAJA NEGRA DE BASE
+// ============================================================================
+
+typedef enum {
+    CM_MASTER_BBOX_IDLE,        ///< Sin lectura pedida
+    CM_MASTER_BBOX_FETCHING,    ///< Leyendo líneas tras cada SYNC
+    CM_MASTER_BBOX_DONE,        ///< Volcado completo (cm_master_blackbox_get)
+    CM_MASTER_BBOX_EMPTY,       ///< Base no tiene ese volcado
+    CM_MASTER_BBOX_FAILED       ///< Base dejó de responder o sin memoria
+} cm_master_bbox_state_t;
+
+/**
+ * @brief Empieza a leer un volcado de la caja negra de Base
+ *
+ * La lectura va intercalada con los SYNC (unas pocas líneas BLACKBOX por
+ * ciclo), así que no afecta al control: un volcado de 30 s tarda ~8 s.
+ * Al terminar se resume por log (los registros con nivel DEBUG).
+ *
+ * @param dump 0 = volcado más reciente, 1 = el anterior...
+ * @return ESP_OK si se inició, ESP_ERR_INVALID_STATE si no está inicializado
+ */
+esp_err_t cm_master_blackbox_fetch(uint16_t dump);
+
+/**
+ * @brief Estado de la lectura en curso o de la última
+ *
+ * @param[out] progress_pct Porcentaje de líneas recibidas (puede ser NULL)
+ */
+cm_master_bbox_state_t cm_master_blackbox_state(uint8_t *progress_pct);
+
+/**
+ * @brief Copia un volcado leído completo
+ *
+ * @param[out] header  Cabecera del volcado
+ * @param[out] records Al menos max_records registros, del más antiguo al más reciente
+ * @param max_records  Capacidad de records
+ * @return Registros copiados, 0 si no hay un volcado completo
+ */
+size_t cm_master_blackbox_get(cm_bbox_header_t *header, cm_bbox_record_t *records, size_t max_records);
+
+/**
+ * @brief Cabecera y registro del disparo de un volcado leído completo
+ *
+ * Sin copiar el volcado entero (pantalla de servicio).
+ *
+ * @param[out] trigger Registro del disparo (a cero si el volcado está vacío)
+ * @return false si no hay un volcado completo
+ */
+bool cm_master_blackbox_trigger(cm_bbox_header_t *header, cm_bbox_record_t *trigger);
+
+// ============================================================================
+// ESTADÍSTICAS DE BASE (pantalla de servicio)
+// ============================================================================
+
+/** Última respuesta STATS completa de Base (formato en cm_schema.h) */
+typedef struct {
+    cm_stats_sys_msg_t sys;
+    cm_stats_task_msg_t tasks[CM_STATS_MAX_TASKS];  ///< sys.task_count válidas
+    cm_stats_slot_msg_t slots[CM_STATS_MAX_SLOTS];  ///< sys.slot_count válidas
+    cm_stats_mb_msg_t mb;
+    cm_stats_link_msg_t link;
+    cm_stats_nvs_msg_t nvs;
+} cm_master_base_stats_t;
+
+/**
+ * @brief Pide a Base sus estadísticas de ejecución
+ *
+ * Base responde en segundo plano, sin retrasar el DATA de los SYNC; la
+ * respuesta completa llega en unos 100 ms. El reparto de CPU se refiere al
+ * intervalo desde la petición anterior: pedir a ritmo fijo.
+ *
+ * @return ESP_OK si se envió, ESP_ERR_INVALID_STATE si no está inicializado
+ */
+esp_err_t cm_master_request_stats(void);
+
+/**
+ * @brief Copia la última respuesta STATS completa
+ *
+ * @param[out] out    Estadísticas
+ * @param[out] age_ms Antigüedad de la respuesta (puede ser NULL)
+ * @return false si todavía no ha llegado ninguna respuesta completa
+ */
+bool cm_master_get_base_stats(cm_master_base_stats_t *out, uint32_t *age_ms);
+
 #ifdef __cplusplus
 }
 #endif
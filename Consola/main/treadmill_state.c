@@ -11,7 +11,6 @@ TreadmillState g_treadmill_state = {
     .resume_from_stop = false,
     .speed_before_stop = 0.0f,
     .target_speed = 0.0f,
-    .cooldown_climb_ramp_rate = 0.0f,
     .real_pulse = 0,
     .ble_connected = false,
     .sim_pulse = 80,
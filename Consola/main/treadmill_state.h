@@ -36,7 +36,6 @@ typedef struct {
     bool resume_from_stop;
     float speed_before_stop;
     float target_speed;
-    float cooldown_climb_ramp_rate;
 
     // Data from BLE Heart Rate monitor
     volatile uint16_t real_pulse;
@@ -23,8 +23,27 @@ const char *TAG = "UI";  // Accesible desde ui_wifi.c
 
 
 
-const float COOLDOWN_RAMP_RATE_KMH_S = 10.0f / 120.0f; // Rampa lenta de 2 minutos para el cool down
-const float STOP_RAMP_RATE_KMH_S = 5.0f;    // Rampa rápida para detener/reanudar
+/**
+ * @brief Cambia el modo de rampa y el perfil que Base programa en el VFD
+ *
+ * Con g_state_mutex tomado y antes de cm_master_set_speed(): la rampa la hace
+ * el VFD con el perfil (pausa 5 km/h/s, enfriamiento CM_RAMP_COOLDOWN_KMH_S).
+ */
+static void set_ramp_mode(ramp_mode_t mode) {
+    g_treadmill_state.ramp_mode = mode;
+    switch (mode) {
+        case RAMP_MODE_STOP_STOP:
+        case RAMP_MODE_STOP_RESUME:
+            cm_master_set_ramp_mode(CM_RAMP_STOP);
+            break;
+        case RAMP_MODE_COOLDOWN_STOP:
+            cm_master_set_ramp_mode(CM_RAMP_COOLDOWN);
+            break;
+        default:
+            cm_master_set_ramp_mode(CM_RAMP_NORMAL);
+            break;
+    }
+}
 
 //==================================================================================
 // 1B. FUNCIONES DE PERSISTENCIA (NVS)
@@ -164,6 +183,14 @@ static lv_obj_t *label_pulse_set;
 static lv_obj_t *label_kcal_set;
 static lv_obj_t *ta_info_set;
 
+// -- Pantalla de servicio (estadísticas de Base) --
+#define SERVICE_REFRESH_MS 2000
+static lv_obj_t *scr_service;
+static lv_obj_t *label_service_tasks;
+static lv_obj_t *label_service_system;
+static lv_obj_t *label_service_bbox;
+static lv_timer_t *service_timer = NULL;
+
 // WiFi screens are now handled in ui_wifi.c
 
 //==================================================================================
@@ -190,6 +217,7 @@ static void ble_device_btn_delete_cb(lv_event_t *e);
 static void create_main_screen(void);
 static void create_set_screen(void);
 static void create_wax_screen(void);
+static void create_service_screen(void);
 static void _switch_to_set_screen_internal(set_mode_t mode);
 static void _switch_to_main_screen_internal(void);
 static void _update_set_display_text_internal(void);
@@ -204,6 +232,10 @@ static void wifi_selector_event_cb(lv_event_t *e);
 static void wax_event_cb(lv_event_t *e);
 static void apply_wax_event_cb(lv_event_t *e);
 static void wax_back_event_cb(lv_event_t *e);
+static void service_event_cb(lv_event_t *e);
+static void service_back_event_cb(lv_event_t *e);
+static void service_timer_cb(lv_timer_t *timer);
+static void service_bbox_event_cb(lv_event_t *e);
 
 
 //==================================================================================
@@ -290,10 +322,8 @@ void ui_update_task(void *pvParameter) {
         float real_incline_from_slave = cm_master_get_current_incline();
         g_treadmill_state.speed_kmh = real_speed_from_slave;
 
-        // Actualizar inclinación real, excepto en modo cooldown donde se gestiona localmente
-        if (g_treadmill_state.ramp_mode != RAMP_MODE_COOLDOWN_STOP) {
-            g_treadmill_state.climb_percent = real_incline_from_slave;
-        }
+        // Actualizar inclinación real (también en cool down: la rampa la hace Base)
+        g_treadmill_state.climb_percent = real_incline_from_slave;
 
         // --- Actualizar estados de ventiladores desde el esclavo ---
         uint8_t head_fan_from_slave = cm_master_get_head_fan_state();
@@ -310,9 +340,10 @@ void ui_update_task(void *pvParameter) {
         if (incline_sensor_fault && !system_locked_due_to_sensor_fault) {
             system_locked_due_to_sensor_fault = true;
 
-            // Detener la cinta inmediatamente
+            // Detener la cinta inmediatamente: EMERGENCY_STOP para el VFD sin
+            // esperar al siguiente SYNC (y fija la consigna a 0 km/h)
             g_treadmill_state.target_speed = 0.0f;
-            cm_master_set_speed(0.0f);
+            cm_master_emergency_stop();
 
             // Mostrar mensaje de error crítico
             bsp_display_lock(0);
@@ -350,42 +381,11 @@ void ui_update_task(void *pvParameter) {
         float speed_diff = g_treadmill_state.target_speed - g_treadmill_state.speed_kmh;
         if (fabs(speed_diff) < 0.05f) {
             if (g_treadmill_state.ramp_mode != RAMP_MODE_NORMAL) {
-                g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL;
+                set_ramp_mode(RAMP_MODE_NORMAL);
                 g_treadmill_state.is_resuming = false;
             }
         }
 
-        // --- Lógica de Rampa de Velocidad (Cool Down) ---
-        // En modo cooldown, reducir la velocidad gradualmente
-        static uint32_t last_cooldown_speed_update_ms = 0;
-        if (g_treadmill_state.ramp_mode == RAMP_MODE_COOLDOWN_STOP && g_treadmill_state.target_speed == 0.0f) {
-            // Enviar comandos de velocidad periódicamente durante el cooldown
-            uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            if (now_ms - last_cooldown_speed_update_ms >= 500) {  // Cada 500ms
-                last_cooldown_speed_update_ms = now_ms;
-                // Calcular velocidad objetivo actual basada en la rampa de cooldown
-                float current_speed = g_treadmill_state.speed_kmh;
-                if (current_speed > 0.1f) {
-                    float speed_decrement = COOLDOWN_RAMP_RATE_KMH_S * 0.5f;  // 500ms de decremento
-                    float new_target = current_speed - speed_decrement;
-                    if (new_target < 0) new_target = 0;
-                    cm_master_set_speed(new_target);
-                }
-            }
-        }
-
-        // --- Lógica de Rampa de Inclinación (Cool Down) ---
-        // En modo cooldown, la inclinación se gestiona localmente
-        if (g_treadmill_state.ramp_mode == RAMP_MODE_COOLDOWN_STOP && g_treadmill_state.climb_percent > 0) {
-            float decrement = g_treadmill_state.cooldown_climb_ramp_rate * (UI_UPDATE_INTERVAL_MS / 1000.0f);
-            g_treadmill_state.climb_percent -= decrement;
-            if (g_treadmill_state.climb_percent < 0) {
-                g_treadmill_state.climb_percent = 0;
-            }
-            // Enviar comando al esclavo con la nueva inclinación
-            cm_master_set_incline(g_treadmill_state.climb_percent);
-        }
-
         // --- Time and Data updates ---
         if (g_treadmill_state.speed_kmh > 0.0f) {
             if (was_stopped) {
@@ -1389,8 +1389,8 @@ static void create_training_select_screen(void) {
     lv_obj_set_style_pad_bottom(right_col, margin, 0);
     lv_obj_set_style_pad_gap(right_col, 20, 0); // Add a small gap between buttons
 
-    // Create only the 3 required buttons
-    for (int i = 1; i <= 3; i++) {
+    // WIFI, BLE, WAX y BASE (servicio)
+    for (int i = 1; i <= 4; i++) {
         btn = lv_btn_create(right_col);
         lv_obj_set_size(btn, right_btn_w, btn_h);
         lv_obj_set_user_data(btn, (void*)i);
@@ -1400,9 +1400,11 @@ static void create_training_select_screen(void) {
             lv_obj_add_event_cb(btn, wifi_selector_event_cb, LV_EVENT_CLICKED, NULL);
         } else if (i == 2) {
             lv_obj_add_event_cb(btn, ble_scan_button_event_cb, LV_EVENT_CLICKED, NULL);
-        } else {
+        } else if (i == 3) {
             // WAX button
             lv_obj_add_event_cb(btn, wax_event_cb, LV_EVENT_CLICKED, NULL);
+        } else {
+            lv_obj_add_event_cb(btn, service_event_cb, LV_EVENT_CLICKED, NULL);
         }
 
         l = lv_label_create(btn);
@@ -1413,8 +1415,10 @@ static void create_training_select_screen(void) {
             lv_label_set_text(l, "WIFI");
         } else if (i == 2) {
             lv_label_set_text(l, "BLE");
-        } else { // i == 3
+        } else if (i == 3) {
             lv_label_set_text(l, "WAX");
+        } else { // i == 4
+            lv_label_set_text(l, "BASE");
         }
         lv_obj_center(l);
     }
@@ -1686,6 +1690,57 @@ static void create_wax_screen(void) {
     lv_obj_center(l);
 }
 
+static void create_service_screen(void) {
+    scr_service = lv_obj_create(NULL);
+    lv_obj_set_size(scr_service, LV_PCT(100), LV_PCT(100));
+    lv_obj_clear_flag(scr_service, LV_OBJ_FLAG_SCROLLABLE);
+
+    // Título
+    lv_obj_t *title = lv_label_create(scr_service);
+    lv_obj_add_style(title, &style_title, 0);
+    lv_label_set_text(title, "BASE - SERVICIO");
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+    // Columna izquierda: tareas; derecha: ejecutivo, Modbus, enlace, NVS y sistema
+    label_service_tasks = lv_label_create(scr_service);
+    lv_obj_set_style_text_font(label_service_tasks, &lv_font_montserrat_18, 0);
+    lv_obj_set_width(label_service_tasks, 600);
+    lv_label_set_text(label_service_tasks, "");
+    lv_obj_align(label_service_tasks, LV_ALIGN_TOP_LEFT, 20, 80);
+
+    label_service_system = lv_label_create(scr_service);
+    lv_obj_set_style_text_font(label_service_system, &lv_font_montserrat_18, 0);
+    lv_obj_set_width(label_service_system, 620);
+    lv_label_set_text(label_service_system, "");
+    lv_obj_align(label_service_system, LV_ALIGN_TOP_RIGHT, -20, 80);
+
+    // Caja negra: último volcado de Base y su registro de disparo
+    label_service_bbox = lv_label_create(scr_service);
+    lv_obj_set_style_text_font(label_service_bbox, &lv_font_montserrat_18, 0);
+    lv_obj_set_width(label_service_bbox, 600);
+    lv_label_set_text(label_service_bbox, "");
+    lv_obj_align(label_service_bbox, LV_ALIGN_BOTTOM_LEFT, 20, -70);
+
+    lv_obj_t *btn = lv_btn_create(scr_service);
+    lv_obj_set_size(btn, 260, 50);
+    lv_obj_align(btn, LV_ALIGN_BOTTOM_LEFT, 20, -10);
+    lv_obj_add_event_cb(btn, service_bbox_event_cb, LV_EVENT_CLICKED, NULL);
+    lv_obj_t *l = lv_label_create(btn);
+    lv_obj_add_style(l, &style_btn_text, 0);
+    lv_label_set_text(l, "Leer caja negra");
+    lv_obj_center(l);
+
+    // Botón Volver
+    btn = lv_btn_create(scr_service);
+    lv_obj_set_size(btn, 150, 50);
+    lv_obj_align(btn, LV_ALIGN_BOTTOM_MID, 0, -10);
+    lv_obj_add_event_cb(btn, service_back_event_cb, LV_EVENT_CLICKED, NULL);
+    l = lv_label_create(btn);
+    lv_obj_add_style(l, &style_btn_text, 0);
+    lv_label_set_text(l, "Volver");
+    lv_obj_center(l);
+}
+
 static void create_shutdown_screen(void) {
     scr_shutdown = lv_obj_create(NULL);
     lv_obj_set_size(scr_shutdown, LV_PCT(100), LV_PCT(100));
@@ -1809,6 +1864,7 @@ void ui_init(void) {
     create_main_screen();
     create_set_screen();
     create_wax_screen();
+    create_service_screen();
     create_shutdown_screen();
     create_wifi_screens();
     lv_scr_load(scr_training_select);  // Mostrar pantalla de selección al inicio
@@ -1830,10 +1886,10 @@ void ui_speed_inc(void) {
         // Use a small epsilon for float comparison
         if (fabsf(g_treadmill_state.target_speed - g_treadmill_state.speed_kmh) > 0.05f) { // Ramp is active
             new_target_speed = g_treadmill_state.speed_kmh; // Stop at current real speed
-            g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL; // Ensure ramp is stopped
+            set_ramp_mode(RAMP_MODE_NORMAL); // Ensure ramp is stopped
         } else { // No ramp active, or ramp has finished
             new_target_speed = g_treadmill_state.target_speed + 0.1f;
-            g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL; // Ensure ramp is normal
+            set_ramp_mode(RAMP_MODE_NORMAL); // Ensure ramp is normal
         }
 
         if (new_target_speed > MAX_SPEED_KMH) new_target_speed = MAX_SPEED_KMH;
@@ -1862,10 +1918,10 @@ void ui_speed_dec(void) {
         // Use a small epsilon for float comparison
         if (fabsf(g_treadmill_state.target_speed - g_treadmill_state.speed_kmh) > 0.05f) { // Ramp is active
             new_target_speed = g_treadmill_state.speed_kmh; // Stop at current real speed
-            g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL; // Ensure ramp is stopped
+            set_ramp_mode(RAMP_MODE_NORMAL); // Ensure ramp is stopped
         } else { // No ramp active, or ramp has finished
             new_target_speed = g_treadmill_state.target_speed - 0.1f;
-            g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL; // Ensure ramp is normal
+            set_ramp_mode(RAMP_MODE_NORMAL); // Ensure ramp is normal
         }
 
         if (new_target_speed < 0.0f) new_target_speed = 0.0f;
@@ -1951,7 +2007,7 @@ void ui_stop_resume(void) {
         g_treadmill_state.is_resuming = false;
         g_treadmill_state.speed_before_stop = g_treadmill_state.target_speed;
         g_treadmill_state.target_speed = 0.0f;
-        g_treadmill_state.ramp_mode = RAMP_MODE_STOP_STOP;
+        set_ramp_mode(RAMP_MODE_STOP_STOP);
         ESP_LOGI(TAG, "ui_stop_resume: STOP activado");
 
         // Enviar comando de velocidad 0 al slave
@@ -1964,7 +2020,7 @@ void ui_stop_resume(void) {
         g_treadmill_state.resume_from_stop = false;
         float resume_speed = g_treadmill_state.speed_before_stop;
         g_treadmill_state.target_speed = resume_speed;
-        g_treadmill_state.ramp_mode = RAMP_MODE_STOP_RESUME;
+        set_ramp_mode(RAMP_MODE_STOP_RESUME);
         ESP_LOGI(TAG, "ui_stop_resume: RESUME activado");
 
         // Enviar comando de velocidad de reanudación al slave
@@ -2038,32 +2094,43 @@ void ui_cool_down(void) {
         g_treadmill_state.is_resuming = false;
         g_treadmill_state.speed_before_stop = g_treadmill_state.target_speed;
         g_treadmill_state.target_speed = 0.0f;
+        g_treadmill_state.target_climb_percent = 0.0f;
 
-        float time_to_stop_s = g_treadmill_state.speed_before_stop / COOLDOWN_RAMP_RATE_KMH_S;
+        // La inclinación baja a 0 en la primera mitad de la rampa de velocidad
+        float time_to_stop_s = g_treadmill_state.speed_before_stop / CM_RAMP_COOLDOWN_KMH_S;
         float half_time_s = time_to_stop_s / 2.0f;
 
+        set_ramp_mode(RAMP_MODE_COOLDOWN_STOP);
+        // NO modificar buttons_are_stop_mode - se gestiona en ui_update_task
+
+        // Una sola consigna: el VFD baja con la deceleración del perfil de enfriamiento
+        // y Base hace la rampa de inclinación (un perfil de un segmento)
+        xSemaphoreGive(g_state_mutex);
+        cm_master_set_speed(0.0f);
         if (half_time_s > 0.1f) {
-            g_treadmill_state.cooldown_climb_ramp_rate = g_treadmill_state.climb_percent / half_time_s;
+            const cm_profile_seg_msg_t seg = {
+                .duration_ms = (uint32_t)(half_time_s * 1000.0f),
+                .speed_kmh = 0.0f,
+                .incline_pct = 0.0f,
+                .ramp = CM_PROFILE_RAMP_INCLINE,
+            };
+            cm_master_run_profile(&seg, 1);
         } else {
-            g_treadmill_state.climb_percent = 0.0f;
-            g_treadmill_state.cooldown_climb_ramp_rate = 0.0f;
+            cm_master_set_incline(0.0f);
         }
-
-        g_treadmill_state.ramp_mode = RAMP_MODE_COOLDOWN_STOP;
-        // NO modificar buttons_are_stop_mode - se gestiona en ui_update_task
-
-        // Nota: No enviamos cm_master_set_speed aquí porque la velocidad
-        // se irá reduciendo gradualmente en ui_update_task
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
     } else {
         g_treadmill_state.is_cooling_down = false;
         g_treadmill_state.is_resuming = true;
         g_treadmill_state.resume_from_stop = false;
         float resume_speed = g_treadmill_state.speed_before_stop;
         g_treadmill_state.target_speed = resume_speed;
-        g_treadmill_state.ramp_mode = RAMP_MODE_COOLDOWN_RESUME;
+        set_ramp_mode(RAMP_MODE_COOLDOWN_RESUME);
 
-        // Enviar comando de velocidad de reanudación al slave
+        // Enviar comando de velocidad de reanudación al slave (la inclinación
+        // se queda donde la dejó la rampa de cool down)
         xSemaphoreGive(g_state_mutex);
+        cm_master_cancel_profile();
         cm_master_set_speed(resume_speed);
         xSemaphoreTake(g_state_mutex, portMAX_DELAY);
     }
@@ -2263,7 +2330,7 @@ void ui_confirm_set_value(void) {
             // Velocidad: 3 dígitos divididos por 10 (ej: "051" = 5.1 km/h)
             final_value = atof(g_treadmill_state.set_buffer) / 10.0f;
             if (final_value > MAX_SPEED_KMH) final_value = MAX_SPEED_KMH;
-            g_treadmill_state.ramp_mode = RAMP_MODE_NORMAL;
+            set_ramp_mode(RAMP_MODE_NORMAL);
             g_treadmill_state.target_speed = final_value;
         } else { // SET_MODE_CLIMB
             // Inclinación: 2 dígitos sin dividir (ej: "05" = 5%)
@@ -2463,6 +2530,176 @@ static void wax_back_event_cb(lv_event_t *e) {
     bsp_display_unlock();
 }
 
+/**
+ * @brief Muestra el estado de la lectura de la caja negra y, leída, el registro del disparo
+ */
+static void service_bbox_render(void) {
+    static const char *const reasons[] = {
+        [CM_BBOX_REASON_WATCHDOG] = "watchdog",
+        [CM_BBOX_REASON_SENSOR_FAULT] = "fin de carrera",
+        [CM_BBOX_REASON_ESTOP_INPUT] = "seta",
+        [CM_BBOX_REASON_ESTOP_LINK] = "EMERGENCY_STOP",
+        [CM_BBOX_REASON_SAFE_STATE] = "safe state",
+        [CM_BBOX_REASON_RESET] = "reinicio",
+    };
+    cm_bbox_header_t hdr;
+    cm_bbox_record_t trg;
+    char buf[256];
+    uint8_t pct;
+
+    switch (cm_master_blackbox_state(&pct)) {
+        case CM_MASTER_BBOX_IDLE:
+            lv_label_set_text(label_service_bbox, "CAJA NEGRA\nSin leer");
+            break;
+        case CM_MASTER_BBOX_FETCHING:
+            lv_label_set_text_fmt(label_service_bbox, "CAJA NEGRA\nLeyendo... %u%%", pct);
+            break;
+        case CM_MASTER_BBOX_EMPTY:
+            lv_label_set_text(label_service_bbox, "CAJA NEGRA\nBase no tiene ningun volcado");
+            break;
+        case CM_MASTER_BBOX_FAILED:
+            lv_label_set_text(label_service_bbox, "CAJA NEGRA\nLectura fallida (Base no responde)");
+            break;
+        case CM_MASTER_BBOX_DONE:
+            if (!cm_master_blackbox_trigger(&hdr, &trg)) {
+                break;
+            }
+            const char *reason = (hdr.reason < sizeof(reasons) / sizeof(reasons[0]) && reasons[hdr.reason])
+                                 ? reasons[hdr.reason] : "?";
+            // snprintf y no lv_label_set_text_fmt: el printf de LVGL va sin coma flotante
+            snprintf(buf, sizeof(buf),
+                     "CAJA NEGRA #%lu: %s, %u muestras, %lu perdidas\n"
+                     "Disparo: vel %.2f/%.2f km/h, incl %.2f/%.2f %%\n"
+                     "VFD %.2f/%.2f Hz, flags 0x%02X, reles 0x%02X, eventos 0x%02X",
+                     hdr.dump_seq, reason, hdr.record_count, hdr.dropped,
+                     trg.real_speed / 100.0f, trg.target_speed / 100.0f,
+                     trg.real_incline / 100.0f, trg.target_incline / 100.0f,
+                     trg.vfd_real_freq / 100.0f, trg.vfd_target_freq / 100.0f,
+                     trg.flags, trg.relays, trg.events);
+            lv_label_set_text(label_service_bbox, buf);
+            break;
+    }
+}
+
+/**
+ * @brief Muestra la última respuesta STATS de Base
+ */
+static void service_render(void) {
+    static cm_master_base_stats_t st;  // ~2 KB: fuera de la pila de la tarea LVGL
+    static char buf[2048];
+    uint32_t age_ms;
+
+    service_bbox_render();
+
+    if (!cm_master_get_base_stats(&st, &age_ms)) {
+        lv_label_set_text(label_service_tasks,
+                          cm_master_is_connected() ? "Esperando respuesta de Base..." : "Base desconectada");
+        lv_label_set_text(label_service_system, "");
+        return;
+    }
+
+    // Tareas de más a menos CPU
+    uint8_t order[CM_STATS_MAX_TASKS];
+    uint8_t n = st.sys.task_count < CM_STATS_MAX_TASKS ? st.sys.task_count : CM_STATS_MAX_TASKS;
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t j = i;
+        while (j > 0 && st.tasks[order[j - 1]].cpu_permille < st.tasks[i].cpu_permille) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int len = snprintf(buf, sizeof(buf), "TAREAS (CPU en %lu.%lu s, pila libre min.)\n",
+                       st.sys.window_ms / 1000, (st.sys.window_ms % 1000) / 100);
+    if (n == 0) {
+        len += snprintf(buf + len, sizeof(buf) - len, "Base sin CONFIG_FREERTOS_USE_TRACE_FACILITY\n");
+    }
+    for (uint8_t k = 0; k < n && len < (int)sizeof(buf); k++) {
+        const cm_stats_task_msg_t *t = &st.tasks[order[k]];
+        char cpu[12] = "--";
+        if (st.sys.runtime_stats) {
+            snprintf(cpu, sizeof(cpu), "%lu.%lu%%", t->cpu_permille / 10, t->cpu_permille % 10);
+        }
+        char core[4] = "*";
+        if (t->core != 255) {
+            snprintf(core, sizeof(core), "%u", t->core);
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "%-16s %6s  %5lu B  p%u  n%s\n",
+                        t->name.s, cpu, t->stack_free, t->prio, core);
+    }
+    lv_label_set_text(label_service_tasks, buf);
+
+    len = snprintf(buf, sizeof(buf), "EJECUTIVO (jitter / ejecucion, media-max. us)\n");
+    for (uint8_t i = 0; i < st.sys.slot_count && i < CM_STATS_MAX_SLOTS && len < (int)sizeof(buf); i++) {
+        const cm_stats_slot_msg_t *sl = &st.slots[i];
+        len += snprintf(buf + len, sizeof(buf) - len, "%-10s %lu-%lu / %lu-%lu  excesos %lu\n",
+                        sl->name.s, sl->jitter_avg_us, sl->jitter_max_us,
+                        sl->exec_avg_us, sl->exec_max_us, sl->overruns);
+    }
+    if (len < (int)sizeof(buf)) {
+        snprintf(buf + len, sizeof(buf) - len,
+                 "Marcos excedidos: %lu\n\n"
+                 "MODBUS\n%lu transacciones, %lu errores, %lu reintentos\n(%lu timeouts, %lu CRC/trama/excepcion)\n"
+                 "Respuesta p50/p99 %lu/%lu ms, timeout %lu ms\n\n"
+                 "ENLACE\nUART: %lu desbordes, %lu trama/paridad\n"
+                 "Lineas largas %lu, tramas invalidas %lu\n"
+                 "Watchdog: %lu disparos (retraso max. %lu us)\n\n"
+                 "NVS\n%lu escrituras, %lu errores, commit max. %lu us\n\n"
+                 "SISTEMA\nEncendida %luh %02lum, heap %lu KB (min. %lu KB)\n"
+                 "Respuesta de hace %lu ms",
+                 st.sys.frame_overruns,
+                 st.mb.transactions, st.mb.errors, st.mb.retries, st.mb.timeouts, st.mb.invalid,
+                 st.mb.rtt_p50_ms, st.mb.rtt_p99_ms, st.mb.timeout_ms,
+                 st.link.uart_overruns, st.link.uart_errors,
+                 st.link.line_overflows, st.link.frames_bad,
+                 st.link.watchdog_trips, st.link.watchdog_late_max_us,
+                 st.nvs.writes, st.nvs.errors, st.nvs.commit_max_us,
+                 st.sys.uptime_s / 3600, (st.sys.uptime_s % 3600) / 60,
+                 st.sys.heap_free / 1024, st.sys.heap_min / 1024,
+                 age_ms);
+    }
+    lv_label_set_text(label_service_system, buf);
+}
+
+static void service_timer_cb(lv_timer_t *timer) {
+    // Muestra la respuesta anterior y pide la siguiente: ventana de CPU = SERVICE_REFRESH_MS
+    service_render();
+    cm_master_request_stats();
+}
+
+static void service_event_cb(lv_event_t *e) {
+    audio_play_beep();
+    cm_master_request_stats();
+    bsp_display_lock(0);
+    service_render();
+    if (service_timer == NULL) {
+        service_timer = lv_timer_create(service_timer_cb, SERVICE_REFRESH_MS, NULL);
+    }
+    lv_scr_load(scr_service);
+    bsp_display_unlock();
+}
+
+static void service_bbox_event_cb(lv_event_t *e) {
+    // Volcado más reciente; la lectura va con los SYNC y el timer muestra el avance
+    audio_play_beep();
+    cm_master_blackbox_fetch(0);
+    bsp_display_lock(0);
+    service_bbox_render();
+    bsp_display_unlock();
+}
+
+static void service_back_event_cb(lv_event_t *e) {
+    audio_play_beep();
+    bsp_display_lock(0);
+    if (service_timer) {
+        lv_timer_del(service_timer);
+        service_timer = NULL;
+    }
+    lv_scr_load(scr_training_select);
+    bsp_display_unlock();
+}
+
 void ui_weight_entry(void) {
     ESP_LOGI(TAG, "ui_weight_entry: buttons_are_stop_mode=%d", buttons_are_stop_mode);
     // Verificar si los botones están en modo STOP/COOL DOWN
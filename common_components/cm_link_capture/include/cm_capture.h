@@ -0,0 +1,75 @@
+/**
+ * @file cm_capture.h
+ * @brief Grabador de tráfico del enlace RS485 Consola <-> Base
+ *
+ * Guarda cada línea enviada/recibida con su timestamp (esp_timer) en un
+ * buffer circular. El volcado a flash lo realiza una tarea de baja
+ * prioridad para no bloquear las tareas de comunicación.
+ *
+ * Con CONFIG_CM_CAPTURE_ENABLE desactivado todas las funciones son
+ * inline vacías y no ocupan memoria.
+ */
+
+#ifndef CM_CAPTURE_H
+#define CM_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "cm_capture_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_CM_CAPTURE_ENABLE
+
+/**
+ * @brief Reserva el buffer circular y crea la tarea de volcado
+ *
+ * @param node CM_CAPTURE_NODE_CONSOLA o CM_CAPTURE_NODE_BASE
+ * @return ESP_OK, o ESP_ERR_NO_MEM si no hay memoria para el anillo
+ */
+esp_err_t cm_capture_init(uint8_t node);
+
+/**
+ * @brief Registra una trama (seguro desde cualquier tarea, no bloquea)
+ *
+ * @param dir CM_CAPTURE_DIR_TX / CM_CAPTURE_DIR_RX
+ * @param data Contenido de la línea (sin '\n' obligatorio)
+ * @param len Longitud de data
+ * @param flags CM_CAPTURE_FLAG_*
+ */
+void cm_capture_record(uint8_t dir, const void *data, size_t len, uint8_t flags);
+
+/**
+ * @brief Solicita un volcado asíncrono del anillo a flash
+ *
+ * Durante el volcado el anillo queda congelado (las tramas nuevas se
+ * descartan) para que la captura refleje el momento del fallo.
+ */
+void cm_capture_request_dump(void);
+
+/**
+ * @brief Número de tramas actualmente en el anillo
+ */
+size_t cm_capture_count(void);
+
+#else
+
+static inline esp_err_t cm_capture_init(uint8_t node) { (void)node; return ESP_OK; }
+static inline void cm_capture_record(uint8_t dir, const void *data, size_t len, uint8_t flags) {
+    (void)dir; (void)data; (void)len; (void)flags;
+}
+static inline void cm_capture_request_dump(void) {}
+static inline size_t cm_capture_count(void) { return 0; }
+
+#endif // CONFIG_CM_CAPTURE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_CAPTURE_H
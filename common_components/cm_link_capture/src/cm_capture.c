@@ -0,0 +1,228 @@
+/**
+ * @file cm_capture.c
+ * @brief Implementación del grabador de tráfico RS485
+ */
+
+#include "cm_capture.h"
+
+#if CONFIG_CM_CAPTURE_ENABLE
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include <string.h>
+
+static const char *TAG = "CM_CAPTURE";
+
+// ============================================================================
+// CONSTANTES
+// ============================================================================
+
+#define CAPTURE_RECORDS          CONFIG_CM_CAPTURE_RECORDS
+#define CAPTURE_DUMP_CHUNK       8       // Registros copiados por escritura a flash
+#define CAPTURE_DUMP_TASK_STACK  3072
+#define CAPTURE_DUMP_TASK_PRIO   2       // Por debajo de todas las tareas de control
+
+// ============================================================================
+// VARIABLES PRIVADAS
+// ============================================================================
+
+/** Anillo de registros (PSRAM si existe) */
+static cm_capture_record_t *s_ring = NULL;
+
+/** Protege s_head/s_count/s_overwritten/s_frozen */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t s_head = 0;           ///< Próxima posición a escribir
+static size_t s_count = 0;          ///< Registros válidos
+static uint32_t s_overwritten = 0;  ///< Registros sobrescritos desde el último volcado
+static bool s_frozen = false;       ///< Anillo congelado durante el volcado
+static uint8_t s_node = 0;
+
+static TaskHandle_t s_dump_task_handle = NULL;
+
+// ============================================================================
+// VOLCADO A FLASH
+// ============================================================================
+
+static esp_err_t dump_to_partition(void) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           CONFIG_CM_CAPTURE_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "Partición '%s' no encontrada", CONFIG_CM_CAPTURE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Instantánea de índices (el anillo ya está congelado)
+    taskENTER_CRITICAL(&s_lock);
+    size_t count = s_count;
+    size_t start = (s_head + CAPTURE_RECORDS - s_count) % CAPTURE_RECORDS;
+    uint32_t overwritten = s_overwritten;
+    taskEXIT_CRITICAL(&s_lock);
+
+    size_t max_records = (part->size - sizeof(cm_capture_header_t)) / sizeof(cm_capture_record_t);
+    if (count > max_records) {
+        // Conservar lo más reciente
+        start = (start + (count - max_records)) % CAPTURE_RECORDS;
+        overwritten += count - max_records;
+        count = max_records;
+    }
+
+    size_t total = sizeof(cm_capture_header_t) + count * sizeof(cm_capture_record_t);
+    size_t erase_size = (total + part->erase_size - 1) / part->erase_size * part->erase_size;
+    esp_err_t err = esp_partition_erase_range(part, 0, erase_size);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error borrando partición: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    cm_capture_header_t header = {
+        .magic = CM_CAPTURE_MAGIC,
+        .version = CM_CAPTURE_VERSION,
+        .record_size = sizeof(cm_capture_record_t),
+        .record_count = count,
+        .overwritten = overwritten,
+        .node = s_node,
+    };
+    err = esp_partition_write(part, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error escribiendo cabecera: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Copiar a RAM interna por bloques (el anillo puede estar en PSRAM)
+    cm_capture_record_t chunk[CAPTURE_DUMP_CHUNK];
+    size_t offset = sizeof(header);
+    size_t done = 0;
+    while (done < count) {
+        size_t n = count - done;
+        if (n > CAPTURE_DUMP_CHUNK) {
+            n = CAPTURE_DUMP_CHUNK;
+        }
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] = s_ring[(start + done + i) % CAPTURE_RECORDS];
+        }
+        err = esp_partition_write(part, offset, chunk, n * sizeof(cm_capture_record_t));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Error escribiendo registros: %s", esp_err_to_name(err));
+            return err;
+        }
+        offset += n * sizeof(cm_capture_record_t);
+        done += n;
+    }
+
+    ESP_LOGI(TAG, "Captura volcada a '%s': %u tramas (%lu perdidas), %u bytes",
+             CONFIG_CM_CAPTURE_PARTITION_LABEL, (unsigned)count,
+             (unsigned long)overwritten, (unsigned)total);
+    return ESP_OK;
+}
+
+static void dump_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t err = dump_to_partition();
+        ESP_LOGI(TAG, "Volcado %s en %lld ms", (err == ESP_OK) ? "completado" : "fallido",
+                 (esp_timer_get_time() - start_us) / 1000);
+
+        // Reanudar captura con el anillo vacío
+        taskENTER_CRITICAL(&s_lock);
+        s_head = 0;
+        s_count = 0;
+        s_overwritten = 0;
+        s_frozen = false;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+esp_err_t cm_capture_init(uint8_t node) {
+    if (s_ring != NULL) {
+        return ESP_OK;
+    }
+
+    size_t size = CAPTURE_RECORDS * sizeof(cm_capture_record_t);
+    s_ring = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (s_ring == NULL) {
+        s_ring = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if (s_ring == NULL) {
+        ESP_LOGE(TAG, "Sin memoria para %d tramas (%u bytes)", CAPTURE_RECORDS, (unsigned)size);
+        return ESP_ERR_NO_MEM;
+    }
+    s_node = node;
+
+    if (xTaskCreate(dump_task, "cm_capture_dump", CAPTURE_DUMP_TASK_STACK, NULL,
+                    CAPTURE_DUMP_TASK_PRIO, &s_dump_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de volcado");
+        heap_caps_free(s_ring);
+        s_ring = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Captura de enlace activa: %d tramas (%u KB)", CAPTURE_RECORDS, (unsigned)(size / 1024));
+    return ESP_OK;
+}
+
+void cm_capture_record(uint8_t dir, const void *data, size_t len, uint8_t flags) {
+    if (s_ring == NULL) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    if (len > CM_CAPTURE_DATA_MAX) {
+        len = CM_CAPTURE_DATA_MAX;
+        flags |= CM_CAPTURE_FLAG_TRUNCATED;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    if (!s_frozen) {
+        cm_capture_record_t *rec = &s_ring[s_head];
+        rec->timestamp_us = now_us;
+        rec->dir = dir;
+        rec->len = (uint8_t)len;
+        rec->flags = flags;
+        rec->reserved = 0;
+        memcpy(rec->data, data, len);
+
+        s_head = (s_head + 1) % CAPTURE_RECORDS;
+        if (s_count < CAPTURE_RECORDS) {
+            s_count++;
+        } else {
+            s_overwritten++;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void cm_capture_request_dump(void) {
+    if (s_dump_task_handle == NULL) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool already_frozen = s_frozen;
+    s_frozen = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!already_frozen) {
+        xTaskNotifyGive(s_dump_task_handle);
+    }
+}
+
+size_t cm_capture_count(void) {
+    taskENTER_CRITICAL(&s_lock);
+    size_t count = s_count;
+    taskEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+#endif // CONFIG_CM_CAPTURE_ENABLE
@@ -0,0 +1,255 @@
+/**
+ * @file test_cm_clock.c
+ * @brief Tests de host del estimador de reloj (cm_clock.h)
+ *
+ * Simulan un par cuyo reloj va adelantado un offset fijo y con deriva de
+ * cristal, con intercambios SYNC/DATA cada 100 ms y delays asimétricos, y
+ * comprueban cuándo se declara válida la estimación y a qué converge.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "cm_clock.h"
+#include "test_cm_protocol.h"
+
+// ============================================================================
+// PAR SIMULADO
+// ============================================================================
+
+#define SIM_PERIOD_US       (100 * 1000)    ///< SYNC_INTERVAL_MS de Consola
+#define SIM_TURNAROUND_US   400             ///< t3 - t2 en Base
+
+typedef struct {
+    int64_t offset_us;      ///< Reloj del par - reloj local en local = 0
+    double drift_ppm;       ///< Deriva del par respecto al local
+    uint32_t seed;
+} sim_peer_t;
+
+static int64_t sim_peer_time(const sim_peer_t *peer, int64_t local_us) {
+    return local_us + peer->offset_us + (int64_t)((double)local_us * peer->drift_ppm * 1e-6);
+}
+
+/** Offset real en un instante local */
+static int64_t sim_true_offset(const sim_peer_t *peer, int64_t local_us) {
+    return sim_peer_time(peer, local_us) - local_us;
+}
+
+/** Retardo de un sentido: 1-3 ms de línea más, a veces, una tarea bloqueada */
+static int64_t sim_leg_us(sim_peer_t *peer) {
+    peer->seed = peer->seed * 1664525u + 1013904223u;
+    int64_t leg = 1000 + (peer->seed >> 8) % 2000;
+    if ((peer->seed >> 28) == 0) {
+        leg += 20000;
+    }
+    return leg;
+}
+
+/** Un intercambio completo que empieza en local_us */
+static bool sim_exchange(cm_clock_t *clk, sim_peer_t *peer, int64_t local_us) {
+    int64_t t1 = local_us;
+    int64_t rx_local = t1 + sim_leg_us(peer);
+    int64_t t2 = sim_peer_time(peer, rx_local);
+    int64_t t3 = t2 + SIM_TURNAROUND_US;
+    int64_t t4 = rx_local + SIM_TURNAROUND_US + sim_leg_us(peer);
+    return cm_clock_add_exchange(clk, t1, t2, t3, t4);
+}
+
+// ============================================================================
+// INTERCAMBIOS (CONSOLA)
+// ============================================================================
+
+static void test_exchange_valid_after_min_samples(void)
+{
+    cm_clock_t clk;
+    sim_peer_t peer = { .offset_us = 5000000, .seed = 1 };
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < CM_CLOCK_MIN_SAMPLES - 1; i++, t += SIM_PERIOD_US) {
+        TEST_ASSERT_TRUE(sim_exchange(&clk, &peer, t));
+        TEST_ASSERT_FALSE(clk.valid);
+        TEST_ASSERT_TRUE(cm_clock_offset_at(&clk, t) == 0);
+    }
+    TEST_ASSERT_TRUE(sim_exchange(&clk, &peer, t));
+    TEST_ASSERT_TRUE(clk.valid);
+}
+
+static void test_exchange_offset_converges(void)
+{
+    cm_clock_t clk;
+    sim_peer_t peer = { .offset_us = -123456789, .seed = 7 };
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < 50; i++, t += SIM_PERIOD_US) {
+        sim_exchange(&clk, &peer, t);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+    // El filtro elige el intercambio de menor delay: error <= asimetría de 1-3 ms / 2
+    TEST_ASSERT_INT64_WITHIN(1000, sim_true_offset(&peer, t), cm_clock_offset_at(&clk, t));
+}
+
+static void test_exchange_drift_converges(void)
+{
+    cm_clock_t clk;
+    sim_peer_t peer = { .offset_us = 2000000, .drift_ppm = 40.0, .seed = 3 };
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < 3000; i++, t += SIM_PERIOD_US) {   // 5 minutos
+        sim_exchange(&clk, &peer, t);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+    TEST_ASSERT_TRUE(clk.drift_valid);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 40.0f, (float)(clk.drift * 1e6));
+
+    // Sin intercambios, la deriva mantiene la predicción 10 s después (40 ppm = 400 us)
+    int64_t later = t + 10 * 1000 * 1000;
+    TEST_ASSERT_INT64_WITHIN(1000, sim_true_offset(&peer, later), cm_clock_offset_at(&clk, later));
+}
+
+static void test_exchange_rejects_bad_delay(void)
+{
+    cm_clock_t clk;
+    cm_clock_reset(&clk);
+
+    // Delay por encima de CM_CLOCK_MAX_DELAY_US
+    TEST_ASSERT_FALSE(cm_clock_add_exchange(&clk, 0, 1000, 1100, CM_CLOCK_MAX_DELAY_US + 200));
+    // Tiempos incoherentes (t4 < t1, t3 < t2)
+    TEST_ASSERT_FALSE(cm_clock_add_exchange(&clk, 1000, 5000, 5100, 900));
+    TEST_ASSERT_FALSE(cm_clock_add_exchange(&clk, 0, 5000, 4000, 2000));
+    TEST_ASSERT_EQUAL_UINT32(3, clk.rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, clk.samples);
+    TEST_ASSERT_FALSE(clk.valid);
+}
+
+static void test_exchange_step_restarts(void)
+{
+    cm_clock_t clk;
+    sim_peer_t peer = { .offset_us = 5000000, .seed = 11 };
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < 20; i++, t += SIM_PERIOD_US) {
+        sim_exchange(&clk, &peer, t);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+
+    // El par se reinicia: su reloj vuelve a empezar. El salto se ve cuando
+    // una muestra nueva es la de menor delay, como tarde al rotar la ventana
+    peer.offset_us = -t;
+    bool invalidated = false;
+    for (int i = 0; i < CM_CLOCK_FILTER_SIZE; i++, t += SIM_PERIOD_US) {
+        sim_exchange(&clk, &peer, t);
+        invalidated |= !clk.valid;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, clk.steps);
+    TEST_ASSERT_TRUE(invalidated);
+
+    for (int i = 0; i < 20; i++, t += SIM_PERIOD_US) {
+        sim_exchange(&clk, &peer, t);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+    TEST_ASSERT_INT64_WITHIN(1000, sim_true_offset(&peer, t), cm_clock_offset_at(&clk, t));
+}
+
+// ============================================================================
+// ADOPCIÓN (BASE)
+// ============================================================================
+
+static void test_adopt_needs_min_samples(void)
+{
+    cm_clock_t clk;
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < CM_CLOCK_MIN_SAMPLES - 1; i++, t += SIM_PERIOD_US) {
+        cm_clock_adopt(&clk, t, -5000000 + i * 100);
+        TEST_ASSERT_FALSE(clk.valid);
+    }
+    cm_clock_adopt(&clk, t, -5000000);
+    TEST_ASSERT_TRUE(clk.valid);
+    TEST_ASSERT_INT64_WITHIN(100, -5000000, cm_clock_offset_at(&clk, t));
+}
+
+static void test_adopt_inconsistent_restarts_count(void)
+{
+    cm_clock_t clk;
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    // Dos estimaciones de una Consola que aún converge, luego una muy distinta
+    cm_clock_adopt(&clk, t, 0);
+    t += SIM_PERIOD_US;
+    cm_clock_adopt(&clk, t, 100);
+    t += SIM_PERIOD_US;
+    cm_clock_adopt(&clk, t, 3 * CM_CLOCK_STEP_US);
+    t += SIM_PERIOD_US;
+    TEST_ASSERT_EQUAL_UINT32(1, clk.samples);
+    TEST_ASSERT_FALSE(clk.valid);
+
+    for (int i = 1; i < CM_CLOCK_MIN_SAMPLES; i++, t += SIM_PERIOD_US) {
+        TEST_ASSERT_FALSE(clk.valid);
+        cm_clock_adopt(&clk, t, 3 * CM_CLOCK_STEP_US);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+    TEST_ASSERT_TRUE(cm_clock_offset_at(&clk, t) == 3 * CM_CLOCK_STEP_US);
+}
+
+static void test_adopt_step_invalidates(void)
+{
+    cm_clock_t clk;
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < CM_CLOCK_MIN_SAMPLES; i++, t += SIM_PERIOD_US) {
+        cm_clock_adopt(&clk, t, -5000000);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+
+    // Consola reiniciada: su estimación salta y Base deja de fiarse hasta que se repite
+    cm_clock_adopt(&clk, t, 7000000);
+    t += SIM_PERIOD_US;
+    TEST_ASSERT_EQUAL_UINT32(1, clk.steps);
+    TEST_ASSERT_FALSE(clk.valid);
+    for (int i = 1; i < CM_CLOCK_MIN_SAMPLES; i++, t += SIM_PERIOD_US) {
+        cm_clock_adopt(&clk, t, 7000000);
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+}
+
+static void test_adopt_drift_converges(void)
+{
+    cm_clock_t clk;
+    sim_peer_t peer = { .offset_us = -3000000, .drift_ppm = -25.0 };
+    int64_t t = 1000000;
+
+    cm_clock_reset(&clk);
+    for (int i = 0; i < 3000; i++, t += SIM_PERIOD_US) {
+        cm_clock_adopt(&clk, t, sim_true_offset(&peer, t));
+    }
+    TEST_ASSERT_TRUE(clk.valid);
+    TEST_ASSERT_TRUE(clk.drift_valid);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, -25.0f, (float)(clk.drift * 1e6));
+
+    int64_t later = t + 10 * 1000 * 1000;
+    TEST_ASSERT_INT64_WITHIN(100, sim_true_offset(&peer, later), cm_clock_offset_at(&clk, later));
+}
+
+// ============================================================================
+// GRUPO
+// ============================================================================
+
+void test_cm_clock_run(void)
+{
+    RUN_TEST(test_exchange_valid_after_min_samples);
+    RUN_TEST(test_exchange_offset_converges);
+    RUN_TEST(test_exchange_drift_converges);
+    RUN_TEST(test_exchange_rejects_bad_delay);
+    RUN_TEST(test_exchange_step_restarts);
+    RUN_TEST(test_adopt_needs_min_samples);
+    RUN_TEST(test_adopt_inconsistent_restarts_count);
+    RUN_TEST(test_adopt_step_invalidates);
+    RUN_TEST(test_adopt_drift_converges);
+}
@@ -0,0 +1,15 @@
+/**
+ * @file test_cm_protocol.h
+ * @brief Grupos de tests de host de cm_protocol
+ */
+
+#ifndef TEST_CM_PROTOCOL_H
+#define TEST_CM_PROTOCOL_H
+
+/** @brief Codecs ASCII/binario generados por el esquema y CRC de trama */
+void test_cm_schema_run(void);
+
+/** @brief Estimador de offset y deriva del reloj */
+void test_cm_clock_run(void);
+
+#endif // TEST_CM_PROTOCOL_H
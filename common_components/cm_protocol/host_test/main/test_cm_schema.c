@@ -0,0 +1,359 @@
+/**
+ * @file test_cm_schema.c
+ * @brief Tests de host de los codecs generados por cm_schema.h y del CRC de trama
+ *
+ * Cubren lo que ninguno de los dos firmwares puede comprobar por sí solo:
+ * ida y vuelta ASCII/binario con los valores extremos de cada tipo de campo,
+ * rechazo de valores fuera de rango, líneas truncadas o con campos de más,
+ * y tramas binarias con CRC o longitud corruptos.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "cm_protocol.h"
+#include "cm_frame.h"
+#include "cm_schema.h"
+#include "test_cm_protocol.h"
+
+// ============================================================================
+// AUXILIARES
+// ============================================================================
+
+/** Codifica y quita el '\n' final para poder pasar la línea al decodificador */
+#define ENCODE_LINE(fn, msg, buf)                                   \
+    do {                                                            \
+        size_t n_ = fn(&(msg), (buf), sizeof(buf));                 \
+        TEST_ASSERT_GREATER_THAN(0, n_);                            \
+        TEST_ASSERT_EQUAL_CHAR('\n', (buf)[n_ - 1]);                \
+        (buf)[n_ - 1] = '\0';                                       \
+    } while (0)
+
+static cm_sync_msg_t sample_sync(void)
+{
+    cm_sync_msg_t msg = {
+        .target_speed_kmh = 6.0f,
+        .target_incline_pct = 5.0f,
+        .fan_head = 1,
+        .fan_chest = 0,
+        .wax_pump = 0,
+        .training_mode = 1,
+        .ramp_mode = CM_RAMP_COOLDOWN,
+        .profile_id = 7,
+        .tx_us = 81234567,
+        .clock_offset_us = -5301234,
+        .clock_valid = 1,
+    };
+    return msg;
+}
+
+// ============================================================================
+// IDA Y VUELTA
+// ============================================================================
+
+static void test_sync_ascii_roundtrip(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    cm_sync_msg_t out;
+    char line[CM_SCHEMA_ASCII_MAX];
+
+    ENCODE_LINE(cm_sync_encode_ascii, in, line);
+    TEST_ASSERT_EQUAL_STRING("SYNC=6.00,5.00,1,0,0,1,2,7,81234567,-5301234,1", line);
+    TEST_ASSERT_TRUE(cm_sync_decode_ascii(line, &out));
+
+    TEST_ASSERT_EQUAL_FLOAT(in.target_speed_kmh, out.target_speed_kmh);
+    TEST_ASSERT_EQUAL_FLOAT(in.target_incline_pct, out.target_incline_pct);
+    TEST_ASSERT_EQUAL_UINT8(in.fan_head, out.fan_head);
+    TEST_ASSERT_EQUAL_UINT8(in.training_mode, out.training_mode);
+    TEST_ASSERT_EQUAL_UINT8(in.ramp_mode, out.ramp_mode);
+    TEST_ASSERT_EQUAL_UINT8(in.profile_id, out.profile_id);
+    TEST_ASSERT_TRUE(in.tx_us == out.tx_us);
+    TEST_ASSERT_TRUE(in.clock_offset_us == out.clock_offset_us);
+    TEST_ASSERT_EQUAL_UINT8(in.clock_valid, out.clock_valid);
+}
+
+static void test_sync_ascii_i64_extremes(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    cm_sync_msg_t out;
+    char line[CM_SCHEMA_ASCII_MAX];
+
+    in.tx_us = INT64_MAX;
+    in.clock_offset_us = INT64_MIN;
+    ENCODE_LINE(cm_sync_encode_ascii, in, line);
+    TEST_ASSERT_TRUE(cm_sync_decode_ascii(line, &out));
+    TEST_ASSERT_TRUE(out.tx_us == INT64_MAX);
+    TEST_ASSERT_TRUE(out.clock_offset_us == INT64_MIN);
+}
+
+static void test_data_bin_roundtrip(void)
+{
+    cm_data_msg_t in = {
+        .real_speed_kmh = 12.34f,
+        .real_incline_pct = -2.5f,
+        .vfd_freq_hz = 46.88f,
+        .vfd_fault = 3,
+        .fan_head = 1,
+        .fan_chest = 1,
+        .incline_fault = 0,
+        .profile_id = 255,
+        .profile_state = CM_PROFILE_RUNNING,
+        .profile_segment = 4,
+        .profile_left_ms = UINT32_MAX,
+        .sync_tx_us = INT64_MIN,
+        .rx_us = INT64_MAX,
+        .turnaround_us = 412,
+    };
+    cm_data_msg_t out;
+    uint8_t buf[CM_DATA_BIN_SIZE];
+
+    TEST_ASSERT_EQUAL(CM_DATA_BIN_SIZE, cm_data_encode_bin(&in, buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(cm_data_decode_bin(buf, sizeof(buf), &out));
+
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, in.real_speed_kmh, out.real_speed_kmh);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, in.real_incline_pct, out.real_incline_pct);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, in.vfd_freq_hz, out.vfd_freq_hz);
+    TEST_ASSERT_EQUAL_UINT8(in.vfd_fault, out.vfd_fault);
+    TEST_ASSERT_EQUAL_UINT8(in.profile_id, out.profile_id);
+    TEST_ASSERT_EQUAL_UINT8(in.profile_state, out.profile_state);
+    TEST_ASSERT_EQUAL_UINT32(in.profile_left_ms, out.profile_left_ms);
+    TEST_ASSERT_TRUE(in.sync_tx_us == out.sync_tx_us);
+    TEST_ASSERT_TRUE(in.rx_us == out.rx_us);
+    TEST_ASSERT_EQUAL_UINT32(in.turnaround_us, out.turnaround_us);
+}
+
+static void test_bin_fixed_point_saturates(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    cm_sync_msg_t out;
+    uint8_t buf[CM_SYNC_BIN_SIZE];
+
+    // F2 viaja como int16 ×100: ±327.67 es el máximo representable
+    in.target_speed_kmh = 1000.0f;
+    in.target_incline_pct = -1000.0f;
+    TEST_ASSERT_EQUAL(CM_SYNC_BIN_SIZE, cm_sync_encode_bin(&in, buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(cm_sync_decode_bin(buf, sizeof(buf), &out));
+    TEST_ASSERT_EQUAL_FLOAT(327.67f, out.target_speed_kmh);
+    TEST_ASSERT_EQUAL_FLOAT(-327.68f, out.target_incline_pct);
+}
+
+static void test_stats_task_name_roundtrip(void)
+{
+    cm_stats_task_msg_t in = { .index = 3, .cpu_permille = 125, .stack_free = 1024, .prio = 5, .core = 255 };
+    cm_stats_task_msg_t out;
+    char line[CM_SCHEMA_ASCII_MAX];
+
+    cm_name16_set(&in.name, "vfd_control");
+    ENCODE_LINE(cm_stats_task_encode_ascii, in, line);
+    TEST_ASSERT_EQUAL_STRING("STASK=3,vfd_control,125,1024,5,255", line);
+    TEST_ASSERT_TRUE(cm_stats_task_decode_ascii(line, &out));
+    TEST_ASSERT_EQUAL_STRING("vfd_control", out.name.s);
+    TEST_ASSERT_EQUAL_UINT8(255, out.core);
+}
+
+// ============================================================================
+// LÍMITES DE CAMPO
+// ============================================================================
+
+static void test_u8_limits(void)
+{
+    cm_profile_msg_t msg;
+
+    TEST_ASSERT_TRUE(cm_profile_decode_ascii("PROFILE=255,0", &msg));
+    TEST_ASSERT_EQUAL_UINT8(255, msg.profile_id);
+    TEST_ASSERT_FALSE(cm_profile_decode_ascii("PROFILE=256,0", &msg));
+    TEST_ASSERT_FALSE(cm_profile_decode_ascii("PROFILE=-1,0", &msg));
+}
+
+static void test_u32_limits(void)
+{
+    cm_stats_nvs_msg_t msg;
+
+    TEST_ASSERT_TRUE(cm_stats_nvs_decode_ascii("SNVS=4294967295,0,0,0", &msg));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, msg.writes);
+    TEST_ASSERT_FALSE(cm_stats_nvs_decode_ascii("SNVS=4294967296,0,0,0", &msg));
+    TEST_ASSERT_FALSE(cm_stats_nvs_decode_ascii("SNVS=-1,0,0,0", &msg));
+}
+
+static void test_i64_limits(void)
+{
+    cm_sync_msg_t msg;
+
+    TEST_ASSERT_TRUE(cm_sync_decode_ascii(
+        "SYNC=0.00,0.00,0,0,0,0,0,0,9223372036854775807,-9223372036854775808,0", &msg));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=0.00,0.00,0,0,0,0,0,0,9223372036854775808,0,0", &msg));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=0.00,0.00,0,0,0,0,0,0,0,-9223372036854775809,0", &msg));
+}
+
+static void test_s16_limits(void)
+{
+    cm_stats_task_msg_t msg;
+
+    // 15 caracteres caben con el '\0'; 16 no; vacío tampoco es un nombre
+    TEST_ASSERT_TRUE(cm_stats_task_decode_ascii("STASK=0,abcdefghijklmno,0,0,0,0", &msg));
+    TEST_ASSERT_EQUAL_STRING("abcdefghijklmno", msg.name.s);
+    TEST_ASSERT_FALSE(cm_stats_task_decode_ascii("STASK=0,abcdefghijklmnop,0,0,0,0", &msg));
+    TEST_ASSERT_FALSE(cm_stats_task_decode_ascii("STASK=0,,0,0,0,0", &msg));
+}
+
+// ============================================================================
+// LÍNEAS MALFORMADAS
+// ============================================================================
+
+static void test_truncated_lines_rejected(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    cm_sync_msg_t out;
+    char line[CM_SCHEMA_ASCII_MAX];
+    char cut[CM_SCHEMA_ASCII_MAX];
+
+    ENCODE_LINE(cm_sync_encode_ascii, in, line);
+    size_t len = strlen(line);
+
+    // Cualquier corte (p. ej. una línea perdida a mitad por ruido en el bus) falla
+    for (size_t n = 0; n < len; n++) {
+        memcpy(cut, line, n);
+        cut[n] = '\0';
+        TEST_ASSERT_FALSE_MESSAGE(cm_sync_decode_ascii(cut, &out), cut);
+    }
+    TEST_ASSERT_TRUE(cm_sync_decode_ascii(line, &out));
+}
+
+static void test_malformed_lines_rejected(void)
+{
+    cm_sync_msg_t sync;
+    cm_data_msg_t data;
+
+    // Prefijo equivocado (una línea DATA no es un SYNC)
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "DATA=6.00,5.00,1,0,0,1,0,0,81234567,-5301234,1", &sync));
+    // Campo de más (firmware de otra versión) y coma final
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=6.00,5.00,1,0,0,1,0,0,81234567,-5301234,1,0", &sync));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=6.00,5.00,1,0,0,1,0,0,81234567,-5301234,1,", &sync));
+    // Valores no numéricos o no finitos
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=nan,5.00,1,0,0,1,0,0,81234567,-5301234,1", &sync));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=6.00,inf,1,0,0,1,0,0,81234567,-5301234,1", &sync));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=6.00,5.00,x,0,0,1,0,0,81234567,-5301234,1", &sync));
+    TEST_ASSERT_FALSE(cm_sync_decode_ascii(
+        "SYNC=6.00,5.00,1;0,0,1,0,0,81234567,-5301234,1", &sync));
+    TEST_ASSERT_FALSE(cm_data_decode_ascii("DATA=", &data));
+}
+
+static void test_encode_buffer_too_small(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    char line[CM_SCHEMA_ASCII_MAX];
+    uint8_t bin[CM_SYNC_BIN_SIZE];
+
+    size_t full = cm_sync_encode_ascii(&in, line, sizeof(line));
+    TEST_ASSERT_GREATER_THAN(0, full);
+    // Con sitio para todo menos el '\0' final no debe escribir una línea cortada
+    TEST_ASSERT_EQUAL(0, cm_sync_encode_ascii(&in, line, full));
+    TEST_ASSERT_EQUAL(0, cm_sync_encode_bin(&in, bin, sizeof(bin) - 1));
+}
+
+static void test_bin_wrong_length_rejected(void)
+{
+    cm_sync_msg_t in = sample_sync();
+    cm_sync_msg_t out;
+    uint8_t bin[CM_SYNC_BIN_SIZE + 1] = { 0 };
+
+    TEST_ASSERT_EQUAL(CM_SYNC_BIN_SIZE, cm_sync_encode_bin(&in, bin, CM_SYNC_BIN_SIZE));
+    TEST_ASSERT_FALSE(cm_sync_decode_bin(bin, CM_SYNC_BIN_SIZE - 1, &out));
+    TEST_ASSERT_FALSE(cm_sync_decode_bin(bin, CM_SYNC_BIN_SIZE + 1, &out));
+}
+
+// ============================================================================
+// TRAMA BINARIA (CRC)
+// ============================================================================
+
+/** Construye una trama SYNC binaria con caracteres que obligan a hacer stuffing */
+static size_t build_sync_frame(uint8_t *raw, size_t max)
+{
+    cm_sync_msg_t msg = sample_sync();
+    cm_frame_t frame = { .seq = CM_SOF, .cmd = CM_CMD_SYNC };
+
+    msg.tx_us = ((int64_t)CM_SOF << 8) | CM_ESC;
+    frame.len = (uint8_t)cm_sync_encode_bin(&msg, frame.payload, sizeof(frame.payload));
+    TEST_ASSERT_EQUAL(CM_SYNC_BIN_SIZE, frame.len);
+    return cm_build_frame(&frame, raw, max);
+}
+
+static void test_frame_roundtrip(void)
+{
+    uint8_t raw[CM_MAX_STUFFED_SIZE];
+    cm_frame_t frame;
+    cm_sync_msg_t out;
+
+    size_t len = build_sync_frame(raw, sizeof(raw));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_TRUE(cm_parse_frame(raw, len, &frame));
+    TEST_ASSERT_EQUAL_UINT8(CM_CMD_SYNC, frame.cmd);
+    TEST_ASSERT_EQUAL_UINT8(CM_SOF, frame.seq);
+    TEST_ASSERT_TRUE(cm_sync_decode_bin(frame.payload, frame.len, &out));
+    TEST_ASSERT_TRUE(out.tx_us == (((int64_t)CM_SOF << 8) | CM_ESC));
+}
+
+static void test_frame_bad_crc_rejected(void)
+{
+    uint8_t raw[CM_MAX_STUFFED_SIZE];
+    cm_frame_t frame;
+
+    size_t len = build_sync_frame(raw, sizeof(raw));
+
+    // El último byte es CRC_L: alterarlo (sin crear un escape) debe fallar
+    uint8_t saved = raw[len - 1];
+    raw[len - 1] ^= 0x01;
+    if (raw[len - 1] == CM_SOF || raw[len - 1] == CM_ESC) {
+        raw[len - 1] ^= 0x03;
+    }
+    TEST_ASSERT_FALSE(cm_parse_frame(raw, len, &frame));
+    raw[len - 1] = saved;
+
+    // Un bit cambiado en el payload (clock_offset_us, sin escape) también
+    raw[len - 8] ^= 0x10;
+    TEST_ASSERT_FALSE(cm_parse_frame(raw, len, &frame));
+}
+
+static void test_frame_truncated_rejected(void)
+{
+    uint8_t raw[CM_MAX_STUFFED_SIZE];
+    cm_frame_t frame;
+
+    size_t len = build_sync_frame(raw, sizeof(raw));
+    for (size_t n = 0; n < len; n++) {
+        TEST_ASSERT_FALSE(cm_parse_frame(raw, n, &frame));
+    }
+    TEST_ASSERT_TRUE(cm_parse_frame(raw, len, &frame));
+}
+
+// ============================================================================
+// GRUPO
+// ============================================================================
+
+void test_cm_schema_run(void)
+{
+    RUN_TEST(test_sync_ascii_roundtrip);
+    RUN_TEST(test_sync_ascii_i64_extremes);
+    RUN_TEST(test_data_bin_roundtrip);
+    RUN_TEST(test_bin_fixed_point_saturates);
+    RUN_TEST(test_stats_task_name_roundtrip);
+    RUN_TEST(test_u8_limits);
+    RUN_TEST(test_u32_limits);
+    RUN_TEST(test_i64_limits);
+    RUN_TEST(test_s16_limits);
+    RUN_TEST(test_truncated_lines_rejected);
+    RUN_TEST(test_malformed_lines_rejected);
+    RUN_TEST(test_encode_buffer_too_small);
+    RUN_TEST(test_bin_wrong_length_rejected);
+    RUN_TEST(test_frame_roundtrip);
+    RUN_TEST(test_frame_bad_crc_rejected);
+    RUN_TEST(test_frame_truncated_rejected);
+}
@@ -0,0 +1,23 @@
+/**
+ * @file test_main.c
+ * @brief Punto de entrada de los tests de host de cm_protocol
+ *
+ * Se compila con el target linux de ESP-IDF; el código de salida del
+ * proceso es el número de tests fallidos (0 = todo correcto), para poder
+ * usarlo directamente en CI.
+ */
+
+#include <stdlib.h>
+#include "unity.h"
+#include "test_cm_protocol.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    test_cm_schema_run();
+    test_cm_clock_run();
+    exit(UNITY_END());
+}
@@ -0,0 +1,156 @@
+/**
+ * @file cm_blackbox_format.h
+ * @brief Formato de la caja negra de Base y de su lectura por el enlace
+ *
+ * Compartido entre el grabador de Base (blackbox.c), el lector de Consola
+ * (cm_master.c) y las herramientas de host. Todos los campos son
+ * little-endian (nativo en ESP32, ESP32-P4 y x86/ARM de host).
+ *
+ * Layout de cada volcado en flash (partición "blackbox", un hueco por volcado):
+ *   [cm_bbox_header_t] [cm_bbox_record_t × record_count]
+ * Los registros están ordenados del más antiguo al más reciente.
+ *
+ * Lectura por el enlace ASCII (una línea por petición, cabe en CM_LINE_BUFFER_SIZE):
+ *   Consola -> Base:  BLACKBOX=<volcado>,<línea>
+ *   Base -> Consola:  BBOX=<volcado>,<línea>,<hex>,<crc16>
+ * Volcado 0 es el más reciente, 1 el anterior... La línea 0 lleva la
+ * cabecera (vacía si el volcado no existe); la línea n >= 1 los registros
+ * (n-1)·CM_BBOX_RECORDS_PER_LINE y siguientes. El CRC-16/CCITT-FALSE cubre
+ * los bytes decodificados del campo hex.
+ */
+
+#ifndef CM_BLACKBOX_FORMAT_H
+#define CM_BLACKBOX_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Firma de cabecera: "CMBB" */
+#define CM_BBOX_MAGIC           0x42424D43u
+
+/** Versión del formato */
+#define CM_BBOX_VERSION         1
+
+/** Prefijos de las líneas del enlace */
+#define CM_BBOX_REQUEST_PREFIX  "BLACKBOX="
+#define CM_BBOX_LINE_PREFIX     "BBOX="
+
+/** Registros por línea BBOX */
+#define CM_BBOX_RECORDS_PER_LINE    2
+
+/** Motivo del volcado */
+#define CM_BBOX_REASON_WATCHDOG     1   ///< Watchdog de comunicación
+#define CM_BBOX_REASON_SENSOR_FAULT 2   ///< Fin de carrera no detectado
+#define CM_BBOX_REASON_ESTOP_INPUT  3   ///< Seta de emergencia
+#define CM_BBOX_REASON_ESTOP_LINK   4   ///< Trama EMERGENCY_STOP
+#define CM_BBOX_REASON_SAFE_STATE   5   ///< Otro paso a safe state
+#define CM_BBOX_REASON_RESET        6   ///< Anillo recuperado tras un reinicio por pánico o watchdog
+
+/** Bits de cm_bbox_record_t.flags */
+#define CM_BBOX_FLAG_SAFE_STATE     0x01
+#define CM_BBOX_FLAG_INCLINE_FAULT  0x02
+#define CM_BBOX_FLAG_CALIBRATED     0x04
+#define CM_BBOX_FLAG_LINK_SEEN      0x08
+#define CM_BBOX_FLAG_ESTOP_INPUT    0x10
+#define CM_BBOX_FLAG_ESTOP_REARM    0x20
+#define CM_BBOX_FLAG_VFD_FAULT      0x40
+#define CM_BBOX_FLAG_VFD_OFFLINE    0x80
+
+/** Bits de cm_bbox_record_t.relays (salidas ordenadas) */
+#define CM_BBOX_RELAY_INCLINE_ON    0x01
+#define CM_BBOX_RELAY_INCLINE_DOWN  0x02
+#define CM_BBOX_RELAY_HEAD_FAN      0x04
+#define CM_BBOX_RELAY_HEAD_FAST     0x08
+#define CM_BBOX_RELAY_CHEST_FAN     0x10
+#define CM_BBOX_RELAY_CHEST_FAST    0x20
+#define CM_BBOX_RELAY_WAX_PUMP      0x40
+
+/** Bits de cm_bbox_record_t.events (ocurridos desde el registro anterior) */
+#define CM_BBOX_EVT_SAFE_ENTER      0x01
+#define CM_BBOX_EVT_SAFE_EXIT       0x02
+#define CM_BBOX_EVT_WATCHDOG        0x04
+#define CM_BBOX_EVT_ESTOP           0x08
+#define CM_BBOX_EVT_LIMIT_HIT       0x10
+#define CM_BBOX_EVT_CALIBRATE       0x20
+#define CM_BBOX_EVT_SENSOR_FAULT    0x40
+#define CM_BBOX_EVT_TRIGGER         0x80   ///< Registro en el que se pidió el volcado
+
+/**
+ * @brief Cabecera de un volcado
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             ///< CM_BBOX_MAGIC
+    uint16_t version;           ///< CM_BBOX_VERSION
+    uint16_t record_size;       ///< sizeof(cm_bbox_record_t)
+    uint32_t dump_seq;          ///< Número de volcado desde que se borró la partición
+    uint16_t record_count;      ///< Registros tras la cabecera
+    uint16_t trigger_index;     ///< Registro del disparo dentro del volcado
+    uint16_t period_ms;         ///< Periodo de muestreo
+    uint8_t reason;             ///< CM_BBOX_REASON_*
+    uint8_t reserved;
+    uint32_t dropped;           ///< Muestras perdidas con el anillo congelado
+} cm_bbox_header_t;
+
+/**
+ * @brief Una muestra del estado de Base (24 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t t_ms;              ///< esp_timer_get_time() / 1000 (32 bits bajos)
+    uint16_t seq;               ///< Número de muestra (detecta huecos)
+    int16_t target_speed;       ///< km/h × 100
+    int16_t real_speed;         ///< km/h × 100
+    int16_t target_incline;     ///< % × 100
+    int16_t real_incline;       ///< % × 100
+    uint16_t vfd_target_freq;   ///< Hz × 100, consigna enviada al VFD
+    uint16_t vfd_real_freq;     ///< Hz × 100, leída del VFD (0x2103)
+    uint8_t flags;              ///< CM_BBOX_FLAG_*
+    uint8_t relays;             ///< CM_BBOX_RELAY_*
+    uint8_t incline_state;      ///< Estado del actuador (STOPPED, UP, DOWN, HOMING)
+    uint8_t events;             ///< CM_BBOX_EVT_*
+    uint8_t sync_ok;            ///< SYNC válidos desde el registro anterior (satura en 255)
+    uint8_t frames_bad;         ///< Tramas inválidas o desconocidas desde el registro anterior
+} cm_bbox_record_t;
+
+/** Bytes de datos máximos en una línea BBOX */
+#define CM_BBOX_LINE_DATA_MAX   (CM_BBOX_RECORDS_PER_LINE * sizeof(cm_bbox_record_t))
+
+/**
+ * @brief Número de líneas BBOX de un volcado (cabecera incluida)
+ */
+static inline uint32_t cm_bbox_line_count(uint32_t record_count) {
+    return 1 + (record_count + CM_BBOX_RECORDS_PER_LINE - 1) / CM_BBOX_RECORDS_PER_LINE;
+}
+
+/**
+ * @brief Codifica una línea "BBOX=volcado,línea,hex,crc" (sin '\n')
+ *
+ * @return Longitud escrita, 0 si no cabe en out_size
+ */
+size_t cm_bbox_line_encode(uint16_t dump, uint16_t line, const void *data, size_t len,
+                           char *out, size_t out_size);
+
+/**
+ * @brief Decodifica una línea "BBOX=..." (sin '\n')
+ *
+ * @param[out] data Bytes del campo hex (al menos CM_BBOX_LINE_DATA_MAX)
+ * @param[out] len  Bytes decodificados
+ * @return false si el formato o el CRC no son válidos
+ */
+bool cm_bbox_line_decode(const char *line, uint16_t *dump, uint16_t *line_no,
+                         uint8_t *data, size_t *len);
+
+/**
+ * @brief Decodifica una petición "BLACKBOX=volcado,línea"
+ */
+bool cm_bbox_request_decode(const char *line, uint16_t *dump, uint16_t *line_no);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_BLACKBOX_FORMAT_H
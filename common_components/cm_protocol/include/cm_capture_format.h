@@ -0,0 +1,73 @@
+/**
+ * @file cm_capture_format.h
+ * @brief Formato binario de las capturas del enlace RS485
+ *
+ * Compartido entre el grabador de los firmwares (cm_link_capture) y las
+ * herramientas de host (tools/link_replay). Todos los campos son
+ * little-endian (nativo en ESP32, ESP32-P4 y x86/ARM de host).
+ *
+ * Layout del volcado en flash:
+ *   [cm_capture_header_t] [cm_capture_record_t × record_count]
+ * Los registros están ordenados del más antiguo al más reciente.
+ */
+
+#ifndef CM_CAPTURE_FORMAT_H
+#define CM_CAPTURE_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Firma de cabecera: "CMCP" */
+#define CM_CAPTURE_MAGIC        0x50434D43u
+
+/** Versión del formato */
+#define CM_CAPTURE_VERSION      1
+
+/** Bytes de datos almacenados por trama (las líneas más largas se truncan) */
+#define CM_CAPTURE_DATA_MAX     80
+
+/** Dirección de la trama desde el punto de vista del nodo que captura */
+#define CM_CAPTURE_DIR_TX       0
+#define CM_CAPTURE_DIR_RX       1
+
+/** Nodo que generó la captura */
+#define CM_CAPTURE_NODE_CONSOLA 1
+#define CM_CAPTURE_NODE_BASE    2
+
+/** Flags de registro */
+#define CM_CAPTURE_FLAG_TRUNCATED   0x01  ///< Datos recortados a CM_CAPTURE_DATA_MAX
+#define CM_CAPTURE_FLAG_OVERFLOW    0x02  ///< Línea descartada por el receptor (demasiado larga)
+
+/**
+ * @brief Cabecera del volcado
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;          ///< CM_CAPTURE_MAGIC
+    uint16_t version;        ///< CM_CAPTURE_VERSION
+    uint16_t record_size;    ///< sizeof(cm_capture_record_t)
+    uint32_t record_count;   ///< Registros válidos tras la cabecera
+    uint32_t overwritten;    ///< Registros perdidos por desbordamiento del anillo
+    uint8_t node;            ///< CM_CAPTURE_NODE_*
+    uint8_t reserved[3];
+} cm_capture_header_t;
+
+/**
+ * @brief Una trama capturada (línea ASCII sin '\n')
+ */
+typedef struct __attribute__((packed)) {
+    int64_t timestamp_us;               ///< esp_timer_get_time() del nodo al capturar
+    uint8_t dir;                        ///< CM_CAPTURE_DIR_*
+    uint8_t len;                        ///< Bytes válidos en data
+    uint8_t flags;                      ///< CM_CAPTURE_FLAG_*
+    uint8_t reserved;
+    uint8_t data[CM_CAPTURE_DATA_MAX];  ///< Contenido de la línea
+} cm_capture_record_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_CAPTURE_FORMAT_H
@@ -0,0 +1,174 @@
+/**
+ * @file cm_clock.h
+ * @brief Sincronización de reloj entre Consola y Base (estilo NTP)
+ *
+ * Cada nodo tiene su propio esp_timer_get_time(). Este estimador calcula el
+ * offset (reloj del par - reloj local) y la deriva relativa a partir de los
+ * intercambios SYNC/DATA, sin tráfico adicional:
+ *
+ *   Consola                      Base
+ *     t1 ──── SYNC(tx_us=t1) ────▶ t2
+ *     t4 ◀─── DATA(t1,t2,t3-t2) ── t3
+ *
+ *   offset = ((t2 - t1) + (t3 - t4)) / 2
+ *   delay  = (t4 - t1) - (t3 - t2)
+ *
+ * Consola alimenta el estimador con cada intercambio completo y publica su
+ * estimación en el siguiente SYNC; Base la adopta (cm_clock_adopt) para que
+ * ambos nodos compartan una única base de tiempos.
+ *
+ * El estimador no depende de ESP-IDF (puro C) para poder usarse en las
+ * herramientas de host. El acceso concurrente lo protege cada firmware.
+ */
+
+#ifndef CM_CLOCK_H
+#define CM_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+/** Intercambios recientes entre los que se elige el de menor delay */
+#define CM_CLOCK_FILTER_SIZE        8
+
+/** Intercambios necesarios antes de considerar válida la estimación */
+#define CM_CLOCK_MIN_SAMPLES        4
+
+/** Intercambios con delay mayor se descartan (reintentos, tareas bloqueadas) */
+#define CM_CLOCK_MAX_DELAY_US       (50 * 1000)
+
+/** Salto de offset que indica reinicio del par: se reinicia el estimador */
+#define CM_CLOCK_STEP_US            (50 * 1000)
+
+/** Separación mínima entre muestras para estimar la deriva */
+#define CM_CLOCK_DRIFT_SPAN_US      (30 * 1000 * 1000)
+
+/** Deriva máxima aceptada (cristales de ±20 ppm con mucho margen) */
+#define CM_CLOCK_DRIFT_MAX_PPM      500.0
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/** @brief Un intercambio SYNC/DATA completo */
+typedef struct {
+    int64_t offset_us;      ///< Reloj del par - reloj local
+    int64_t delay_us;       ///< Ida y vuelta sin el tiempo de proceso del par
+    int64_t local_us;       ///< Reloj local al completar el intercambio (t4)
+} cm_clock_sample_t;
+
+/** @brief Estado del estimador (un par por instancia) */
+typedef struct {
+    cm_clock_sample_t filter[CM_CLOCK_FILTER_SIZE];
+    uint8_t filter_count;
+    uint8_t filter_head;
+
+    int64_t ref_local_us;       ///< Instante local de la última muestra aplicada
+    int64_t ref_offset_us;      ///< Offset en ref_local_us
+    double drift;               ///< d(offset)/d(local) (1e-6 = 1 ppm)
+    bool drift_valid;
+    int64_t anchor_local_us;    ///< Muestra de referencia para la deriva
+    int64_t anchor_offset_us;
+
+    int64_t last_delay_us;      ///< Delay del último intercambio aceptado
+    uint32_t samples;           ///< Intercambios aceptados desde el último reinicio
+    uint32_t rejected;          ///< Intercambios descartados por delay
+    uint32_t steps;             ///< Reinicios por salto de offset
+    bool valid;
+} cm_clock_t;
+
+// ============================================================================
+// ESTIMADOR
+// ============================================================================
+
+/**
+ * @brief Reinicia el estimador (sin estimación válida)
+ */
+void cm_clock_reset(cm_clock_t *clk);
+
+/**
+ * @brief Añade un intercambio completo (lado que inicia: Consola)
+ *
+ * @param t1 Reloj local al enviar la petición
+ * @param t2 Reloj del par al recibirla
+ * @param t3 Reloj del par al enviar la respuesta
+ * @param t4 Reloj local al recibir la respuesta
+ * @return true si el intercambio se aceptó
+ */
+bool cm_clock_add_exchange(cm_clock_t *clk, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/**
+ * @brief Adopta el offset estimado por el par (lado que responde: Base)
+ *
+ * Como en cm_clock_add_exchange, la estimación es válida tras
+ * CM_CLOCK_MIN_SAMPLES adopciones consecutivas que difieren entre sí menos
+ * de CM_CLOCK_STEP_US; un salto mayor reinicia la cuenta.
+ *
+ * @param local_us Reloj local en el que se recibió la estimación
+ * @param offset_us Reloj del par - reloj local (el negado de lo que publica el par)
+ */
+void cm_clock_adopt(cm_clock_t *clk, int64_t local_us, int64_t offset_us);
+
+/**
+ * @brief Offset (par - local) previsto en un instante local, con deriva
+ */
+int64_t cm_clock_offset_at(const cm_clock_t *clk, int64_t local_us);
+
+/** @brief Convierte un instante local al reloj del par */
+static inline int64_t cm_clock_to_peer(const cm_clock_t *clk, int64_t local_us) {
+    return local_us + cm_clock_offset_at(clk, local_us);
+}
+
+/** @brief Convierte un instante del reloj del par al reloj local */
+static inline int64_t cm_clock_from_peer(const cm_clock_t *clk, int64_t peer_us) {
+    // La deriva es de ppm: una iteración basta
+    return peer_us - cm_clock_offset_at(clk, peer_us - clk->ref_offset_us);
+}
+
+/**
+ * @brief Instante de inicio de una línea a partir del instante en que se completó
+ *
+ * Resta el tiempo de serialización (10 bits por byte) para que la asimetría
+ * entre SYNC y DATA (longitudes distintas) no sesgue el offset.
+ */
+static inline int64_t cm_clock_frame_start_us(int64_t end_us, size_t bytes, uint32_t baud) {
+    return end_us - (int64_t)((bytes * 10ULL * 1000000ULL) / baud);
+}
+
+// ============================================================================
+// API DE NODO
+// ============================================================================
+//
+// Cada firmware la implementa sobre la instancia de cm_clock_t que alimenta
+// su enlace (Consola: cm_master.c, Base: main.c).
+
+/**
+ * @brief Convierte esp_timer_get_time() local al reloj del otro nodo
+ *
+ * Sin estimación válida devuelve el mismo valor.
+ */
+int64_t cm_time_to_peer(int64_t local_us);
+
+/**
+ * @brief Convierte un timestamp del otro nodo a esp_timer_get_time() local
+ */
+int64_t cm_time_from_peer(int64_t peer_us);
+
+/**
+ * @brief true si hay estimación válida del reloj del otro nodo
+ */
+bool cm_time_peer_synced(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_CLOCK_H
@@ -0,0 +1,83 @@
+/**
+ * @file cm_line.h
+ * @brief Ensamblador de líneas ASCII del enlace RS485 (compartido Consola/Base)
+ *
+ * Acumula bytes hasta '\n' o '\r', descartando caracteres no imprimibles.
+ * Es el mismo código que usan las tareas RX de ambos firmwares y las
+ * herramientas de host (replay, inyección de fallos), de modo que el
+ * comportamiento ante líneas largas o basura es idéntico en todos ellos.
+ */
+
+#ifndef CM_LINE_H
+#define CM_LINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Tamaño del buffer de línea (incluye '\0') */
+#define CM_LINE_BUFFER_SIZE 128
+
+/** Resultado de alimentar un byte al ensamblador */
+typedef enum {
+    CM_LINE_NONE,       ///< Byte acumulado (o ignorado), línea incompleta
+    CM_LINE_READY,      ///< Línea completa disponible en reader->buf
+    CM_LINE_OVERFLOW,   ///< Línea demasiado larga, descartada
+} cm_line_status_t;
+
+/** @brief Estado del ensamblador de líneas */
+typedef struct {
+    char buf[CM_LINE_BUFFER_SIZE];  ///< Línea terminada en '\0' tras CM_LINE_READY
+    size_t pos;                     ///< Bytes acumulados
+} cm_line_reader_t;
+
+/**
+ * @brief Reinicia el ensamblador descartando la línea parcial
+ */
+static inline void cm_line_reader_reset(cm_line_reader_t *reader) {
+    reader->pos = 0;
+}
+
+/**
+ * @brief Procesa un byte recibido
+ *
+ * @param reader Ensamblador
+ * @param byte Byte recibido por UART
+ * @return CM_LINE_READY si reader->buf contiene una línea completa (válida
+ *         hasta la siguiente llamada), CM_LINE_OVERFLOW si se descartó una
+ *         línea por exceder CM_LINE_BUFFER_SIZE - 1, CM_LINE_NONE en otro caso
+ */
+static inline cm_line_status_t cm_line_reader_feed(cm_line_reader_t *reader, uint8_t byte) {
+    // Detectar fin de línea (ignorar \r/\n adicionales)
+    if (byte == '\n' || byte == '\r') {
+        if (reader->pos == 0) {
+            return CM_LINE_NONE;
+        }
+        reader->buf[reader->pos] = '\0';
+        reader->pos = 0;
+        return CM_LINE_READY;
+    }
+
+    // Solo caracteres imprimibles ASCII
+    if (byte < 32 || byte >= 127) {
+        return CM_LINE_NONE;
+    }
+
+    if (reader->pos < CM_LINE_BUFFER_SIZE - 1) {
+        reader->buf[reader->pos++] = (char)byte;
+        return CM_LINE_NONE;
+    }
+
+    // Buffer lleno, descartar línea
+    reader->pos = 0;
+    return CM_LINE_OVERFLOW;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_LINE_H
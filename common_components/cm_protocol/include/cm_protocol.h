@@ -47,6 +47,19 @@ extern "C" {
 /** Tamaño máximo de trama física (stuffed) - peor caso: todos los bytes necesitan stuffing */
 #define CM_MAX_STUFFED_SIZE (1 + CM_MAX_FRAME_SIZE * 2)  // SOF + worst case stuffing
 
+// ============================================================================
+// TEMPORIZACIÓN DEL ENLACE SYNC/DATA
+// ============================================================================
+
+/** Periodo de envío de SYNC desde Consola */
+#define CM_LINK_SYNC_INTERVAL_MS        100
+
+/** Base entra en estado seguro si no recibe ninguna línea en este tiempo */
+#define CM_LINK_WATCHDOG_TIMEOUT_MS     1000
+
+/** Consola marca desconexión si no recibe DATA en este tiempo */
+#define CM_LINK_CONNECTION_TIMEOUT_MS   1000
+
 // ============================================================================
 // COMANDOS DEL MAESTRO (Consola -> Sala de Máquinas)
 // ============================================================================
@@ -81,6 +94,9 @@ extern "C" {
 /** Solicitar estado de ventiladores - Sin payload */
 #define CM_CMD_GET_FAN_STATE        0x24
 
+/** Sincronización completa de objetivos - Payload: CM_SYNC_BIN_SIZE bytes (ver cm_schema.h) */
+#define CM_CMD_SYNC                 0x30
+
 // ============================================================================
 // COMANDOS DEL ESCLAVO (Sala de Máquinas -> Consola)
 // ============================================================================
@@ -103,6 +119,9 @@ extern "C" {
 /** Respuesta: estado de ventiladores - Payload: 2 bytes (head_fan, chest_fan) */
 #define CM_RSP_FAN_STATE            0xA4
 
+/** Respuesta a SYNC: valores reales - Payload: CM_DATA_BIN_SIZE bytes (ver cm_schema.h) */
+#define CM_RSP_DATA                 0xB0
+
 // ============================================================================
 // CÓDIGOS DE ERROR (NAK)
 // ============================================================================
@@ -0,0 +1,401 @@
+/**
+ * @file cm_schema.h
+ * @brief Esquema único de los mensajes del enlace (Consola <-> Base)
+ *
+ * El orden, tipo y formato de cada campo se define UNA sola vez mediante
+ * X-macros. A partir de esa lista se generan en tiempo de compilación:
+ * - Las estructuras de mensaje (cm_sync_msg_t, cm_data_msg_t)
+ * - Los codificadores/decodificadores ASCII ("SYNC=..."/"DATA=...")
+ * - Los codificadores/decodificadores binarios (payload big-endian, solo SYNC/DATA)
+ *
+ * Añadir un campo = añadir una línea a la lista correspondiente. Consola y
+ * Base compilan contra el mismo header, por lo que no pueden desincronizarse.
+ *
+ * Tipos de campo disponibles:
+ * - F2: float con 2 decimales (ASCII "%.2f", binario int16 ×100)
+ * - F1: float con 1 decimal   (ASCII "%.1f", binario int16 ×10)
+ * - U8: entero sin signo 0-255 (ASCII "%u",  binario 1 byte)
+ * - U32: entero sin signo 32 bits (ASCII decimal, binario 4 bytes)
+ * - I64: entero con signo 64 bits (ASCII decimal, binario 8 bytes)
+ * - S16: texto de hasta 15 caracteres sin ',' (solo ASCII, mensajes sin codec binario)
+ */
+
+#ifndef CM_SCHEMA_H
+#define CM_SCHEMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// DEFINICIÓN DE CAMPOS
+// ============================================================================
+
+/**
+ * @brief SYNC (Consola -> Base): objetivos de control
+ * Formato ASCII: SYNC=speed,incline,fan_head,fan_chest,wax,training_mode,
+ *                     ramp_mode,profile_id,tx_us,clock_offset_us,clock_valid
+ *
+ * ramp_mode (CM_RAMP_*): perfil de aceleración/deceleración que Base programa
+ * en el VFD. Consola envía la consigna final una sola vez; la rampa la hace
+ * el variador.
+ *
+ * profile_id: perfil de movimiento que Consola quiere en marcha (0 = ninguno).
+ * Mientras Base ejecuta o terminó ese perfil, ignora speed e incline del SYNC;
+ * un SYNC con otro profile_id cancela el perfil en curso.
+ *
+ * Campos de reloj (ver cm_clock.h):
+ * - tx_us: esp_timer_get_time() de Consola al enviar (t1)
+ * - clock_offset_us: estimación de Consola de (reloj Base - reloj Consola)
+ * - clock_valid: 1 si clock_offset_us es fiable
+ */
+#define CM_SYNC_SCHEMA(X)            \
+    X(F2, target_speed_kmh)          \
+    X(F2, target_incline_pct)        \
+    X(U8, fan_head)                  \
+    X(U8, fan_chest)                 \
+    X(U8, wax_pump)                  \
+    X(U8, training_mode)             \
+    X(U8, ramp_mode)                 \
+    X(U8, profile_id)                \
+    X(I64, tx_us)                    \
+    X(I64, clock_offset_us)          \
+    X(U8, clock_valid)
+
+/**
+ * @brief DATA (Base -> Consola): valores reales medidos
+ * Formato ASCII: DATA=speed,incline,vfd_freq,vfd_fault,fan_head,fan_chest,incline_fault,
+ *                     profile_id,profile_state,profile_segment,profile_left_ms,
+ *                     sync_tx_us,rx_us,turnaround_us
+ *
+ * Progreso del perfil de movimiento: último perfil recibido, su estado
+ * (CM_PROFILE_*), segmento en curso y ms que le quedan.
+ *
+ * Campos de reloj (ver cm_clock.h):
+ * - sync_tx_us: eco del tx_us del SYNC que se responde (0 si no responde a un SYNC)
+ * - rx_us: reloj de Base al recibir ese SYNC (t2)
+ * - turnaround_us: tiempo entre la recepción del SYNC y el envío de este DATA (t3 - t2)
+ */
+#define CM_DATA_SCHEMA(X)            \
+    X(F2, real_speed_kmh)            \
+    X(F1, real_incline_pct)          \
+    X(F2, vfd_freq_hz)               \
+    X(U8, vfd_fault)                 \
+    X(U8, fan_head)                  \
+    X(U8, fan_chest)                 \
+    X(U8, incline_fault)             \
+    X(U8, profile_id)                \
+    X(U8, profile_state)             \
+    X(U8, profile_segment)           \
+    X(U32, profile_left_ms)          \
+    X(I64, sync_tx_us)               \
+    X(I64, rx_us)                    \
+    X(U32, turnaround_us)
+
+/**
+ * @brief Perfil de movimiento (Consola -> Base), fuera del ciclo SYNC/DATA
+ *
+ * Una línea PSEG por segmento y, al final, PROFILE con el número de
+ * segmentos: Base lo arranca solo si recibió todos los PSEG de ese
+ * profile_id. Cada segmento dura duration_ms; con el bit CM_PROFILE_RAMP_* la
+ * magnitud va en línea recta desde el final del segmento anterior, sin él
+ * salta al valor al empezar el segmento. Consola repite las líneas hasta que
+ * DATA confirma el profile_id (reenviar un perfil ya arrancado no tiene efecto).
+ *
+ * PSEG=profile_id,index,duration_ms,speed_kmh,incline_pct,ramp
+ * PROFILE=profile_id,segment_count
+ */
+#define CM_PROFILE_SEG_SCHEMA(X)     \
+    X(U8, profile_id)                \
+    X(U8, index)                     \
+    X(U32, duration_ms)              \
+    X(F2, speed_kmh)                 \
+    X(F1, incline_pct)               \
+    X(U8, ramp)
+
+#define CM_PROFILE_SCHEMA(X)         \
+    X(U8, profile_id)                \
+    X(U8, segment_count)
+
+/**
+ * @brief Estadísticas de Base, fuera del ciclo SYNC/DATA
+ *
+ * Consola pide "STATS=1"; Base responde desde una tarea de baja prioridad con
+ * una línea STASK por tarea, una SSLOT por slot del ejecutivo, SMB, SLINK,
+ * SNVS y, al final, SSYS. SSYS cierra la respuesta: lleva cuántas líneas
+ * STASK/SSLOT se enviaron para que Consola descarte respuestas incompletas.
+ *
+ * SSYS=uptime_s,window_ms,heap_free,heap_min,runtime_stats,task_count,slot_count,frame_overruns
+ * - window_ms: intervalo al que se refiere el reparto de CPU (desde la petición anterior)
+ * - runtime_stats: 0 si Base se compiló sin CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+ */
+#define CM_STATS_SYS_SCHEMA(X)       \
+    X(U32, uptime_s)                 \
+    X(U32, window_ms)                \
+    X(U32, heap_free)                \
+    X(U32, heap_min)                 \
+    X(U8, runtime_stats)             \
+    X(U8, task_count)                \
+    X(U8, slot_count)                \
+    X(U32, frame_overruns)
+
+/**
+ * STASK=index,name,cpu_permille,stack_free,prio,core
+ * - cpu_permille: ‰ de la CPU total (todos los núcleos) en window_ms
+ * - stack_free: mínimo de pila libre desde el arranque, en bytes
+ * - core: núcleo fijado (255 = cualquiera)
+ */
+#define CM_STATS_TASK_SCHEMA(X)      \
+    X(U8, index)                     \
+    X(S16, name)                     \
+    X(U32, cpu_permille)             \
+    X(U32, stack_free)               \
+    X(U8, prio)                      \
+    X(U8, core)
+
+/** SSLOT=index,name,runs,overruns,jitter_avg_us,jitter_max_us,exec_avg_us,exec_max_us */
+#define CM_STATS_SLOT_SCHEMA(X)      \
+    X(U8, index)                     \
+    X(S16, name)                     \
+    X(U32, runs)                     \
+    X(U32, overruns)                 \
+    X(U32, jitter_avg_us)            \
+    X(U32, jitter_max_us)            \
+    X(U32, exec_avg_us)              \
+    X(U32, exec_max_us)
+
+/**
+ * SMB=transactions,errors,timeouts,invalid,retries,timeout_ms,rtt_p50_ms,rtt_p99_ms (Modbus con el VFD)
+ * - timeout_ms: timeout de respuesta vigente (3 × p99, adaptativo)
+ * - rtt_p50_ms/rtt_p99_ms: tiempo de respuesta del VFD, ventana reciente (0 = sin medidas)
+ */
+#define CM_STATS_MB_SCHEMA(X)        \
+    X(U32, transactions)             \
+    X(U32, errors)                   \
+    X(U32, timeouts)                 \
+    X(U32, invalid)                  \
+    X(U32, retries)                  \
+    X(U32, timeout_ms)               \
+    X(U32, rtt_p50_ms)               \
+    X(U32, rtt_p99_ms)
+
+/** SLINK=uart_overruns,uart_errors,line_overflows,frames_bad,watchdog_trips,watchdog_late_max_us */
+#define CM_STATS_LINK_SCHEMA(X)      \
+    X(U32, uart_overruns)            \
+    X(U32, uart_errors)              \
+    X(U32, line_overflows)           \
+    X(U32, frames_bad)               \
+    X(U32, watchdog_trips)           \
+    X(U32, watchdog_late_max_us)
+
+/** SNVS=writes,errors,flush_hints,commit_max_us */
+#define CM_STATS_NVS_SCHEMA(X)       \
+    X(U32, writes)                   \
+    X(U32, errors)                   \
+    X(U32, flush_hints)              \
+    X(U32, commit_max_us)
+
+/** Valores de ramp_mode (SYNC) */
+#define CM_RAMP_NORMAL          0   ///< Cambios de velocidad del usuario
+#define CM_RAMP_STOP            1   ///< Pausa: deceleración rápida hasta 0
+#define CM_RAMP_COOLDOWN        2   ///< Enfriamiento: deceleración lenta hasta 0
+
+/** Deceleración del perfil CM_RAMP_COOLDOWN (Consola baja la inclinación al mismo ritmo) */
+#define CM_RAMP_COOLDOWN_KMH_S  (10.0f / 120.0f)
+
+/** Perfiles de movimiento */
+#define CM_PROFILE_MAX_SEGMENTS 16
+#define CM_PROFILE_RAMP_SPEED   0x01    ///< Velocidad en rampa durante el segmento
+#define CM_PROFILE_RAMP_INCLINE 0x02    ///< Inclinación en rampa durante el segmento
+
+/** Valores de profile_state (DATA) */
+#define CM_PROFILE_IDLE         0   ///< Ningún perfil desde el arranque
+#define CM_PROFILE_RUNNING      1
+#define CM_PROFILE_DONE         2   ///< Terminado: Base mantiene las consignas del último segmento
+#define CM_PROFILE_ABORTED      3   ///< Cancelado por Consola, safe state o fin del entrenamiento
+
+/** Límites de una respuesta STATS */
+#define CM_STATS_MAX_TASKS      32
+#define CM_STATS_MAX_SLOTS      8
+
+/** Prefijos ASCII de cada mensaje */
+#define CM_SYNC_ASCII_PREFIX    "SYNC="
+#define CM_DATA_ASCII_PREFIX    "DATA="
+#define CM_PROFILE_SEG_PREFIX   "PSEG="
+#define CM_PROFILE_PREFIX       "PROFILE="
+#define CM_STATS_REQUEST_PREFIX "STATS="
+#define CM_STATS_SYS_PREFIX     "SSYS="
+#define CM_STATS_TASK_PREFIX    "STASK="
+#define CM_STATS_SLOT_PREFIX    "SSLOT="
+#define CM_STATS_MB_PREFIX      "SMB="
+#define CM_STATS_LINK_PREFIX    "SLINK="
+#define CM_STATS_NVS_PREFIX     "SNVS="
+
+/** Tamaño máximo de una línea ASCII codificada (incluye '\n' y '\0') */
+#define CM_SCHEMA_ASCII_MAX     128
+
+// ============================================================================
+// PROPIEDADES DE CADA TIPO DE CAMPO
+// ============================================================================
+
+#define CM_FIELD_CTYPE_F2       float
+#define CM_FIELD_CTYPE_F1       float
+#define CM_FIELD_CTYPE_U8       uint8_t
+#define CM_FIELD_CTYPE_U32      uint32_t
+#define CM_FIELD_CTYPE_I64      int64_t
+#define CM_FIELD_CTYPE_S16      cm_name16_t
+
+#define CM_FIELD_BIN_SIZE_F2    2
+#define CM_FIELD_BIN_SIZE_F1    2
+#define CM_FIELD_BIN_SIZE_U8    1
+#define CM_FIELD_BIN_SIZE_U32   4
+#define CM_FIELD_BIN_SIZE_I64   8
+
+/** @brief Texto corto terminado en '\0' (campo S16) */
+typedef struct {
+    char s[16];
+} cm_name16_t;
+
+// ============================================================================
+// ESTRUCTURAS GENERADAS
+// ============================================================================
+
+#define CM_SCHEMA_MEMBER(kind, name)        CM_FIELD_CTYPE_##kind name;
+#define CM_SCHEMA_COUNT(kind, name)         + 1
+#define CM_SCHEMA_BIN_SIZE(kind, name)      + CM_FIELD_BIN_SIZE_##kind
+
+/** @brief Mensaje SYNC decodificado */
+typedef struct {
+    CM_SYNC_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_sync_msg_t;
+
+/** @brief Mensaje DATA decodificado */
+typedef struct {
+    CM_DATA_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_data_msg_t;
+
+/** @brief Líneas de un perfil de movimiento */
+typedef struct {
+    CM_PROFILE_SEG_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_profile_seg_msg_t;
+
+typedef struct {
+    CM_PROFILE_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_profile_msg_t;
+
+/** @brief Líneas de la respuesta STATS */
+typedef struct {
+    CM_STATS_SYS_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_sys_msg_t;
+
+typedef struct {
+    CM_STATS_TASK_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_task_msg_t;
+
+typedef struct {
+    CM_STATS_SLOT_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_slot_msg_t;
+
+typedef struct {
+    CM_STATS_MB_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_mb_msg_t;
+
+typedef struct {
+    CM_STATS_LINK_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_link_msg_t;
+
+typedef struct {
+    CM_STATS_NVS_SCHEMA(CM_SCHEMA_MEMBER)
+} cm_stats_nvs_msg_t;
+
+enum {
+    CM_SYNC_FIELD_COUNT = 0 CM_SYNC_SCHEMA(CM_SCHEMA_COUNT),   ///< Nº de campos de SYNC
+    CM_DATA_FIELD_COUNT = 0 CM_DATA_SCHEMA(CM_SCHEMA_COUNT),   ///< Nº de campos de DATA
+    CM_SYNC_BIN_SIZE = 0 CM_SYNC_SCHEMA(CM_SCHEMA_BIN_SIZE),   ///< Bytes del payload binario SYNC
+    CM_DATA_BIN_SIZE = 0 CM_DATA_SCHEMA(CM_SCHEMA_BIN_SIZE),   ///< Bytes del payload binario DATA
+};
+
+// ============================================================================
+// CODIFICACIÓN / DECODIFICACIÓN
+// ============================================================================
+
+/**
+ * @brief Codifica un SYNC como línea ASCII terminada en '\n'
+ *
+ * @param msg Mensaje a codificar
+ * @param buf Buffer de salida (recomendado CM_SCHEMA_ASCII_MAX bytes)
+ * @param max Tamaño del buffer
+ * @return Longitud de la línea (sin '\0'), o 0 si el buffer es insuficiente
+ */
+size_t cm_sync_encode_ascii(const cm_sync_msg_t *msg, char *buf, size_t max);
+
+/**
+ * @brief Decodifica una línea "SYNC=..." (sin '\n')
+ *
+ * @return true solo si el prefijo es correcto y se leen exactamente
+ *         CM_SYNC_FIELD_COUNT campos válidos
+ */
+bool cm_sync_decode_ascii(const char *line, cm_sync_msg_t *msg);
+
+/**
+ * @brief Codifica un SYNC como payload binario big-endian
+ *
+ * @return CM_SYNC_BIN_SIZE, o 0 si el buffer es insuficiente
+ */
+size_t cm_sync_encode_bin(const cm_sync_msg_t *msg, uint8_t *buf, size_t max);
+
+/**
+ * @brief Decodifica un payload binario SYNC
+ *
+ * @return true si len == CM_SYNC_BIN_SIZE
+ */
+bool cm_sync_decode_bin(const uint8_t *buf, size_t len, cm_sync_msg_t *msg);
+
+/** @brief Codifica un DATA como línea ASCII (ver cm_sync_encode_ascii) */
+size_t cm_data_encode_ascii(const cm_data_msg_t *msg, char *buf, size_t max);
+
+/** @brief Decodifica una línea "DATA=..." (ver cm_sync_decode_ascii) */
+bool cm_data_decode_ascii(const char *line, cm_data_msg_t *msg);
+
+/** @brief Codifica un DATA como payload binario (ver cm_sync_encode_bin) */
+size_t cm_data_encode_bin(const cm_data_msg_t *msg, uint8_t *buf, size_t max);
+
+/** @brief Decodifica un payload binario DATA (ver cm_sync_decode_bin) */
+bool cm_data_decode_bin(const uint8_t *buf, size_t len, cm_data_msg_t *msg);
+
+/** @brief Codificadores/decodificadores ASCII del perfil de movimiento */
+size_t cm_profile_seg_encode_ascii(const cm_profile_seg_msg_t *msg, char *buf, size_t max);
+size_t cm_profile_encode_ascii(const cm_profile_msg_t *msg, char *buf, size_t max);
+bool cm_profile_seg_decode_ascii(const char *line, cm_profile_seg_msg_t *msg);
+bool cm_profile_decode_ascii(const char *line, cm_profile_msg_t *msg);
+
+/** @brief Codificadores ASCII de las líneas STATS (ver cm_sync_encode_ascii) */
+size_t cm_stats_sys_encode_ascii(const cm_stats_sys_msg_t *msg, char *buf, size_t max);
+size_t cm_stats_task_encode_ascii(const cm_stats_task_msg_t *msg, char *buf, size_t max);
+size_t cm_stats_slot_encode_ascii(const cm_stats_slot_msg_t *msg, char *buf, size_t max);
+size_t cm_stats_mb_encode_ascii(const cm_stats_mb_msg_t *msg, char *buf, size_t max);
+size_t cm_stats_link_encode_ascii(const cm_stats_link_msg_t *msg, char *buf, size_t max);
+size_t cm_stats_nvs_encode_ascii(const cm_stats_nvs_msg_t *msg, char *buf, size_t max);
+
+/** @brief Decodificadores ASCII de las líneas STATS (ver cm_sync_decode_ascii) */
+bool cm_stats_sys_decode_ascii(const char *line, cm_stats_sys_msg_t *msg);
+bool cm_stats_task_decode_ascii(const char *line, cm_stats_task_msg_t *msg);
+bool cm_stats_slot_decode_ascii(const char *line, cm_stats_slot_msg_t *msg);
+bool cm_stats_mb_decode_ascii(const char *line, cm_stats_mb_msg_t *msg);
+bool cm_stats_link_decode_ascii(const char *line, cm_stats_link_msg_t *msg);
+bool cm_stats_nvs_decode_ascii(const char *line, cm_stats_nvs_msg_t *msg);
+
+/**
+ * @brief Copia un texto en un campo S16 (truncado a 15 caracteres, ',' -> '_')
+ */
+void cm_name16_set(cm_name16_t *dst, const char *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CM_SCHEMA_H
@@ -0,0 +1,106 @@
+/**
+ * @file cm_blackbox.c
+ * @brief Líneas BBOX/BLACKBOX del enlace (ver cm_blackbox_format.h)
+ */
+
+#include "cm_blackbox_format.h"
+#include "cm_crc16.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(cm_bbox_header_t) == 24, "cm_bbox_header_t cambió de tamaño");
+_Static_assert(sizeof(cm_bbox_record_t) == 24, "cm_bbox_record_t cambió de tamaño");
+_Static_assert(sizeof(cm_bbox_header_t) <= CM_BBOX_LINE_DATA_MAX, "La cabecera no cabe en una línea");
+
+static const char k_hex[] = "0123456789ABCDEF";
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/** Lee un entero decimal hasta sep; avanza *p tras el separador */
+static bool parse_u16(const char **p, char sep, uint16_t *out) {
+    char *end;
+    unsigned long v = strtoul(*p, &end, 10);
+    if (end == *p || *end != sep || v > 0xFFFF) {
+        return false;
+    }
+    *out = (uint16_t)v;
+    *p = end + 1;
+    return true;
+}
+
+size_t cm_bbox_line_encode(uint16_t dump, uint16_t line, const void *data, size_t len,
+                           char *out, size_t out_size) {
+    if (len > CM_BBOX_LINE_DATA_MAX) {
+        return 0;
+    }
+    int n = snprintf(out, out_size, CM_BBOX_LINE_PREFIX "%u,%u,", (unsigned)dump, (unsigned)line);
+    if (n < 0 || (size_t)n + len * 2 + 6 > out_size) {
+        return 0;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    char *pos = out + n;
+    for (size_t i = 0; i < len; i++) {
+        *pos++ = k_hex[bytes[i] >> 4];
+        *pos++ = k_hex[bytes[i] & 0x0F];
+    }
+    uint16_t crc = cm_crc16_calculate(bytes, len);
+    *pos++ = ',';
+    for (int shift = 12; shift >= 0; shift -= 4) {
+        *pos++ = k_hex[(crc >> shift) & 0x0F];
+    }
+    *pos = '\0';
+    return (size_t)(pos - out);
+}
+
+bool cm_bbox_line_decode(const char *line, uint16_t *dump, uint16_t *line_no,
+                         uint8_t *data, size_t *len) {
+    if (strncmp(line, CM_BBOX_LINE_PREFIX, sizeof(CM_BBOX_LINE_PREFIX) - 1) != 0) {
+        return false;
+    }
+    const char *p = line + sizeof(CM_BBOX_LINE_PREFIX) - 1;
+    if (!parse_u16(&p, ',', dump) || !parse_u16(&p, ',', line_no)) {
+        return false;
+    }
+
+    size_t n = 0;
+    while (*p != ',' && *p != '\0') {
+        int hi = hex_nibble(p[0]);
+        int lo = (hi >= 0) ? hex_nibble(p[1]) : -1;
+        if (lo < 0 || n >= CM_BBOX_LINE_DATA_MAX) {
+            return false;
+        }
+        data[n++] = (uint8_t)((hi << 4) | lo);
+        p += 2;
+    }
+    if (*p != ',' || strlen(p + 1) != 4) {
+        return false;
+    }
+    uint16_t crc = 0;
+    for (int i = 1; i <= 4; i++) {
+        int v = hex_nibble(p[i]);
+        if (v < 0) {
+            return false;
+        }
+        crc = (uint16_t)((crc << 4) | v);
+    }
+    if (crc != cm_crc16_calculate(data, n)) {
+        return false;
+    }
+    *len = n;
+    return true;
+}
+
+bool cm_bbox_request_decode(const char *line, uint16_t *dump, uint16_t *line_no) {
+    if (strncmp(line, CM_BBOX_REQUEST_PREFIX, sizeof(CM_BBOX_REQUEST_PREFIX) - 1) != 0) {
+        return false;
+    }
+    const char *p = line + sizeof(CM_BBOX_REQUEST_PREFIX) - 1;
+    return parse_u16(&p, ',', dump) && parse_u16(&p, '\0', line_no);
+}
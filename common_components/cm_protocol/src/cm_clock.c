@@ -0,0 +1,132 @@
+/**
+ * @file cm_clock.c
+ * @brief Estimador de offset y deriva entre relojes de Consola y Base
+ *
+ * Filtro de mínimo delay (como el clock filter de NTP): de los últimos
+ * CM_CLOCK_FILTER_SIZE intercambios se usa el de menor ida y vuelta, que es
+ * el que menos error de asimetría puede tener (|error| <= delay / 2). La
+ * deriva se obtiene de la pendiente entre muestras separadas al menos
+ * CM_CLOCK_DRIFT_SPAN_US y se suaviza con una media exponencial.
+ */
+
+#include "cm_clock.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+/** Peso de cada nueva medida de deriva en la media exponencial */
+#define CLOCK_DRIFT_ALPHA   0.25
+
+void cm_clock_reset(cm_clock_t *clk) {
+    memset(clk, 0, sizeof(*clk));
+}
+
+int64_t cm_clock_offset_at(const cm_clock_t *clk, int64_t local_us) {
+    if (!clk->valid) {
+        return 0;
+    }
+    int64_t offset = clk->ref_offset_us;
+    if (clk->drift_valid) {
+        offset += (int64_t)llround(clk->drift * (double)(local_us - clk->ref_local_us));
+    }
+    return offset;
+}
+
+/**
+ * @brief Aplica una muestra seleccionada al modelo offset + deriva
+ */
+static void clock_apply(cm_clock_t *clk, int64_t local_us, int64_t offset_us) {
+    // Salto brusco: el par se ha reiniciado (su esp_timer vuelve a 0)
+    if (clk->valid) {
+        int64_t predicted = cm_clock_offset_at(clk, local_us);
+        if (llabs(offset_us - predicted) > CM_CLOCK_STEP_US) {
+            uint32_t steps = clk->steps + 1;
+            uint32_t rejected = clk->rejected;
+            cm_clock_reset(clk);
+            clk->steps = steps;
+            clk->rejected = rejected;
+        }
+    }
+
+    if (clk->anchor_local_us == 0) {
+        clk->anchor_local_us = local_us;
+        clk->anchor_offset_us = offset_us;
+    } else if ((local_us - clk->anchor_local_us) >= CM_CLOCK_DRIFT_SPAN_US) {
+        double raw = (double)(offset_us - clk->anchor_offset_us) /
+                     (double)(local_us - clk->anchor_local_us);
+        if (fabs(raw) <= CM_CLOCK_DRIFT_MAX_PPM * 1e-6) {
+            clk->drift = clk->drift_valid ? clk->drift + CLOCK_DRIFT_ALPHA * (raw - clk->drift) : raw;
+            clk->drift_valid = true;
+        }
+        clk->anchor_local_us = local_us;
+        clk->anchor_offset_us = offset_us;
+    }
+
+    clk->ref_local_us = local_us;
+    clk->ref_offset_us = offset_us;
+}
+
+bool cm_clock_add_exchange(cm_clock_t *clk, int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t delay = (t4 - t1) - (t3 - t2);
+    if (t4 < t1 || t3 < t2 || delay < 0 || delay > CM_CLOCK_MAX_DELAY_US) {
+        clk->rejected++;
+        return false;
+    }
+
+    cm_clock_sample_t sample = {
+        .offset_us = ((t2 - t1) + (t3 - t4)) / 2,
+        .delay_us = delay,
+        .local_us = t4,
+    };
+    clk->filter[clk->filter_head] = sample;
+    clk->filter_head = (clk->filter_head + 1) % CM_CLOCK_FILTER_SIZE;
+    if (clk->filter_count < CM_CLOCK_FILTER_SIZE) {
+        clk->filter_count++;
+    }
+    clk->last_delay_us = delay;
+    clk->samples++;
+
+    // Seleccionar la muestra de menor delay de la ventana
+    const cm_clock_sample_t *best = &clk->filter[0];
+    for (uint8_t i = 1; i < clk->filter_count; i++) {
+        if (clk->filter[i].delay_us < best->delay_us) {
+            best = &clk->filter[i];
+        }
+    }
+
+    // Solo avanzar el modelo con muestras más recientes que la ya aplicada
+    if (best->local_us > clk->ref_local_us) {
+        cm_clock_sample_t chosen = *best;
+        bool was_valid = clk->valid;
+        clock_apply(clk, chosen.local_us, chosen.offset_us);
+        if (was_valid && !clk->valid) {
+            // Reinicio por salto: la ventana anterior ya no sirve
+            clk->filter[0] = chosen;
+            clk->filter_count = 1;
+            clk->filter_head = 1;
+            clk->samples = 1;
+        }
+    }
+
+    if (clk->samples >= CM_CLOCK_MIN_SAMPLES) {
+        clk->valid = true;
+    }
+    return true;
+}
+
+void cm_clock_adopt(cm_clock_t *clk, int64_t local_us, int64_t offset_us) {
+    // Hasta ser válida, una estimación que no coincide con la anterior
+    // (Consola recién reiniciada o aún convergiendo) vuelve a empezar la cuenta
+    if (!clk->valid && clk->samples > 0 &&
+        llabs(offset_us - clk->ref_offset_us) > CM_CLOCK_STEP_US) {
+        uint32_t steps = clk->steps;
+        uint32_t rejected = clk->rejected;
+        cm_clock_reset(clk);
+        clk->steps = steps;
+        clk->rejected = rejected;
+    }
+
+    clock_apply(clk, local_us, offset_us);
+    clk->samples++;
+    clk->valid = (clk->samples >= CM_CLOCK_MIN_SAMPLES);
+}
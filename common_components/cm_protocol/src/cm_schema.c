@@ -0,0 +1,317 @@
+/**
+ * @file cm_schema.c
+ * @brief Codificadores del enlace generados a partir de cm_schema.h
+ *
+ * Cada tipo de campo (F2, F1, U8, U32, I64, S16) tiene un par de rutinas especializadas
+ * para ASCII y otro para binario. Las macros de CM_*_SCHEMA expanden una
+ * llamada por campo, de modo que el compilador genera código lineal sin
+ * tablas ni cadenas de formato interpretadas en tiempo de ejecución.
+ */
+
+#include "cm_schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+// ============================================================================
+// ASCII - ESCRITURA
+// ============================================================================
+
+typedef struct {
+    char *pos;
+    char *end;
+    bool ok;
+} cm_ascii_writer_t;
+
+static void ascii_put_fmt_float(cm_ascii_writer_t *w, const char *fmt, float value) {
+    if (!w->ok) {
+        return;
+    }
+    int n = snprintf(w->pos, (size_t)(w->end - w->pos), fmt, value);
+    if (n < 0 || n >= (w->end - w->pos)) {
+        w->ok = false;
+        return;
+    }
+    w->pos += n;
+}
+
+static inline void ascii_put_F2(cm_ascii_writer_t *w, float value) {
+    ascii_put_fmt_float(w, "%.2f", value);
+}
+
+static inline void ascii_put_F1(cm_ascii_writer_t *w, float value) {
+    ascii_put_fmt_float(w, "%.1f", value);
+}
+
+/** Entero en decimal sin snprintf (el formato de 64 bits no es portable en newlib-nano) */
+static void ascii_put_uint(cm_ascii_writer_t *w, uint64_t value, bool negative) {
+    char digits[21];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    if (negative) {
+        digits[n++] = '-';
+    }
+
+    if (!w->ok || (w->end - w->pos) <= n) {
+        w->ok = false;
+        return;
+    }
+    while (n > 0) {
+        *w->pos++ = digits[--n];
+    }
+}
+
+static inline void ascii_put_U8(cm_ascii_writer_t *w, uint8_t value) {
+    ascii_put_uint(w, value, false);
+}
+
+static inline void ascii_put_U32(cm_ascii_writer_t *w, uint32_t value) {
+    ascii_put_uint(w, value, false);
+}
+
+static inline void ascii_put_I64(cm_ascii_writer_t *w, int64_t value) {
+    // Magnitud calculada en unsigned para cubrir INT64_MIN
+    uint64_t mag = (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value;
+    ascii_put_uint(w, mag, value < 0);
+}
+
+static inline void ascii_put_char(cm_ascii_writer_t *w, char c) {
+    if (!w->ok || (w->end - w->pos) <= 1) {
+        w->ok = false;
+        return;
+    }
+    *w->pos++ = c;
+}
+
+static inline void ascii_put_str(cm_ascii_writer_t *w, const char *s, size_t len) {
+    if (!w->ok || (size_t)(w->end - w->pos) <= len) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->pos, s, len);
+    w->pos += len;
+}
+
+static inline void ascii_put_S16(cm_ascii_writer_t *w, cm_name16_t value) {
+    ascii_put_str(w, value.s, strnlen(value.s, sizeof(value.s) - 1));
+}
+
+// ============================================================================
+// ASCII - LECTURA
+// ============================================================================
+
+static bool ascii_get_float(const char **p, float *out) {
+    char *end;
+    float value = strtof(*p, &end);
+    if (end == *p || !isfinite(value)) {
+        return false;
+    }
+    *out = value;
+    *p = end;
+    return true;
+}
+
+static inline bool ascii_get_F2(const char **p, float *out) {
+    return ascii_get_float(p, out);
+}
+
+static inline bool ascii_get_F1(const char **p, float *out) {
+    return ascii_get_float(p, out);
+}
+
+static inline bool ascii_get_U8(const char **p, uint8_t *out) {
+    char *end;
+    long value = strtol(*p, &end, 10);
+    if (end == *p || value < 0 || value > 255) {
+        return false;
+    }
+    *out = (uint8_t)value;
+    *p = end;
+    return true;
+}
+
+static inline bool ascii_get_U32(const char **p, uint32_t *out) {
+    char *end;
+    if (**p == '-') {
+        return false;
+    }
+    unsigned long long value = strtoull(*p, &end, 10);
+    if (end == *p || value > UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)value;
+    *p = end;
+    return true;
+}
+
+static inline bool ascii_get_I64(const char **p, int64_t *out) {
+    char *end;
+    errno = 0;
+    long long value = strtoll(*p, &end, 10);
+    if (end == *p || errno == ERANGE) {
+        return false;
+    }
+    *out = (int64_t)value;
+    *p = end;
+    return true;
+}
+
+static inline bool ascii_get_S16(const char **p, cm_name16_t *out) {
+    size_t n = 0;
+    while ((*p)[n] != ',' && (*p)[n] != '\0') {
+        if (n >= sizeof(out->s) - 1) {
+            return false;
+        }
+        out->s[n] = (*p)[n];
+        n++;
+    }
+    if (n == 0) {
+        return false;
+    }
+    out->s[n] = '\0';
+    *p += n;
+    return true;
+}
+
+/** Consume el separador ',' si existe. Solo se acepta ',' o fin de línea. */
+static inline bool ascii_get_sep(const char **p) {
+    if (**p == ',') {
+        (*p)++;
+        return true;
+    }
+    return (**p == '\0');
+}
+
+// ============================================================================
+// BINARIO (big-endian, punto fijo)
+// ============================================================================
+
+static inline void bin_put_i16(uint8_t **p, float scaled) {
+    long v = lroundf(scaled);
+    if (v > INT16_MAX) v = INT16_MAX;
+    if (v < INT16_MIN) v = INT16_MIN;
+    uint16_t u = (uint16_t)(int16_t)v;
+    (*p)[0] = (uint8_t)(u >> 8);
+    (*p)[1] = (uint8_t)(u & 0xFF);
+    *p += 2;
+}
+
+static inline int16_t bin_get_i16(const uint8_t **p) {
+    uint16_t u = ((uint16_t)(*p)[0] << 8) | (*p)[1];
+    *p += 2;
+    return (int16_t)u;
+}
+
+static inline void bin_put_be(uint8_t **p, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        *(*p)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static inline uint64_t bin_get_be(const uint8_t **p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | *(*p)++;
+    }
+    return value;
+}
+
+static inline void bin_put_F2(uint8_t **p, float value) { bin_put_i16(p, value * 100.0f); }
+static inline void bin_put_F1(uint8_t **p, float value) { bin_put_i16(p, value * 10.0f); }
+static inline void bin_put_U8(uint8_t **p, uint8_t value) { *(*p)++ = value; }
+static inline void bin_put_U32(uint8_t **p, uint32_t value) { bin_put_be(p, value, 4); }
+static inline void bin_put_I64(uint8_t **p, int64_t value) { bin_put_be(p, (uint64_t)value, 8); }
+
+static inline void bin_get_F2(const uint8_t **p, float *out) { *out = (float)bin_get_i16(p) / 100.0f; }
+static inline void bin_get_F1(const uint8_t **p, float *out) { *out = (float)bin_get_i16(p) / 10.0f; }
+static inline void bin_get_U8(const uint8_t **p, uint8_t *out) { *out = *(*p)++; }
+static inline void bin_get_U32(const uint8_t **p, uint32_t *out) { *out = (uint32_t)bin_get_be(p, 4); }
+static inline void bin_get_I64(const uint8_t **p, int64_t *out) { *out = (int64_t)bin_get_be(p, 8); }
+
+// ============================================================================
+// GENERADOR DE CODECS
+// ============================================================================
+
+#define CM_ENC_ASCII_FIELD(kind, name)  ascii_put_##kind(&w, msg->name); ascii_put_char(&w, ',');
+#define CM_DEC_ASCII_FIELD(kind, name)  if (!ascii_get_##kind(&p, &tmp.name) || !ascii_get_sep(&p)) return false;
+#define CM_ENC_BIN_FIELD(kind, name)    bin_put_##kind(&p, msg->name);
+#define CM_DEC_BIN_FIELD(kind, name)    bin_get_##kind(&p, &tmp.name);
+
+#define CM_SCHEMA_DEFINE_ASCII_CODEC(fn, msg_t, PREFIX, SCHEMA)                    \
+    size_t fn##_encode_ascii(const msg_t *msg, char *buf, size_t max) {              \
+        if (!msg || !buf || max == 0) {                                              \
+            return 0;                                                                \
+        }                                                                            \
+        cm_ascii_writer_t w = { .pos = buf, .end = buf + max, .ok = true };          \
+        ascii_put_str(&w, PREFIX, sizeof(PREFIX) - 1);                               \
+        SCHEMA(CM_ENC_ASCII_FIELD)                                                   \
+        if (!w.ok) {                                                                 \
+            return 0;                                                                \
+        }                                                                            \
+        w.pos[-1] = '\n';  /* La última ',' pasa a ser el fin de línea */            \
+        *w.pos = '\0';                                                               \
+        return (size_t)(w.pos - buf);                                                \
+    }                                                                                \
+                                                                                     \
+    bool fn##_decode_ascii(const char *line, msg_t *msg) {                           \
+        if (!line || !msg || strncmp(line, PREFIX, sizeof(PREFIX) - 1) != 0) {       \
+            return false;                                                            \
+        }                                                                            \
+        const char *p = line + sizeof(PREFIX) - 1;                                   \
+        msg_t tmp;                                                                   \
+        SCHEMA(CM_DEC_ASCII_FIELD)                                                   \
+        if (*p != '\0' || p[-1] == ',') {  /* Campos de más o ',' final */           \
+            return false;                                                            \
+        }                                                                            \
+        *msg = tmp;                                                                  \
+        return true;                                                                 \
+    }
+
+#define CM_SCHEMA_DEFINE_CODEC(fn, msg_t, PREFIX, SCHEMA, BIN_SIZE)                 \
+    CM_SCHEMA_DEFINE_ASCII_CODEC(fn, msg_t, PREFIX, SCHEMA)                         \
+                                                                                     \
+    size_t fn##_encode_bin(const msg_t *msg, uint8_t *buf, size_t max) {             \
+        if (!msg || !buf || max < (BIN_SIZE)) {                                      \
+            return 0;                                                                \
+        }                                                                            \
+        uint8_t *p = buf;                                                            \
+        SCHEMA(CM_ENC_BIN_FIELD)                                                     \
+        return (size_t)(BIN_SIZE);                                                   \
+    }                                                                                \
+                                                                                     \
+    bool fn##_decode_bin(const uint8_t *buf, size_t len, msg_t *msg) {               \
+        if (!buf || !msg || len != (BIN_SIZE)) {                                     \
+            return false;                                                            \
+        }                                                                            \
+        const uint8_t *p = buf;                                                      \
+        msg_t tmp;                                                                   \
+        SCHEMA(CM_DEC_BIN_FIELD)                                                     \
+        *msg = tmp;                                                                  \
+        return true;                                                                 \
+    }
+
+CM_SCHEMA_DEFINE_CODEC(cm_sync, cm_sync_msg_t, CM_SYNC_ASCII_PREFIX, CM_SYNC_SCHEMA, CM_SYNC_BIN_SIZE)
+CM_SCHEMA_DEFINE_CODEC(cm_data, cm_data_msg_t, CM_DATA_ASCII_PREFIX, CM_DATA_SCHEMA, CM_DATA_BIN_SIZE)
+
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_profile_seg, cm_profile_seg_msg_t, CM_PROFILE_SEG_PREFIX, CM_PROFILE_SEG_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_profile, cm_profile_msg_t, CM_PROFILE_PREFIX, CM_PROFILE_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_sys, cm_stats_sys_msg_t, CM_STATS_SYS_PREFIX, CM_STATS_SYS_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_task, cm_stats_task_msg_t, CM_STATS_TASK_PREFIX, CM_STATS_TASK_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_slot, cm_stats_slot_msg_t, CM_STATS_SLOT_PREFIX, CM_STATS_SLOT_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_mb, cm_stats_mb_msg_t, CM_STATS_MB_PREFIX, CM_STATS_MB_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_link, cm_stats_link_msg_t, CM_STATS_LINK_PREFIX, CM_STATS_LINK_SCHEMA)
+CM_SCHEMA_DEFINE_ASCII_CODEC(cm_stats_nvs, cm_stats_nvs_msg_t, CM_STATS_NVS_PREFIX, CM_STATS_NVS_SCHEMA)
+
+void cm_name16_set(cm_name16_t *dst, const char *src) {
+    size_t n = 0;
+    while (src != NULL && src[n] != '\0' && n < sizeof(dst->s) - 1) {
+        dst->s[n] = (src[n] == ',') ? '_' : src[n];
+        n++;
+    }
+    dst->s[n] = '\0';
+}
@@ -0,0 +1,678 @@
+/**
+ * @file link_faults.c
+ * @brief Inyector de fallos para el enlace Consola <-> Base (host, target linux)
+ *
+ * Levanta dos extremos del protocolo SYNC/DATA conectados por dos pares pty
+ * con un inyector de fallos en medio:
+ *
+ *   [Consola] <-pty-> [inyector] <-pty-> [Base]
+ *
+ * Los extremos usan el mismo ensamblador de líneas (cm_line.h), los mismos
+ * codecs (cm_schema.h) y los mismos timeouts (cm_protocol.h) que los
+ * firmwares, y reproducen su lógica de detección:
+ * - Base: watchdog de comunicación y reset_safe_state() con uart_flush
+ * - Consola: desconexión por CONNECTION_TIMEOUT_MS sin DATA válido
+ *
+ * Para cada clase de fallo se mide el tiempo hasta la detección (TTD, desde
+ * el inicio del fallo) y el tiempo hasta la recuperación (TTR, desde el fin
+ * del fallo hasta que ambos extremos vuelven a intercambiar SYNC/DATA
+ * válidos). También se cuentan las corrupciones que pasan el parser sin ser
+ * detectadas.
+ *
+ * Configuración por variables de entorno (todas opcionales):
+ *   CM_FI_FAULT_MS          Duración de cada fallo (3000)
+ *   CM_FI_REPEAT            Repeticiones por clase (3)
+ *   CM_FI_CLASSES           Nombres separados por comas, p. ej. "drop,garbage" (todas)
+ *   CM_FI_DIR               both | c2b | b2c (both)
+ *   CM_FI_SEED              Semilla aleatoria (1)
+ *   CM_FI_WATCHDOG_MS       Timeout del watchdog de Base
+ *   CM_FI_CONN_TIMEOUT_MS   Timeout de conexión de Consola
+ *   CM_FI_DROP_PROB         Probabilidad de pérdida por byte (0.02)
+ *   CM_FI_FLIP_PROB         Probabilidad de bit flip por byte (0.01)
+ *   CM_FI_TRUNC_PROB        Probabilidad de truncar cada línea (0.3)
+ *   CM_FI_GARBAGE_PROB      Probabilidad de ráfaga de basura por línea (0.2)
+ *   CM_FI_GARBAGE_LEN       Bytes por ráfaga de basura (200, máx. 4096)
+ *   CM_FI_LATENCY_MS        Duración de cada pico de latencia (1500)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <pty.h>
+#include "cm_protocol.h"
+#include "cm_line.h"
+#include "cm_schema.h"
+
+// ============================================================================
+// CLASES DE FALLO
+// ============================================================================
+
+typedef enum {
+    FAULT_NONE,
+    FAULT_DROP,         ///< Pérdida aleatoria de bytes
+    FAULT_BITFLIP,      ///< Inversión aleatoria de un bit
+    FAULT_TRUNCATE,     ///< Línea cortada (se pierde la cola, se conserva '\n')
+    FAULT_GARBAGE,      ///< Ráfaga de bytes imprimibles sin '\n'
+    FAULT_LATENCY,      ///< Pico de latencia (el enlace se congela)
+    FAULT_BLACKOUT,     ///< Corte total
+    FAULT_COUNT
+} fault_class_t;
+
+static const char *k_fault_names[FAULT_COUNT] = {
+    "none", "drop", "bitflip", "truncate", "garbage", "latency", "blackout"
+};
+
+/** Tope de CM_FI_GARBAGE_LEN (bytes por ráfaga) */
+#define LINK_FAULTS_GARBAGE_MAX 4096
+
+typedef struct {
+    double drop_prob;
+    double flip_prob;
+    double trunc_prob;
+    double garbage_prob;
+    int garbage_len;
+    int latency_ms;
+    bool inject_c2b;
+    bool inject_b2c;
+} fault_params_t;
+
+// ============================================================================
+// VALORES DE REFERENCIA
+// ============================================================================
+
+/** SYNC fijo que envía la Consola simulada (para detectar corrupción silenciosa) */
+static const cm_sync_msg_t k_sync_ref = {
+    .target_speed_kmh = 8.50f,
+    .target_incline_pct = 4.00f,
+    .fan_head = 1,
+    .fan_chest = 2,
+    .wax_pump = 0,
+    .training_mode = 1,
+};
+
+static void data_from_sync(const cm_sync_msg_t *sync, cm_data_msg_t *data) {
+    memset(data, 0, sizeof(*data));
+    data->real_speed_kmh = sync->target_speed_kmh;
+    data->real_incline_pct = sync->target_incline_pct;
+    data->vfd_freq_hz = sync->target_speed_kmh * (50.0f / 6.4f);
+    data->fan_head = sync->fan_head;
+    data->fan_chest = sync->fan_chest;
+}
+
+static bool sync_matches(const cm_sync_msg_t *a, const cm_sync_msg_t *b) {
+    return fabsf(a->target_speed_kmh - b->target_speed_kmh) < 0.005f &&
+           fabsf(a->target_incline_pct - b->target_incline_pct) < 0.005f &&
+           a->fan_head == b->fan_head && a->fan_chest == b->fan_chest &&
+           a->wax_pump == b->wax_pump && a->training_mode == b->training_mode;
+}
+
+static bool data_matches(const cm_data_msg_t *a, const cm_data_msg_t *b) {
+    return fabsf(a->real_speed_kmh - b->real_speed_kmh) < 0.005f &&
+           fabsf(a->real_incline_pct - b->real_incline_pct) < 0.05f &&
+           fabsf(a->vfd_freq_hz - b->vfd_freq_hz) < 0.005f &&
+           a->vfd_fault == b->vfd_fault && a->fan_head == b->fan_head &&
+           a->fan_chest == b->fan_chest && a->incline_fault == b->incline_fault;
+}
+
+// ============================================================================
+// ESTADO COMPARTIDO
+// ============================================================================
+
+typedef struct {
+    int64_t first_detect_us;    ///< -1 si no se detectó
+    const char *detect_by;
+    uint32_t decode_errors;
+    uint32_t overflows;
+    uint32_t watchdog_trips;
+    uint32_t disconnects;
+    uint32_t silent_corruptions;
+} episode_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool s_running = true;
+static volatile fault_class_t s_active_fault = FAULT_NONE;
+static fault_params_t s_params;
+
+static int64_t s_watchdog_timeout_us;
+static int64_t s_conn_timeout_us;
+
+// Protegido por s_lock
+static bool s_episode_open = false;
+static int64_t s_fault_start_us = 0;
+static episode_t s_ep;
+static bool s_base_safe = false;
+static bool s_console_connected = false;
+static int64_t s_last_valid_sync_us = 0;
+static int64_t s_last_valid_data_us = 0;
+static uint32_t s_latency_spike_epoch = 0;  ///< Se incrementa al iniciar cada fallo LATENCY
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/** Registra un evento de detección (llamar con s_lock tomado) */
+static void note_detect_locked(const char *by) {
+    if (s_episode_open && s_ep.first_detect_us < 0) {
+        s_ep.first_detect_us = now_us() - s_fault_start_us;
+        s_ep.detect_by = by;
+    }
+}
+
+static void write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+// ============================================================================
+// INYECTOR
+// ============================================================================
+
+typedef struct {
+    int in_fd;
+    int out_fd;
+    bool c2b;               ///< true: Consola -> Base
+    unsigned int seed;
+} injector_t;
+
+static double rnd(unsigned int *seed) {
+    return (double)rand_r(seed) / ((double)RAND_MAX + 1.0);
+}
+
+static void *injector_thread(void *arg) {
+    injector_t *inj = arg;
+    uint8_t in[256];
+    uint8_t out[sizeof(in)];
+    uint8_t garbage[LINK_FAULTS_GARBAGE_MAX];
+    bool truncating = false;
+    uint32_t spiked_epoch = 0;
+
+    while (s_running) {
+        struct pollfd pfd = { .fd = inj->in_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        ssize_t n = read(inj->in_fd, in, sizeof(in));
+        if (n <= 0) {
+            continue;
+        }
+
+        fault_class_t fault = s_active_fault;
+        if ((inj->c2b && !s_params.inject_c2b) || (!inj->c2b && !s_params.inject_b2c)) {
+            fault = FAULT_NONE;
+        }
+
+        if (fault == FAULT_LATENCY) {
+            pthread_mutex_lock(&s_lock);
+            uint32_t epoch = s_latency_spike_epoch;
+            pthread_mutex_unlock(&s_lock);
+            if (epoch != spiked_epoch) {
+                spiked_epoch = epoch;
+                sleep_ms(s_params.latency_ms);  // Congela esta dirección con los bytes retenidos
+            }
+        }
+
+        size_t o = 0;
+        for (ssize_t i = 0; i < n; i++) {
+            uint8_t b = in[i];
+            switch (fault) {
+                case FAULT_DROP:
+                    if (rnd(&inj->seed) < s_params.drop_prob) {
+                        continue;
+                    }
+                    break;
+                case FAULT_BITFLIP:
+                    if (rnd(&inj->seed) < s_params.flip_prob) {
+                        b ^= (uint8_t)(1u << (rand_r(&inj->seed) % 8));
+                    }
+                    break;
+                case FAULT_TRUNCATE:
+                    if (b == '\n') {
+                        truncating = false;
+                    } else if (truncating) {
+                        continue;
+                    } else if (rnd(&inj->seed) < s_params.trunc_prob / 20.0) {
+                        // ~20 bytes por línea: trunc_prob por línea
+                        truncating = true;
+                        continue;
+                    }
+                    break;
+                case FAULT_BLACKOUT:
+                    continue;
+                default:
+                    break;
+            }
+            out[o++] = b;
+
+            // Una lectura puede traer varias líneas: vaciar out antes de cada ráfaga
+            if (fault == FAULT_GARBAGE && b == '\n' && rnd(&inj->seed) < s_params.garbage_prob) {
+                write_all(inj->out_fd, out, o);
+                o = 0;
+                int len = s_params.garbage_len;
+                if (len > LINK_FAULTS_GARBAGE_MAX) {
+                    len = LINK_FAULTS_GARBAGE_MAX;
+                }
+                for (int k = 0; k < len; k++) {
+                    garbage[k] = (uint8_t)(33 + rand_r(&inj->seed) % 94);  // Imprimible, sin '\n'
+                }
+                write_all(inj->out_fd, garbage, (size_t)len);
+            }
+        }
+        if (fault != FAULT_TRUNCATE) {
+            truncating = false;
+        }
+        write_all(inj->out_fd, out, o);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// EXTREMO CONSOLA (modelo de cm_master.c)
+// ============================================================================
+
+static void *console_thread(void *arg) {
+    int fd = *(int *)arg;
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
+
+    cm_data_msg_t expected;
+    data_from_sync(&k_sync_ref, &expected);
+
+    int64_t next_sync_us = now_us();
+    int64_t last_response_us = now_us();
+
+    while (s_running) {
+        int64_t now = now_us();
+        if (now >= next_sync_us) {
+            char line[CM_SCHEMA_ASCII_MAX];
+            size_t len = cm_sync_encode_ascii(&k_sync_ref, line, sizeof(line));
+            write_all(fd, line, len);
+            next_sync_us += CM_LINK_SYNC_INTERVAL_MS * 1000;
+        }
+
+        int wait_ms = (int)((next_sync_us - now_us()) / 1000);
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, wait_ms > 0 ? wait_ms : 0) > 0) {
+            uint8_t buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            for (ssize_t i = 0; i < n; i++) {
+                cm_line_status_t st = cm_line_reader_feed(&reader, buf[i]);
+                if (st == CM_LINE_READY) {
+                    cm_data_msg_t data;
+                    pthread_mutex_lock(&s_lock);
+                    if (strncmp(reader.buf, CM_DATA_ASCII_PREFIX, sizeof(CM_DATA_ASCII_PREFIX) - 1) == 0 &&
+                        cm_data_decode_ascii(reader.buf, &data)) {
+                        if (!data_matches(&data, &expected)) {
+                            s_ep.silent_corruptions++;
+                        }
+                        last_response_us = now_us();
+                        s_last_valid_data_us = last_response_us;
+                        s_console_connected = true;
+                    } else {
+                        s_ep.decode_errors++;
+                        note_detect_locked("consola:parse");
+                    }
+                    pthread_mutex_unlock(&s_lock);
+                } else if (st == CM_LINE_OVERFLOW) {
+                    pthread_mutex_lock(&s_lock);
+                    s_ep.overflows++;
+                    note_detect_locked("consola:overflow");
+                    pthread_mutex_unlock(&s_lock);
+                }
+            }
+        }
+
+        // Timeout de conexión
+        pthread_mutex_lock(&s_lock);
+        if (s_console_connected && (now_us() - last_response_us) > s_conn_timeout_us) {
+            s_console_connected = false;
+            s_ep.disconnects++;
+            note_detect_locked("consola:timeout");
+        }
+        pthread_mutex_unlock(&s_lock);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// EXTREMO BASE (modelo de Base/main/main.c)
+// ============================================================================
+
+static void *base_thread(void *arg) {
+    int fd = *(int *)arg;
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
+    int64_t last_command_us = now_us();
+
+    while (s_running) {
+        // uart_read_bytes(..., pdMS_TO_TICKS(100))
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) > 0) {
+            uint8_t buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            for (ssize_t i = 0; i < n; i++) {
+                cm_line_status_t st = cm_line_reader_feed(&reader, buf[i]);
+                if (st == CM_LINE_OVERFLOW) {
+                    pthread_mutex_lock(&s_lock);
+                    s_ep.overflows++;
+                    note_detect_locked("base:overflow");
+                    pthread_mutex_unlock(&s_lock);
+                    continue;
+                }
+                if (st != CM_LINE_READY) {
+                    continue;
+                }
+
+                // process_sync() -> reset_safe_state() solo con un SYNC válido
+                bool flushed = false;
+                cm_sync_msg_t sync;
+                bool ok = cm_sync_decode_ascii(reader.buf, &sync);
+                pthread_mutex_lock(&s_lock);
+                if (ok) {
+                    if (s_base_safe) {
+                        s_base_safe = false;
+                        tcflush(fd, TCIFLUSH);  // uart_flush(): se pierde lo ya recibido
+                        flushed = true;
+                    }
+                    last_command_us = now_us();
+                    if (!sync_matches(&sync, &k_sync_ref)) {
+                        s_ep.silent_corruptions++;
+                    }
+                    s_last_valid_sync_us = now_us();
+                } else {
+                    s_ep.decode_errors++;
+                    note_detect_locked("base:parse");
+                }
+                pthread_mutex_unlock(&s_lock);
+
+                if (ok) {
+                    cm_data_msg_t data;
+                    char line[CM_SCHEMA_ASCII_MAX];
+                    data_from_sync(&sync, &data);
+                    size_t len = cm_data_encode_ascii(&data, line, sizeof(line));
+                    write_all(fd, line, len);
+                }
+                if (flushed) {
+                    break;  // El resto del bloque leído estaba en el buffer del driver
+                }
+            }
+        }
+
+        // watchdog_task
+        pthread_mutex_lock(&s_lock);
+        if (!s_base_safe && (now_us() - last_command_us) > s_watchdog_timeout_us) {
+            s_base_safe = true;
+            s_ep.watchdog_trips++;
+            note_detect_locked("base:watchdog");
+        }
+        pthread_mutex_unlock(&s_lock);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// EJECUCIÓN DE EPISODIOS
+// ============================================================================
+
+typedef struct {
+    uint32_t runs;
+    uint32_t detected;
+    uint32_t recovered;
+    int64_t ttd_total_us;
+    int64_t ttd_max_us;
+    int64_t ttr_total_us;
+    int64_t ttr_max_us;
+    episode_t totals;
+    const char *last_detect_by;
+} class_result_t;
+
+static bool link_healthy_since(int64_t since_us) {
+    pthread_mutex_lock(&s_lock);
+    bool ok = s_console_connected && !s_base_safe &&
+              s_last_valid_sync_us > since_us && s_last_valid_data_us > since_us;
+    pthread_mutex_unlock(&s_lock);
+    return ok;
+}
+
+static void run_episode(fault_class_t fault, int fault_ms, int recovery_max_ms, class_result_t *res) {
+    pthread_mutex_lock(&s_lock);
+    memset(&s_ep, 0, sizeof(s_ep));
+    s_ep.first_detect_us = -1;
+    s_fault_start_us = now_us();
+    s_episode_open = true;
+    s_latency_spike_epoch++;
+    pthread_mutex_unlock(&s_lock);
+
+    s_active_fault = fault;
+    sleep_ms(fault_ms);
+    s_active_fault = FAULT_NONE;
+    int64_t fault_end_us = now_us();
+
+    int64_t ttr_us = -1;
+    while ((now_us() - fault_end_us) < (int64_t)recovery_max_ms * 1000) {
+        if (link_healthy_since(fault_end_us)) {
+            ttr_us = now_us() - fault_end_us;
+            break;
+        }
+        sleep_ms(5);
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_episode_open = false;
+    episode_t ep = s_ep;
+    pthread_mutex_unlock(&s_lock);
+
+    res->runs++;
+    if (ep.first_detect_us >= 0) {
+        res->detected++;
+        res->ttd_total_us += ep.first_detect_us;
+        if (ep.first_detect_us > res->ttd_max_us) {
+            res->ttd_max_us = ep.first_detect_us;
+        }
+        res->last_detect_by = ep.detect_by;
+    }
+    if (ttr_us >= 0) {
+        res->recovered++;
+        res->ttr_total_us += ttr_us;
+        if (ttr_us > res->ttr_max_us) {
+            res->ttr_max_us = ttr_us;
+        }
+    }
+    res->totals.decode_errors += ep.decode_errors;
+    res->totals.overflows += ep.overflows;
+    res->totals.watchdog_trips += ep.watchdog_trips;
+    res->totals.disconnects += ep.disconnects;
+    res->totals.silent_corruptions += ep.silent_corruptions;
+
+    printf("  %-9s TTD=%7.1f ms (%s)  TTR=%7.1f ms  parse=%lu ovf=%lu wd=%lu disc=%lu silent=%lu\n",
+           k_fault_names[fault],
+           ep.first_detect_us >= 0 ? ep.first_detect_us / 1000.0 : -1.0,
+           ep.first_detect_us >= 0 ? ep.detect_by : "no detectado",
+           ttr_us >= 0 ? ttr_us / 1000.0 : -1.0,
+           (unsigned long)ep.decode_errors, (unsigned long)ep.overflows,
+           (unsigned long)ep.watchdog_trips, (unsigned long)ep.disconnects,
+           (unsigned long)ep.silent_corruptions);
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static double env_double(const char *name, double def) {
+    const char *v = getenv(name);
+    return (v != NULL) ? atof(v) : def;
+}
+
+static int env_int(const char *name, int def) {
+    const char *v = getenv(name);
+    return (v != NULL) ? atoi(v) : def;
+}
+
+static int open_raw_pty(int *master, int *slave) {
+    if (openpty(master, slave, NULL, NULL, NULL) != 0) {
+        return -1;
+    }
+    struct termios tio;
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    tcgetattr(*master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*master, TCSANOW, &tio);
+    return 0;
+}
+
+/**
+ * @brief true si name aparece como elemento completo de la lista separada por comas
+ *
+ * "drop" no debe seleccionar "dropout" ni "bitflip,drop2" seleccionar "drop".
+ */
+static bool class_selected(const char *list, const char *name) {
+    size_t name_len = strlen(name);
+    const char *p = list;
+    while (*p != '\0') {
+        const char *end = strchr(p, ',');
+        size_t len = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && *p == ' ') {
+            p++;
+            len--;
+        }
+        while (len > 0 && p[len - 1] == ' ') {
+            len--;
+        }
+        if (len == name_len && strncmp(p, name, len) == 0) {
+            return true;
+        }
+        if (end == NULL) {
+            break;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+static int run_faults(void) {
+    int fault_ms = env_int("CM_FI_FAULT_MS", 3000);
+    int repeat = env_int("CM_FI_REPEAT", 3);
+    int recovery_max_ms = env_int("CM_FI_RECOVERY_MAX_MS", 10000);
+    const char *classes = getenv("CM_FI_CLASSES");
+    const char *dir = getenv("CM_FI_DIR");
+    unsigned int seed = (unsigned int)env_int("CM_FI_SEED", 1);
+
+    s_watchdog_timeout_us = (int64_t)env_int("CM_FI_WATCHDOG_MS", CM_LINK_WATCHDOG_TIMEOUT_MS) * 1000;
+    s_conn_timeout_us = (int64_t)env_int("CM_FI_CONN_TIMEOUT_MS", CM_LINK_CONNECTION_TIMEOUT_MS) * 1000;
+
+    s_params = (fault_params_t) {
+        .drop_prob = env_double("CM_FI_DROP_PROB", 0.02),
+        .flip_prob = env_double("CM_FI_FLIP_PROB", 0.01),
+        .trunc_prob = env_double("CM_FI_TRUNC_PROB", 0.3),
+        .garbage_prob = env_double("CM_FI_GARBAGE_PROB", 0.2),
+        .garbage_len = env_int("CM_FI_GARBAGE_LEN", 200),
+        .latency_ms = env_int("CM_FI_LATENCY_MS", 1500),
+        .inject_c2b = (dir == NULL || strcmp(dir, "both") == 0 || strcmp(dir, "c2b") == 0),
+        .inject_b2c = (dir == NULL || strcmp(dir, "both") == 0 || strcmp(dir, "b2c") == 0),
+    };
+
+    int con_master, con_slave, base_master, base_slave;
+    if (open_raw_pty(&con_master, &con_slave) != 0 || open_raw_pty(&base_master, &base_slave) != 0) {
+        perror("openpty");
+        return 1;
+    }
+
+    injector_t c2b = { .in_fd = con_master, .out_fd = base_master, .c2b = true, .seed = seed };
+    injector_t b2c = { .in_fd = base_master, .out_fd = con_master, .c2b = false, .seed = seed * 7919u + 1 };
+
+    pthread_t th[4];
+    pthread_create(&th[0], NULL, injector_thread, &c2b);
+    pthread_create(&th[1], NULL, injector_thread, &b2c);
+    pthread_create(&th[2], NULL, console_thread, &con_slave);
+    pthread_create(&th[3], NULL, base_thread, &base_slave);
+
+    printf("Inyección de fallos: watchdog Base=%lld ms, timeout Consola=%lld ms, fallo=%d ms, dir=%s\n",
+           (long long)(s_watchdog_timeout_us / 1000), (long long)(s_conn_timeout_us / 1000),
+           fault_ms, dir ? dir : "both");
+
+    // Calentamiento: esperar enlace sano
+    int64_t warm_start = now_us();
+    while (!link_healthy_since(warm_start) && (now_us() - warm_start) < 5000000) {
+        sleep_ms(10);
+    }
+
+    class_result_t results[FAULT_COUNT];
+    memset(results, 0, sizeof(results));
+
+    for (int f = FAULT_NONE + 1; f < FAULT_COUNT; f++) {
+        if (classes != NULL && !class_selected(classes, k_fault_names[f])) {
+            continue;
+        }
+        for (int r = 0; r < repeat; r++) {
+            run_episode((fault_class_t)f, fault_ms, recovery_max_ms, &results[f]);
+            sleep_ms(500);  // Asentamiento entre episodios
+        }
+    }
+
+    s_running = false;
+    for (int i = 0; i < 4; i++) {
+        pthread_join(th[i], NULL);
+    }
+
+    printf("\n=== Resumen por clase de fallo ===\n");
+    printf("%-9s %5s %10s %10s %10s %10s %6s %6s %5s %5s %7s\n",
+           "clase", "det", "TTD med", "TTD máx", "TTR med", "TTR máx",
+           "parse", "ovf", "wd", "disc", "silent");
+    int silent_total = 0;
+    bool all_recovered = true;
+    for (int f = FAULT_NONE + 1; f < FAULT_COUNT; f++) {
+        class_result_t *r = &results[f];
+        if (r->runs == 0) {
+            continue;
+        }
+        printf("%-9s %2lu/%-2lu %8.1fms %8.1fms %8.1fms %8.1fms %6lu %6lu %5lu %5lu %7lu\n",
+               k_fault_names[f], (unsigned long)r->detected, (unsigned long)r->runs,
+               r->detected ? r->ttd_total_us / 1000.0 / r->detected : -1.0, r->ttd_max_us / 1000.0,
+               r->recovered ? r->ttr_total_us / 1000.0 / r->recovered : -1.0, r->ttr_max_us / 1000.0,
+               (unsigned long)r->totals.decode_errors, (unsigned long)r->totals.overflows,
+               (unsigned long)r->totals.watchdog_trips, (unsigned long)r->totals.disconnects,
+               (unsigned long)r->totals.silent_corruptions);
+        if (r->recovered < r->runs) {
+            printf("  ⚠️ %s: %lu episodios sin recuperación en %d ms\n", k_fault_names[f],
+                   (unsigned long)(r->runs - r->recovered), recovery_max_ms);
+            all_recovered = false;
+        }
+        silent_total += r->totals.silent_corruptions;
+    }
+    if (silent_total > 0) {
+        printf("⚠️ %d tramas corruptas aceptadas por el parser sin detección\n", silent_total);
+    }
+
+    close(con_master);
+    close(con_slave);
+    close(base_master);
+    close(base_slave);
+    return all_recovered ? 0 : 2;
+}
+
+void app_main(void) {
+    exit(run_faults());
+}
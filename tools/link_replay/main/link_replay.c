@@ -0,0 +1,488 @@
+/**
+ * @file link_replay.c
+ * @brief Reproductor de capturas del enlace RS485 (host, target linux)
+ *
+ * Lee un volcado generado por cm_link_capture y alimenta las tramas al
+ * mismo ensamblador de líneas (cm_line.h) y decodificadores (cm_schema.h)
+ * que usan los firmwares, respetando los tiempos originales o acelerados.
+ *
+ * Con CM_REPLAY_PORT las líneas hacia Base se escriben además en el
+ * pseudo-terminal del ejecutable de host de Base (destino linux), de modo
+ * que recorren su uart_rx_task, process_command y process_sync reales. El
+ * veredicto sale entonces de Base: sus contadores SLINK (pedidos con STATS
+ * antes y después) y las respuestas DATA que devuelve.
+ *
+ * Configuración por variables de entorno:
+ *   CM_REPLAY_FILE    Fichero de captura (obligatorio)
+ *   CM_REPLAY_TARGET  "base" (SYNC Consola->Base) o "consola" (DATA Base->Consola)
+ *   CM_REPLAY_SPEED   Factor de velocidad (1.0 = tiempo real, 0 = sin esperas)
+ *   CM_REPLAY_PORT    Pseudo-terminal del ejecutable de host de Base (solo "base")
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "cm_line.h"
+#include "cm_schema.h"
+#include "cm_capture_format.h"
+
+// ============================================================================
+// CONSTANTES
+// ============================================================================
+
+/** Gap máximo esperado entre SYNC consecutivos (SYNC_INTERVAL_MS + margen) */
+#define REPLAY_GAP_WARN_US      (150 * 1000)
+
+/** Timeout de conexión de ambos firmwares */
+#define REPLAY_GAP_STALL_US     (1000 * 1000)
+
+/** Límites del histograma de gaps en ms */
+static const int64_t k_gap_buckets_ms[] = { 110, 150, 250, 500, 1000 };
+#define REPLAY_GAP_BUCKETS      (sizeof(k_gap_buckets_ms) / sizeof(k_gap_buckets_ms[0]) + 1)
+
+/** Espera máxima del DATA de un SYNC con CM_REPLAY_SPEED=0 (Base responde en < 10 ms) */
+#define REPLAY_RESPONSE_TIMEOUT_US  (100 * 1000)
+
+/** Espera máxima de la respuesta STATS completa (la envía una tarea de baja prioridad) */
+#define REPLAY_STATS_TIMEOUT_US     (2000 * 1000)
+
+// ============================================================================
+// ESTADÍSTICAS
+// ============================================================================
+
+typedef struct {
+    uint32_t frames;            ///< Tramas entregadas al parser
+    uint32_t decoded;           ///< Decodificadas correctamente
+    uint32_t decode_errors;     ///< Rechazadas por el decodificador
+    uint32_t other;             ///< Otros comandos (CALIBRATE_INCLINE, ...)
+    uint32_t overflows;         ///< Líneas descartadas por longitud
+    uint64_t decode_ns_total;
+    uint64_t decode_ns_max;
+    int64_t gap_max_us;
+    uint32_t gaps_warn;
+    uint32_t gaps_stall;
+    uint32_t gap_hist[REPLAY_GAP_BUCKETS];
+    uint32_t rtt_count;         ///< Pares petición -> respuesta en la captura
+    int64_t rtt_total_us;
+    int64_t rtt_max_us;
+    int64_t rtt_min_us;
+} replay_stats_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_us(int64_t us) {
+    if (us <= 0) {
+        return;
+    }
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// ============================================================================
+// EJECUTABLE DE HOST DE BASE
+// ============================================================================
+
+/** @brief Enlace con el pseudo-terminal de Base y lo que ha respondido */
+typedef struct {
+    int fd;
+    cm_line_reader_t reader;
+    uint64_t pending_sync_ns;   ///< Envío del último SYNC aún sin DATA (0 = ninguno)
+    uint32_t syncs_sent;
+    uint32_t data_rx;           ///< Líneas DATA recibidas
+    uint32_t data_bad;          ///< DATA que no decodifica
+    uint32_t data_missing;      ///< SYNC sin DATA antes del siguiente SYNC
+    uint64_t resp_ns_total;     ///< SYNC -> DATA medido desde el host
+    uint64_t resp_ns_max;
+    uint32_t resp_count;
+    cm_stats_link_msg_t slink;  ///< Último SLINK recibido
+    bool stats_done;            ///< SSYS recibido: respuesta STATS completa
+} base_link_t;
+
+static bool base_link_open(base_link_t *link, const char *path) {
+    memset(link, 0, sizeof(*link));
+    link->fd = open(path, O_RDWR | O_NOCTTY);
+    if (link->fd < 0) {
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(link->fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(link->fd, TCSANOW, &tio);
+    cm_line_reader_reset(&link->reader);
+    return true;
+}
+
+static void base_link_on_line(base_link_t *link, const char *line) {
+    if (strncmp(line, CM_DATA_ASCII_PREFIX, sizeof(CM_DATA_ASCII_PREFIX) - 1) == 0) {
+        cm_data_msg_t data;
+        link->data_rx++;
+        if (!cm_data_decode_ascii(line, &data)) {
+            link->data_bad++;
+            printf("  DATA inválido de Base: %s\n", line);
+        }
+        if (link->pending_sync_ns != 0) {
+            uint64_t dt = now_ns() - link->pending_sync_ns;
+            link->resp_ns_total += dt;
+            link->resp_count++;
+            if (dt > link->resp_ns_max) {
+                link->resp_ns_max = dt;
+            }
+            link->pending_sync_ns = 0;
+        }
+    } else if (strncmp(line, CM_STATS_LINK_PREFIX, sizeof(CM_STATS_LINK_PREFIX) - 1) == 0) {
+        cm_stats_link_decode_ascii(line, &link->slink);
+    } else if (strncmp(line, CM_STATS_SYS_PREFIX, sizeof(CM_STATS_SYS_PREFIX) - 1) == 0) {
+        link->stats_done = true;
+    }
+}
+
+/**
+ * @brief Lee lo que responda Base durante budget_us
+ *
+ * @param until_data Volver en cuanto llegue el DATA del SYNC pendiente
+ */
+static void base_link_wait(base_link_t *link, int64_t budget_us, bool until_data) {
+    uint64_t end_ns = now_ns() + (budget_us > 0 ? (uint64_t)budget_us * 1000u : 0);
+    for (;;) {
+        if (until_data && link->pending_sync_ns == 0) {
+            return;
+        }
+        uint64_t now = now_ns();
+        if (now >= end_ns) {
+            return;
+        }
+        struct pollfd pfd = { .fd = link->fd, .events = POLLIN };
+        int timeout_ms = (int)((end_ns - now + 999999u) / 1000000u);
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            continue;
+        }
+        uint8_t buf[256];
+        ssize_t n = read(link->fd, buf, sizeof(buf));
+        for (ssize_t k = 0; k < n; k++) {
+            if (cm_line_reader_feed(&link->reader, buf[k]) == CM_LINE_READY) {
+                base_link_on_line(link, link->reader.buf);
+            }
+        }
+    }
+}
+
+/** @brief Escribe una línea capturada tal cual llegó a la UART de Base */
+static void base_link_send(base_link_t *link, const uint8_t *data, size_t len) {
+    uint8_t buf[CM_CAPTURE_DATA_MAX + 1];
+    memcpy(buf, data, len);
+    buf[len] = '\n';
+
+    if (len >= sizeof(CM_SYNC_ASCII_PREFIX) - 1 &&
+        memcmp(data, CM_SYNC_ASCII_PREFIX, sizeof(CM_SYNC_ASCII_PREFIX) - 1) == 0) {
+        if (link->pending_sync_ns != 0) {
+            link->data_missing++;
+        }
+        link->pending_sync_ns = now_ns();
+        link->syncs_sent++;
+    }
+    if (write(link->fd, buf, len + 1) != (ssize_t)(len + 1)) {
+        printf("  Error escribiendo en el enlace de Base\n");
+    }
+}
+
+/** @brief Pide STATS a Base y espera a SSYS; false si no respondió completo */
+static bool base_link_stats(base_link_t *link, cm_stats_link_msg_t *out) {
+    static const char request[] = CM_STATS_REQUEST_PREFIX "1\n";
+    link->stats_done = false;
+    if (write(link->fd, request, sizeof(request) - 1) != (ssize_t)(sizeof(request) - 1)) {
+        return false;
+    }
+    uint64_t end_ns = now_ns() + (uint64_t)REPLAY_STATS_TIMEOUT_US * 1000u;
+    while (!link->stats_done && now_ns() < end_ns) {
+        base_link_wait(link, 10 * 1000, false);
+    }
+    *out = link->slink;
+    return link->stats_done;
+}
+
+// ============================================================================
+// PARSER
+// ============================================================================
+
+/**
+ * @brief Entrega una línea completa al decodificador del firmware destino
+ */
+static void parse_line(const char *line, bool target_base, replay_stats_t *st) {
+    uint64_t t0 = now_ns();
+    bool ok;
+    bool known;
+
+    if (target_base) {
+        cm_sync_msg_t sync;
+        known = (strncmp(line, CM_SYNC_ASCII_PREFIX, sizeof(CM_SYNC_ASCII_PREFIX) - 1) == 0);
+        ok = known && cm_sync_decode_ascii(line, &sync);
+    } else {
+        cm_data_msg_t data;
+        known = (strncmp(line, CM_DATA_ASCII_PREFIX, sizeof(CM_DATA_ASCII_PREFIX) - 1) == 0);
+        ok = known && cm_data_decode_ascii(line, &data);
+    }
+
+    uint64_t dt = now_ns() - t0;
+    st->decode_ns_total += dt;
+    if (dt > st->decode_ns_max) {
+        st->decode_ns_max = dt;
+    }
+
+    st->frames++;
+    if (!known) {
+        st->other++;
+    } else if (ok) {
+        st->decoded++;
+    } else {
+        st->decode_errors++;
+        printf("  ERROR de parseo: %s\n", line);
+    }
+}
+
+static void account_gap(int64_t gap_us, int64_t rel_us, replay_stats_t *st) {
+    if (gap_us > st->gap_max_us) {
+        st->gap_max_us = gap_us;
+    }
+    size_t b = 0;
+    while (b < REPLAY_GAP_BUCKETS - 1 && gap_us >= k_gap_buckets_ms[b] * 1000) {
+        b++;
+    }
+    st->gap_hist[b]++;
+
+    if (gap_us >= REPLAY_GAP_STALL_US) {
+        st->gaps_stall++;
+        printf("  STALL de %lld ms en t=%.3f s\n", (long long)(gap_us / 1000), rel_us / 1e6);
+    } else if (gap_us >= REPLAY_GAP_WARN_US) {
+        st->gaps_warn++;
+    }
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static int run_replay(void) {
+    const char *path = getenv("CM_REPLAY_FILE");
+    const char *target = getenv("CM_REPLAY_TARGET");
+    const char *speed_str = getenv("CM_REPLAY_SPEED");
+    const char *port = getenv("CM_REPLAY_PORT");
+
+    if (path == NULL) {
+        printf("Uso: CM_REPLAY_FILE=captura.bin [CM_REPLAY_TARGET=base|consola] "
+               "[CM_REPLAY_SPEED=1.0] [CM_REPLAY_PORT=/dev/pts/N] link_replay.elf\n");
+        return 1;
+    }
+    bool target_base = (target == NULL || strcmp(target, "base") == 0);
+    double speed = (speed_str != NULL) ? atof(speed_str) : 1.0;
+
+    // Solo Base tiene ejecutable de host; Consola se valida con sus decodificadores
+    base_link_t link = { .fd = -1 };
+    bool use_base = false;
+    cm_stats_link_msg_t slink_before = { 0 };
+    if (port != NULL) {
+        if (!target_base) {
+            printf("CM_REPLAY_PORT solo aplica a CM_REPLAY_TARGET=base\n");
+            return 1;
+        }
+        if (!base_link_open(&link, port)) {
+            printf("No se puede abrir %s\n", port);
+            return 1;
+        }
+        if (!base_link_stats(&link, &slink_before)) {
+            printf("Base no responde a STATS en %s\n", port);
+            close(link.fd);
+            return 1;
+        }
+        use_base = true;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("No se puede abrir %s\n", path);
+        if (use_base) {
+            close(link.fd);
+        }
+        return 1;
+    }
+
+    cm_capture_header_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != CM_CAPTURE_MAGIC ||
+        hdr.version != CM_CAPTURE_VERSION || hdr.record_size != sizeof(cm_capture_record_t)) {
+        printf("Cabecera de captura inválida\n");
+        fclose(f);
+        if (use_base) {
+            close(link.fd);
+        }
+        return 1;
+    }
+
+    // Dirección que corresponde al tráfico hacia el firmware destino
+    uint8_t wanted_dir;
+    if (hdr.node == CM_CAPTURE_NODE_CONSOLA) {
+        wanted_dir = target_base ? CM_CAPTURE_DIR_TX : CM_CAPTURE_DIR_RX;
+    } else {
+        wanted_dir = target_base ? CM_CAPTURE_DIR_RX : CM_CAPTURE_DIR_TX;
+    }
+
+    printf("Captura de %s: %lu tramas (%lu perdidas). Destino: parser de %s, velocidad %.2fx\n",
+           hdr.node == CM_CAPTURE_NODE_CONSOLA ? "Consola" : "Base",
+           (unsigned long)hdr.record_count, (unsigned long)hdr.overwritten,
+           target_base ? "Base (SYNC)" : "Consola (DATA)", speed);
+    if (use_base) {
+        printf("Firmware de Base en %s\n", port);
+    }
+
+    replay_stats_t st = { .rtt_min_us = INT64_MAX };
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
+
+    int64_t first_ts = 0;
+    int64_t last_wanted_ts = -1;
+    int64_t pending_tx_ts = -1;
+    uint64_t wall_start_ns = now_ns();
+
+    for (uint32_t i = 0; i < hdr.record_count; i++) {
+        cm_capture_record_t rec;
+        if (fread(&rec, sizeof(rec), 1, f) != 1) {
+            printf("Captura truncada en registro %lu\n", (unsigned long)i);
+            break;
+        }
+        if (i == 0) {
+            first_ts = rec.timestamp_us;
+        }
+        int64_t rel_us = rec.timestamp_us - first_ts;
+
+        // RTT visto desde el nodo que capturó: TX -> siguiente RX
+        if (rec.dir == CM_CAPTURE_DIR_TX) {
+            pending_tx_ts = rec.timestamp_us;
+        } else if (pending_tx_ts >= 0) {
+            int64_t rtt = rec.timestamp_us - pending_tx_ts;
+            st.rtt_count++;
+            st.rtt_total_us += rtt;
+            if (rtt > st.rtt_max_us) st.rtt_max_us = rtt;
+            if (rtt < st.rtt_min_us) st.rtt_min_us = rtt;
+            pending_tx_ts = -1;
+        }
+
+        if (rec.dir != wanted_dir) {
+            continue;
+        }
+        if (rec.flags & CM_CAPTURE_FLAG_OVERFLOW) {
+            st.overflows++;
+            continue;
+        }
+
+        // Respetar la temporización original (escalada), atendiendo a Base mientras
+        if (speed > 0.0) {
+            int64_t due_us = (int64_t)(rel_us / speed);
+            int64_t elapsed_us = (int64_t)((now_ns() - wall_start_ns) / 1000);
+            if (use_base) {
+                base_link_wait(&link, due_us - elapsed_us, false);
+            } else {
+                sleep_us(due_us - elapsed_us);
+            }
+        }
+
+        if (last_wanted_ts >= 0) {
+            account_gap(rec.timestamp_us - last_wanted_ts, rel_us, &st);
+        }
+        last_wanted_ts = rec.timestamp_us;
+
+        // Alimentar byte a byte como lo haría la UART
+        for (uint8_t k = 0; k < rec.len; k++) {
+            if (cm_line_reader_feed(&reader, rec.data[k]) == CM_LINE_OVERFLOW) {
+                st.overflows++;
+            }
+        }
+        if (cm_line_reader_feed(&reader, '\n') == CM_LINE_READY) {
+            parse_line(reader.buf, target_base, &st);
+        }
+
+        if (use_base) {
+            base_link_send(&link, rec.data, rec.len);
+            // Sin esperas: no mandar el siguiente SYNC hasta que Base responda
+            if (speed <= 0.0) {
+                base_link_wait(&link, REPLAY_RESPONSE_TIMEOUT_US, true);
+            }
+        }
+    }
+    fclose(f);
+
+    cm_stats_link_msg_t slink_after = { 0 };
+    bool base_stats_ok = true;
+    if (use_base) {
+        base_link_wait(&link, REPLAY_RESPONSE_TIMEOUT_US, true);
+        if (link.pending_sync_ns != 0) {
+            link.data_missing++;
+        }
+        base_stats_ok = base_link_stats(&link, &slink_after);
+        close(link.fd);
+    }
+
+    double wall_s = (now_ns() - wall_start_ns) / 1e9;
+    printf("\n=== Resultado ===\n");
+    printf("Tramas: %lu | OK: %lu | Error: %lu | Otras: %lu | Desbordadas: %lu\n",
+           (unsigned long)st.frames, (unsigned long)st.decoded, (unsigned long)st.decode_errors,
+           (unsigned long)st.other, (unsigned long)st.overflows);
+    if (st.frames > 0) {
+        printf("Decodificación: media %.0f ns, máx %llu ns\n",
+               (double)st.decode_ns_total / st.frames, (unsigned long long)st.decode_ns_max);
+    }
+    printf("Gap máx: %lld ms | >%d ms: %lu | stalls (>%d ms): %lu\n",
+           (long long)(st.gap_max_us / 1000), REPLAY_GAP_WARN_US / 1000, (unsigned long)st.gaps_warn,
+           REPLAY_GAP_STALL_US / 1000, (unsigned long)st.gaps_stall);
+    printf("Histograma de gaps:");
+    for (size_t b = 0; b < REPLAY_GAP_BUCKETS; b++) {
+        if (b < REPLAY_GAP_BUCKETS - 1) {
+            printf(" <%lldms:%lu", (long long)k_gap_buckets_ms[b], (unsigned long)st.gap_hist[b]);
+        } else {
+            printf(" >=%lldms:%lu", (long long)k_gap_buckets_ms[b - 1], (unsigned long)st.gap_hist[b]);
+        }
+    }
+    printf("\n");
+    if (st.rtt_count > 0) {
+        printf("RTT petición->respuesta: min %.2f ms, media %.2f ms, máx %.2f ms (%lu pares)\n",
+               st.rtt_min_us / 1000.0, (double)st.rtt_total_us / st.rtt_count / 1000.0,
+               st.rtt_max_us / 1000.0, (unsigned long)st.rtt_count);
+    }
+    printf("Duración de la reproducción: %.2f s\n", wall_s);
+
+    uint32_t base_bad = 0;
+    if (use_base) {
+        printf("\n=== Firmware de Base ===\n");
+        if (!base_stats_ok) {
+            printf("Base no respondió a STATS al terminar\n");
+            return 2;
+        }
+        base_bad = slink_after.frames_bad - slink_before.frames_bad;
+        printf("SYNC enviados: %lu | DATA: %lu (inválidos %lu) | SYNC sin respuesta: %lu\n",
+               (unsigned long)link.syncs_sent, (unsigned long)link.data_rx,
+               (unsigned long)link.data_bad, (unsigned long)link.data_missing);
+        printf("Rechazadas por Base: %lu | Desbordadas: %lu | Disparos del watchdog: %lu\n",
+               (unsigned long)base_bad,
+               (unsigned long)(slink_after.line_overflows - slink_before.line_overflows),
+               (unsigned long)(slink_after.watchdog_trips - slink_before.watchdog_trips));
+        if (link.resp_count > 0) {
+            printf("SYNC->DATA (host): media %.2f ms, máx %.2f ms\n",
+                   (double)link.resp_ns_total / link.resp_count / 1e6, link.resp_ns_max / 1e6);
+        }
+    }
+
+    bool base_ok = !use_base || (base_bad == 0 && link.data_bad == 0 && link.data_missing == 0);
+    return (st.decode_errors == 0 && base_ok) ? 0 : 2;
+}
+
+void app_main(void) {
+    exit(run_replay());
+}
@@ -0,0 +1,277 @@
+/**
+ * @file link_stress.c
+ * @brief Prueba de estrés del enlace RS485 contra una Base real (host, target linux)
+ *
+ * Hace de Consola a través de un adaptador USB-RS485: envía SYNC a la tasa
+ * pedida (100 Hz por defecto) y empareja cada DATA con su SYNC por el eco
+ * sync_tx_us. Pensada para ejecutarse con la Base compilada con
+ * CONFIG_BASE_NVS_STRESS_TEST, que mantiene la caché de flash deshabilitada
+ * con commits NVS continuos: cualquier byte perdido por la UART de Base
+ * aparece aquí como SYNC sin respuesta.
+ *
+ * El enlace es half-duplex: nunca se envía un SYNC con otro pendiente. Si la
+ * ida y vuelta no cabe en el periodo, la tasa real queda por debajo de la
+ * pedida (se informa de ambas).
+ *
+ * Configuración por variables de entorno (todas opcionales):
+ *   CM_LS_PORT          Puerto serie (/dev/ttyUSB0)
+ *   CM_LS_RATE_HZ       SYNC por segundo (100)
+ *   CM_LS_SECONDS       Duración de la prueba (60)
+ *   CM_LS_TIMEOUT_MS    Espera máxima de cada DATA (100)
+ *   CM_LS_MAX_DROPS     Pérdidas toleradas antes de fallar (0)
+ *
+ * Código de salida: 0 si las pérdidas no superan CM_LS_MAX_DROPS, 2 si las
+ * superan, 1 si no se pudo abrir el puerto.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include "cm_line.h"
+#include "cm_schema.h"
+
+// ============================================================================
+// CONSTANTES
+// ============================================================================
+
+/** Velocidad del enlace (UART_BAUD_RATE de ambos firmwares) */
+#define LS_BAUD                 B115200
+
+/** Límites del histograma de ida y vuelta en ms */
+static const int64_t k_rtt_buckets_ms[] = { 5, 10, 20, 50, 100 };
+#define LS_RTT_BUCKETS          (sizeof(k_rtt_buckets_ms) / sizeof(k_rtt_buckets_ms[0]) + 1)
+
+/** SYNC enviado: todo parado, fuera de entrenamiento */
+static const cm_sync_msg_t k_sync_idle = {
+    .target_speed_kmh = 0.0f,
+    .target_incline_pct = 0.0f,
+    .training_mode = 0,
+};
+
+// ============================================================================
+// ESTADÍSTICAS
+// ============================================================================
+
+typedef struct {
+    uint32_t sent;              ///< SYNC enviados
+    uint32_t answered;          ///< DATA que responden al SYNC pendiente
+    uint32_t dropped;           ///< SYNC sin DATA en CM_LS_TIMEOUT_MS
+    uint32_t stale;             ///< DATA de un SYNC anterior (llegó tarde)
+    uint32_t decode_errors;     ///< Líneas que no decodifican como DATA
+    uint32_t overflows;         ///< Líneas descartadas por longitud
+    uint32_t drop_bursts;       ///< Rachas de pérdidas consecutivas
+    uint32_t drop_burst_max;
+    int64_t rtt_total_us;
+    int64_t rtt_max_us;
+    uint32_t rtt_hist[LS_RTT_BUCKETS];
+} ls_stats_t;
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int env_int(const char *name, int def) {
+    const char *v = getenv(name);
+    return (v != NULL) ? atoi(v) : def;
+}
+
+static void write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static int open_port(const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, LS_BAUD);
+    cfsetospeed(&tio, LS_BAUD);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+static void rtt_add(ls_stats_t *st, int64_t rtt_us) {
+    st->rtt_total_us += rtt_us;
+    if (rtt_us > st->rtt_max_us) {
+        st->rtt_max_us = rtt_us;
+    }
+    size_t b = 0;
+    while (b < LS_RTT_BUCKETS - 1 && rtt_us > k_rtt_buckets_ms[b] * 1000) {
+        b++;
+    }
+    st->rtt_hist[b]++;
+}
+
+// ============================================================================
+// PRINCIPAL
+// ============================================================================
+
+static int run_stress(void) {
+    const char *port = getenv("CM_LS_PORT") ? getenv("CM_LS_PORT") : "/dev/ttyUSB0";
+    int rate_hz = env_int("CM_LS_RATE_HZ", 100);
+    int seconds = env_int("CM_LS_SECONDS", 60);
+    int64_t timeout_us = (int64_t)env_int("CM_LS_TIMEOUT_MS", 100) * 1000;
+    uint32_t max_drops = (uint32_t)env_int("CM_LS_MAX_DROPS", 0);
+    int64_t period_us = 1000000 / (rate_hz > 0 ? rate_hz : 1);
+
+    int fd = open_port(port);
+    if (fd < 0) {
+        perror(port);
+        return 1;
+    }
+
+    printf("Estrés del enlace: %s, %d Hz pedidos, %d s, timeout DATA %lld ms\n",
+           port, rate_hz, seconds, (long long)(timeout_us / 1000));
+
+    cm_line_reader_t reader;
+    cm_line_reader_reset(&reader);
+    ls_stats_t st = { 0 };
+    ls_stats_t prev = { 0 };
+    uint32_t burst = 0;
+
+    int64_t start_us = now_us();
+    int64_t end_us = start_us + (int64_t)seconds * 1000000;
+    int64_t next_send_us = start_us;
+    int64_t next_report_us = start_us + 1000000;
+    int64_t pending_tx_us = 0;      // 0: sin SYNC pendiente
+
+    while (now_us() < end_us) {
+        int64_t now = now_us();
+
+        // Pendiente sin respuesta: pérdida
+        if (pending_tx_us != 0 && now - pending_tx_us > timeout_us) {
+            st.dropped++;
+            if (burst++ == 0) {
+                st.drop_bursts++;
+            }
+            if (burst > st.drop_burst_max) {
+                st.drop_burst_max = burst;
+            }
+            pending_tx_us = 0;
+        }
+
+        if (pending_tx_us == 0 && now >= next_send_us) {
+            cm_sync_msg_t sync = k_sync_idle;
+            sync.tx_us = now;
+            char line[CM_SCHEMA_ASCII_MAX];
+            size_t len = cm_sync_encode_ascii(&sync, line, sizeof(line));
+            write_all(fd, line, len);
+            pending_tx_us = now;
+            st.sent++;
+            next_send_us += period_us;
+            if (next_send_us < now) {
+                next_send_us = now;  // Half-duplex: la tasa real cae, no se acumulan envíos
+            }
+        }
+
+        if (now >= next_report_us) {
+            printf("  t=%3llds  enviados=%5lu (+%3lu)  respondidos=%5lu  perdidos=%4lu (+%lu)  tardíos=%lu\n",
+                   (long long)((now - start_us) / 1000000),
+                   (unsigned long)st.sent, (unsigned long)(st.sent - prev.sent),
+                   (unsigned long)st.answered, (unsigned long)st.dropped,
+                   (unsigned long)(st.dropped - prev.dropped), (unsigned long)st.stale);
+            prev = st;
+            next_report_us += 1000000;
+        }
+
+        int64_t wake_us = pending_tx_us != 0 ? pending_tx_us + timeout_us : next_send_us;
+        if (wake_us > next_report_us) {
+            wake_us = next_report_us;
+        }
+        int wait_ms = (int)((wake_us - now_us() + 999) / 1000);
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, wait_ms > 0 ? wait_ms : 0) <= 0) {
+            continue;
+        }
+
+        uint8_t buf[256];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        int64_t rx_us = now_us();
+        for (ssize_t i = 0; i < n; i++) {
+            cm_line_status_t ls = cm_line_reader_feed(&reader, buf[i]);
+            if (ls == CM_LINE_OVERFLOW) {
+                st.overflows++;
+                continue;
+            }
+            if (ls != CM_LINE_READY) {
+                continue;
+            }
+            cm_data_msg_t data;
+            if (!cm_data_decode_ascii(reader.buf, &data)) {
+                st.decode_errors++;
+                continue;
+            }
+            if (pending_tx_us != 0 && data.sync_tx_us == pending_tx_us) {
+                st.answered++;
+                rtt_add(&st, rx_us - pending_tx_us);
+                pending_tx_us = 0;
+                burst = 0;
+            } else {
+                st.stale++;
+            }
+        }
+    }
+    close(fd);
+
+    double elapsed_s = (double)(now_us() - start_us) / 1e6;
+    printf("\nResultado (%.1f s):\n", elapsed_s);
+    printf("  SYNC enviados:       %lu (%.1f Hz reales de %d pedidos)\n",
+           (unsigned long)st.sent, st.sent / elapsed_s, rate_hz);
+    printf("  DATA respondidos:    %lu\n", (unsigned long)st.answered);
+    printf("  Tramas perdidas:     %lu (%.3f%%), %lu rachas, racha máx %lu\n",
+           (unsigned long)st.dropped, st.sent ? 100.0 * st.dropped / st.sent : 0.0,
+           (unsigned long)st.drop_bursts, (unsigned long)st.drop_burst_max);
+    printf("  DATA tardíos:        %lu\n", (unsigned long)st.stale);
+    printf("  Errores de decodif.: %lu, líneas desbordadas: %lu\n",
+           (unsigned long)st.decode_errors, (unsigned long)st.overflows);
+    if (st.answered > 0) {
+        printf("  Ida y vuelta:        media %.2f ms, máx %.2f ms\n",
+               st.rtt_total_us / 1000.0 / st.answered, st.rtt_max_us / 1000.0);
+        printf("  Histograma (ms):    ");
+        for (size_t b = 0; b < LS_RTT_BUCKETS; b++) {
+            if (b < LS_RTT_BUCKETS - 1) {
+                printf(" <=%lld:%lu", (long long)k_rtt_buckets_ms[b], (unsigned long)st.rtt_hist[b]);
+            } else {
+                printf(" >%lld:%lu", (long long)k_rtt_buckets_ms[b - 1], (unsigned long)st.rtt_hist[b]);
+            }
+        }
+        printf("\n");
+    }
+
+    return (st.dropped > max_drops) ? 2 : 0;
+}
+
+void app_main(void) {
+    exit(run_stress());
+}